@@ -0,0 +1,130 @@
+#define _GNU_SOURCE
+#include "bench.h"
+#include "../include/scheduler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+// 链接时用-Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc把调用重定向到这里
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+static atomic_ulong allocations;
+
+void *__wrap_malloc(size_t size) {
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size) {
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    return __real_calloc(nmemb, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    return __real_realloc(ptr, size);
+}
+
+static uint64_t min_time_ns = 500 * NSEC_PER_MSEC;    // 每个用例的最短运行时间
+static const char *filter = NULL;                    // 用例名过滤子串
+static uint64_t random_state = 0x9e3779b97f4a7c15ULL;
+static volatile double sink;
+
+bool bench_selected(const char *name) {
+    return !filter || strstr(name, filter) != NULL;
+}
+
+double bench_random(void) {
+    random_state ^= random_state >> 12;
+    random_state ^= random_state << 25;
+    random_state ^= random_state >> 27;
+    return (double)((random_state * 0x2545f4914f6cdd1dULL) >> 11) / (double)(1ULL << 53);
+}
+
+void bench_sink(double value) {
+    sink = value;
+}
+
+void bench_run(const char *name, BenchFunc fn, void *ctx) {
+    if (!bench_selected(name)) {
+        return;
+    }
+
+    // 预热一次，再按上一轮的耗时估算达到最短运行时间所需的迭代次数
+    fn(ctx, 1);
+    uint64_t iterations = 1;
+    uint64_t elapsed;
+    unsigned long allocs;
+    for (;;) {
+        unsigned long allocs_before = atomic_load(&allocations);
+        uint64_t start = monotonic_ns();
+        fn(ctx, iterations);
+        elapsed = monotonic_ns() - start;
+        allocs = atomic_load(&allocations) - allocs_before;
+
+        if (elapsed >= min_time_ns || iterations >= 1000000000ULL) {
+            break;
+        }
+        uint64_t next = elapsed > 0 ? iterations * min_time_ns / elapsed * 6 / 5 : iterations * 100;
+        if (next > iterations * 100) {
+            next = iterations * 100;
+        }
+        iterations = next > iterations ? next : iterations + 1;
+    }
+
+    printf("Benchmark%s\t%10llu\t%14.1f ns/op\t%10.2f allocs/op\n",
+           name, (unsigned long long)iterations,
+           (double)elapsed / iterations, (double)allocs / iterations);
+    fflush(stdout);
+}
+
+static void print_help(void) {
+    printf("用法: bench [选项]\n");
+    printf("选项:\n");
+    printf("  -h            显示帮助信息\n");
+    printf("  -t <间隔>     每个用例的最短运行时间，如1、0.2、100ms（默认: 500ms）\n");
+    printf("  -f <子串>     只运行名称包含该子串的用例\n");
+    printf("  -p <目录>     额外以该目录作为procfs根目录运行解析用例（如/proc）\n");
+}
+
+int main(int argc, char *argv[]) {
+    const char *proc_root = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "ht:f:p:")) != -1) {
+        switch (opt) {
+            case 'h':
+                print_help();
+                return 0;
+            case 't':
+                if (parse_interval(optarg, &min_time_ns) != 0) {
+                    fprintf(stderr, "错误: 无效的运行时间 %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'f':
+                filter = optarg;
+                break;
+            case 'p':
+                proc_root = optarg;
+                break;
+            default:
+                fprintf(stderr, "使用 -h 选项获取帮助\n");
+                return 1;
+        }
+    }
+
+    printf("goos: linux\n");
+    printf("pkg: anomaly_detection\n");
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    printf("cpus: %ld\n", cpus);
+
+    bench_proc(proc_root);
+    bench_stats();
+    bench_detectors();
+    return 0;
+}
@@ -0,0 +1,59 @@
+/**
+ * @file bench.h
+ * @brief 微基准测试框架头文件
+ *
+ * 每个用例自动增加迭代次数，直到总耗时达到最短运行时间，然后以
+ * Go benchmark格式输出一行（可直接交给benchstat比较）：
+ *
+ *   BenchmarkName/param  <迭代次数>  <x> ns/op  <y> allocs/op
+ *
+ * 内存分配次数通过链接器--wrap拦截malloc/calloc/realloc统计，
+ * 只包含本项目代码中的直接调用。
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief 用例函数：执行iterations次被测操作
+ * @param ctx 用例上下文
+ * @param iterations 迭代次数
+ */
+typedef void (*BenchFunc)(void *ctx, uint64_t iterations);
+
+/**
+ * @brief 判断用例是否被命令行过滤条件选中，未选中的用例应跳过准备工作
+ * @param name 用例名称（不含"Benchmark"前缀）
+ * @return 选中返回true
+ */
+bool bench_selected(const char *name);
+
+/**
+ * @brief 运行一个用例并输出结果
+ * @param name 用例名称（不含"Benchmark"前缀）
+ * @param fn 用例函数
+ * @param ctx 用例上下文
+ */
+void bench_run(const char *name, BenchFunc fn, void *ctx);
+
+/**
+ * @brief 生成[0, 1)之间的伪随机数（xorshift64*，结果可复现）
+ * @return 伪随机数
+ */
+double bench_random(void);
+
+/**
+ * @brief 防止编译器把被测计算当作无用代码删除
+ * @param value 计算结果
+ */
+void bench_sink(double value);
+
+/* 各组用例 */
+void bench_proc(const char *proc_root);
+void bench_stats(void);
+void bench_detectors(void);
+
+#endif /* BENCH_H */
@@ -0,0 +1,259 @@
+#include "bench.h"
+#include "../include/anomaly_detection.h"
+#include "../include/config.h"
+#include "../include/scheduler.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+/* 检测器用例上下文 */
+typedef struct {
+    AnomalyDetector detector;
+    int (*detect)(AnomalyDetector *detector);
+} DetectorBench;
+
+// 对全部指标运行一次检测，每次从空异常列表开始，与检测线程每个周期的做法一致
+static void run_detector(void *ctx, uint64_t iterations) {
+    DetectorBench *b = (DetectorBench *)ctx;
+    int total = 0;
+    for (uint64_t i = 0; i < iterations; i++) {
+        anomaly_arena_reset(&b->detector.anomalies);
+        total += b->detect(&b->detector);
+    }
+    bench_sink(total);
+}
+
+// 注册series个磁盘使用率指标并填满窗口，约1%的指标当前值为离群点
+static int setup_detector(AnomalyDetector *detector, int series) {
+    if (init_detector(detector, DEFAULT_WINDOW_SIZE, DEFAULT_SIGMA_FACTOR) != 0) {
+        return -1;
+    }
+
+    for (int s = 0; s < series; s++) {
+        char instance[32];
+        snprintf(instance, sizeof(instance), "sd%d", s);
+        int id = register_metric(detector, METRIC_DISK_UTIL, instance);
+        if (id < 0) {
+            free_detector(detector);
+            return -1;
+        }
+        Metric *metric = &detector->metrics[id];
+        double base = 20.0 + 40.0 * bench_random();
+        for (int i = 0; i < DEFAULT_WINDOW_SIZE; i++) {
+            add_metric_datapoint(metric, base + 5.0 * bench_random(), (uint64_t)i);
+        }
+        if (bench_random() < 0.01) {
+            add_metric_datapoint(metric, base + 60.0, (uint64_t)DEFAULT_WINDOW_SIZE);
+        }
+    }
+    return 0;
+}
+
+// 让全部指标选用kind检测器，预测模型用当前值附近的几个样本预热（预测检测不保留历史数据）
+static int select_detector(AnomalyDetector *detector, DetectorKind kind) {
+    for (int k = DETECTOR_NSIGMA + 1; k < DETECTOR_COUNT; k++) {
+        if (set_detector_metrics(detector, (DetectorKind)k, k == (int)kind ? "all" : NULL) != 0) {
+            return -1;
+        }
+    }
+    if (kind == DETECTOR_EWMA || kind == DETECTOR_HOLT_WINTERS) {
+        for (int i = 0; i < detector->metric_count; i++) {
+            Metric *metric = &detector->metrics[i];
+            if (!metric->forecast) {
+                continue;
+            }
+            for (int n = 0; n <= FORECAST_WARMUP; n++) {
+                forecast_update(metric->forecast, metric->value + 5.0 * (bench_random() - 0.5),
+                                (uint64_t)n * NSEC_PER_SEC);
+            }
+            forecast_update(metric->forecast, metric->value, (uint64_t)FORECAST_WARMUP * NSEC_PER_SEC);
+        }
+    } else {
+        // 从预测检测切换回来时历史数据为空，在当前值附近重新填满窗口，最后一点仍为当前值
+        for (int i = 0; i < detector->metric_count; i++) {
+            Metric *metric = &detector->metrics[i];
+            if (!metric->history || metric->history_size > 0) {
+                continue;
+            }
+            double value = metric->value;
+            for (int n = 0; n < DEFAULT_WINDOW_SIZE - 1; n++) {
+                add_metric_datapoint(metric, value + 5.0 * (bench_random() - 0.5), (uint64_t)n);
+            }
+            add_metric_datapoint(metric, value, (uint64_t)DEFAULT_WINDOW_SIZE);
+        }
+    }
+    return 0;
+}
+
+// 只运行批量统计内核，不生成异常消息
+static void run_batch_stats(void *ctx, uint64_t iterations) {
+    DetectorBench *b = (DetectorBench *)ctx;
+    int total = 0;
+    for (uint64_t i = 0; i < iterations; i++) {
+        total += stats_columns_detect(&b->detector.columns, b->detector.sigma_factor);
+    }
+    bench_sink(total);
+}
+
+// 按类别生成一个序列：普通值、偏高/偏低离群点、零标准差、样本数不足、NaN和无穷大
+static void fill_compare_lane(StatsColumns *cols, int idx) {
+    double mean = 1000.0 * bench_random() - 100.0;
+    double m2 = 50.0 * bench_random();
+    double n = (double)(STATS_MIN_SAMPLES + (int)(60.0 * bench_random()));
+    double value = mean + 4.0 * (bench_random() - 0.5);
+    switch ((int)(12.0 * bench_random())) {
+    case 0: value = mean + 1e3; break;                  // 偏高
+    case 1: value = mean - 1e3; break;                  // 偏低（下限可能为负）
+    case 2: m2 = 0.0; value = mean; break;              // 零标准差，值等于均值
+    case 3: m2 = 0.0; value = nextafter(mean, INFINITY); break; // 零标准差，刚好越过上限
+    case 4: n = (double)(int)(STATS_MIN_SAMPLES * bench_random()); value = mean + 1e3; break;
+    case 5: value = NAN; break;
+    case 6: mean = NAN; break;
+    case 7: m2 = NAN; break;
+    case 8: n = NAN; value = mean + 1e3; break;
+    case 9: value = INFINITY; break;
+    case 10: m2 = -1e-300; break;                       // 舍入产生的负离差平方和
+    default: break;
+    }
+    stats_columns_set(cols, idx, value, mean, m2, 0);
+    cols->n[idx] = n;
+}
+
+// 各批量统计内核在同一组序列上逐位比较：标准差、上下限、位图和置位数，
+// 序列数取1、向量宽度的非整数倍和跨多个位图字的长度。结果以Go benchmark格式输出，
+// 迭代次数一栏为比较的序列数
+static void check_kernels_identical(void) {
+    static const int counts[] = { 1, 7, 67, 1027 };
+    static const char *kernels[] = { "sse2", "avx2" };
+
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        char names[sizeof(kernels) / sizeof(kernels[0])][64];
+        bool any = false;
+        for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+            snprintf(names[k], sizeof(names[k]), "BatchStatsIdentical/%s/series-%d", kernels[k], counts[c]);
+            any = any || bench_selected(names[k]);
+        }
+        if (!any) {
+            continue;
+        }
+
+        int count = counts[c];
+        StatsColumns cols, expected;
+        if (stats_columns_init(&cols) != 0 || stats_columns_reserve(&cols, count) != 0 ||
+            stats_columns_init(&expected) != 0 || stats_columns_reserve(&expected, count) != 0) {
+            fprintf(stderr, "跳过%d个序列: 无法分配统计列\n", count);
+            stats_columns_free(&cols);
+            stats_columns_free(&expected);
+            continue;
+        }
+        for (int i = 0; i < count; i++) {
+            fill_compare_lane(&cols, i);
+        }
+
+        size_t column_bytes = sizeof(double) * (size_t)count;
+        size_t mask_bytes = sizeof(uint64_t) * (size_t)((count + 63) / 64);
+        stats_kernel_select("scalar");
+        int expected_flagged = stats_columns_detect(&cols, DEFAULT_SIGMA_FACTOR);
+        memcpy(expected.stddev, cols.stddev, column_bytes);
+        memcpy(expected.upper, cols.upper, column_bytes);
+        memcpy(expected.lower, cols.lower, column_bytes);
+        memcpy(expected.high, cols.high, mask_bytes);
+        memcpy(expected.low, cols.low, mask_bytes);
+
+        for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+            if (!bench_selected(names[k]) || stats_kernel_select(kernels[k]) != 0) {
+                continue;
+            }
+            memset(cols.stddev, 0xff, column_bytes);
+            memset(cols.upper, 0xff, column_bytes);
+            memset(cols.lower, 0xff, column_bytes);
+            int flagged = stats_columns_detect(&cols, DEFAULT_SIGMA_FACTOR);
+
+            int mismatched = 0;
+            for (int i = 0; i < count; i++) {
+                uint64_t bit = 1ULL << (i % 64);
+                if (memcmp(&cols.stddev[i], &expected.stddev[i], sizeof(double)) != 0 ||
+                    memcmp(&cols.upper[i], &expected.upper[i], sizeof(double)) != 0 ||
+                    memcmp(&cols.lower[i], &expected.lower[i], sizeof(double)) != 0 ||
+                    (cols.high[i / 64] & bit) != (expected.high[i / 64] & bit) ||
+                    (cols.low[i / 64] & bit) != (expected.low[i / 64] & bit)) {
+                    mismatched++;
+                }
+            }
+            // 尾部填充序列不应被置位
+            bool masks_same = memcmp(cols.high, expected.high, mask_bytes) == 0 &&
+                              memcmp(cols.low, expected.low, mask_bytes) == 0;
+            printf("Benchmark%s\t%10d\t%10d flagged\t%10d mismatched-lanes\n",
+                   names[k], count, flagged, mismatched);
+            if (mismatched > 0 || !masks_same || flagged != expected_flagged) {
+                fprintf(stderr, "错误: %s内核与标量实现不一致: %d个序列不同，置位%d个，应为%d个\n",
+                        kernels[k], mismatched, flagged, expected_flagged);
+            }
+        }
+        stats_kernel_select(NULL);
+        stats_columns_free(&cols);
+        stats_columns_free(&expected);
+    }
+}
+
+void bench_detectors(void) {
+    static const int series_counts[] = { 10, 100, 1000, 10000, 100000 };
+    static const struct {
+        const char *name;
+        int (*detect)(AnomalyDetector *detector);
+        DetectorKind kind;      // 运行前让全部指标选用的检测器
+    } detectors[] = {
+        { "DetectNSigma", detect_anomalies_nsigma, DETECTOR_NSIGMA },
+        { "DetectMAD", detect_anomalies_mad, DETECTOR_MAD },
+        { "DetectEWMA", detect_anomalies_forecast, DETECTOR_EWMA },
+        { "DetectHoltWinters", detect_anomalies_forecast, DETECTOR_HOLT_WINTERS },
+        { "DetectThreshold", detect_anomalies_threshold, DETECTOR_NSIGMA },
+    };
+    const size_t detector_count = sizeof(detectors) / sizeof(detectors[0]);
+    static const char *kernels[] = { "scalar", "sse2", "avx2" }; // 批量统计内核
+
+    check_kernels_identical();
+
+    for (size_t n = 0; n < sizeof(series_counts) / sizeof(series_counts[0]); n++) {
+        char names[sizeof(detectors) / sizeof(detectors[0])][64];
+        char kernel_names[sizeof(kernels) / sizeof(kernels[0])][64];
+        bool any = false;
+        for (size_t d = 0; d < detector_count; d++) {
+            snprintf(names[d], sizeof(names[d]), "%s/series-%d", detectors[d].name, series_counts[n]);
+            any = any || bench_selected(names[d]);
+        }
+        for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+            snprintf(kernel_names[k], sizeof(kernel_names[k]), "BatchStats/%s/series-%d",
+                     kernels[k], series_counts[n]);
+            any = any || bench_selected(kernel_names[k]);
+        }
+        if (!any) {
+            continue;
+        }
+
+        // 所有检测器共用同一组指标，结果可以直接比较
+        static DetectorBench b;
+        if (setup_detector(&b.detector, series_counts[n]) != 0) {
+            fprintf(stderr, "跳过%d个序列: 无法注册指标\n", series_counts[n]);
+            continue;
+        }
+        for (size_t d = 0; d < detector_count; d++) {
+            if (!bench_selected(names[d]) || select_detector(&b.detector, detectors[d].kind) != 0) {
+                continue;
+            }
+            b.detect = detectors[d].detect;
+            bench_run(names[d], run_detector, &b);
+        }
+
+        // 各批量统计内核（CPU不支持的跳过），结束后恢复自动选择
+        if (select_detector(&b.detector, DETECTOR_NSIGMA) == 0) {
+            for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+                if (bench_selected(kernel_names[k]) && stats_kernel_select(kernels[k]) == 0) {
+                    bench_run(kernel_names[k], run_batch_stats, &b);
+                }
+            }
+            stats_kernel_select(NULL);
+        }
+        free_detector(&b.detector);
+    }
+}
@@ -0,0 +1,654 @@
+#include "bench.h"
+#include "../include/proc_snapshot.h"
+#include "../include/metrics_collector.h"
+#include "../include/process_collector.h"
+#include "../include/config.h"
+#include "../include/scheduler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#define PROC_PAGE_SIZE 4096         // seq_file每次read返回的大致上限
+
+/* 夹具规模 */
+typedef struct {
+    const char *name;           // 规模名称
+    int cpus;                   // /proc/stat中的CPU数
+    int irqs;                   // intr行的中断计数个数
+    int disks;                  // /proc/diskstats行数
+    int nets;                   // /proc/net/dev接口数
+} FixtureProfile;
+
+static const FixtureProfile profiles[] = {
+    // 典型服务器：两块NVMe盘及分区、若干loop和dm设备、几个容器接口
+    { "realistic", 16, 300, 20, 8 },
+    // 大型容器宿主机：上千CPU、数千个loop设备和veth接口。夹具是普通文件，一次read
+    // 即返回全部内容，不能发现按页返回的procfs上的截断，由check_read_complete检查
+    { "extreme", 1024, 4096, 4096, 4096 },
+};
+
+static const char meminfo_fixture[] =
+    "MemTotal:       65849044 kB\n"
+    "MemFree:        21184552 kB\n"
+    "MemAvailable:   48511384 kB\n"
+    "Buffers:          918664 kB\n"
+    "Cached:         25473024 kB\n"
+    "SwapCached:            0 kB\n"
+    "Active:         18817896 kB\n"
+    "Inactive:       22179104 kB\n"
+    "Active(anon):   14836212 kB\n"
+    "Inactive(anon):    13360 kB\n"
+    "Active(file):    3981684 kB\n"
+    "Inactive(file): 22165744 kB\n"
+    "Unevictable:       30436 kB\n"
+    "Mlocked:           27516 kB\n"
+    "SwapTotal:       8388604 kB\n"
+    "SwapFree:        8388604 kB\n"
+    "Zswap:                 0 kB\n"
+    "Zswapped:              0 kB\n"
+    "Dirty:              1100 kB\n"
+    "Writeback:             0 kB\n"
+    "AnonPages:      14635448 kB\n"
+    "Mapped:          2206244 kB\n"
+    "Shmem:            231416 kB\n"
+    "KReclaimable:    1453932 kB\n"
+    "Slab:            2208596 kB\n"
+    "SReclaimable:    1453932 kB\n"
+    "SUnreclaim:       754664 kB\n"
+    "KernelStack:       37600 kB\n"
+    "PageTables:       102108 kB\n"
+    "SecPageTables:         0 kB\n"
+    "NFS_Unstable:          0 kB\n"
+    "Bounce:                0 kB\n"
+    "WritebackTmp:          0 kB\n"
+    "CommitLimit:    41313124 kB\n"
+    "Committed_AS:   34811220 kB\n"
+    "VmallocTotal:   34359738367 kB\n"
+    "VmallocUsed:      229104 kB\n"
+    "VmallocChunk:          0 kB\n"
+    "Percpu:            46080 kB\n"
+    "HardwareCorrupted:     0 kB\n"
+    "AnonHugePages:   4401152 kB\n"
+    "ShmemHugePages:        0 kB\n"
+    "ShmemPmdMapped:        0 kB\n"
+    "FileHugePages:         0 kB\n"
+    "FilePmdMapped:         0 kB\n"
+    "HugePages_Total:       0\n"
+    "HugePages_Free:        0\n"
+    "HugePages_Rsvd:        0\n"
+    "HugePages_Surp:        0\n"
+    "Hugepagesize:       2048 kB\n"
+    "Hugetlb:               0 kB\n"
+    "DirectMap4k:     1069980 kB\n"
+    "DirectMap2M:    37613568 kB\n"
+    "DirectMap1G:    28311552 kB\n";
+
+// 随机计数器，位数与长时间运行的主机相近
+static unsigned long long counter(unsigned long long scale) {
+    return (unsigned long long)(bench_random() * (double)scale);
+}
+
+static void write_stat(FILE *f, const FixtureProfile *profile) {
+    fprintf(f, "cpu  %llu %llu %llu %llu %llu %llu %llu %llu 0 0\n",
+            counter(1ULL << 40), counter(1ULL << 30), counter(1ULL << 38), counter(1ULL << 42),
+            counter(1ULL << 34), counter(1ULL << 24), counter(1ULL << 32), counter(1ULL << 20));
+    for (int i = 0; i < profile->cpus; i++) {
+        fprintf(f, "cpu%d %llu %llu %llu %llu %llu %llu %llu %llu 0 0\n", i,
+                counter(1ULL << 32), counter(1ULL << 22), counter(1ULL << 30), counter(1ULL << 34),
+                counter(1ULL << 26), counter(1ULL << 16), counter(1ULL << 24), counter(1ULL << 12));
+    }
+    fprintf(f, "intr %llu", counter(1ULL << 40));
+    for (int i = 0; i < profile->irqs; i++) {
+        fprintf(f, " %llu", i % 4 == 0 ? counter(1ULL << 32) : 0ULL);
+    }
+    fprintf(f, "\nctxt %llu\nbtime 1760000000\nprocesses %llu\n"
+            "procs_running 3\nprocs_blocked 0\nsoftirq %llu 0 %llu %llu %llu %llu 0 %llu %llu 0 %llu\n",
+            counter(1ULL << 42), counter(1ULL << 28), counter(1ULL << 36), counter(1ULL << 34),
+            counter(1ULL << 30), counter(1ULL << 30), counter(1ULL << 30), counter(1ULL << 34),
+            counter(1ULL << 20), counter(1ULL << 34));
+}
+
+static void write_diskstats(FILE *f, const FixtureProfile *profile) {
+    for (int i = 0; i < profile->disks; i++) {
+        char name[PROC_NAME_LEN];
+        int major, minor;
+        if (i < 8) {
+            // 两块NVMe盘，各带三个分区
+            major = 259;
+            minor = i;
+            if (i % 4 == 0) {
+                snprintf(name, sizeof(name), "nvme%dn1", i / 4);
+            } else {
+                snprintf(name, sizeof(name), "nvme%dn1p%d", i / 4, i % 4);
+            }
+        } else if (i % 8 == 7) {
+            major = 253;
+            minor = i / 8;
+            snprintf(name, sizeof(name), "dm-%d", i / 8);
+        } else {
+            major = 7;
+            minor = i;
+            snprintf(name, sizeof(name), "loop%d", i - 8);
+        }
+        fprintf(f, "%4d %7d %s %llu %llu %llu %llu %llu %llu %llu %llu 0 %llu %llu 0 0 0 0 %llu %llu\n",
+                major, minor, name,
+                counter(1ULL << 30), counter(1ULL << 24), counter(1ULL << 36), counter(1ULL << 30),
+                counter(1ULL << 32), counter(1ULL << 26), counter(1ULL << 38), counter(1ULL << 32),
+                counter(1ULL << 32), counter(1ULL << 34), counter(1ULL << 24), counter(1ULL << 28));
+    }
+}
+
+static void write_netdev(FILE *f, const FixtureProfile *profile) {
+    fprintf(f, "Inter-|   Receive                                                |  Transmit\n");
+    fprintf(f, " face |bytes    packets errs drop fifo frame compressed multicast|"
+               "bytes    packets errs drop fifo colls carrier compressed\n");
+    for (int i = 0; i < profile->nets; i++) {
+        char name[PROC_NAME_LEN];
+        if (i == 0) {
+            snprintf(name, sizeof(name), "lo");
+        } else if (i == 1) {
+            snprintf(name, sizeof(name), "eth0");
+        } else if (i == 2) {
+            snprintf(name, sizeof(name), "docker0");
+        } else {
+            snprintf(name, sizeof(name), "veth%08x", (unsigned)(bench_random() * 4294967295.0));
+        }
+        fprintf(f, "%*s: %llu %llu %llu %llu 0 0 0 %llu %llu %llu %llu %llu 0 0 0 0\n",
+                (int)(strlen(name) < 6 ? 6 : strlen(name)), name,
+                counter(1ULL << 44), counter(1ULL << 34), counter(1ULL << 8), counter(1ULL << 16),
+                counter(1ULL << 20), counter(1ULL << 44), counter(1ULL << 34),
+                counter(1ULL << 8), counter(1ULL << 16));
+    }
+}
+
+// 在dir下创建只含一个数据源文件的procfs根目录，返回0表示成功
+static int write_fixture(const char *dir, const char *file, const FixtureProfile *profile,
+                         void (*writer)(FILE *, const FixtureProfile *)) {
+    char path[512];
+    if (mkdir(dir, 0755) != 0) {
+        return -1;
+    }
+    if (strcmp(file, "net/dev") == 0) {
+        snprintf(path, sizeof(path), "%s/net", dir);
+        if (mkdir(path, 0755) != 0) {
+            return -1;
+        }
+    }
+
+    snprintf(path, sizeof(path), "%s/%s", dir, file);
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        return -1;
+    }
+    if (writer) {
+        writer(f, profile);
+    } else {
+        fputs(meminfo_fixture, f);
+    }
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+static void remove_fixture(const char *dir, const char *file) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", dir, file);
+    unlink(path);
+    if (strcmp(file, "net/dev") == 0) {
+        snprintf(path, sizeof(path), "%s/net", dir);
+        rmdir(path);
+    }
+    rmdir(dir);
+}
+
+// 用read逐次读到文件结束，作为读取完整性的参照；返回读到的字节数，失败返回-1
+static ssize_t read_reference(const char *path, char **out) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    size_t capacity = 1 << 16, length = 0;
+    char *buf = (char *)malloc(capacity);
+    for (;;) {
+        if (!buf) {
+            close(fd);
+            return -1;
+        }
+        if (length == capacity) {
+            capacity *= 2;
+            char *new_buf = (char *)realloc(buf, capacity);
+            if (!new_buf) {
+                free(buf);
+            }
+            buf = new_buf;
+            continue;
+        }
+        ssize_t n = read(fd, buf + length, capacity - length);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        length += (size_t)n;
+    }
+    close(fd);
+    *out = buf;
+    return (ssize_t)length;
+}
+
+static size_t count_lines(const char *buf, size_t length) {
+    size_t lines = 0;
+    for (size_t i = 0; i < length; i++) {
+        lines += buf[i] == '\n';
+    }
+    return lines;
+}
+
+// 读取完整性检查：procfs的seq_file每次read最多返回约一页，夹具中的普通文件
+// 一次即可读完，发现不了短读截断。这里把真实的、大于一页且内容稳定的procfs
+// 文件链接为夹具中的meminfo（解析器按键匹配，解析失败不影响读取），用快照读取
+// 后与逐次read到文件结束的结果比较，确认每一行都被读到；第一次读取同时经过
+// 缓冲区扩容后从头重读的路径。结果以Go benchmark格式输出，迭代次数一栏为行数
+static void check_read_complete(const char *base) {
+    static const char *const candidates[] = { "/proc/kallsyms", "/proc/slabinfo", "/proc/zoneinfo" };
+    if (!bench_selected("ProcReadComplete")) {
+        return;
+    }
+
+    for (size_t c = 0; c < sizeof(candidates) / sizeof(candidates[0]); c++) {
+        char *expected = NULL, *again = NULL;
+        ssize_t length = read_reference(candidates[c], &expected);
+        ssize_t again_length = length > 0 ? read_reference(candidates[c], &again) : -1;
+        bool stable = length > PROC_PAGE_SIZE && again_length == length &&
+                      memcmp(expected, again, (size_t)length) == 0;
+        free(again);
+        if (!stable) {
+            free(expected);
+            continue;
+        }
+
+        char dir[256], link[512];
+        snprintf(dir, sizeof(dir), "%s/read-complete", base);
+        snprintf(link, sizeof(link), "%s/meminfo", dir);
+        ProcSnapshot snap;
+        if (mkdir(dir, 0755) != 0 || symlink(candidates[c], link) != 0 ||
+            proc_snapshot_init(&snap, dir) != 0) {
+            fprintf(stderr, "跳过 ProcReadComplete: 无法创建夹具\n");
+            free(expected);
+            unlink(link);
+            rmdir(dir);
+            return;
+        }
+
+        const char *file = strrchr(candidates[c], '/') + 1;
+        size_t expected_lines = count_lines(expected, (size_t)length);
+        for (int pass = 0; pass < 2; pass++) {
+            proc_snapshot_read(&snap, PROC_SRC_MEMINFO);
+            const ProcSource *src = &snap.sources[PROC_SRC_MEMINFO];
+            size_t lines = count_lines(src->buf, src->length);
+            bool same = src->length == (size_t)length && memcmp(src->buf, expected, src->length) == 0;
+            printf("BenchmarkProcReadComplete/%s/pass-%d\t%10zu\t%14zu bytes\t%10zu missing-lines\n",
+                   file, pass, lines, src->length, expected_lines > lines ? expected_lines - lines : 0);
+            if (!same) {
+                fprintf(stderr, "错误: 读取%s不完整: %zu字节%zu行，应为%zd字节%zu行\n",
+                        candidates[c], src->length, lines, length, expected_lines);
+            }
+        }
+        proc_snapshot_free(&snap);
+        free(expected);
+        unlink(link);
+        rmdir(dir);
+        return;
+    }
+    fprintf(stderr, "跳过 ProcReadComplete: 没有可读的、大于一页且内容稳定的procfs文件\n");
+}
+
+/* 解析用例上下文 */
+typedef struct {
+    ProcSnapshot snap;
+    CounterSet cpu;             // 聚合CPU的计数器组
+    CounterSet *disk_state;     // 每个设备的计数器组
+    int disk_state_count;
+    CounterSet *net_state;      // 每个接口的计数器组
+    int net_state_count;
+} ProcBench;
+
+// 读取并解析/proc/stat，计算三个CPU指标
+static void run_stat(void *ctx, uint64_t iterations) {
+    ProcBench *b = (ProcBench *)ctx;
+    double value, total = 0.0;
+    for (uint64_t i = 0; i < iterations; i++) {
+        proc_snapshot_refresh(&b->snap);
+        CounterDelta delta;
+        if (cpu_counters_update(&b->cpu, &b->snap.cpu, b->snap.timestamp_ns, &delta) != 0) {
+            continue;
+        }
+        if (read_cpu_usage(&delta, &value) == 0) {
+            total += value;
+        }
+        if (read_cpu_iowait(&delta, &value) == 0) {
+            total += value;
+        }
+        if (read_cpu_irq(&delta, &value) == 0) {
+            total += value;
+        }
+    }
+    bench_sink(total);
+}
+
+// 读取并解析/proc/meminfo，计算两个内存指标
+static void run_meminfo(void *ctx, uint64_t iterations) {
+    ProcBench *b = (ProcBench *)ctx;
+    double value, total = 0.0;
+    for (uint64_t i = 0; i < iterations; i++) {
+        proc_snapshot_refresh(&b->snap);
+        if (read_mem_usage(&b->snap, &value) == 0) {
+            total += value;
+        }
+        if (read_mem_active(&b->snap, &value) == 0) {
+            total += value;
+        }
+    }
+    bench_sink(total);
+}
+
+// 读取并解析/proc/diskstats，计算每个设备的三个磁盘指标
+static void run_diskstats(void *ctx, uint64_t iterations) {
+    ProcBench *b = (ProcBench *)ctx;
+    double value, total = 0.0;
+    for (uint64_t i = 0; i < iterations; i++) {
+        proc_snapshot_refresh(&b->snap);
+        int count = b->snap.disk_count < b->disk_state_count ? b->snap.disk_count : b->disk_state_count;
+        for (int d = 0; d < count; d++) {
+            CounterDelta delta;
+            if (disk_counters_update(&b->disk_state[d], &b->snap.disks[d], b->snap.timestamp_ns, &delta) != 0) {
+                continue;
+            }
+            if (read_disk_read_await(&delta, &value) == 0) {
+                total += value;
+            }
+            if (read_disk_write_await(&delta, &value) == 0) {
+                total += value;
+            }
+            if (read_disk_util(&delta, &value) == 0) {
+                total += value;
+            }
+        }
+    }
+    bench_sink(total);
+}
+
+// 扫描/proc/net/dev，计算每个接口的丢包速率
+static void run_netdev(void *ctx, uint64_t iterations) {
+    ProcBench *b = (ProcBench *)ctx;
+    double value, total = 0.0;
+    for (uint64_t i = 0; i < iterations; i++) {
+        proc_snapshot_refresh(&b->snap);
+        int count = b->snap.net_count < b->net_state_count ? b->snap.net_count : b->net_state_count;
+        for (int n = 0; n < count; n++) {
+            CounterDelta delta;
+            if (net_counters_update(&b->net_state[n], &b->snap.nets[n], b->snap.timestamp_ns, &delta) == 0 &&
+                read_net_dropped(&delta, &value) == 0) {
+                total += value;
+            }
+        }
+    }
+    bench_sink(total);
+}
+
+// 读取并解析全部数据源
+static void run_snapshot(void *ctx, uint64_t iterations) {
+    ProcBench *b = (ProcBench *)ctx;
+    for (uint64_t i = 0; i < iterations; i++) {
+        proc_snapshot_refresh(&b->snap);
+    }
+    bench_sink((double)b->snap.valid);
+}
+
+// 以root为procfs根目录运行一个用例
+static void run_on_root(const char *name, const char *root, BenchFunc fn, int disks, int nets) {
+    ProcBench b;
+    memset(&b, 0, sizeof(b));
+    if (proc_snapshot_init(&b.snap, root) != 0) {
+        fprintf(stderr, "跳过 %s: 无法打开 %s\n", name, root);
+        return;
+    }
+    if (disks > 0) {
+        b.disk_state = (CounterSet *)calloc(disks, sizeof(CounterSet));
+        b.disk_state_count = b.disk_state ? disks : 0;
+    }
+    if (nets > 0) {
+        b.net_state = (CounterSet *)calloc(nets, sizeof(CounterSet));
+        b.net_state_count = b.net_state ? nets : 0;
+    }
+
+    // 先刷新一次，让缓冲区和数组增长到稳定大小
+    proc_snapshot_refresh(&b.snap);
+    bench_run(name, fn, &b);
+
+    free(b.disk_state);
+    free(b.net_state);
+    proc_snapshot_free(&b.snap);
+}
+
+/* 进程采集用例上下文 */
+typedef struct {
+    ProcessCollector pc;
+    ProcessTop top;
+    bool read_all;              // 每次都读取全部进程（不跳过空闲进程）
+    uint64_t now_ns;
+} ProcessBench;
+
+// 采集一个周期：扫描目录、读取到期的进程、维护排行
+static void run_processes(void *ctx, uint64_t iterations) {
+    ProcessBench *b = (ProcessBench *)ctx;
+    for (uint64_t i = 0; i < iterations; i++) {
+        if (b->read_all) {
+            for (unsigned long s = 0; s <= b->pc.mask; s++) {
+                b->pc.entries[s].next_cycle = 0;
+            }
+        }
+        b->now_ns += NSEC_PER_SEC;
+        process_collector_refresh(&b->pc, b->now_ns, &b->top);
+    }
+    bench_sink((double)b->top.process_count);
+}
+
+// 在dir下创建count个进程的stat和statm
+static int write_process_fixture(const char *dir, int count) {
+    if (mkdir(dir, 0755) != 0) {
+        return -1;
+    }
+    for (int pid = 1; pid <= count; pid++) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%d", dir, pid);
+        if (mkdir(path, 0755) != 0) {
+            return -1;
+        }
+        snprintf(path, sizeof(path), "%s/%d/stat", dir, pid);
+        FILE *f = fopen(path, "w");
+        if (!f) {
+            return -1;
+        }
+        fprintf(f, "%d (worker-%d) S 1 %d %d 0 -1 4194560 %llu 0 %llu 0 %llu %llu 0 0 20 0 4 0 %llu "
+                "%llu %llu 18446744073709551615 1 1 0 0 0 0 0 4096 0 0 0 0 17 3 0 0 0 0 0\n",
+                pid, pid % 1000, pid, pid, counter(1ULL << 20), counter(1ULL << 10),
+                counter(1ULL << 24), counter(1ULL << 22), counter(1ULL << 30),
+                counter(1ULL << 32), counter(1ULL << 16));
+        fclose(f);
+        snprintf(path, sizeof(path), "%s/%d/statm", dir, pid);
+        f = fopen(path, "w");
+        if (!f) {
+            return -1;
+        }
+        fprintf(f, "%llu %llu %llu 100 0 %llu 0\n", counter(1ULL << 20), counter(1ULL << 16),
+                counter(1ULL << 12), counter(1ULL << 18));
+        fclose(f);
+    }
+    return 0;
+}
+
+static void remove_process_fixture(const char *dir, int count) {
+    for (int pid = 1; pid <= count; pid++) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%d/stat", dir, pid);
+        unlink(path);
+        snprintf(path, sizeof(path), "%s/%d/statm", dir, pid);
+        unlink(path);
+        snprintf(path, sizeof(path), "%s/%d", dir, pid);
+        rmdir(path);
+    }
+    rmdir(dir);
+}
+
+// 进程采集：稳定状态下空闲进程降低读取频率；all-read为每个周期读取全部进程的上限。
+// 文件描述符超过RLIMIT_NOFILE预算的进程每次重新打开
+static void bench_processes(const char *base, const char *proc_root) {
+    static const int counts[] = { 1000, 50000 };
+    static ProcessBench b;
+
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        char steady_name[128], all_name[128];
+        snprintf(steady_name, sizeof(steady_name), "ProcessCollect/processes-%d", counts[c]);
+        snprintf(all_name, sizeof(all_name), "ProcessCollect/all-read/processes-%d", counts[c]);
+        if (!bench_selected(steady_name) && !bench_selected(all_name)) {
+            continue;
+        }
+
+        char dir[256];
+        snprintf(dir, sizeof(dir), "%s/processes-%d", base, counts[c]);
+        if (write_process_fixture(dir, counts[c]) == 0 &&
+            process_collector_init(&b.pc, dir, PROCESS_TOP_K) == 0) {
+            // 先采集一轮并让空闲进程进入最低读取频率
+            for (int i = 0; i < 2 * PROCESS_IDLE_MAX_SKIP; i++) {
+                b.now_ns += NSEC_PER_SEC;
+                process_collector_refresh(&b.pc, b.now_ns, &b.top);
+            }
+            b.read_all = false;
+            bench_run(steady_name, run_processes, &b);
+            b.read_all = true;
+            bench_run(all_name, run_processes, &b);
+            process_collector_free(&b.pc);
+        } else {
+            fprintf(stderr, "跳过 %s: 无法写入夹具\n", steady_name);
+        }
+        remove_process_fixture(dir, counts[c]);
+    }
+
+    if (proc_root && bench_selected("ProcessCollect/custom") &&
+        process_collector_init(&b.pc, proc_root, PROCESS_TOP_K) == 0) {
+        b.read_all = false;
+        bench_run("ProcessCollect/custom", run_processes, &b);
+        process_collector_free(&b.pc);
+    }
+}
+
+/* 完整采集周期用例上下文 */
+typedef struct {
+    MetricsCollector *collector;
+    SampleBatch batch;
+} CollectBench;
+
+// 采集一个完整周期：读取全部数据源、扫描进程并推导指标
+static void run_collect(void *ctx, uint64_t iterations) {
+    CollectBench *b = (CollectBench *)ctx;
+    for (uint64_t i = 0; i < iterations; i++) {
+        sample_batch_reset(&b->batch);
+        collect_samples(b->collector, &b->batch, NULL);
+    }
+    bench_sink((double)b->batch.sample_count);
+}
+
+// 完整采集周期：workers-0在调用线程中依次读取，其余把数据源分给工作线程并行读取
+static void bench_collect(const char *proc_root) {
+    static const int workers[] = { 0, 2, 4 };
+
+    for (size_t w = 0; w < sizeof(workers) / sizeof(workers[0]); w++) {
+        char name[128];
+        snprintf(name, sizeof(name), "CollectCycle/workers-%d", workers[w]);
+        if (!bench_selected(name)) {
+            continue;
+        }
+
+        CollectorConfig config;
+        metrics_collector_default_config(&config);
+        config.proc_root = proc_root;
+        config.workers = workers[w];
+        config.source_timeout_ns = 0;
+        CollectBench b;
+        b.collector = metrics_collector_create(&config);
+        if (!b.collector) {
+            fprintf(stderr, "跳过 %s: 无法创建收集器\n", name);
+            continue;
+        }
+        sample_batch_init(&b.batch);
+        collect_samples(b.collector, &b.batch, NULL);
+        bench_run(name, run_collect, &b);
+        sample_batch_free(&b.batch);
+        metrics_collector_free(b.collector);
+    }
+}
+
+void bench_proc(const char *proc_root) {
+    static const struct {
+        const char *bench;
+        const char *file;
+        void (*writer)(FILE *, const FixtureProfile *);
+        BenchFunc fn;
+    } sources[] = {
+        { "ProcStat", "stat", write_stat, run_stat },
+        { "ProcMeminfo", "meminfo", NULL, run_meminfo },
+        { "ProcDiskstats", "diskstats", write_diskstats, run_diskstats },
+        { "ProcNetDev", "net/dev", write_netdev, run_netdev },
+    };
+
+    char base[] = "/tmp/anomaly_bench_XXXXXX";
+    if (!mkdtemp(base)) {
+        fprintf(stderr, "跳过/proc解析用例: 无法创建夹具目录\n");
+        return;
+    }
+
+    check_read_complete(base);
+
+    for (size_t p = 0; p < sizeof(profiles) / sizeof(profiles[0]); p++) {
+        const FixtureProfile *profile = &profiles[p];
+        for (size_t s = 0; s < sizeof(sources) / sizeof(sources[0]); s++) {
+            // meminfo的长度与主机规模无关，只测典型规模
+            if (!sources[s].writer && p > 0) {
+                continue;
+            }
+
+            int entries = sources[s].fn == run_stat ? profile->cpus
+                        : sources[s].fn == run_diskstats ? profile->disks
+                        : sources[s].fn == run_netdev ? profile->nets : 0;
+            char name[128];
+            if (entries > 0) {
+                snprintf(name, sizeof(name), "%s/%s-%d", sources[s].bench, profile->name, entries);
+            } else {
+                snprintf(name, sizeof(name), "%s/%s", sources[s].bench, profile->name);
+            }
+            if (!bench_selected(name)) {
+                continue;
+            }
+
+            char dir[256];
+            snprintf(dir, sizeof(dir), "%s/%s-%zu", base, profile->name, s);
+            if (write_fixture(dir, sources[s].file, profile, sources[s].writer) == 0) {
+                run_on_root(name, dir, sources[s].fn, profile->disks, profile->nets);
+            } else {
+                fprintf(stderr, "跳过 %s: 无法写入夹具\n", name);
+            }
+            remove_fixture(dir, sources[s].file);
+        }
+    }
+    bench_processes(base, proc_root);
+    rmdir(base);
+
+    if (proc_root) {
+        run_on_root("ProcSnapshot/custom", proc_root, run_snapshot, 0, 0);
+    }
+    bench_collect(proc_root);
+}
@@ -0,0 +1,335 @@
+#include "bench.h"
+#include "../include/anomaly_detection.h"
+#include "../include/config.h"
+#include "../include/latency.h"
+#include "../include/scheduler.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+/* 窗口用例上下文 */
+typedef struct {
+    AnomalyDetector detector;
+    Metric *metric;
+    double values[1024];        // 循环写入的样本，避免在计时循环中生成随机数
+} StatsBench;
+
+// 写入一个数据点：环形缓冲区替换、增量统计更新和定期重新锚定
+static void run_add_datapoint(void *ctx, uint64_t iterations) {
+    StatsBench *b = (StatsBench *)ctx;
+    for (uint64_t i = 0; i < iterations; i++) {
+        add_metric_datapoint(b->metric, b->values[i & 1023], i);
+    }
+    bench_sink(b->metric->mean);
+}
+
+// 只从累加器重新计算均值和标准差
+static void run_update_stats(void *ctx, uint64_t iterations) {
+    StatsBench *b = (StatsBench *)ctx;
+    double total = 0.0;
+    for (uint64_t i = 0; i < iterations; i++) {
+        update_metric_stats(b->metric);
+        total += b->metric->stddev;
+    }
+    bench_sink(total);
+}
+
+// 从顺序统计计算中位数和MAD，即MAD检测每个指标每周期的开销
+static void run_median_mad(void *ctx, uint64_t iterations) {
+    StatsBench *b = (StatsBench *)ctx;
+    double total = 0.0;
+    for (uint64_t i = 0; i < iterations; i++) {
+        double median = order_stats_median(b->metric->order);
+        total += order_stats_mad(b->metric->order, median);
+    }
+    bench_sink(total);
+}
+
+#define STATS_CHECK_EPS 8.0         // 增量统计误差的容差，单位见bench_stats_error
+
+// 两遍算法（long double累加）计算当前窗口的均值和标准差，作为增量统计的参照
+static void two_pass_stats(const Metric *metric, double *mean, double *stddev) {
+    long double sum = 0.0L;
+    for (int i = 0; i < metric->history_size; i++) {
+        sum += metric_history_at(metric, i);
+    }
+    long double m = sum / metric->history_size;
+    long double m2 = 0.0L;
+    for (int i = 0; i < metric->history_size; i++) {
+        long double d = metric_history_at(metric, i) - m;
+        m2 += d * d;
+    }
+    *mean = (double)m;
+    *stddev = (double)sqrtl(m2 / metric->history_size);
+}
+
+// 增量统计（Welford滑动替换和重新锚定）与两遍算法的误差：写入四个窗口的样本，
+// 每写入1/16个窗口比较一次，以Go benchmark格式输出最大相对误差（迭代次数一栏为
+// 比较次数）。误差与数据有关：均值的相对误差随 ε·√n 增长，标准差的相对误差随
+// ε·(√n + |均值|/标准差) 增长（ε为机器精度，n为窗口大小），同时输出折合成这两个
+// 单位的倍数，超过STATS_CHECK_EPS时报错
+static void bench_stats_error(void) {
+    static const int windows[] = { 60, 1000, 86400 };
+    static const struct {
+        const char *name;
+        double offset;
+        double spread;
+    } profiles[] = {
+        { "centered", 50.0, 10.0 },     // 百分比类指标
+        { "offset", 1e9, 10.0 },        // 大偏移、小波动，如累计字节数
+        { "narrow", 1000.0, 1e-3 },     // 几乎恒定
+    };
+
+    for (size_t w = 0; w < sizeof(windows) / sizeof(windows[0]); w++) {
+        for (size_t p = 0; p < sizeof(profiles) / sizeof(profiles[0]); p++) {
+            char name[64];
+            snprintf(name, sizeof(name), "StatsError/%s/window-%d", profiles[p].name, windows[w]);
+            if (!bench_selected(name)) {
+                continue;
+            }
+
+            static StatsBench b;
+            if (init_detector(&b.detector, windows[w], DEFAULT_SIGMA_FACTOR) != 0) {
+                continue;
+            }
+            int id = register_metric(&b.detector, METRIC_CPU_USAGE, NULL);
+            if (id < 0) {
+                free_detector(&b.detector);
+                continue;
+            }
+            b.metric = &b.detector.metrics[id];
+
+            int step = windows[w] / 16 > 0 ? windows[w] / 16 : 1;
+            int checks = 0;
+            double mean_error = 0.0, stddev_error = 0.0, mean_eps = 0.0, stddev_eps = 0.0;
+            double root_n = sqrt((double)windows[w]);
+            for (int i = 0; i < windows[w] * 4; i++) {
+                double value = profiles[p].offset + profiles[p].spread * bench_random();
+                add_metric_datapoint(b.metric, value, (uint64_t)i);
+                if (i < STATS_MIN_SAMPLES || (i + 1) % step != 0) {
+                    continue;
+                }
+
+                double mean, stddev;
+                two_pass_stats(b.metric, &mean, &stddev);
+                double me = fabs(b.metric->mean - mean) / fabs(mean);
+                double se = stddev > 0 ? fabs(b.metric->stddev - stddev) / stddev : 0.0;
+                mean_error = fmax(mean_error, me);
+                stddev_error = fmax(stddev_error, se);
+                mean_eps = fmax(mean_eps, me / (DBL_EPSILON * root_n));
+                if (stddev > 0) {
+                    stddev_eps = fmax(stddev_eps, se / (DBL_EPSILON * (root_n + fabs(mean) / stddev)));
+                }
+                checks++;
+            }
+            printf("Benchmark%s\t%10d\t%14.2e mean-rel-err\t%14.2e stddev-rel-err\t"
+                   "%8.3f mean-eps\t%8.3f stddev-eps\n",
+                   name, checks, mean_error, stddev_error, mean_eps, stddev_eps);
+            if (!(mean_eps < STATS_CHECK_EPS && stddev_eps < STATS_CHECK_EPS)) {
+                fprintf(stderr, "错误: %s 增量统计误差超过容差（均值%.2f倍、标准差%.2f倍，容差%.0f倍）\n",
+                        name, mean_eps, stddev_eps, STATS_CHECK_EPS);
+            }
+            free_detector(&b.detector);
+        }
+    }
+}
+
+/* 预测模型用例上下文 */
+typedef struct {
+    Forecast *forecast;
+    double values[1024];
+} ForecastBench;
+
+// 并入一个样本，样本间隔1秒，Holt-Winters随之遍历各季节桶
+static void run_forecast_update(void *ctx, uint64_t iterations) {
+    ForecastBench *b = (ForecastBench *)ctx;
+    for (uint64_t i = 0; i < iterations; i++) {
+        forecast_update(b->forecast, b->values[i & 1023], i * 1000000000ULL);
+    }
+    bench_sink(b->forecast->level);
+}
+
+// 预测模型的更新与窗口大小无关，只测一次
+static void bench_forecast(void) {
+    static const struct {
+        const char *name;
+        ForecastKind kind;
+    } models[] = {
+        { "ForecastUpdate/ewma", FORECAST_EWMA },
+        { "ForecastUpdate/holt-winters", FORECAST_HOLT_WINTERS },
+    };
+
+    AnomalyDetector detector;
+    if (init_detector(&detector, DEFAULT_WINDOW_SIZE, DEFAULT_SIGMA_FACTOR) != 0) {
+        return;
+    }
+    for (size_t m = 0; m < sizeof(models) / sizeof(models[0]); m++) {
+        ForecastBench b;
+        b.forecast = forecast_create(models[m].kind, &detector.forecast_params, 0);
+        if (!b.forecast) {
+            continue;
+        }
+        for (int i = 0; i < 1024; i++) {
+            b.values[i] = 50.0 + 10.0 * bench_random();
+        }
+        bench_run(models[m].name, run_forecast_update, &b);
+        free(b.forecast);
+    }
+    free_detector(&detector);
+}
+
+#define CORRELATION_CHECK_TOLERANCE 1e-6    // 秩一更新的逆矩阵允许的最大相对误差
+
+/* 多维相关模型用例上下文 */
+typedef struct {
+    CorrelationModel model;
+    double values[1024][16];    // 循环写入的样本向量，各维与第0维相关
+} CorrelationBench;
+
+// 评分并并入一个样本向量，即多维相关检测每组每周期的开销（含摊还的定期重新求逆）
+static void run_correlation_update(void *ctx, uint64_t iterations) {
+    CorrelationBench *b = (CorrelationBench *)ctx;
+    double total = 0.0;
+    for (uint64_t i = 0; i < iterations; i++) {
+        total += correlation_score(&b->model, b->values[i & 1023], NULL);
+        correlation_update(&b->model, b->values[i & 1023]);
+    }
+    bench_sink(total);
+}
+
+// 由窗口重新求逆，即每滑过一个窗口摊还的开销
+static void run_correlation_rebuild(void *ctx, uint64_t iterations) {
+    CorrelationBench *b = (CorrelationBench *)ctx;
+    for (uint64_t i = 0; i < iterations; i++) {
+        correlation_rebuild(&b->model, true);
+    }
+    bench_sink(b->model.inverse[0]);
+}
+
+// 比较秩一更新得到的逆矩阵与由同一窗口、同一正则项Cholesky重新求逆的结果，返回最大
+// 相对误差（以重新求逆结果中绝对值最大的元素为尺度）；之后模型处于重新求逆后的状态
+static double correlation_inverse_error(CorrelationModel *model) {
+    int k = model->dims;
+    double updated[16 * 16];
+    memcpy(updated, model->inverse, sizeof(double) * k * k);
+    correlation_rebuild(model, false);
+
+    double scale = 0.0, error = 0.0;
+    for (int i = 0; i < k * k; i++) {
+        scale = fmax(scale, fabs(model->inverse[i]));
+        error = fmax(error, fabs(updated[i] - model->inverse[i]));
+    }
+    return scale > 0 ? error / scale : error;
+}
+
+// 多维相关模型的开销只取决于维数，窗口取默认大小
+static void bench_correlation(void) {
+    static const int dims[] = { 2, 4, 8, 16 };
+
+    for (size_t d = 0; d < sizeof(dims) / sizeof(dims[0]); d++) {
+        char name[64], rebuild_name[64], error_name[64];
+        snprintf(name, sizeof(name), "CorrelationUpdate/dims-%d", dims[d]);
+        snprintf(rebuild_name, sizeof(rebuild_name), "CorrelationRebuild/dims-%d", dims[d]);
+        snprintf(error_name, sizeof(error_name), "CorrelationInverseError/dims-%d", dims[d]);
+        if (!bench_selected(name) && !bench_selected(rebuild_name) && !bench_selected(error_name)) {
+            continue;
+        }
+
+        static CorrelationBench b;
+        if (correlation_init(&b.model, dims[d], DEFAULT_WINDOW_SIZE) != 0) {
+            continue;
+        }
+        for (int i = 0; i < 1024; i++) {
+            double common = bench_random();
+            for (int k = 0; k < dims[d]; k++) {
+                b.values[i][k] = 10.0 * (k + 1) * common + bench_random();
+            }
+        }
+        // 先填满窗口，测量稳定状态下的开销
+        for (int i = 0; i < DEFAULT_WINDOW_SIZE; i++) {
+            correlation_update(&b.model, b.values[i & 1023]);
+        }
+        bench_run(name, run_correlation_update, &b);
+
+        // 秩一更新积累到大半个窗口（下一次定期重新求逆之前）时检查逆矩阵的误差，
+        // 以Go benchmark格式输出，迭代次数一栏为上次重新求逆后的更新次数
+        if (bench_selected(error_name)) {
+            for (int i = 0; i < DEFAULT_WINDOW_SIZE && b.model.updates < DEFAULT_WINDOW_SIZE * 3 / 4; i++) {
+                correlation_update(&b.model, b.values[(int)(bench_random() * 1024)]);
+            }
+            int updates = b.model.updates;
+            double error = correlation_inverse_error(&b.model);
+            printf("Benchmark%s\t%10d\t%14.2e max-rel-err\n", error_name, updates, error);
+            if (!(error < CORRELATION_CHECK_TOLERANCE)) {
+                fprintf(stderr, "错误: %s 秩一更新的逆矩阵与重新求逆相差%.2e，超过容差%.0e\n",
+                        error_name, error, CORRELATION_CHECK_TOLERANCE);
+            }
+        }
+        bench_run(rebuild_name, run_correlation_rebuild, &b);
+        correlation_free(&b.model);
+    }
+}
+
+// 记录一次阶段耗时（读时钟并更新直方图），即常开的插桩在每个阶段的开销
+static void run_latency_record(void *ctx, uint64_t iterations) {
+    (void)ctx;
+    uint64_t start_ns = monotonic_ns();
+    for (uint64_t i = 0; i < iterations; i++) {
+        start_ns = latency_record(LATENCY_APPLY, start_ns);
+    }
+    bench_sink((double)start_ns);
+}
+
+void bench_stats(void) {
+    static const int windows[] = { 60, 1000, 10000, 100000, 1000000 };
+
+    for (size_t w = 0; w < sizeof(windows) / sizeof(windows[0]); w++) {
+        char add_name[64], update_name[64], add_mad_name[64], median_name[64];
+        snprintf(add_name, sizeof(add_name), "AddMetricDatapoint/window-%d", windows[w]);
+        snprintf(update_name, sizeof(update_name), "UpdateMetricStats/window-%d", windows[w]);
+        snprintf(add_mad_name, sizeof(add_mad_name), "AddMetricDatapointMAD/window-%d", windows[w]);
+        snprintf(median_name, sizeof(median_name), "MedianMAD/window-%d", windows[w]);
+        if (!bench_selected(add_name) && !bench_selected(update_name) &&
+            !bench_selected(add_mad_name) && !bench_selected(median_name)) {
+            continue;
+        }
+
+        static StatsBench b;
+        if (init_detector(&b.detector, windows[w], DEFAULT_SIGMA_FACTOR) != 0) {
+            fprintf(stderr, "跳过窗口%d: 无法初始化检测器\n", windows[w]);
+            continue;
+        }
+        int id = register_metric(&b.detector, METRIC_CPU_USAGE, NULL);
+        if (id < 0) {
+            free_detector(&b.detector);
+            continue;
+        }
+        b.metric = &b.detector.metrics[id];
+        for (int i = 0; i < 1024; i++) {
+            b.values[i] = 50.0 + 10.0 * bench_random();
+        }
+        // 先填满窗口，测量稳定状态下的开销
+        for (int i = 0; i < windows[w]; i++) {
+            add_metric_datapoint(b.metric, b.values[i & 1023], (uint64_t)i);
+        }
+
+        bench_run(add_name, run_add_datapoint, &b);
+        bench_run(update_name, run_update_stats, &b);
+
+        // 同时维护顺序统计（中位数/MAD检测的指标）
+        if ((bench_selected(add_mad_name) || bench_selected(median_name)) &&
+            set_metric_detector(&b.detector, id, DETECTOR_MAD) == 0) {
+            bench_run(add_mad_name, run_add_datapoint, &b);
+            bench_run(median_name, run_median_mad, &b);
+        }
+        free_detector(&b.detector);
+    }
+
+    bench_stats_error();
+    bench_forecast();
+    bench_correlation();
+
+    bench_run("LatencyRecord", run_latency_record, NULL);
+    latency_reset();
+}
@@ -0,0 +1,163 @@
+/**
+ * @file alert.h
+ * @brief 告警状态跟踪头文件
+ *
+ * 检测器每个周期对越界的指标各生成一条异常记录，持续越界的指标每个周期都会
+ * 重复产生记录。告警跟踪器为每个指标维护一个状态：
+ *
+ *   未触发 --被标记--> 等待 --持续被标记满pending_ns--> 触发 --持续恢复满resolve_ns--> 未触发
+ *
+ * 同一周期内统计检测和阈值检测对同一指标的判定合并为一次，一次持续的异常
+ * 只产生一个触发事件和一个恢复事件。等待期间出现未被标记的周期即回到未触发，
+ * 不产生事件。触发后，未被任何检测器标记的周期计为恢复，持续resolve_ns后
+ * 产生恢复事件。阈值是固定的，值容易在阈值上下来回波动，最近一次被阈值检测
+ * 标记的告警还要求当前值降到阈值的(1 - hysteresis)倍以下，停在阈值附近的值
+ * 视为仍在告警并重新开始恢复计时；统计检测的界限随窗口移动，只按时长消抖。
+ */
+
+#ifndef ALERT_H
+#define ALERT_H
+
+#include "anomaly_detection.h"
+
+/* 告警状态 */
+typedef enum {
+    ALERT_INACTIVE,             // 未触发
+    ALERT_PENDING,              // 已被标记，等待持续时间满足
+    ALERT_FIRING                // 已触发
+} AlertState;
+
+/* 告警事件种类 */
+typedef enum {
+    ALERT_EVENT_FIRING,         // 告警触发
+    ALERT_EVENT_RESOLVED        // 告警恢复（或指标已退役）
+} AlertEventKind;
+
+/* 告警事件 */
+typedef struct {
+    AlertEventKind kind;        // 事件种类
+    int metric_id;              // 指标下标
+    MetricType type;            // 指标种类
+    unsigned int sources;       // 标记过该指标的检测（1 << 异常来源）
+    int severity;               // 告警期间的最高严重程度
+    double value;               // 触发时为越界值，恢复时为当前值
+    double threshold;           // 最近一次越过的界限，只被多维相关检测标记时为NAN
+    double peak;                // 告警期间偏离最远的值
+    time_t started;             // 首次被标记的采样时间（Unix纪元秒）
+    time_t timestamp;           // 事件的采样时间（Unix纪元秒）
+    uint64_t duration_ns;       // 从首次被标记到事件发生的采样时长
+    unsigned long anomalies;    // 被标记的周期数
+    Anomaly anomaly;            // 严重程度最高的异常记录
+} AlertEvent;
+
+/* 一个指标的告警状态 */
+typedef struct {
+    AlertState state;
+    unsigned long incarnation;  // 指标的注册编号，与指标不同时重置
+    unsigned long hit_round;    // 最近一次被标记的更新轮次
+    bool clearing;              // 是否处于恢复计时中
+    bool high;                  // 越过上限（true）或下限
+    uint64_t first_ns;          // 首次被标记的采样时间
+    uint64_t clear_ns;          // 恢复计时的开始时间
+    time_t started;             // 首次被标记的采样时间（Unix纪元秒）
+    double value;               // 最近一次越界的值
+    double bound;               // 最近一次越过的界限（同一周期多个检测取最先越过的，不含马氏距离，没有时为NAN）
+    double threshold;           // 最近一次被阈值检测标记时的阈值，0表示未被阈值检测标记
+    double peak;                // 偏离最远的值
+    int severity;               // 最高严重程度
+    unsigned int sources;       // 标记过的检测
+    unsigned long anomalies;    // 被标记的周期数
+    bool has_anomaly;           // anomaly是否已记录
+    Anomaly anomaly;            // 严重程度最高的异常记录
+} AlertEntry;
+
+/* 告警跟踪器，单线程使用 */
+typedef struct {
+    AlertEntry *entries;        // 以指标下标索引
+    int capacity;
+    unsigned long round;        // 更新轮次
+    uint64_t pending_ns;        // 触发前需要持续被标记的时长
+    uint64_t resolve_ns;        // 恢复前需要持续未被标记的时长
+    double hysteresis;          // 阈值告警的恢复回差，阈值的倍数
+    int firing;                 // 当前触发中的告警数
+    unsigned long fired;        // 累计触发的告警数
+    AlertEvent *events;         // 尚未取走的事件
+    int event_count;
+    int event_capacity;
+} AlertTracker;
+
+/**
+ * @brief 初始化告警跟踪器
+ * @param tracker 跟踪器指针
+ * @param pending_ns 触发前需要持续被标记的时长，0表示首次被标记即触发
+ * @param resolve_ns 恢复前需要持续未被标记的时长，0表示首个恢复周期即恢复
+ * @param hysteresis 阈值告警的恢复回差，阈值的倍数（如0.05）
+ * @return 成功返回0，失败返回非0
+ */
+int alert_tracker_init(AlertTracker *tracker, uint64_t pending_ns, uint64_t resolve_ns, double hysteresis);
+
+/**
+ * @brief 按本周期检测器中的全部异常更新所有指标的告警状态
+ *
+ * 已退役或重新注册的指标上触发中的告警产生恢复事件。事件追加到尚未清空的
+ * 事件之后，调用者取走后用alert_tracker_clear_events清空，取走失败时（如输出
+ * 队列满）保留到下一个周期，触发和恢复事件不会丢失。
+ *
+ * @param tracker 跟踪器指针
+ * @param detector 异常检测器指针（anomalies为本周期的异常）
+ * @param timestamp_ns 本周期的采样时间（纳秒，经detector->clock_offset_ns换算为事件时间）
+ * @return 本次产生的事件数，失败返回-1
+ */
+int alert_tracker_update(AlertTracker *tracker, const AnomalyDetector *detector, uint64_t timestamp_ns);
+
+/**
+ * @brief 只更新一个指标的告警状态，事件同样追加到尚未清空的事件之后
+ *
+ * 用于样本逐个序列到达的场景，每检测一个样本调用一次。
+ *
+ * @param tracker 跟踪器指针
+ * @param detector 异常检测器指针
+ * @param metric_id 指标下标
+ * @param first 本次检测产生的第一条异常在detector->anomalies中的下标
+ * @param timestamp_ns 样本的采样时间（纳秒，经detector->clock_offset_ns换算为事件时间）
+ * @return 本次产生的事件数，失败返回-1
+ */
+int alert_tracker_observe(AlertTracker *tracker, const AnomalyDetector *detector, int metric_id,
+                          int first, uint64_t timestamp_ns);
+
+/**
+ * @brief 清空已取走的事件
+ * @param tracker 跟踪器指针
+ */
+void alert_tracker_clear_events(AlertTracker *tracker);
+
+/**
+ * @brief 释放告警跟踪器
+ * @param tracker 跟踪器指针
+ */
+void alert_tracker_free(AlertTracker *tracker);
+
+/**
+ * @brief 把标记过告警的检测格式化为"N-Sigma+阈值"形式
+ * @param sources 检测位掩码
+ * @param buf 输出缓冲区
+ * @param size 缓冲区大小
+ * @return buf
+ */
+const char *alert_source_names(unsigned int sources, char *buf, size_t size);
+
+/**
+ * @brief 按日志格式格式化一个告警事件（以换行结尾）
+ * @param event 事件指针
+ * @param time_str 事件时间字符串
+ * @param metric_name 指标名称
+ * @param description 指标描述，用于格式化异常信息
+ * @param processes 相关的进程排行，NULL或空串表示无
+ * @param buf 输出缓冲区
+ * @param size 缓冲区大小
+ * @return 写入的字符数（超长时截断并保留换行），失败返回-1
+ */
+int alert_event_format(const AlertEvent *event, const char *time_str, const char *metric_name,
+                       const char *description, const char *processes, char *buf, size_t size);
+
+#endif /* ALERT_H */
@@ -0,0 +1,193 @@
+/**
+ * @file alert_log.h
+ * @brief 带索引的二进制告警日志头文件
+ *
+ * 与文本日志并行写入的结构化告警日志，按时间范围、指标和严重程度查询时
+ * 不必扫描整个文件。由两个只追加的文件组成，整数和浮点数均为本机字节序（小端）：
+ *
+ *   path       [文件头][记录][记录]...
+ *   path.idx   [文件头][索引项][索引项]...
+ *
+ * 每条记录以AlertLogRecord开头（length为整条记录的长度），随后是name_len字节的
+ * 指标名和description_len字节的描述（均不含'\0'），整条记录按8字节对齐。
+ * 记录按写入顺序每ALERT_LOG_BLOCK_RECORDS条组成一个块，块写满（或日志关闭）后
+ * 在索引文件中追加一项，记录块的位置、时间范围、最高严重程度和指标名的
+ * 布隆过滤器。最后一个索引项之后的记录尚未建立索引，读者逐条扫描这一段。
+ *
+ * 打开已有日志时截掉末尾不完整的记录，并为尚未建立索引的记录补写索引项；
+ * 索引文件缺失或损坏时按日志重建。
+ */
+
+#ifndef ALERT_LOG_H
+#define ALERT_LOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "alert.h"
+
+#define ALERT_LOG_MAGIC "ADALERTS"      // 日志文件魔数（8字节，不含'\0'）
+#define ALERT_INDEX_MAGIC "ADALTIDX"    // 索引文件魔数
+#define ALERT_LOG_VERSION 1             // 文件格式版本
+#define ALERT_LOG_BLOOM_WORDS 32        // 布隆过滤器长度（64位字，共2048位）
+
+/* 文件头，日志和索引文件相同 */
+typedef struct {
+    char magic[8];                  // ALERT_LOG_MAGIC或ALERT_INDEX_MAGIC
+    uint32_t version;               // ALERT_LOG_VERSION
+    uint32_t header_size;           // 文件头长度
+} AlertLogFileHeader;
+
+/* 一条告警记录，随后是指标名和描述 */
+typedef struct {
+    uint32_t length;                // 整条记录的长度（含名称和填充）
+    uint8_t kind;                   // AlertEventKind
+    uint8_t type;                   // MetricType
+    uint8_t source;                 // 严重程度最高的异常的来源
+    uint8_t severity;               // 告警期间的最高严重程度
+    uint32_t sources;               // 标记过该指标的检测
+    uint16_t name_len;              // 指标名长度
+    uint16_t description_len;       // 描述长度
+    int64_t timestamp;              // 事件时间（Unix秒）
+    int64_t started;                // 首次被标记的时间（Unix秒）
+    uint64_t duration_ns;           // 从首次被标记到事件发生的采样时长
+    uint64_t anomalies;             // 被标记的周期数
+    double value;                   // 触发时为越界值，恢复时为当前值
+    double threshold;               // 最近一次越过的界限，只被多维相关检测标记时为NAN
+    double peak;                    // 告警期间偏离最远的值
+    double anomaly_value;           // 严重程度最高的异常：值、界限、中心和离散程度
+    double anomaly_threshold;
+    double anomaly_center;
+    double anomaly_spread;
+} AlertLogRecord;
+
+/* 一个块的索引项 */
+typedef struct {
+    uint64_t offset;                // 块在日志文件中的偏移
+    uint64_t bytes;                 // 块长度
+    int64_t first;                  // 块内最早的事件时间（Unix秒）
+    int64_t last;                   // 块内最晚的事件时间
+    uint32_t count;                 // 记录数
+    uint32_t max_severity;          // 最高严重程度
+    uint64_t metrics[ALERT_LOG_BLOOM_WORDS]; // 完整指标名和种类名的布隆过滤器
+} AlertIndexEntry;
+
+/* 告警日志写入器，可由多个线程共用 */
+typedef struct {
+    pthread_mutex_t lock;
+    int fd;                         // 日志文件描述符
+    int index_fd;                   // 索引文件描述符
+    char path[256];                 // 日志文件路径
+    uint64_t size;                  // 日志文件长度
+    AlertIndexEntry block;          // 正在填充、尚未写入索引的块
+    unsigned long records;          // 本次打开后写入的记录数
+    unsigned long write_errors;     // 写入失败次数
+} AlertLog;
+
+/* 查询条件 */
+typedef struct {
+    int64_t since;                  // 只返回不早于该时间的事件（Unix秒），0表示不限
+    int64_t until;                  // 只返回早于该时间的事件，0表示不限
+    const char *metric;             // 完整指标名或种类名，NULL表示全部
+    int min_severity;               // 最低严重程度
+} AlertQuery;
+
+/* 查询统计 */
+typedef struct {
+    unsigned long blocks;           // 索引中的块数
+    unsigned long blocks_scanned;   // 按索引无法排除而扫描的块数
+    unsigned long records_scanned;  // 扫描的记录数（含未建立索引的记录）
+    unsigned long matched;          // 符合条件的记录数
+} AlertQueryStats;
+
+/* 告警日志读取器：只读映射日志和索引文件 */
+typedef struct {
+    const char *data;               // 映射的日志文件
+    uint64_t size;
+    const char *index;              // 映射的索引文件，NULL表示没有可用的索引
+    uint64_t index_size;
+    const AlertIndexEntry *entries; // 索引项
+    uint64_t entry_count;
+    uint64_t tail;                  // 未建立索引的记录的起始偏移
+} AlertLogReader;
+
+/**
+ * @brief 记录中的指标名（不以'\0'结尾，长度为name_len）
+ * @param record 记录指针
+ * @return 指标名
+ */
+static inline const char *alert_record_name(const AlertLogRecord *record) {
+    return (const char *)(record + 1);
+}
+
+/**
+ * @brief 记录中的描述（不以'\0'结尾，长度为description_len）
+ * @param record 记录指针
+ * @return 描述
+ */
+static inline const char *alert_record_description(const AlertLogRecord *record) {
+    return (const char *)(record + 1) + record->name_len;
+}
+
+/**
+ * @brief 打开（不存在时创建）告警日志和索引文件用于追加
+ *
+ * 已有日志的格式不匹配时改名为path.1后创建新文件。
+ *
+ * @param log 写入器指针
+ * @param path 日志文件路径，索引文件为path.idx
+ * @return 成功返回0，失败返回非0
+ */
+int alert_log_open(AlertLog *log, const char *path);
+
+/**
+ * @brief 追加一个告警事件，块写满时同时追加索引项
+ * @param log 写入器指针
+ * @param event 事件指针
+ * @param name 指标名
+ * @param description 指标描述
+ * @return 成功返回0，失败返回非0
+ */
+int alert_log_append(AlertLog *log, const AlertEvent *event, const char *name, const char *description);
+
+/**
+ * @brief 为未写满的块追加索引项并关闭文件
+ * @param log 写入器指针
+ */
+void alert_log_close(AlertLog *log);
+
+/**
+ * @brief 只读打开告警日志，索引文件缺失或损坏时全部记录按未建立索引处理
+ * @param reader 读取器指针
+ * @param path 日志文件路径
+ * @return 成功返回0，文件不存在或格式不符返回非0
+ */
+int alert_log_reader_open(AlertLogReader *reader, const char *path);
+
+/**
+ * @brief 按条件查询，跳过索引表明不含符合条件记录的块
+ * @param reader 读取器指针
+ * @param query 查询条件
+ * @param fn 对每条符合条件的记录按写入顺序调用，返回非0时停止查询
+ * @param arg 传给fn的参数
+ * @param stats 存储查询统计的指针，可为NULL
+ * @return 符合条件的记录数
+ */
+unsigned long alert_log_query(const AlertLogReader *reader, const AlertQuery *query,
+                              int (*fn)(const AlertLogRecord *record, void *arg), void *arg,
+                              AlertQueryStats *stats);
+
+/**
+ * @brief 关闭读取器
+ * @param reader 读取器指针
+ */
+void alert_log_reader_close(AlertLogReader *reader);
+
+/**
+ * @brief 把记录还原为告警事件，用于按文本日志格式输出
+ * @param record 记录指针
+ * @param event 存储事件的指针（metric_id为-1）
+ */
+void alert_record_to_event(const AlertLogRecord *record, AlertEvent *event);
+
+#endif /* ALERT_LOG_H */
@@ -13,8 +13,14 @@
 #include <time.h>
 #include <unistd.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include "name_index.h"
+#include "order_stats.h"
+#include "forecast.h"
+#include "batch_stats.h"
+#include "correlation.h"
 
-/* 定义指标类型 */
+/* 定义指标种类：系统级指标只有一个实例，磁盘和网络指标每个设备/接口一个实例 */
 typedef enum {
     METRIC_CPU_USAGE,           // CPU使用率
     METRIC_CPU_IOWAIT,          // CPU IO等待
@@ -25,41 +31,156 @@ typedef enum {
     METRIC_DISK_WRITE_AWAIT,    // 磁盘写响应时间
     METRIC_DISK_UTIL,           // 磁盘使用率
     METRIC_NET_DROPPED,         // 网络丢包
-    METRIC_COUNT                // 指标总数
+    METRIC_COUNT                // 指标种类总数
 } MetricType;
 
+/* 统计检测器：每个指标选用其一，阈值检测对所有指标生效 */
+typedef enum {
+    DETECTOR_NSIGMA,            // 均值/标准差（默认）
+    DETECTOR_MAD,               // 中位数/中位数绝对偏差，不受窗口内尖峰影响
+    DETECTOR_EWMA,              // 指数加权移动平均的一步预测
+    DETECTOR_HOLT_WINTERS,      // 加法Holt-Winters季节预测
+    DETECTOR_COUNT              // 检测器种类总数
+} DetectorKind;
+
+/* 按指标覆盖的检测参数，name为种类名（匹配该种类的全部实例）或完整指标名，完整指标名优先 */
+typedef struct {
+    char name[NAME_INDEX_KEY_LEN];  // 种类名或完整指标名
+    double threshold;               // 阈值，0表示不做阈值检测，小于0表示不覆盖
+    double sigma_factor;            // N-Sigma因子，0表示不覆盖
+} MetricSetting;
+
+/* 滑动窗口统计累加器（Welford算法） */
+typedef struct {
+    int count;                  // 样本数量
+    double mean;                // 均值
+    double m2;                  // 离差平方和
+} RunningStats;
+
 /* 定义指标数据结构 */
 typedef struct {
-    MetricType type;            // 指标类型
-    char name[64];              // 指标名称
+    MetricType type;            // 指标种类
+    bool active;                // 是否在用（来源消失后退役，槽位可复用）
+    char name[NAME_INDEX_KEY_LEN]; // 指标名称（种类名[:实例名]）
     char description[256];      // 指标描述
     double value;               // 当前值
+    uint64_t timestamp_ns;      // 当前值的采样时间（单调时钟）
     double threshold;           // 阈值
+    double sigma_factor;        // 本指标的N-Sigma因子（MAD和预测检测同样使用），0表示使用检测器的因子
     double mean;                // 均值
     double stddev;              // 标准差
-    double *history;            // 历史数据
+    double *history;            // 历史数据（环形缓冲区），预测检测的指标不保存，为NULL
+    int history_head;           // 最旧数据点的下标
     int history_size;           // 历史数据大小
     int history_capacity;       // 历史数据容量
+    RunningStats window;        // 当前窗口的增量统计（仅有历史数据时）
+    RunningStats shadow;        // 重新锚定用的影子统计（只做加法，仅有历史数据时）
+    unsigned long incarnation;  // 下标每次被（重新）注册时分配的唯一编号
+    DetectorKind detector;      // 统计检测器
+    OrderStats *order;          // 窗口的顺序统计（仅DETECTOR_MAD），随历史数据同步更新
+    double median;              // 中位数（仅DETECTOR_MAD，检测时更新）
+    double mad;                 // 中位数绝对偏差（仅DETECTOR_MAD，检测时更新）
+    Forecast *forecast;         // 预测模型（仅DETECTOR_EWMA/DETECTOR_HOLT_WINTERS），随样本同步更新
+    StatsColumns *columns;      // 检测器的统计列，当前值和窗口统计随样本同步写入
+    int column;                 // 在统计列中的下标（即指标下标）
 } Metric;
 
-/* 定义异常结构 */
+/**
+ * @brief 按时间顺序访问历史数据
+ * @param metric 指标指针
+ * @param i 下标，0为最旧的数据点
+ * @return 数据值
+ */
+static inline double metric_history_at(const Metric *metric, int i) {
+    int idx = metric->history_head + i;
+    if (idx >= metric->history_capacity) {
+        idx -= metric->history_capacity;
+    }
+    return metric->history[idx];
+}
+
+/* 阈值检测和多维相关检测产生的异常的来源，统计检测产生的异常以DetectorKind为来源 */
+#define ANOMALY_SOURCE_THRESHOLD DETECTOR_COUNT
+#define ANOMALY_SOURCE_MAHALANOBIS (DETECTOR_COUNT + 1)
+
+/*
+ * 异常记录只保存结构化字段，不在检测时格式化文本；需要文本的输出端
+ * 用format_anomaly按来源生成消息。
+ */
 typedef struct {
-    MetricType type;            // 异常指标类型
-    char message[256];          // 异常信息
+    int metric_id;              // 异常指标在检测器中的下标
+    uint8_t type;               // 异常指标类型（MetricType）
+    uint8_t source;             // 产生异常的检测（DetectorKind或ANOMALY_SOURCE_*）
+    int16_t severity;           // 严重程度 (1-5)
     double value;               // 异常值
-    double threshold;           // 触发阈值
+    double threshold;           // 越过的界限（多维相关检测为马氏距离的界限，与指标值量纲不同）
+    double center;              // 界限的中心：均值、中位数或预测值（阈值检测为0，多维相关检测为该指标在窗口内的均值）
+    double spread;              // 离散程度：标准差、MAD或残差标准差（阈值检测为0，多维相关检测为马氏距离）
     time_t timestamp;           // 时间戳
-    int severity;               // 严重程度 (1-5)
 } Anomaly;
 
+/**
+ * @brief 判断异常偏高还是偏低时与值比较的基准
+ * @param anomaly 异常记录
+ * @return 越过的界限；多维相关检测的界限是距离，返回窗口均值
+ */
+static inline double anomaly_reference(const Anomaly *anomaly) {
+    return anomaly->source == ANOMALY_SOURCE_MAHALANOBIS ? anomaly->center : anomaly->threshold;
+}
+
+/* 每个周期的异常记录：连续存放，容量按需倍增，清空时保留内存 */
+typedef struct {
+    Anomaly *records;
+    int count;
+    int capacity;
+} AnomalyArena;
+
+/**
+ * @brief 清空异常记录，保留已分配的内存
+ * @param arena 异常记录指针
+ */
+static inline void anomaly_arena_reset(AnomalyArena *arena) {
+    arena->count = 0;
+}
+
+/* 多维相关检测的一组指标：成员同一周期的样本组成一个向量，按马氏距离检测 */
+typedef struct {
+    char *spec;                     // 成员列表，格式同检测器的指标列表
+    int *members;                   // 成员的指标下标，按下标排序
+    unsigned long *incarnations;    // 成员的注册编号，与指标不一致时重新解析
+    int member_count;
+    unsigned long resolved;         // 解析成员时检测器已分配的注册编号数量
+    CorrelationModel model;         // 成员变化时清空
+    double *values;                 // 本周期的样本向量
+    double *contrib;                // 各成员对距离的贡献
+    uint64_t last_timestamp_ns;     // 最近一次并入模型的样本时间
+    double limit;                   // 马氏距离的界限，随成员数和N-Sigma因子缓存
+    double limit_sigma;             // 计算limit时的N-Sigma因子
+    bool truncated;                 // 已提示匹配的指标超过CORRELATION_MAX_MEMBERS
+} CorrelationGroup;
+
 /* 定义异常检测器结构 */
 typedef struct {
-    Metric metrics[METRIC_COUNT];   // 监控的指标
-    Anomaly *anomalies;             // 检测到的异常
-    int anomaly_count;              // 异常数量
-    int anomaly_capacity;           // 异常容量
+    Metric *metrics;                // 指标注册表，以指标下标索引
+    int metric_count;               // 已使用的下标数量（含已退役的槽位）
+    int metric_capacity;            // 指标数组容量
+    NameIndex metric_index;         // 指标名称到下标的哈希索引
+    int *free_ids;                  // 已退役、可复用的下标
+    int free_count;                 // 可复用下标数量
+    unsigned long incarnations;     // 已分配的注册编号数量
+    int *series_metrics;            // 采集端序列号到指标下标的映射，-1表示无
+    int series_capacity;            // 映射表长度
+    AnomalyArena anomalies;         // 本周期检测到的异常，由调用者在每个周期开始时清空
     int window_size;                // 滑动窗口大小
-    double sigma_factor;            // N-Sigma因子
+    double sigma_factor;            // N-Sigma因子（MAD和预测检测同样以它为倍数）
+    char *detector_metrics[DETECTOR_COUNT]; // 各检测器的指标列表，NULL表示无（N-Sigma为默认，不用）
+    MetricSetting *settings;        // 按指标覆盖的阈值和N-Sigma因子
+    int setting_count;
+    CorrelationGroup *groups;       // 多维相关检测的指标组
+    int group_count;
+    ForecastParams forecast_params; // 新建预测模型使用的参数
+    int64_t clock_offset_ns;        // 样本时间戳到Unix纪元时间的偏移（实时采集为实时钟减单调时钟）
+    StatsColumns columns;           // N-Sigma批量检测用的统计列，以指标下标索引
 } AnomalyDetector;
 
 /* 函数声明 */
@@ -74,17 +195,131 @@ typedef struct {
 int init_detector(AnomalyDetector *detector, int window_size, double sigma_factor);
 
 /**
- * @brief 释放异常检测器资源
+ * @brief 获取指标种类名称
+ * @param type 指标种类
+ * @return 种类名称（如disk_read_await）
+ */
+const char *metric_kind_name(MetricType type);
+
+/**
+ * @brief 按种类名查找指标种类
+ * @param name 种类名（不必以'\0'结尾）
+ * @param len 种类名长度
+ * @return 指标种类，未知的种类名返回-1
+ */
+int find_metric_kind(const char *name, size_t len);
+
+/**
+ * @brief 向注册表添加一个指标，名称已存在时返回已有指标
  * @param detector 异常检测器指针
+ * @param type 指标种类
+ * @param name 指标名称
+ * @param description 指标描述
+ * @param threshold 阈值（0表示不做阈值检测）
+ * @return 成功返回指标下标，失败返回-1
  */
-void free_detector(AnomalyDetector *detector);
+int add_metric(AnomalyDetector *detector, MetricType type, const char *name,
+               const char *description, double threshold);
+
+/**
+ * @brief 按种类和实例注册指标，名称、描述和阈值由种类决定
+ * @param detector 异常检测器指针
+ * @param type 指标种类
+ * @param instance 实例名（如nvme0n1、eth0、cpu3），系统级指标传NULL
+ * @return 成功返回指标下标，失败返回-1
+ */
+int register_metric(AnomalyDetector *detector, MetricType type, const char *instance);
+
+/**
+ * @brief 按完整名称（种类名[:实例名]）注册指标，用于从持久化数据恢复
+ * @param detector 异常检测器指针
+ * @param name 指标名称
+ * @return 成功返回指标下标，种类未知或失败返回-1
+ */
+int register_metric_name(AnomalyDetector *detector, const char *name);
+
+/**
+ * @brief 按名称查找指标
+ * @param detector 异常检测器指针
+ * @param name 指标名称
+ * @return 找到返回指标下标，否则返回-1
+ */
+int find_metric(const AnomalyDetector *detector, const char *name);
 
 /**
- * @brief 收集系统指标数据
+ * @brief 退役指标：释放历史数据，从索引中移除，下标留待复用
  * @param detector 异常检测器指针
+ * @param metric_id 指标下标
+ */
+void retire_metric(AnomalyDetector *detector, int metric_id);
+
+/**
+ * @brief 为指标选择统计检测器，切换到DETECTOR_MAD时由当前历史数据建立顺序统计，
+ *        切换到预测检测时释放历史数据，切换回来时重新分配
+ * @param detector 异常检测器指针
+ * @param metric_id 指标下标
+ * @param kind 检测器种类
+ * @return 成功返回0，失败返回非0（失败时指标保持原检测器）
+ */
+int set_metric_detector(AnomalyDetector *detector, int metric_id, DetectorKind kind);
+
+/**
+ * @brief 设置使用某种检测器的指标，对已注册和之后注册的指标都生效
+ *
+ * 列表以逗号分隔，每项为种类名（如disk_read_await，匹配该种类的全部实例）、
+ * 完整指标名（如disk_read_await:sda）或all。一个指标出现在多个列表中时，
+ * 依次优先选用Holt-Winters、EWMA、MAD；不在任何列表中的指标使用N-Sigma。
+ *
+ * @param detector 异常检测器指针
+ * @param kind 检测器种类（不能为DETECTOR_NSIGMA）
+ * @param list 指标列表，NULL或空串表示清空
+ * @return 成功返回0，失败返回非0
+ */
+int set_detector_metrics(AnomalyDetector *detector, DetectorKind kind, const char *list);
+
+/**
+ * @brief 设置按指标覆盖的阈值和N-Sigma因子，对已注册和之后注册的指标都生效
+ *
+ * 指标先取种类的默认阈值和检测器的N-Sigma因子，再依次应用种类名匹配的设置和
+ * 完整指标名匹配的设置。使用自己因子的N-Sigma指标不参与批量内核，逐个检测。
+ * 只改变参数，不影响历史数据和窗口统计。
+ *
+ * @param detector 异常检测器指针
+ * @param settings 设置数组，NULL表示清空
+ * @param count 设置数量
  * @return 成功返回0，失败返回非0
  */
-int collect_metrics(AnomalyDetector *detector);
+int set_metric_settings(AnomalyDetector *detector, const MetricSetting *settings, int count);
+
+/**
+ * @brief 设置多维相关检测的指标组
+ *
+ * 组之间以分号分隔，每组的成员列表格式同set_detector_metrics（种类名匹配该种类的
+ * 全部实例），最多CORRELATION_MAX_MEMBERS个成员，匹配更多指标时只使用下标最小的
+ * 成员并在标准错误上提示一次。成员列表与原有组相同的组保留
+ * 已建立的模型，其余的组从空窗口开始。
+ *
+ * @param detector 异常检测器指针
+ * @param groups 指标组，NULL或空串表示清空
+ * @return 成功返回0，失败返回非0
+ */
+int set_correlation_groups(AnomalyDetector *detector, const char *groups);
+
+/**
+ * @brief 设置样本时间戳到Unix纪元时间的偏移（Holt-Winters按墙上时间计算季节相位）
+ *
+ * 离线回放的时间戳本身就是纪元时间，偏移为0。已有的预测模型同时更新。
+ *
+ * @param detector 异常检测器指针
+ * @param offset_ns 偏移
+ */
+void set_detector_clock(AnomalyDetector *detector, int64_t offset_ns);
+
+/**
+ * @brief 释放异常检测器资源
+ * @param detector 异常检测器指针
+ */
+void free_detector(AnomalyDetector *detector);
 
 /**
  * @brief 使用N-Sigma算法检测异常
@@ -93,6 +328,28 @@ int collect_metrics(AnomalyDetector *detector);
  */
 int detect_anomalies_nsigma(AnomalyDetector *detector);
 
+/**
+ * @brief 使用中位数/MAD算法检测异常（只检查选用DETECTOR_MAD的指标）
+ *
+ * 上下限为 中位数 ± sigma_factor × 1.4826 × MAD（正态分布下与N-Sigma的
+ * 标准差尺度一致）；窗口中超过一半的点相同使MAD为0时，改用
+ * 1.2533 × 平均绝对偏差作为尺度。
+ *
+ * @param detector 异常检测器指针
+ * @return 检测到的异常数量
+ */
+int detect_anomalies_mad(AnomalyDetector *detector);
+
+/**
+ * @brief 使用预测模型检测异常（只检查选用EWMA或Holt-Winters的指标）
+ *
+ * 当前值与样本到达前的一步预测之差超过 sigma_factor × 残差标准差 时判定为异常。
+ *
+ * @param detector 异常检测器指针
+ * @return 检测到的异常数量
+ */
+int detect_anomalies_forecast(AnomalyDetector *detector);
+
 /**
  * @brief 使用阈值检测异常
  * @param detector 异常检测器指针
@@ -101,44 +358,68 @@ int detect_anomalies_nsigma(AnomalyDetector *detector);
 int detect_anomalies_threshold(AnomalyDetector *detector);
 
 /**
- * @brief 打印检测到的异常
+ * @brief 使用马氏距离检测各指标组的组合异常
+ *
+ * 组内全部成员在同一周期都有新样本时，以窗口内的均值向量和协方差矩阵计算该
+ * 样本向量的马氏距离，再把它并入窗口（每组O(k²)）。距离超过k维正态分布下与
+ * sigma_factor倍标准差等概率的界限时判定为异常，记在对距离贡献最大的成员上。
+ * 成员各自都在N-Sigma界限以内、但偏离了彼此之间相关关系的样本也会被发现。
+ *
  * @param detector 异常检测器指针
+ * @return 检测到的异常数量
  */
-void print_anomalies(AnomalyDetector *detector);
+int detect_anomalies_correlation(AnomalyDetector *detector);
 
 /**
- * @brief 将异常保存到日志文件
+ * @brief 只检测一个指标：运行它选用的统计检测器（N-Sigma、MAD或预测），再做阈值检测
+ *
+ * 用于样本逐个序列到达的场景（如汇聚多台主机样本的服务端），只检查刚写入样本的指标，
+ * 判定规则与对应的detect_anomalies_*相同。
+ *
  * @param detector 异常检测器指针
- * @param filename 日志文件名
- * @return 成功返回0，失败返回非0
+ * @param metric_id 指标下标
+ * @return 检测到的异常数量，参数无效时返回-1
  */
-int log_anomalies(AnomalyDetector *detector, const char *filename);
+int detect_metric_anomalies(AnomalyDetector *detector, int metric_id);
 
 /**
- * @brief 更新指标的统计信息（均值、标准差）
+ * @brief 根据增量累加器更新指标的统计信息（均值、标准差），O(1)
  * @param metric 指标指针
  */
 void update_metric_stats(Metric *metric);
 
 /**
- * @brief 添加指标数据点
+ * @brief 添加指标数据点，O(1)，与窗口大小无关；预测检测的指标只更新模型
  * @param metric 指标指针
  * @param value 数据值
+ * @param timestamp_ns 采样时间（单调时钟，纳秒）
  * @return 成功返回0，失败返回非0
  */
-int add_metric_datapoint(Metric *metric, double value);
+int add_metric_datapoint(Metric *metric, double value, uint64_t timestamp_ns);
 
 /**
  * @brief 添加异常记录
  * @param detector 异常检测器指针
- * @param type 异常指标类型
+ * @param metric_id 异常指标下标
+ * @param source 产生异常的检测（DetectorKind或ANOMALY_SOURCE_*）
  * @param value 异常值
- * @param threshold 触发阈值
- * @param message 异常信息
+ * @param threshold 越过的界限
+ * @param center 界限的中心（均值、中位数或预测值，阈值检测为0）
+ * @param spread 离散程度（标准差、MAD或残差标准差，阈值检测为0）
  * @param severity 严重程度
  * @return 成功返回0，失败返回非0
  */
-int add_anomaly(AnomalyDetector *detector, MetricType type, double value, 
-                double threshold, const char *message, int severity);
+int add_anomaly(AnomalyDetector *detector, int metric_id, int source, double value,
+                double threshold, double center, double spread, int severity);
+
+/**
+ * @brief 按异常来源把异常记录格式化为可读消息
+ * @param anomaly 异常记录
+ * @param description 指标描述
+ * @param buf 输出缓冲区
+ * @param size 缓冲区大小
+ * @return 写入的字符数（超长时截断），失败返回-1
+ */
+int format_anomaly(const Anomaly *anomaly, const char *description, char *buf, size_t size);
 
 #endif /* ANOMALY_DETECTION_H */
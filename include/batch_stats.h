@@ -0,0 +1,94 @@
+/**
+ * @file batch_stats.h
+ * @brief 结构数组（SoA）布局的批量统计头文件
+ *
+ * 把N-Sigma检测用到的热数据（当前值、均值、离差平方和、样本数）按字段
+ * 存放在连续数组中，以指标下标索引。检测时一个内核遍历全部序列，
+ * 计算标准差和上下限并输出异常位图，只有被置位的序列才回到Metric结构
+ * 格式化消息。内核按CPU特性在运行时选择：AVX2（每次4个序列）、
+ * SSE2（每次2个序列）或标量实现，结果逐位相同（向量内核不用FMA，
+ * bin/bench的BatchStatsIdentical用例逐位比较各内核的输出）。
+ */
+
+#ifndef BATCH_STATS_H
+#define BATCH_STATS_H
+
+#include <stdint.h>
+
+#define STATS_MIN_SAMPLES 3         // 参与检测需要的最少样本数
+
+/* 统计列 */
+typedef struct {
+    int count;                  // 使用的长度（指标下标上限）
+    int capacity;               // 数组容量（8的倍数，尾部填充的样本数为0）
+    double *value;              // 当前值
+    double *mean;               // 窗口均值
+    double *m2;                 // 窗口离差平方和
+    double *n;                  // 窗口样本数，不参与N-Sigma检测的序列为0
+    double *stddev;             // 标准差（检测时计算）
+    double *upper;              // 上限（检测时计算）
+    double *lower;              // 下限（检测时计算）
+    uint64_t *high;             // 异常偏高位图，每64个序列一个字
+    uint64_t *low;              // 异常偏低位图（仅下限大于0时）
+} StatsColumns;
+
+/**
+ * @brief 初始化统计列
+ * @param cols 统计列指针
+ * @return 成功返回0，失败返回非0
+ */
+int stats_columns_init(StatsColumns *cols);
+
+/**
+ * @brief 释放统计列
+ * @param cols 统计列指针
+ */
+void stats_columns_free(StatsColumns *cols);
+
+/**
+ * @brief 保证下标count-1可用，新增的序列样本数为0
+ * @param cols 统计列指针
+ * @param count 需要的长度
+ * @return 成功返回0，失败返回非0
+ */
+int stats_columns_reserve(StatsColumns *cols, int count);
+
+/**
+ * @brief 写入一个序列的当前值和窗口统计
+ * @param cols 统计列指针
+ * @param idx 序列下标
+ * @param value 当前值
+ * @param mean 均值
+ * @param m2 离差平方和
+ * @param n 样本数，0表示不参与检测
+ */
+static inline void stats_columns_set(StatsColumns *cols, int idx, double value,
+                                     double mean, double m2, int n) {
+    cols->value[idx] = value;
+    cols->mean[idx] = mean;
+    cols->m2[idx] = m2;
+    cols->n[idx] = (double)n;
+}
+
+/**
+ * @brief 对全部序列计算标准差和 均值 ± sigma_factor × 标准差，填充异常位图
+ * @param cols 统计列指针
+ * @param sigma_factor N-Sigma因子
+ * @return 被置位的序列数
+ */
+int stats_columns_detect(StatsColumns *cols, double sigma_factor);
+
+/**
+ * @brief 当前使用的内核名称
+ * @return "avx2"、"sse2"或"scalar"
+ */
+const char *stats_kernel_name(void);
+
+/**
+ * @brief 指定内核（用于基准测试和对比），CPU不支持时不改变
+ * @param name "avx2"、"sse2"、"scalar"，NULL表示按CPU特性自动选择
+ * @return 成功返回0，不支持返回非0
+ */
+int stats_kernel_select(const char *name);
+
+#endif /* BATCH_STATS_H */
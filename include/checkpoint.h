@@ -0,0 +1,58 @@
+/**
+ * @file checkpoint.h
+ * @brief 预测模型检查点头文件
+ *
+ * 把各指标的EWMA/Holt-Winters状态保存到一个小文件，重启后按指标名恢复，
+ * 季节基线不必重新学习一个完整周期。文件为本机字节序：
+ *
+ *   [CheckpointHeader][记录0][记录1]...
+ *   记录 = CheckpointRecord + bytes字节的Forecast（含季节分量）
+ *
+ * 先写入path.tmp再改名，读者只会看到完整的检查点。
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdint.h>
+#include "anomaly_detection.h"
+
+#define CHECKPOINT_MAGIC "ADFCKPT"      // 文件魔数（含'\0'共8字节）
+#define CHECKPOINT_VERSION 1            // 文件格式版本
+
+/* 文件头 */
+typedef struct {
+    char magic[8];                  // CHECKPOINT_MAGIC
+    uint32_t version;               // CHECKPOINT_VERSION
+    uint32_t record_count;          // 记录数
+    uint64_t saved_ns;              // 保存时间（Unix纪元纳秒）
+} CheckpointHeader;
+
+/* 记录头 */
+typedef struct {
+    char name[NAME_INDEX_KEY_LEN];  // 指标名称
+    uint32_t bytes;                 // 随后的Forecast长度
+    uint32_t reserved;
+} CheckpointRecord;
+
+/**
+ * @brief 保存全部在用指标的预测模型
+ * @param detector 异常检测器指针
+ * @param path 检查点文件路径
+ * @param saved_ns 保存时间（Unix纪元纳秒）
+ * @return 成功返回保存的模型数，失败返回-1
+ */
+int save_forecast_checkpoint(const AnomalyDetector *detector, const char *path, uint64_t saved_ns);
+
+/**
+ * @brief 按指标名恢复预测模型
+ *
+ * 指标尚未注册时按名称注册；只恢复种类和季节参数与当前设置一致的模型。
+ *
+ * @param detector 异常检测器指针
+ * @param path 检查点文件路径
+ * @return 恢复的模型数，文件不存在或格式不符返回0
+ */
+int load_forecast_checkpoint(AnomalyDetector *detector, const char *path);
+
+#endif /* CHECKPOINT_H */
@@ -10,12 +10,47 @@
 #define DEFAULT_WINDOW_SIZE 60      // 默认滑动窗口大小（数据点数量）
 #define DEFAULT_SIGMA_FACTOR 3.0    // 默认N-Sigma因子
 #define DEFAULT_SAMPLING_INTERVAL 5 // 默认采样间隔（秒）
-#define MAX_ANOMALIES 1000          // 最大异常记录数
+#define MIN_SAMPLING_INTERVAL_MS 10 // 最小采样间隔（毫秒）
+#define PIPELINE_QUEUE_DEPTH 16     // 线程间队列深度（批次数量），队列满时丢弃并计数
 #define LOG_FILE_PATH "anomalies.log" // 异常日志文件路径
-
-/* 默认设备名 */
-#define DEFAULT_DISK_DEVICE "sda"   // 默认磁盘设备
-#define DEFAULT_NET_INTERFACE "eth0" // 默认网络接口
+#define LOG_BUFFER_SIZE (1024 * 1024) // 日志缓冲区大小（字节，双缓冲）
+#define LOG_FLUSH_INTERVAL_MS 1000  // 日志最长刷新间隔（毫秒）
+#define LOG_ROTATE_BYTES (64ULL * 1024 * 1024) // 日志文件轮转大小（字节）
+#define LOG_ROTATE_AGE_SEC 86400    // 日志文件轮转时间（秒）
+#define LOG_ROTATE_KEEP 5           // 保留的历史日志文件数量
+#define ALERT_LOG_BLOCK_RECORDS 256 // 结构化告警日志每个索引块的记录数
+#define SERIES_FILE_PATH "metrics.series" // 指标时间序列文件路径
+#define SERIES_BLOCK_ROWS 720       // 序列文件每块行数
+#define SERIES_SPARE_COLUMNS 8      // 序列文件每块至少预留的空列数
+#define SERIES_MAX_BYTES (256ULL * 1024 * 1024) // 序列文件轮转大小（字节）
+#define FORECAST_ALPHA 0.1          // EWMA/Holt-Winters水平平滑系数
+#define FORECAST_BETA 0.01          // Holt-Winters趋势平滑系数
+#define FORECAST_GAMMA 0.05         // Holt-Winters季节平滑系数（桶内每个样本）
+#define FORECAST_VARIANCE_ALPHA 0.05 // 残差方差平滑系数
+#define FORECAST_SEASON_SEC 86400   // 默认季节周期（秒）
+#define FORECAST_SEASON_BUCKETS 96  // 每个季节周期的桶数
+#define FORECAST_WARMUP 20          // 预测模型开始检测前需要的样本数
+#define FORECAST_CHECKPOINT_PATH "forecast.ckpt" // 预测模型检查点文件路径
+#define FORECAST_CHECKPOINT_SEC 300 // 检查点保存间隔（秒）
+#define CORRELATION_MAX_MEMBERS 16  // 多维相关检测每组的最大成员数
+#define INGEST_ADDRESS "udp:127.0.0.1:9125" // 汇聚服务端默认监听地址
+#define INGEST_QUEUE_DEPTH 1024     // 汇聚服务端每个工作线程的队列深度（批次数量）
+#define INGEST_RECV_BATCH 64        // 每次recvmmsg读取的最大数据报数
+#define INGEST_RECV_BUFFER (16 * 1024 * 1024) // 请求的套接字接收缓冲区大小（字节）
+#define INGEST_REPORT_SEC 10        // 汇聚服务端打印吞吐统计的间隔（秒）
+#define EXPOSITION_TIMEOUT_MS 1000  // 指标端点单个连接从接受到写完响应的总时限（毫秒）
+#define PROCESS_TOP_K 5             // 默认的进程占用排行进程数
+#define PROCESS_IDLE_MAX_SKIP 4     // 空闲进程最多每隔多少个周期读取一次，即开始运行后最迟被看到的周期数
+#define PROCESS_FD_RESERVE 256      // 缓存进程文件描述符时为其他用途预留的数量
+#define COLLECT_WORKERS 2           // 并行读取数据源的工作线程数，0表示在采集线程中依次读取
+#define COLLECT_SOURCE_TIMEOUT_MS 1000 // 单个数据源的最长等待时间（毫秒），不超过采样间隔的一半
+#define ALERT_PENDING_SEC 0         // 告警触发前需要持续异常的时长（秒），0表示首次异常即触发
+#define ALERT_RESOLVE_SEC 30        // 告警恢复前需要持续正常的时长（秒）
+#define ALERT_HYSTERESIS 0.05       // 阈值告警的恢复回差：当前值需降到阈值的(1-该比例)倍以下
+#define BURST_INTERVAL_MS 100       // 默认的突发采样间隔（毫秒）
+#define BURST_DURATION_SEC 30       // 每次压力触发后保持突发采样的时长（秒）
+#define PSI_STALL_US 100000         // PSI触发阈值：窗口内的停顿时间（微秒）
+#define PSI_WINDOW_US 1000000       // PSI触发窗口（微秒，内核要求500ms到10s）
 
 /* 指标阈值配置 */
 #define CPU_USAGE_THRESHOLD 90.0    // CPU使用率阈值（%）
@@ -0,0 +1,112 @@
+/**
+ * @file correlation.h
+ * @brief 滑动窗口多维相关模型（马氏距离）头文件
+ *
+ * 对一组k个指标的同步样本向量维护窗口内的均值向量、离差平方和矩阵S及
+ * (S + R)的逆矩阵，R为很小的对角正则项，使成员完全共线或某个成员恒定时
+ * 矩阵仍然可逆。样本向量x的马氏距离平方为
+ *
+ *   d² = (x - μ)ᵀ Σ⁻¹ (x - μ)，Σ = S / (n - 1)
+ *
+ * 窗口滑动时加入和移出一个样本都只使S改变一个秩一项，逆矩阵用
+ * Sherman-Morrison公式更新，每个样本O(k²)，不重新求逆。每滑过一个窗口
+ * （或秩一更新的分母接近0时）由窗口内的样本重新计算均值、S和逆矩阵，
+ * 消除累积误差，代价O(n·k² + k³)，摊到每个样本仍为O(k²)。
+ */
+
+#ifndef CORRELATION_H
+#define CORRELATION_H
+
+#include <stdbool.h>
+
+#define CORRELATION_RIDGE 1e-6          // 正则项：S对角元的相对比例
+#define CORRELATION_MIN_VARIANCE 1e-6   // 正则项：每个成员的最小方差（绝对值）
+#define CORRELATION_MIN_PIVOT 1e-6      // 秩一更新分母的下限，低于它时重新求逆
+
+/* 相关模型 */
+typedef struct {
+    int dims;                   // 维数k
+    int capacity;               // 窗口大小
+    int count;                  // 窗口内的样本数
+    int head;                   // 最旧样本的下标
+    double *samples;            // 窗口内的样本向量（环形缓冲区，capacity×k）
+    double *mean;               // 均值向量（k）
+    double *scatter;            // 离差平方和矩阵S（k×k，行主序）
+    double *inverse;            // (S + R)的逆矩阵（k×k）
+    double *ridge;              // 求逆时使用的对角正则项R（k）
+    double *work;               // 临时空间（k×k + 2k）
+    bool inverse_valid;         // 逆矩阵是否与当前窗口一致
+    int updates;                // 上次重新计算后的样本数
+} CorrelationModel;
+
+/**
+ * @brief 初始化模型
+ * @param model 模型指针
+ * @param dims 维数（至少为1）
+ * @param capacity 窗口大小（至少为2）
+ * @return 成功返回0，失败返回非0
+ */
+int correlation_init(CorrelationModel *model, int dims, int capacity);
+
+/**
+ * @brief 释放模型
+ * @param model 模型指针
+ */
+void correlation_free(CorrelationModel *model);
+
+/**
+ * @brief 清空窗口，保留已分配的内存
+ * @param model 模型指针
+ */
+void correlation_reset(CorrelationModel *model);
+
+/**
+ * @brief 模型是否可以给出距离：窗口内至少有2k+1个样本
+ * @param model 模型指针
+ * @return 可以返回true
+ */
+static inline bool correlation_ready(const CorrelationModel *model) {
+    return model->inverse_valid && model->count >= 2 * model->dims + 1;
+}
+
+/**
+ * @brief 以当前窗口计算样本向量的马氏距离平方，O(k²)，不改变模型
+ *
+ * contrib[i] = (n - 1)·(x_i - μ_i)·(A⁻¹(x - μ))_i，各项之和等于d²，
+ * 最大的一项对应对距离贡献最大的成员。
+ *
+ * @param model 模型指针
+ * @param x 样本向量（k）
+ * @param contrib 存储各成员贡献的数组（k），可为NULL
+ * @return 马氏距离的平方，模型尚不可用时返回-1
+ */
+double correlation_score(const CorrelationModel *model, const double *x, double *contrib);
+
+/**
+ * @brief 把样本向量加入窗口，窗口已满时先移出最旧的样本，O(k²)
+ * @param model 模型指针
+ * @param x 样本向量（k）
+ */
+void correlation_update(CorrelationModel *model, const double *x);
+
+/**
+ * @brief 由窗口内的样本重新计算均值、离差矩阵和逆矩阵（Cholesky分解），O(n·k² + k³)
+ *
+ * correlation_update在需要时自动调用（同时按窗口内的方差重新计算正则项）；
+ * 沿用当前正则项单独调用时，结果可与秩一更新得到的逆矩阵直接比较。
+ *
+ * @param model 模型指针
+ * @param update_ridge 是否按窗口内的方差重新计算正则项
+ */
+void correlation_rebuild(CorrelationModel *model, bool update_ridge);
+
+/**
+ * @brief k维正态分布下马氏距离的界限：落在界限以外的概率与一维的
+ *        sigma倍标准差以外相同（卡方分位数的Wilson-Hilferty近似）
+ * @param dims 维数
+ * @param sigma_factor N-Sigma因子
+ * @return 马氏距离的界限（不是平方）
+ */
+double correlation_limit(int dims, double sigma_factor);
+
+#endif /* CORRELATION_H */
@@ -0,0 +1,84 @@
+/**
+ * @file counter_rate.h
+ * @brief 累计计数器差值计算头文件
+ *
+ * /proc中的CPU时间、块设备统计和网络丢包都是自启动以来的累计计数器。
+ * 计数器组保存一组计数器的上一次值和单调时钟采样时间，每次更新得到本
+ * 区间的增量和区间长度，各指标由增量计算速率和比值。
+ *
+ * 计数器变小时，只有调用者声明为32位宽的计数器（如内核以%u输出的diskstats
+ * 耗时字段）在上一次的值处于32位范围内、回绕后的增量小于2^31时按32位回绕
+ * 处理；其余计数器变小一律视为被重置（如设备重新注册），整组重新取基准，
+ * 本区间不产生数据。64位计数器重置后若按回绕处理，会得到接近2^32的虚假增量。
+ */
+
+#ifndef COUNTER_RATE_H
+#define COUNTER_RATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define COUNTER_SET_MAX 8           // 一组最多的计数器数量
+
+/* 一组计数器的上一次采样值 */
+typedef struct {
+    unsigned long long prev[COUNTER_SET_MAX]; // 上一次的计数器值
+    uint64_t timestamp_ns;          // 上一次的采样时间（单调时钟），0表示还没有基准
+} CounterSet;
+
+/* 一个采样区间的增量 */
+typedef struct {
+    unsigned long long delta[COUNTER_SET_MAX]; // 各计数器的增量
+    double seconds;                 // 区间长度（秒）
+} CounterDelta;
+
+/**
+ * @brief 丢弃基准，下一次更新只记录基准值
+ * @param set 计数器组指针
+ */
+void counter_set_reset(CounterSet *set);
+
+/**
+ * @brief 计数器组是否已有基准
+ * @param set 计数器组指针
+ * @return 有基准返回true
+ */
+static inline bool counter_set_primed(const CounterSet *set) {
+    return set->timestamp_ns != 0;
+}
+
+/**
+ * @brief 用当前计数器值更新计数器组，计算相对上一次的增量
+ * @param set 计数器组指针
+ * @param values 当前计数器值
+ * @param count 计数器数量（不超过COUNTER_SET_MAX）
+ * @param width32 位宽为32位、可能回绕的计数器位掩码（第i位对应values[i]）
+ * @param timestamp_ns 采样时间（单调时钟，纳秒）
+ * @param delta 存储增量的指针
+ * @return 增量有效返回0；首次采样、计数器重置或时间未前进时返回1（只更新基准）；参数错误返回-1
+ */
+int counter_set_update(CounterSet *set, const unsigned long long *values, int count,
+                       unsigned int width32, uint64_t timestamp_ns, CounterDelta *delta);
+
+/**
+ * @brief 计算一个计数器的每秒速率
+ * @param delta 增量指针
+ * @param i 计数器下标
+ * @return 每秒增量
+ */
+static inline double counter_delta_rate(const CounterDelta *delta, int i) {
+    return delta->seconds > 0 ? (double)delta->delta[i] / delta->seconds : 0.0;
+}
+
+/**
+ * @brief 计算两个计数器增量的比值
+ * @param delta 增量指针
+ * @param num 分子计数器下标
+ * @param den 分母计数器下标
+ * @return 比值，分母增量为0时返回0
+ */
+static inline double counter_delta_ratio(const CounterDelta *delta, int num, int den) {
+    return delta->delta[den] > 0 ? (double)delta->delta[num] / delta->delta[den] : 0.0;
+}
+
+#endif /* COUNTER_RATE_H */
@@ -0,0 +1,86 @@
+/**
+ * @file exposition.h
+ * @brief Prometheus文本格式指标端点头文件
+ *
+ * 输出线程每个周期把各指标的当前值、均值、标准差、阈值和告警状态渲染成
+ * Prometheus文本格式（0.0.4），写入自己的缓冲区后与已发布的缓冲区交换；
+ * 服务线程在本机HTTP端口上响应GET /metrics，加锁复制已发布的页面后发送。
+ * 锁只在交换指针和复制页面时持有，抓取不访问检测器，也不阻塞采集。
+ * 三块缓冲区都只在内容变长时扩容，稳定运行时渲染和抓取都不分配内存。
+ */
+
+#ifndef EXPOSITION_H
+#define EXPOSITION_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include "output.h"
+
+/* 可复用的文本缓冲区 */
+typedef struct {
+    char *data;
+    size_t len;                     // 内容长度
+    size_t capacity;                // 容量
+} ExpositionBuffer;
+
+/* 随页面导出的流水线计数器 */
+typedef struct {
+    unsigned long cycles;           // 已采集的周期数
+    unsigned long collect_errors;   // 数据源读取失败的周期数
+    unsigned long missed_deadlines; // 错过的采样截止时间数
+    unsigned long source_timeouts;  // 超时未读完而被跳过的数据源次数
+    unsigned long dropped_samples;  // 丢弃的采样批次数
+    unsigned long dropped_outputs;  // 丢弃的输出批次数
+    unsigned long pressure_bursts;  // 资源压力触发突发采样的次数
+} ExpositionCounters;
+
+/* 指标端点 */
+typedef struct {
+    int fd;                         // 监听套接字
+    int wake_fd;                    // 唤醒服务线程的eventfd
+    pthread_t thread;
+    bool running;                   // 服务线程已启动
+    atomic_bool stopping;
+    atomic_ulong scrapes;           // 已响应的抓取次数
+
+    pthread_mutex_t lock;           // 保护published
+    ExpositionBuffer published;     // 最新的完整页面
+
+    // 输出线程独占
+    ExpositionBuffer render;        // 正在渲染的页面
+    unsigned long *alert_totals;    // 各指标累计触发的告警数，以指标下标索引，重新注册时清零
+    bool *alert_firing;             // 各指标的告警是否触发中
+    int alert_capacity;
+    unsigned long alerts;           // 累计触发的告警数
+
+    // 服务线程独占
+    ExpositionBuffer response;      // 发送中的页面副本
+} Exposition;
+
+/**
+ * @brief 在本机地址上监听并启动服务线程
+ * @param exposition 端点指针
+ * @param address 端口号或"<IPv4地址>:<端口>"，只给端口时监听127.0.0.1
+ * @return 成功返回0，失败返回非0
+ */
+int exposition_start(Exposition *exposition, const char *address);
+
+/**
+ * @brief 渲染一个周期的输出批次并发布（由输出线程调用）
+ * @param exposition 端点指针
+ * @param sink 输出端（已应用本批次的标签）
+ * @param batch 输出批次
+ * @param counters 流水线计数器
+ * @return 成功返回0，内存不足时返回非0（保留上一次发布的页面）
+ */
+int exposition_publish(Exposition *exposition, const OutputSink *sink, const OutputBatch *batch,
+                       const ExpositionCounters *counters);
+
+/**
+ * @brief 停止服务线程并释放资源
+ * @param exposition 端点指针
+ */
+void exposition_stop(Exposition *exposition);
+
+#endif /* EXPOSITION_H */
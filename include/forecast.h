@@ -0,0 +1,84 @@
+/**
+ * @file forecast.h
+ * @brief 常数内存的预测模型（EWMA和加法Holt-Winters）头文件
+ *
+ * 每个样本以O(1)代价更新模型：先用更新前的状态给出一步预测和残差尺度，
+ * 检测时比较当前值与该预测，再把样本并入状态。不保存原始历史：
+ *   - EWMA：水平和残差方差，几十字节；
+ *   - Holt-Winters：水平、趋势、残差方差，以及按墙上时间把一个季节周期
+ *     均分成若干桶的季节分量（float），默认96个桶约400字节。
+ * 同一桶内的样本共同更新该桶的季节分量，因此季节长度与采样间隔无关。
+ */
+
+#ifndef FORECAST_H
+#define FORECAST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* 模型种类 */
+typedef enum {
+    FORECAST_EWMA,              // 指数加权移动平均
+    FORECAST_HOLT_WINTERS       // 加法Holt-Winters（水平+趋势+季节）
+} ForecastKind;
+
+/* 模型参数 */
+typedef struct {
+    double alpha;               // 水平平滑系数
+    double beta;                // 趋势平滑系数（仅Holt-Winters）
+    double gamma;               // 季节平滑系数（仅Holt-Winters）
+    double variance_alpha;      // 残差方差平滑系数
+    uint64_t season_ns;         // 季节周期（仅Holt-Winters）
+    int season_buckets;         // 每个周期的桶数（仅Holt-Winters）
+    int warmup;                 // 开始给出预测前需要的样本数
+} ForecastParams;
+
+/* 模型状态，seasonal为柔性数组，长度为season_buckets（EWMA为0） */
+typedef struct {
+    ForecastKind kind;
+    ForecastParams params;
+    int64_t clock_offset_ns;    // 样本时间戳加上它得到Unix纪元时间，用于计算季节相位
+    uint64_t count;             // 已并入的样本数
+    double level;               // 水平
+    double trend;               // 趋势（每个样本）
+    double variance;            // 残差的指数加权方差
+    double predicted;           // 最近一个样本到达前的一步预测
+    double scale;               // 最近一个样本到达前的残差标准差
+    bool ready;                 // predicted和scale是否可用于检测
+    float seasonal[];           // 各桶的季节分量，NaN表示该桶尚未出现过
+} Forecast;
+
+/**
+ * @brief 创建模型
+ * @param kind 模型种类
+ * @param params 模型参数
+ * @param clock_offset_ns 样本时间戳到Unix纪元时间的偏移
+ * @return 模型指针，失败返回NULL，用free释放
+ */
+Forecast *forecast_create(ForecastKind kind, const ForecastParams *params, int64_t clock_offset_ns);
+
+/**
+ * @brief 模型占用的字节数（用于检查点）
+ * @param forecast 模型指针
+ * @return 字节数
+ */
+size_t forecast_size(const Forecast *forecast);
+
+/**
+ * @brief 并入一个样本：先记录一步预测和残差尺度，再更新状态
+ * @param forecast 模型指针
+ * @param value 样本值
+ * @param timestamp_ns 样本时间戳
+ */
+void forecast_update(Forecast *forecast, double value, uint64_t timestamp_ns);
+
+/**
+ * @brief 用检查点中的状态覆盖模型（种类和季节桶数必须一致）
+ * @param forecast 模型指针
+ * @param saved 检查点中的模型
+ * @return 成功返回0，不一致返回非0
+ */
+int forecast_restore(Forecast *forecast, const Forecast *saved);
+
+#endif /* FORECAST_H */
@@ -0,0 +1,151 @@
+/**
+ * @file ingest.h
+ * @brief 多主机样本上报协议头文件
+ *
+ * 代理（或负载生成器）把样本打包成数据报发送给汇聚服务端，传输层为本地
+ * UDP或Unix数据报套接字。每个数据报是一帧：帧头之后是若干定长记录，
+ * 字节序为主机字节序（只用于本机或同构主机之间）。
+ *
+ *   - 样本帧（INGEST_FRAME_SAMPLES）：每条记录为序列键和样本值，共16字节，
+ *     同一帧内的样本共用帧头中的采样时间；
+ *   - 序列帧（INGEST_FRAME_SERIES）：每条记录为序列键、主机名和指标名。
+ *
+ * 序列键是主机名和指标名的FNV-1a哈希（见ingest_series_key），服务端收到
+ * 序列帧后才认识该键，之前的样本被计为未知样本丢弃。数据报可能丢失，
+ * 代理应定期重发序列帧（客户端每INGEST_DEFINE_EVERY帧样本重发一次）。
+ */
+
+#ifndef INGEST_H
+#define INGEST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include "name_index.h"
+
+#define INGEST_MAGIC 0x46494441u   // 帧魔数（内存中为"ADIF"）
+#define INGEST_VERSION 1            // 协议版本
+#define INGEST_MAX_FRAME 16384      // 单帧最大字节数
+#define INGEST_HOST_LEN 32          // 主机名最大长度（含结尾'\0'）
+#define INGEST_DEFINE_EVERY 64      // 客户端每发送多少帧样本重发一次序列定义
+
+/* 帧类型 */
+typedef enum {
+    INGEST_FRAME_SAMPLES = 1,       // 样本帧
+    INGEST_FRAME_SERIES = 2         // 序列定义帧
+} IngestFrameKind;
+
+/* 帧头 */
+typedef struct {
+    uint32_t magic;                 // INGEST_MAGIC
+    uint16_t version;               // INGEST_VERSION
+    uint16_t kind;                  // 帧类型（IngestFrameKind）
+    uint32_t count;                 // 记录数
+    uint32_t reserved;              // 保留，写0
+    uint64_t timestamp_ns;          // 采样时间（Unix纪元纳秒，仅样本帧）
+} IngestFrameHeader;
+
+/* 样本记录 */
+typedef struct {
+    uint64_t key;                   // 序列键
+    double value;                   // 样本值
+} IngestSample;
+
+/* 序列定义记录 */
+typedef struct {
+    uint64_t key;                   // 序列键
+    char host[INGEST_HOST_LEN];     // 主机名
+    char metric[NAME_INDEX_KEY_LEN]; // 指标名（种类名[:实例名]，如disk_util:sda）
+} IngestSeries;
+
+#define INGEST_SAMPLES_PER_FRAME ((INGEST_MAX_FRAME - sizeof(IngestFrameHeader)) / sizeof(IngestSample))
+#define INGEST_SERIES_PER_FRAME ((INGEST_MAX_FRAME - sizeof(IngestFrameHeader)) / sizeof(IngestSeries))
+
+/* 解析后的地址 */
+typedef struct {
+    struct sockaddr_storage addr;   // 套接字地址
+    socklen_t len;                  // 地址长度
+    int family;                     // AF_INET、AF_INET6或AF_UNIX
+} IngestAddress;
+
+/* 上报客户端，单线程使用 */
+typedef struct {
+    int fd;                         // 已连接的数据报套接字
+    char host[INGEST_HOST_LEN];     // 本机名
+    IngestSeries *series;           // 已定义的序列，定期重发
+    int series_count;
+    int series_capacity;
+    int series_sent;                // 已发送定义的序列数
+    int frames_since_define;        // 距上次重发序列定义发送的样本帧数
+    unsigned long frames;           // 已发送的帧数
+    unsigned long send_errors;      // 发送失败（如服务端接收缓冲区满）的帧数
+    IngestFrameHeader *frame;       // 正在填充的样本帧
+    IngestSample *samples;          // frame之后的样本记录
+} IngestClient;
+
+/**
+ * @brief 解析地址："udp:<主机>:<端口>"（IPv6地址写在方括号中）或"unix:<路径>"
+ * @param text 地址字符串
+ * @param address 存储结果的指针
+ * @return 成功返回0，格式错误返回非0
+ */
+int ingest_parse_address(const char *text, IngestAddress *address);
+
+/**
+ * @brief 计算序列键（主机名和指标名的64位FNV-1a哈希）
+ * @param host 主机名
+ * @param metric 指标名
+ * @return 序列键
+ */
+uint64_t ingest_series_key(const char *host, const char *metric);
+
+/**
+ * @brief 检查帧头并返回记录数
+ * @param data 数据报
+ * @param len 数据报长度
+ * @return 帧头有效且长度与记录数相符时返回记录数，否则返回-1
+ */
+int ingest_frame_records(const void *data, size_t len);
+
+/**
+ * @brief 连接服务端
+ * @param client 客户端指针
+ * @param address 服务端地址（格式见ingest_parse_address）
+ * @param host 本机名，NULL表示使用gethostname
+ * @return 成功返回0，失败返回非0
+ */
+int ingest_client_open(IngestClient *client, const char *address, const char *host);
+
+/**
+ * @brief 定义一个序列，序列定义随下一帧样本一起发出
+ * @param client 客户端指针
+ * @param metric 指标名（种类名[:实例名]）
+ * @param key 存储序列键的指针
+ * @return 成功返回0，失败返回非0
+ */
+int ingest_client_define(IngestClient *client, const char *metric, uint64_t *key);
+
+/**
+ * @brief 追加一个样本；采样时间与当前帧不同或帧已满时先发送当前帧
+ * @param client 客户端指针
+ * @param key 序列键
+ * @param value 样本值
+ * @param timestamp_ns 采样时间（Unix纪元纳秒）
+ * @return 成功返回0，发送失败返回非0（未发出的帧被丢弃，样本仍进入下一帧）
+ */
+int ingest_client_sample(IngestClient *client, uint64_t key, double value, uint64_t timestamp_ns);
+
+/**
+ * @brief 发送当前帧中的样本
+ * @param client 客户端指针
+ * @return 成功或没有样本时返回0，发送失败返回非0
+ */
+int ingest_client_flush(IngestClient *client);
+
+/**
+ * @brief 发送剩余样本并关闭连接
+ * @param client 客户端指针
+ */
+void ingest_client_close(IngestClient *client);
+
+#endif /* INGEST_H */
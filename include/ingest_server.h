@@ -0,0 +1,124 @@
+/**
+ * @file ingest_server.h
+ * @brief 多主机样本汇聚服务端头文件
+ *
+ * 一个接收线程从UDP或Unix数据报套接字批量读取帧（协议见ingest.h），按序列键
+ * 的哈希把序列分配给工作线程。每个工作线程拥有独立的异常检测器，序列只属于
+ * 一个工作线程，热路径上没有共享锁：接收线程独占序列键映射表，为每个工作线程
+ * 分配连续的序列号，把序列创建事件和样本写入采样批次，经单生产者单消费者
+ * 队列交给工作线程；工作线程应用批次后只检测本批次写入样本的指标。
+ * 队列满时丢弃样本并计数，序列事件随下一个批次送达。
+ *
+ * 汇聚的指标名为 种类名:主机名[/实例名]，如cpu_usage:web01、disk_util:web01/sda，
+ * 阈值和描述沿用指标种类的设置。
+ */
+
+#ifndef INGEST_SERVER_H
+#define INGEST_SERVER_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include "anomaly_detection.h"
+#include "alert.h"
+#include "sample_batch.h"
+#include "log_writer.h"
+#include "alert_log.h"
+#include "spsc_ring.h"
+#include "ingest.h"
+
+/* 服务端参数 */
+typedef struct {
+    const char *address;            // 监听地址（格式见ingest_parse_address）
+    int workers;                    // 工作线程数，0表示在线CPU数
+    int window_size;                // 滑动窗口大小
+    double sigma_factor;            // N-Sigma因子
+    const char *log_file;           // 异常日志文件路径
+    const char *alert_log_file;     // 结构化告警日志文件路径，NULL表示不写入
+    const char *detector_metrics[DETECTOR_COUNT]; // 各检测器的指标列表，NULL表示无
+    const MetricSetting *settings;  // 按指标覆盖的阈值和N-Sigma因子，启动时复制到各工作线程
+    int setting_count;
+    uint64_t season_ns;             // Holt-Winters季节周期，0表示默认
+    uint64_t alert_pending_ns;      // 告警触发前需要持续异常的时长
+    uint64_t alert_resolve_ns;      // 告警恢复前需要持续正常的时长
+    unsigned long queue_depth;      // 每个工作线程的队列深度（批次数量）
+} IngestServerConfig;
+
+/* 服务端计数器，各线程只做原子加 */
+typedef struct {
+    atomic_ulong series;            // 已定义的序列数
+    atomic_ulong frames;            // 收到的有效帧数
+    atomic_ulong bad_frames;        // 格式错误的数据报数
+    atomic_ulong samples;           // 收到的样本数
+    atomic_ulong unknown_samples;   // 序列键尚未定义而丢弃的样本数
+    atomic_ulong rejected_series;   // 指标名无效或键不匹配而拒绝的序列定义数
+    atomic_ulong dropped_samples;   // 工作线程队列满而丢弃的样本数
+    atomic_ulong detected_samples;  // 工作线程已检测的样本数
+    atomic_ulong anomalies;         // 检测到的异常数
+    atomic_ulong alerts;            // 触发的告警数
+} IngestCounters;
+
+/* 序列键映射表项 */
+typedef struct {
+    uint64_t key;                   // 序列键，0表示空槽位
+    int worker;                     // 所属工作线程
+    int series;                     // 工作线程内的序列号
+} IngestKeySlot;
+
+struct IngestServer;
+
+/* 工作线程 */
+typedef struct {
+    struct IngestServer *server;
+    int index;                      // 工作线程编号
+    pthread_t thread;
+    SpscRing ring;                  // 接收 -> 工作线程
+
+    // 接收线程独占
+    SampleBatch pending;            // 正在填充的批次
+    int series_count;               // 已分配的序列号数量
+
+    // 工作线程独占
+    AnomalyDetector detector;       // 本线程负责的序列
+    AlertTracker alerts;            // 本线程负责的序列的告警状态
+    time_t cached_second;           // 日志时间戳缓存
+    char cached_time[32];
+} IngestWorker;
+
+/* 服务端 */
+typedef struct IngestServer {
+    IngestServerConfig config;
+    IngestCounters counters;
+    int fd;                         // 监听的数据报套接字
+    int wake_fd;                    // 唤醒接收线程的eventfd
+    atomic_bool stopping;           // 请求停止接收
+    atomic_bool receiver_done;      // 接收线程已退出
+    pthread_t receiver_thread;
+    char *recv_buffers;             // recvmmsg的数据报缓冲区（接收线程独占）
+    IngestKeySlot *keys;            // 序列键映射表（开放寻址，接收线程独占）
+    unsigned long key_mask;         // 映射表容量-1
+    unsigned long key_count;        // 映射表中的序列数
+    IngestWorker *workers;
+    int worker_count;
+    LogWriter log;                  // 告警日志，各工作线程整块追加
+    bool alert_log_enabled;         // 是否写入结构化告警日志
+    AlertLog alert_log;             // 结构化告警日志，各工作线程逐条追加
+} IngestServer;
+
+/**
+ * @brief 绑定监听地址，启动接收线程和工作线程
+ *
+ * 调用者应在启动前屏蔽需要同步处理的信号，新线程会继承信号屏蔽字。
+ *
+ * @param server 服务端指针
+ * @param config 服务端参数
+ * @return 成功返回0，失败返回非0
+ */
+int ingest_server_start(IngestServer *server, const IngestServerConfig *config);
+
+/**
+ * @brief 停止接收，等待队列中的批次检测完毕后回收线程和资源
+ * @param server 服务端指针
+ */
+void ingest_server_stop(IngestServer *server);
+
+#endif /* INGEST_SERVER_H */
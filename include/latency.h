@@ -0,0 +1,112 @@
+/**
+ * @file latency.h
+ * @brief 各处理阶段的延迟直方图头文件
+ *
+ * 每个阶段一个定长的对数分桶直方图：小于8纳秒的值各占一个桶，之后每个
+ * 2的幂区间再均分为8个桶，相对误差不超过12.5%，覆盖全部64位纳秒值，
+ * 共496个桶。记录只是读一次单调时钟和几次原子加，可以常开；
+ * 读取（分位数、打印、指标端点）与记录并发进行，不需要加锁。
+ */
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdatomic.h>
+
+#define LATENCY_SUB_BITS 3                                   // 每个2的幂区间的分桶位数
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BITS)          // 每个2的幂区间的桶数
+#define LATENCY_BUCKETS ((64 - LATENCY_SUB_BITS + 1) * LATENCY_SUB_BUCKETS)
+
+/* 处理阶段 */
+typedef enum {
+    LATENCY_PROC_STAT,              // 读取并解析/proc/stat
+    LATENCY_PROC_MEMINFO,           // 读取并解析/proc/meminfo
+    LATENCY_PROC_DISKSTATS,         // 读取并解析/proc/diskstats
+    LATENCY_PROC_NETDEV,            // 读取并解析/proc/net/dev
+    LATENCY_READ_CPU,               // 推导CPU指标（含每CPU和每节点）
+    LATENCY_READ_MEM,               // 推导内存指标
+    LATENCY_READ_DISK,              // 推导磁盘指标
+    LATENCY_READ_NET,               // 推导网络指标
+    LATENCY_READ_PROCESS,           // 采集进程级资源占用
+    LATENCY_COLLECT,                // 采集一个周期（以上全部）
+    LATENCY_APPLY,                  // 把采样批次写入指标（add_metric_datapoint）
+    LATENCY_SERIES,                 // 追加到序列文件
+    LATENCY_DETECT_NSIGMA,          // N-Sigma检测
+    LATENCY_DETECT_MAD,             // 中位数/MAD检测
+    LATENCY_DETECT_FORECAST,        // EWMA/Holt-Winters预测检测
+    LATENCY_DETECT_THRESHOLD,       // 阈值检测
+    LATENCY_DETECT_CORRELATION,     // 多维相关（马氏距离）检测
+    LATENCY_ALERT,                  // 更新告警状态
+    LATENCY_DETECT,                 // 检测一个周期（以上全部及生成输出批次）
+    LATENCY_PRINT,                  // 打印指标值和异常
+    LATENCY_LOG,                    // 把异常交给日志写入器
+    LATENCY_EXPOSITION,             // 渲染指标端点页面
+    LATENCY_END_TO_END,             // 从采样到输出完成
+    LATENCY_STAGE_COUNT             // 阶段总数
+} LatencyStage;
+
+/* 一个阶段的直方图 */
+typedef struct {
+    atomic_ulong buckets[LATENCY_BUCKETS];
+    atomic_ulong sum_ns;            // 总耗时（纳秒）
+    atomic_ulong max_ns;            // 最大耗时（纳秒）
+} LatencyHistogram;
+
+/* 直方图摘要 */
+typedef struct {
+    unsigned long count;            // 记录次数
+    double mean_ns;                 // 平均耗时
+    uint64_t sum_ns;                // 总耗时
+    uint64_t max_ns;                // 最大耗时
+    uint64_t p50_ns;                // 各分位数（所在桶的上界，不超过最大值）
+    uint64_t p90_ns;
+    uint64_t p99_ns;
+    uint64_t p999_ns;
+} LatencySummary;
+
+/**
+ * @brief 记录一次耗时
+ * @param stage 阶段
+ * @param elapsed_ns 耗时（纳秒）
+ */
+void latency_add(LatencyStage stage, uint64_t elapsed_ns);
+
+/**
+ * @brief 记录从start_ns到现在的耗时
+ *
+ * 返回的当前时间可以直接作为下一个阶段的起点，连续的阶段每个只读一次时钟。
+ *
+ * @param stage 阶段
+ * @param start_ns 起始时间（单调时钟，纳秒）
+ * @return 当前时间（单调时钟，纳秒）
+ */
+uint64_t latency_record(LatencyStage stage, uint64_t start_ns);
+
+/**
+ * @brief 计算一个阶段的摘要
+ * @param stage 阶段
+ * @param summary 存储摘要的指针
+ */
+void latency_summarize(LatencyStage stage, LatencySummary *summary);
+
+/**
+ * @brief 获取阶段名称（英文标识符，用作指标标签）
+ * @param stage 阶段
+ * @return 阶段名称
+ */
+const char *latency_stage_name(LatencyStage stage);
+
+/**
+ * @brief 打印各阶段的次数、平均值和分位数（微秒），跳过没有记录的阶段
+ * @param out 输出流
+ */
+void latency_dump(FILE *out);
+
+/**
+ * @brief 清空全部直方图（用于基准测试）
+ */
+void latency_reset(void);
+
+#endif /* LATENCY_H */
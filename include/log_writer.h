@@ -0,0 +1,105 @@
+/**
+ * @file log_writer.h
+ * @brief 异步日志写入模块头文件
+ *
+ * 日志文件在运行期间保持打开，记录先追加到内存缓冲区，由后台线程在缓冲区
+ * 达到大小阈值或超过刷新间隔时整块写入。缓冲区为双缓冲：后台线程写一块时
+ * 写入方继续向另一块追加，只有两块都满时写入方才等待，记录不会丢失。
+ * 文件按大小或时间轮转，轮转发生在两次整块写入之间，记录不会跨文件截断。
+ */
+
+#ifndef LOG_WRITER_H
+#define LOG_WRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+
+/* 日志写入参数 */
+typedef struct {
+    size_t buffer_size;             // 每块缓冲区大小（字节）
+    unsigned int flush_interval_ms; // 最长刷新间隔（毫秒）
+    uint64_t rotate_bytes;          // 文件超过该大小时轮转，0表示不按大小轮转
+    unsigned int rotate_age_sec;    // 文件打开超过该时间时轮转，0表示不按时间轮转
+    int rotate_keep;                // 保留的历史文件数量（path.1 ~ path.N）
+} LogWriterConfig;
+
+/* 异步日志写入器 */
+typedef struct {
+    LogWriterConfig config;
+    char path[256];                 // 日志文件路径
+    int fd;                         // 日志文件描述符
+    uint64_t file_bytes;            // 当前文件大小
+    time_t file_opened;             // 当前文件打开时间
+
+    pthread_mutex_t lock;
+    pthread_cond_t flush_cond;      // 通知后台线程刷新
+    pthread_cond_t space_cond;      // 通知写入方缓冲区已腾出/数据已写入
+    pthread_t thread;
+    bool running;                   // 后台线程已启动（只由打开和关闭写入器的线程访问）
+    bool closing;                   // 请求关闭
+    bool flush_requested;           // 请求立即刷新
+
+    char *active;                   // 写入方追加的缓冲区
+    size_t active_len;
+    char *spare;                    // 后台线程正在写出的缓冲区
+    uint64_t appended;              // 累计追加字节数
+    uint64_t written;               // 累计写出（或因错误放弃）的字节数
+    unsigned long write_errors;     // 写入失败次数
+    unsigned long rotations;        // 轮转次数
+
+    // 写入方的时间戳缓存，同一秒内的记录复用格式化结果
+    time_t cached_second;
+    char cached_time[32];
+} LogWriter;
+
+/**
+ * @brief 获取默认写入参数（取自config.h）
+ * @param config 存储参数的指针
+ */
+void log_writer_default_config(LogWriterConfig *config);
+
+/**
+ * @brief 打开日志文件并启动后台刷新线程
+ * @param writer 写入器指针
+ * @param path 日志文件路径（追加写入）
+ * @param config 写入参数，NULL表示使用默认参数
+ * @return 成功返回0，失败返回非0
+ */
+int log_writer_open(LogWriter *writer, const char *path, const LogWriterConfig *config);
+
+/**
+ * @brief 追加一条或多条完整记录，缓冲区都满时等待后台线程写出
+ * @param writer 写入器指针
+ * @param data 记录内容（应以换行结尾）
+ * @param len 字节数，不能超过缓冲区大小
+ * @return 成功返回0，失败返回非0
+ */
+int log_writer_append(LogWriter *writer, const char *data, size_t len);
+
+/**
+ * @brief 格式化时间戳（"%Y-%m-%d %H:%M:%S"），同一秒内返回缓存结果
+ *
+ * 缓存不加锁，只应由追加记录的那一个线程调用。
+ *
+ * @param writer 写入器指针
+ * @param timestamp 时间
+ * @return 格式化后的字符串，下一次调用前有效
+ */
+const char *log_writer_time(LogWriter *writer, time_t timestamp);
+
+/**
+ * @brief 等待调用前追加的记录全部写入文件
+ * @param writer 写入器指针
+ */
+void log_writer_flush(LogWriter *writer);
+
+/**
+ * @brief 写出剩余记录，停止后台线程并关闭文件
+ * @param writer 写入器指针
+ */
+void log_writer_close(LogWriter *writer);
+
+#endif /* LOG_WRITER_H */
@@ -1,89 +1,233 @@
 /**
  * @file metrics_collector.h
  * @brief 系统指标收集模块头文件
+ *
+ * 收集器的全部状态（快照、各来源的计数器组、序列号分配、过滤列表、
+ * 进程采集器）都在MetricsCollector上下文中，没有文件作用域的可变状态，
+ * 同一进程中可以有多个互不影响的收集器。
+ *
+ * 每个周期，各procfs数据源的读取解析和进程扫描作为互相独立的任务提交到
+ * 收集器的工作线程池并行执行，收集器最多等待一个数据源超时时间。到期仍未
+ * 完成的数据源（如被挂起的文件或规模巨大的进程扫描）本周期不产生数据，
+ * 任务继续在后台运行，完成前该数据源在之后的周期中被跳过，不会拖住整个
+ * 周期。指标推导在所有任务返回后由采集线程完成，只读各来源自己的字段。
  */
 
 #ifndef METRICS_COLLECTOR_H
 #define METRICS_COLLECTOR_H
 
 #include "anomaly_detection.h"
+#include "proc_snapshot.h"
+#include "sample_batch.h"
+#include "counter_rate.h"
+#include "worker_pool.h"
+
+/* 收集器参数 */
+typedef struct {
+    const char *proc_root;          // procfs根目录，NULL表示"/proc"
+    int process_top_k;              // 进程占用排行的进程数，0表示不采集（最大PROCESS_TOP_MAX）
+    int workers;                    // 并行读取数据源的工作线程数，0表示在采集线程中依次读取
+    uint64_t source_timeout_ns;     // 单个数据源的最长等待时间（纳秒），0表示一直等待
+} CollectorConfig;
+
+/* 指标收集器，由一个采集线程使用 */
+typedef struct MetricsCollector MetricsCollector;
+
+/* CPU时间计数器组中的下标 */
+typedef enum {
+    CPU_COUNTER_USER,
+    CPU_COUNTER_NICE,
+    CPU_COUNTER_SYSTEM,
+    CPU_COUNTER_IDLE,
+    CPU_COUNTER_IOWAIT,
+    CPU_COUNTER_IRQ,
+    CPU_COUNTER_SOFTIRQ,
+    CPU_COUNTER_STEAL,
+    CPU_COUNTERS
+} CpuCounter;
+
+/* 块设备计数器组中的下标 */
+typedef enum {
+    DISK_COUNTER_READS,         // 完成的读请求数
+    DISK_COUNTER_READ_TIME,     // 读请求耗时（ms）
+    DISK_COUNTER_WRITES,        // 完成的写请求数
+    DISK_COUNTER_WRITE_TIME,    // 写请求耗时（ms）
+    DISK_COUNTER_IO_TIME,       // 设备忙碌时间（ms）
+    DISK_COUNTERS
+} DiskCounter;
+
+/* 网络接口计数器组中的下标 */
+typedef enum {
+    NET_COUNTER_RX_DROP,
+    NET_COUNTER_TX_DROP,
+    NET_COUNTERS
+} NetCounter;
+
+/*
+ * 所有read_*函数都从同一份ProcSnapshot推导指标值，不再直接访问/proc。
+ * 累计计数器类指标（CPU、磁盘、网络）先由*_counters_update把快照中的计数器
+ * 与该来源的计数器组比较，得到本采样区间的增量，再由read_*从增量计算
+ * 区间内的速率和比值；同一来源的几个指标共用一次更新，保证来自同一区间。
+ * 块设备和网络接口在出现于快照时创建序列，消失后退役。
+ */
 
 /**
- * @brief 从/proc文件系统读取CPU使用率
- * @param usage 存储CPU使用率的指针
+ * @brief 更新CPU时间计数器组
+ * @param set 计数器组（聚合CPU或单个CPU）
+ * @param cpu 当前的CPU时间计数器
+ * @param timestamp_ns 快照的采样时间（单调时钟，纳秒）
+ * @param delta 存储本区间增量的指针
+ * @return 增量有效返回0，只记录了基准返回非0
+ */
+int cpu_counters_update(CounterSet *set, const CpuTimes *cpu, uint64_t timestamp_ns,
+                        CounterDelta *delta);
+
+/**
+ * @brief 从区间增量计算CPU使用率
+ * @param delta cpu_counters_update得到的增量
+ * @param usage 存储CPU使用率的指针（%）
  * @return 成功返回0，失败返回非0
  */
-int read_cpu_usage(double *usage);
+int read_cpu_usage(const CounterDelta *delta, double *usage);
 
 /**
- * @brief 从/proc文件系统读取CPU IO等待时间
- * @param iowait 存储IO等待时间的指针
+ * @brief 从区间增量计算CPU IO等待时间
+ * @param delta cpu_counters_update得到的增量
+ * @param iowait 存储IO等待时间的指针（%）
  * @return 成功返回0，失败返回非0
  */
-int read_cpu_iowait(double *iowait);
+int read_cpu_iowait(const CounterDelta *delta, double *iowait);
 
 /**
- * @brief 从/proc文件系统读取CPU中断时间
- * @param irq 存储中断时间的指针
+ * @brief 从区间增量计算CPU中断时间
+ * @param delta cpu_counters_update得到的增量
+ * @param irq 存储中断时间的指针（%）
  * @return 成功返回0，失败返回非0
  */
-int read_cpu_irq(double *irq);
+int read_cpu_irq(const CounterDelta *delta, double *irq);
 
 /**
- * @brief 从/proc文件系统读取内存使用率
+ * @brief 从快照计算内存使用率
+ * @param snap /proc快照
  * @param usage 存储内存使用率的指针
  * @return 成功返回0，失败返回非0
  */
-int read_mem_usage(double *usage);
+int read_mem_usage(const ProcSnapshot *snap, double *usage);
 
 /**
- * @brief 从/proc文件系统读取活跃内存大小
+ * @brief 从快照读取活跃内存大小
+ * @param snap /proc快照
  * @param active 存储活跃内存大小的指针（KB）
  * @return 成功返回0，失败返回非0
  */
-int read_mem_active(double *active);
+int read_mem_active(const ProcSnapshot *snap, double *active);
+
+/**
+ * @brief 更新块设备计数器组
+ * @param set 该设备的计数器组
+ * @param disk 快照中的块设备统计
+ * @param timestamp_ns 快照的采样时间（单调时钟，纳秒）
+ * @param delta 存储本区间增量的指针
+ * @return 增量有效返回0，只记录了基准返回非0
+ */
+int disk_counters_update(CounterSet *set, const DiskStats *disk, uint64_t timestamp_ns,
+                         CounterDelta *delta);
 
 /**
- * @brief 从/proc/diskstats读取磁盘读响应时间
- * @param read_await 存储读响应时间的指针（ms）
- * @param device 磁盘设备名（如sda）
+ * @brief 计算区间内完成的读请求的平均响应时间
+ * @param delta disk_counters_update得到的增量
+ * @param read_await 存储读响应时间的指针（ms），区间内没有读请求时为0
  * @return 成功返回0，失败返回非0
  */
-int read_disk_read_await(double *read_await, const char *device);
+int read_disk_read_await(const CounterDelta *delta, double *read_await);
 
 /**
- * @brief 从/proc/diskstats读取磁盘写响应时间
- * @param write_await 存储写响应时间的指针（ms）
- * @param device 磁盘设备名（如sda）
+ * @brief 计算区间内完成的写请求的平均响应时间
+ * @param delta disk_counters_update得到的增量
+ * @param write_await 存储写响应时间的指针（ms），区间内没有写请求时为0
  * @return 成功返回0，失败返回非0
  */
-int read_disk_write_await(double *write_await, const char *device);
+int read_disk_write_await(const CounterDelta *delta, double *write_await);
 
 /**
- * @brief 从/proc/diskstats读取磁盘使用率
+ * @brief 计算区间内设备忙碌时间的占比
+ * @param delta disk_counters_update得到的增量
  * @param util 存储磁盘使用率的指针（%）
- * @param device 磁盘设备名（如sda）
  * @return 成功返回0，失败返回非0
  */
-int read_disk_util(double *util, const char *device);
+int read_disk_util(const CounterDelta *delta, double *util);
 
 /**
- * @brief 从/proc/net/dev读取网络丢包数
+ * @brief 更新网络接口计数器组
+ * @param set 该接口的计数器组
+ * @param net 快照中的网络接口统计
+ * @param timestamp_ns 快照的采样时间（单调时钟，纳秒）
+ * @param delta 存储本区间增量的指针
+ * @return 增量有效返回0，只记录了基准返回非0
+ */
+int net_counters_update(CounterSet *set, const NetDevStats *net, uint64_t timestamp_ns,
+                        CounterDelta *delta);
+
+/**
+ * @brief 计算区间内每秒网络丢包数（收发合计）
+ * @param delta net_counters_update得到的增量
  * @param dropped 存储丢包数的指针
- * @param interface 网络接口名（如eth0）
  * @return 成功返回0，失败返回非0
  */
-int read_net_dropped(double *dropped, const char *interface);
+int read_net_dropped(const CounterDelta *delta, double *dropped);
 
 /**
- * @brief 初始化指标收集器
- * @return 成功返回0，失败返回非0
+ * @brief 获取默认收集器参数（取自config.h）
+ * @param config 存储参数的指针
  */
-int init_metrics_collector();
+void metrics_collector_default_config(CollectorConfig *config);
 
 /**
- * @brief 清理指标收集器资源
+ * @brief 创建指标收集器：打开数据源、读取NUMA拓扑、记录计数器基准并启动工作线程
+ * @param config 收集器参数
+ * @return 成功返回收集器指针，失败返回NULL
+ */
+MetricsCollector *metrics_collector_create(const CollectorConfig *config);
+
+/**
+ * @brief 停止工作线程并释放收集器，仍在运行的读取任务最多再等待一个数据源超时，
+ *        到期未完成时保留收集器的内存供该任务使用，不阻塞退出
+ * @param collector 收集器指针，可以为NULL
+ */
+void metrics_collector_free(MetricsCollector *collector);
+
+/**
+ * @brief 设置要跟踪的磁盘设备和网络接口，下一个周期生效
+ * @param collector 收集器指针
+ * @param disks 逗号分隔的设备名列表，NULL或空串表示自动发现全部整盘设备
+ * @param interfaces 逗号分隔的接口名列表，NULL或空串表示自动发现全部接口
+ * @return 成功返回0，列表过长返回非0（保留原来的设置）
+ */
+int set_collector_filters(MetricsCollector *collector, const char *disks, const char *interfaces);
+
+/**
+ * @brief 检查设备和接口列表是否可用于set_collector_filters，不改变当前设置
+ * @param disks 逗号分隔的设备名列表
+ * @param interfaces 逗号分隔的接口名列表
+ * @return 可用返回0，列表过长返回非0
+ */
+int check_collector_filters(const char *disks, const char *interfaces);
+
+/**
+ * @brief 采集一个周期的样本，追加到批次中（不访问异常检测器）
+ * @param collector 收集器指针
+ * @param batch 采样批次，时间戳设置为本周期快照时间
+ * @param timeouts 存储本周期超时或仍被上次读取占用的数据源数量，可以为NULL
+ * @return 成功返回0，有数据源读取失败或超时时返回非0
+ */
+int collect_samples(MetricsCollector *collector, SampleBatch *batch, int *timeouts);
+
+/**
+ * @brief 采集一个周期并直接写入异常检测器（单线程用法）
+ * @param collector 收集器指针
+ * @param detector 异常检测器指针
+ * @return 成功返回0，失败返回非0
  */
-void cleanup_metrics_collector();
+int collect_metrics(MetricsCollector *collector, AnomalyDetector *detector);
 
 #endif /* METRICS_COLLECTOR_H */
@@ -0,0 +1,68 @@
+/**
+ * @file name_index.h
+ * @brief 名称哈希索引头文件
+ *
+ * 开放寻址（线性探测）哈希表，将字符串名称映射到整数（如指标下标），
+ * 删除采用后移法，不留墓碑，查找代价与表中存活元素数量无关。
+ */
+
+#ifndef NAME_INDEX_H
+#define NAME_INDEX_H
+
+#include <stdint.h>
+
+#define NAME_INDEX_KEY_LEN 64       // 名称最大长度（含结尾'\0'）
+
+/* 哈希表槽位 */
+typedef struct {
+    uint32_t hash;                  // 名称哈希值
+    int value;                      // 映射值，-1表示空槽
+    char key[NAME_INDEX_KEY_LEN];   // 名称
+} NameIndexSlot;
+
+/* 名称哈希索引 */
+typedef struct {
+    NameIndexSlot *slots;           // 槽位数组（容量为2的幂）
+    int capacity;                   // 槽位数量
+    int count;                      // 已用槽位数量
+} NameIndex;
+
+/**
+ * @brief 初始化哈希索引
+ * @param index 索引指针
+ * @param capacity 初始容量（会向上取整为2的幂）
+ * @return 成功返回0，失败返回非0
+ */
+int name_index_init(NameIndex *index, int capacity);
+
+/**
+ * @brief 释放哈希索引
+ * @param index 索引指针
+ */
+void name_index_free(NameIndex *index);
+
+/**
+ * @brief 查找名称
+ * @param index 索引指针
+ * @param key 名称
+ * @return 找到返回映射值，否则返回-1
+ */
+int name_index_find(const NameIndex *index, const char *key);
+
+/**
+ * @brief 插入或更新名称的映射值
+ * @param index 索引指针
+ * @param key 名称
+ * @param value 映射值（必须非负）
+ * @return 成功返回0，失败返回非0
+ */
+int name_index_put(NameIndex *index, const char *key, int value);
+
+/**
+ * @brief 删除名称
+ * @param index 索引指针
+ * @param key 名称
+ */
+void name_index_remove(NameIndex *index, const char *key);
+
+#endif /* NAME_INDEX_H */
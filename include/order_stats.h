@@ -0,0 +1,110 @@
+/**
+ * @file order_stats.h
+ * @brief 滑动窗口顺序统计结构头文件
+ *
+ * 以子树大小和子树和增强的treap，节点从定长节点池分配，插入、删除和
+ * 按名次选取均为期望O(log n)，不在运行中分配内存。用于中位数/MAD检测：
+ * 中位数是一次选取，MAD是两条有序偏差序列的第k小，由O(log n)次选取得到。
+ */
+
+#ifndef ORDER_STATS_H
+#define ORDER_STATS_H
+
+#include <stdint.h>
+
+/* treap节点 */
+typedef struct {
+    double value;               // 样本值
+    double sum;                 // 子树样本值之和
+    int left;                   // 左子节点，-1表示无
+    int right;                  // 右子节点，-1表示无
+    int size;                   // 子树节点数
+    uint32_t priority;          // 堆优先级（随机）
+} OrderStatsNode;
+
+/* 顺序统计结构 */
+typedef struct {
+    OrderStatsNode *nodes;      // 节点池
+    int capacity;               // 节点池容量（窗口大小）
+    int root;                   // 根节点，-1表示空
+    int free_list;              // 空闲节点链表（经left链接）
+    uint32_t seed;              // 优先级随机数状态
+} OrderStats;
+
+/**
+ * @brief 初始化顺序统计结构
+ * @param os 结构指针
+ * @param capacity 最多容纳的样本数
+ * @return 成功返回0，失败返回非0
+ */
+int order_stats_init(OrderStats *os, int capacity);
+
+/**
+ * @brief 释放顺序统计结构
+ * @param os 结构指针
+ */
+void order_stats_free(OrderStats *os);
+
+/**
+ * @brief 清空全部样本，保留节点池
+ * @param os 结构指针
+ */
+void order_stats_clear(OrderStats *os);
+
+/**
+ * @brief 样本数量
+ * @param os 结构指针
+ * @return 样本数量
+ */
+static inline int order_stats_count(const OrderStats *os) {
+    return os->root >= 0 ? os->nodes[os->root].size : 0;
+}
+
+/**
+ * @brief 插入样本
+ * @param os 结构指针
+ * @param value 样本值（NaN被拒绝）
+ * @return 成功返回0，已满或值为NaN返回非0
+ */
+int order_stats_insert(OrderStats *os, double value);
+
+/**
+ * @brief 删除一个等于value的样本
+ * @param os 结构指针
+ * @param value 样本值
+ * @return 成功返回0，不存在返回非0
+ */
+int order_stats_remove(OrderStats *os, double value);
+
+/**
+ * @brief 按名次选取样本
+ * @param os 结构指针
+ * @param k 名次（0表示最小值），必须小于样本数量
+ * @return 第k小的样本值
+ */
+double order_stats_select(const OrderStats *os, int k);
+
+/**
+ * @brief 中位数（样本数为偶数时取中间两个的平均值）
+ * @param os 结构指针，不能为空
+ * @return 中位数
+ */
+double order_stats_median(const OrderStats *os);
+
+/**
+ * @brief 中位数绝对偏差 median(|x - median|)
+ * @param os 结构指针，不能为空
+ * @param median order_stats_median的结果
+ * @return MAD
+ */
+double order_stats_mad(const OrderStats *os, double median);
+
+/**
+ * @brief 相对中位数的平均绝对偏差 mean(|x - median|)，MAD为0时用作尺度
+ * @param os 结构指针，不能为空
+ * @param median order_stats_median的结果
+ * @return 平均绝对偏差
+ */
+double order_stats_mean_abs_dev(const OrderStats *os, double median);
+
+#endif /* ORDER_STATS_H */
@@ -0,0 +1,172 @@
+/**
+ * @file output.h
+ * @brief 检测结果输出模块头文件
+ *
+ * 检测端每个周期生成一个输出批次（当前指标值和本周期的告警事件），由输出端
+ * 打印和写入日志。指标的名称和描述只在指标（重新）注册后随批次发送一次，
+ * 输出端按指标下标保存，稳定运行时批次中只有数值。
+ */
+
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include "anomaly_detection.h"
+#include "alert.h"
+#include "log_writer.h"
+#include "alert_log.h"
+#include "process_collector.h"
+
+/* 指标标签 */
+typedef struct {
+    int metric_id;                  // 指标下标
+    char name[NAME_INDEX_KEY_LEN];  // 指标名称
+    char description[256];          // 指标描述
+} MetricLabel;
+
+/* 指标当前值 */
+typedef struct {
+    int metric_id;                  // 指标下标
+    double value;                   // 当前值
+    double threshold;               // 阈值，0表示不做阈值检测（可随配置重新加载改变）
+    double mean;                    // 均值
+    double stddev;                  // 标准差
+    bool robust;                    // 是否使用中位数/MAD检测
+    double median;                  // 中位数（仅robust）
+    double mad;                     // 中位数绝对偏差（仅robust）
+    bool has_stats;                 // 是否有足够的历史数据显示统计信息
+} MetricReport;
+
+/* 输出批次，数组在批次复用时保留 */
+typedef struct {
+    unsigned long cycle;            // 周期序号（从1开始）
+    uint64_t timestamp_ns;          // 采样时间（单调时钟，纳秒）
+    bool detected;                  // 本周期是否运行了异常检测
+    MetricLabel *labels;            // 新注册指标的标签
+    int label_count;
+    int label_capacity;
+    MetricReport *reports;          // 在用指标的当前值
+    int report_count;
+    int report_capacity;
+    AlertEvent *events;             // 本周期的告警触发和恢复事件
+    int event_count;
+    int event_capacity;
+    int alerts_firing;              // 本周期结束时触发中的告警数
+    ProcessTop processes;           // 本周期占用最高的进程，用于说明CPU和内存异常
+} OutputBatch;
+
+/* 输出端状态：以指标下标索引的标签表 */
+typedef struct {
+    MetricLabel *labels;
+    int capacity;
+} OutputSink;
+
+/**
+ * @brief 初始化输出批次
+ * @param batch 批次指针
+ */
+void output_batch_init(OutputBatch *batch);
+
+/**
+ * @brief 释放输出批次
+ * @param batch 批次指针
+ */
+void output_batch_free(OutputBatch *batch);
+
+/**
+ * @brief 清空输出批次，保留已分配的数组
+ * @param batch 批次指针
+ */
+void output_batch_reset(OutputBatch *batch);
+
+/**
+ * @brief 追加指标标签
+ * @param batch 批次指针
+ * @param metric 指标指针
+ * @param metric_id 指标下标
+ * @return 成功返回0，失败返回非0
+ */
+int output_batch_add_label(OutputBatch *batch, const Metric *metric, int metric_id);
+
+/**
+ * @brief 追加指标当前值
+ * @param batch 批次指针
+ * @param metric 指标指针
+ * @param metric_id 指标下标
+ * @return 成功返回0，失败返回非0
+ */
+int output_batch_add_report(OutputBatch *batch, const Metric *metric, int metric_id);
+
+/**
+ * @brief 复制告警跟踪器中本周期的事件和触发中的告警数
+ * @param batch 批次指针
+ * @param tracker 告警跟踪器指针
+ * @return 成功返回0，失败返回非0
+ */
+int output_batch_copy_events(OutputBatch *batch, const AlertTracker *tracker);
+
+/**
+ * @brief 初始化输出端
+ * @param sink 输出端指针
+ */
+void output_sink_init(OutputSink *sink);
+
+/**
+ * @brief 释放输出端
+ * @param sink 输出端指针
+ */
+void output_sink_free(OutputSink *sink);
+
+/**
+ * @brief 把批次中的标签保存到输出端
+ * @param sink 输出端指针
+ * @param batch 批次指针
+ * @return 成功返回0，失败返回非0
+ */
+int output_sink_apply_labels(OutputSink *sink, const OutputBatch *batch);
+
+/**
+ * @brief 打印一个周期的指标值和异常
+ * @param sink 输出端指针
+ * @param batch 批次指针
+ */
+void print_output_batch(const OutputSink *sink, const OutputBatch *batch);
+
+/**
+ * @brief 把与异常指标相关的进程排行格式化为"名称(pid):占用,..."
+ *
+ * CPU使用率异常对应CPU占用排行，内存使用率和活跃内存异常对应常驻内存排行。
+ *
+ * @param batch 批次指针
+ * @param type 异常指标类型
+ * @param buf 输出缓冲区
+ * @param size 缓冲区大小
+ * @return 写入的字符数，没有相关排行时返回0
+ */
+int format_process_top(const OutputBatch *batch, MetricType type, char *buf, size_t size);
+
+/**
+ * @brief 打印本周期的告警事件
+ * @param sink 输出端指针
+ * @param batch 批次指针
+ */
+void print_alerts(const OutputSink *sink, const OutputBatch *batch);
+
+/**
+ * @brief 将告警事件追加到日志，由写入器异步写入文件
+ * @param sink 输出端指针
+ * @param batch 批次指针
+ * @param writer 日志写入器
+ * @return 成功返回0，失败返回非0
+ */
+int log_alerts(const OutputSink *sink, const OutputBatch *batch, LogWriter *writer);
+
+/**
+ * @brief 将告警事件追加到结构化告警日志
+ * @param sink 输出端指针
+ * @param batch 批次指针
+ * @param log 告警日志写入器
+ * @return 成功返回0，失败返回非0
+ */
+int record_alerts(const OutputSink *sink, const OutputBatch *batch, AlertLog *log);
+
+#endif /* OUTPUT_H */
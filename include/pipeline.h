@@ -0,0 +1,141 @@
+/**
+ * @file pipeline.h
+ * @brief 采集-检测-输出流水线头文件
+ *
+ * 采集、检测和输出分别运行在独立线程上，通过单生产者单消费者无锁队列
+ * 传递批次。队列有界，满时丢弃批次并计数，采样节奏不会被检测或输出阻塞。
+ *
+ * 运行时配置以指针发布，重新加载时主线程原子替换指针，采集和检测线程在
+ * 各自周期开始时发现版本变化并应用，随后公布已应用的版本。被替换的配置
+ * 在两个线程都应用了更新的版本后由主线程释放。重新加载只改变参数，
+ * 滑动窗口、统计量、预测模型和告警状态都保留。
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include "anomaly_detection.h"
+#include "sample_batch.h"
+#include "output.h"
+#include "log_writer.h"
+#include "alert_log.h"
+#include "series_store.h"
+#include "spsc_ring.h"
+#include "scheduler.h"
+#include "exposition.h"
+#include "psi.h"
+#include "alert.h"
+#include "runtime_config.h"
+#include "metrics_collector.h"
+
+/* 流水线参数 */
+typedef struct {
+    uint64_t interval_ns;           // 采样间隔（纳秒）
+    MetricsCollector *collector;    // 指标收集器，由调用者创建，在pipeline_stop之后释放
+    int window_size;                // 滑动窗口大小
+    RuntimeConfig *runtime;         // 初始运行时配置，调用pipeline_start后归流水线所有
+    const char *log_file;           // 异常日志文件路径
+    const char *alert_log_file;     // 结构化告警日志文件路径，NULL表示不写入
+    const char *series_file;        // 指标时间序列文件路径，NULL表示不持久化
+    uint64_t season_ns;             // Holt-Winters季节周期，0表示默认
+    const char *checkpoint_file;    // 预测模型检查点文件路径，NULL表示不保存
+    const char *metrics_address;    // Prometheus指标端点地址，NULL表示不启用
+    uint64_t burst_interval_ns;     // 资源压力触发的突发采样间隔，0表示不使用
+    uint64_t alert_pending_ns;      // 告警触发前需要持续异常的时长
+    uint64_t alert_resolve_ns;      // 告警恢复前需要持续正常的时长
+    unsigned long queue_depth;      // 队列深度
+} PipelineConfig;
+
+/* 流水线计数器，各线程只做原子加 */
+typedef struct {
+    atomic_ulong cycles;            // 已采集的周期数
+    atomic_ulong collect_errors;    // 数据源读取失败的周期数
+    atomic_ulong missed_deadlines;  // 错过的采样截止时间数
+    atomic_ulong source_timeouts;   // 超时未读完而被跳过的数据源次数
+    atomic_ulong dropped_samples;   // 因检测队列满而丢弃的采样批次数
+    atomic_ulong dropped_outputs;   // 因输出队列满而丢弃的输出批次数
+    atomic_ulong pressure_bursts;   // 资源压力触发突发采样的次数
+} PipelineCounters;
+
+/* 流水线 */
+typedef struct {
+    PipelineConfig config;
+    PipelineCounters counters;
+    atomic_bool stopping;           // 请求停止采集
+    atomic_bool collector_done;     // 采集线程已退出
+    atomic_bool detector_done;      // 检测线程已退出
+    int wake_fd;                    // 唤醒采集线程的eventfd
+    _Atomic(RuntimeConfig *) runtime; // 当前发布的运行时配置
+    atomic_ulong collector_generation; // 采集线程已应用的配置版本
+    atomic_ulong detector_generation;  // 检测线程已应用的配置版本
+    RuntimeConfig *retired;         // 已被替换、等待释放的配置，只由主线程访问
+
+    // 采集线程
+    pthread_t collector_thread;
+    Scheduler scheduler;
+    SampleBatch carry;              // 被丢弃批次中尚未送达的序列事件
+    SampleBatch overflow;           // 队列满时的临时批次
+    SpscRing sample_ring;           // 采集 -> 检测
+    bool psi_enabled;               // 是否监视资源压力
+    bool psi_polling;               // 是否有资源需要每个周期读取停顿时间（不支持触发器）
+    PsiMonitor psi;                 // 资源压力监视器
+    unsigned long seen_bursts;      // 已计入计数器的突发次数
+    atomic_uint pressure_resources; // 触发突发采样的资源位掩码，由输出线程读取后清零
+
+    // 检测线程
+    pthread_t detector_thread;
+    AnomalyDetector detector;
+    AlertTracker alerts;            // 各指标的告警状态，事件随输出批次发送
+    unsigned long cycle;            // 已检测的周期数
+    int restored;                   // 启动时从序列文件恢复的周期数
+    int forecasts_restored;         // 启动时从检查点恢复的预测模型数
+    uint64_t next_checkpoint_ns;    // 下一次保存检查点的采样时间
+    bool series_enabled;            // 是否写入序列文件
+    SeriesStore series;             // 指标时间序列文件
+    unsigned long *published;       // 每个指标下标已发送标签的注册编号
+    int published_capacity;
+    SpscRing output_ring;           // 检测 -> 输出
+
+    // 输出线程
+    pthread_t output_thread;
+    OutputSink sink;
+    LogWriter log;                  // 异常日志，由后台线程异步写入
+    bool alert_log_enabled;         // 是否写入结构化告警日志
+    AlertLog alert_log;             // 带索引的结构化告警日志
+    bool exposition_enabled;        // 是否启用指标端点
+    Exposition exposition;          // Prometheus指标端点，每个周期由输出线程渲染
+} Pipeline;
+
+/**
+ * @brief 初始化流水线并启动采集、检测和输出线程
+ *
+ * 参数中的指标收集器需已创建。调用者应在启动前屏蔽需要同步处理的信号，
+ * 新线程会继承信号屏蔽字。
+ *
+ * @param pipeline 流水线指针
+ * @param config 流水线参数
+ * @return 成功返回0，失败返回非0
+ */
+int pipeline_start(Pipeline *pipeline, const PipelineConfig *config);
+
+/**
+ * @brief 停止采集，等待队列中的批次处理完毕后回收线程和资源
+ * @param pipeline 流水线指针
+ */
+void pipeline_stop(Pipeline *pipeline);
+
+/**
+ * @brief 发布新的运行时配置，由启动流水线的线程调用
+ *
+ * 新配置在采集和检测线程的下一个周期开始时生效。配置中的设备和接口列表
+ * 应已用check_collector_filters检查过。
+ *
+ * @param pipeline 流水线指针
+ * @param config 新配置，调用后归流水线所有
+ * @return 新配置的版本号
+ */
+unsigned long pipeline_reload(Pipeline *pipeline, RuntimeConfig *config);
+
+#endif /* PIPELINE_H */
@@ -0,0 +1,174 @@
+/**
+ * @file proc_snapshot.h
+ * @brief /proc文件系统快照模块头文件
+ *
+ * 每个采样周期对每个procfs数据源只读取一次，文件描述符在周期之间保持打开，
+ * 使用不分配内存的手写扫描器解析，所有指标推导共享同一份快照。
+ */
+
+#ifndef PROC_SNAPSHOT_H
+#define PROC_SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PROC_NAME_LEN 32            // 设备名/接口名最大长度
+
+/* procfs数据源类型 */
+typedef enum {
+    PROC_SRC_STAT,              // /proc/stat
+    PROC_SRC_MEMINFO,           // /proc/meminfo
+    PROC_SRC_DISKSTATS,         // /proc/diskstats
+    PROC_SRC_NETDEV,            // /proc/net/dev
+    PROC_SRC_COUNT              // 数据源总数
+} ProcSourceType;
+
+/* 单个数据源：持久打开的文件描述符和可复用的读缓冲区 */
+typedef struct {
+    int fd;                     // 文件描述符（-1表示未打开）
+    char *buf;                  // 读缓冲区
+    size_t capacity;            // 缓冲区容量
+    size_t length;              // 本次读取的数据长度
+} ProcSource;
+
+/* CPU时间计数器（单位: jiffies） */
+typedef struct {
+    unsigned long long user;
+    unsigned long long nice;
+    unsigned long long system;
+    unsigned long long idle;
+    unsigned long long iowait;
+    unsigned long long irq;
+    unsigned long long softirq;
+    unsigned long long steal;
+} CpuTimes;
+
+/* 每CPU时间计数器，结构数组（SoA）布局，按/proc/stat中的出现顺序存放 */
+typedef struct {
+    int count;                  // 本次解析到的CPU数量（不含离线CPU）
+    int capacity;               // 数组容量，按在线CPU数初始化
+    int *cpu;                   // CPU编号
+    unsigned long long *user;
+    unsigned long long *nice;
+    unsigned long long *system;
+    unsigned long long *idle;
+    unsigned long long *iowait;
+    unsigned long long *irq;
+    unsigned long long *softirq;
+    unsigned long long *steal;
+} PerCpuTimes;
+
+/* 内存信息（单位: KB） */
+typedef struct {
+    unsigned long total;
+    unsigned long free;
+    unsigned long buffers;
+    unsigned long cached;
+    unsigned long active;
+} MemInfo;
+
+/* 块设备统计信息（/proc/diskstats的一行） */
+typedef struct {
+    char name[PROC_NAME_LEN];
+    unsigned long reads_completed;
+    unsigned long reads_merged;
+    unsigned long long sectors_read;
+    unsigned long read_time_ms;
+    unsigned long writes_completed;
+    unsigned long writes_merged;
+    unsigned long long sectors_written;
+    unsigned long write_time_ms;
+    unsigned long io_in_progress;
+    unsigned long io_time_ms;
+    unsigned long weighted_io_time_ms;
+} DiskStats;
+
+/* 网络接口统计信息（/proc/net/dev的一行） */
+typedef struct {
+    char name[PROC_NAME_LEN];
+    unsigned long long rx_bytes;
+    unsigned long long rx_packets;
+    unsigned long long rx_errs;
+    unsigned long long rx_drop;
+    unsigned long long tx_bytes;
+    unsigned long long tx_packets;
+    unsigned long long tx_errs;
+    unsigned long long tx_drop;
+} NetDevStats;
+
+/* 一个采样周期的/proc快照 */
+typedef struct {
+    ProcSource sources[PROC_SRC_COUNT]; // 各数据源
+    unsigned int valid;                 // 本次成功解析的数据源位掩码
+    uint64_t timestamp_ns;              // 本次快照的采样时间（单调时钟）
+    CpuTimes cpu;                       // 聚合CPU计数器
+    PerCpuTimes percpu;                 // 每CPU计数器
+    MemInfo mem;                        // 内存信息
+    DiskStats *disks;                   // 块设备统计数组
+    int disk_count;                     // 块设备数量
+    int disk_capacity;                  // 块设备数组容量
+    NetDevStats *nets;                  // 网络接口统计数组
+    int net_count;                      // 网络接口数量
+    int net_capacity;                   // 网络接口数组容量
+} ProcSnapshot;
+
+/**
+ * @brief 初始化快照并打开所有数据源
+ * @param snap 快照指针
+ * @param proc_root procfs根目录，NULL表示"/proc"
+ * @return 成功返回0，失败返回非0
+ */
+int proc_snapshot_init(ProcSnapshot *snap, const char *proc_root);
+
+/**
+ * @brief 关闭数据源并释放快照资源
+ * @param snap 快照指针
+ */
+void proc_snapshot_free(ProcSnapshot *snap);
+
+/**
+ * @brief 读取并解析一个数据源，不改变有效位掩码和采样时间
+ *
+ * 只写入该数据源对应的字段，不同数据源可以在不同线程上同时读取，
+ * 由调用者在读取完成后设置valid和timestamp_ns。
+ *
+ * @param snap 快照指针
+ * @param source 数据源类型
+ * @return 成功返回0，失败返回非0
+ */
+int proc_snapshot_read(ProcSnapshot *snap, ProcSourceType source);
+
+/**
+ * @brief 重新读取并解析所有数据源
+ * @param snap 快照指针
+ * @return 所有数据源均成功返回0，否则返回非0（成功的部分仍然有效）
+ */
+int proc_snapshot_refresh(ProcSnapshot *snap);
+
+/**
+ * @brief 判断数据源在本次快照中是否有效
+ * @param snap 快照指针
+ * @param source 数据源类型
+ * @return 有效返回true
+ */
+static inline int proc_snapshot_has(const ProcSnapshot *snap, ProcSourceType source) {
+    return (snap->valid & (1u << source)) != 0;
+}
+
+/**
+ * @brief 在快照中查找块设备
+ * @param snap 快照指针
+ * @param name 设备名（如sda）
+ * @return 找到返回统计信息指针，否则返回NULL
+ */
+const DiskStats *proc_snapshot_find_disk(const ProcSnapshot *snap, const char *name);
+
+/**
+ * @brief 在快照中查找网络接口
+ * @param snap 快照指针
+ * @param name 接口名（如eth0）
+ * @return 找到返回统计信息指针，否则返回NULL
+ */
+const NetDevStats *proc_snapshot_find_net(const ProcSnapshot *snap, const char *name);
+
+#endif /* PROC_SNAPSHOT_H */
@@ -0,0 +1,101 @@
+/**
+ * @file process_collector.h
+ * @brief 进程级资源采集头文件
+ *
+ * 每个周期读取全部进程的/proc/<pid>/stat（CPU时间）和/proc/<pid>/statm
+ * （常驻内存），维护CPU和内存占用最高的K个进程，随采样批次送到输出端，
+ * 异常告警据此说明是哪个进程造成的。
+ *
+ * 开销控制：
+ *   - /proc目录和每个进程的stat、statm文件描述符跨周期保持打开，稳定运行时
+ *     每个进程每次读取只需一次pread；初始化时把RLIMIT_NOFILE软限制提高到
+ *     硬限制（对整个进程生效，提高时打印一行说明），超出预算的部分退化为每次打开；
+ *   - 进程按pid存放在开放寻址哈希表中，CPU增量按进程逐个计算；
+ *   - 连续几次读取都没有CPU增量的进程逐步降低读取频率（最多每
+ *     PROCESS_IDLE_MAX_SKIP个周期一次，开始运行后最迟这么多个周期被看到），
+ *     statm只在进程运行过之后重新读取；
+ *   - 前K名用大小为K的最小堆维护，不对全部进程排序。
+ */
+
+#ifndef PROCESS_COLLECTOR_H
+#define PROCESS_COLLECTOR_H
+
+#include <stdint.h>
+#include <dirent.h>
+
+#define PROCESS_TOP_MAX 16          // 排行榜的最大进程数
+#define PROCESS_COMM_LEN 16         // 进程名最大长度（含结尾'\0'，与内核TASK_COMM_LEN相同）
+
+/* 一个进程的资源占用 */
+typedef struct {
+    int pid;                        // 进程号
+    char comm[PROCESS_COMM_LEN];    // 进程名
+    double cpu_percent;             // CPU使用率（%，单核为100%）
+    unsigned long rss_kb;           // 常驻内存（KB）
+} ProcessUsage;
+
+/* 占用最高的进程，按占用从高到低排列 */
+typedef struct {
+    ProcessUsage cpu[PROCESS_TOP_MAX]; // CPU占用排行
+    int cpu_count;
+    ProcessUsage mem[PROCESS_TOP_MAX]; // 常驻内存排行
+    int mem_count;
+    int process_count;              // 本周期的进程总数，0表示未采集
+} ProcessTop;
+
+/* 一个进程的缓存状态（哈希表槽位） */
+typedef struct {
+    int pid;                        // 进程号，0表示空槽位
+    int stat_fd;                    // 缓存的stat文件描述符，-1表示未缓存
+    int statm_fd;                   // 缓存的statm文件描述符，-1表示未缓存
+    unsigned long seen;             // 最近一次出现在/proc目录中的扫描编号
+    unsigned long long start_time;  // 进程启动时间（时钟滴答），识别pid复用
+    unsigned long long cpu_ticks;   // 上一次读取的utime+stime
+    uint64_t sampled_ns;            // 上一次读取的时间（单调时钟）
+    unsigned long next_cycle;       // 下一次读取的周期
+    int idle_reads;                 // 连续没有CPU增量的读取次数（跳读间隔达到上限后不再增加）
+    int memory_stale;               // 进程运行过、需要重新读取statm
+    double cpu_percent;             // 最近一次计算的CPU使用率
+    unsigned long rss_kb;           // 最近一次读取的常驻内存
+    char comm[PROCESS_COMM_LEN];
+} ProcessEntry;
+
+/* 进程采集器，单线程使用 */
+typedef struct {
+    DIR *proc_dir;                  // 缓存的/proc目录
+    int top_k;                      // 排行榜的进程数
+    ProcessEntry *entries;          // 以pid为键的哈希表（线性探测）
+    unsigned long mask;             // 哈希表容量-1
+    int count;                      // 进程数
+    int cached_fds;                 // 已缓存的文件描述符数
+    int fd_budget;                  // 可缓存的文件描述符上限
+    unsigned long cycle;            // 已采集的周期数
+    long ticks_per_sec;             // 每秒时钟滴答数
+    long page_kb;                   // 每页大小（KB）
+} ProcessCollector;
+
+/**
+ * @brief 打开procfs根目录，把RLIMIT_NOFILE软限制提高到硬限制以便缓存文件描述符
+ * @param pc 采集器指针
+ * @param proc_root procfs根目录，NULL表示"/proc"
+ * @param top_k 排行榜的进程数（1到PROCESS_TOP_MAX）
+ * @return 成功返回0，失败返回非0
+ */
+int process_collector_init(ProcessCollector *pc, const char *proc_root, int top_k);
+
+/**
+ * @brief 采集一个周期：发现新进程、移除已退出的进程、计算CPU增量并生成排行
+ * @param pc 采集器指针
+ * @param timestamp_ns 本周期的采样时间（单调时钟，纳秒）
+ * @param top 存储排行的指针
+ * @return 成功返回0，无法读取/proc目录时返回非0
+ */
+int process_collector_refresh(ProcessCollector *pc, uint64_t timestamp_ns, ProcessTop *top);
+
+/**
+ * @brief 关闭缓存的文件描述符并释放资源
+ * @param pc 采集器指针
+ */
+void process_collector_free(ProcessCollector *pc);
+
+#endif /* PROCESS_COLLECTOR_H */
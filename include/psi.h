@@ -0,0 +1,72 @@
+/**
+ * @file psi.h
+ * @brief 资源压力（PSI）监视头文件
+ *
+ * 在/proc/pressure/{cpu,memory,io}上注册内核触发器（"some <停顿微秒> <窗口微秒>"），
+ * 任一窗口内的停顿时间超过阈值时描述符上出现POLLPRI，由调度器与采样等待
+ * 一起poll。内核不支持触发器（如未开启或权限不足）时退化为每个周期读取
+ * 停顿总时间（total），按两次读取之间的停顿比例判断。
+ */
+
+#ifndef PSI_H
+#define PSI_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* 压力资源 */
+typedef enum {
+    PSI_CPU,
+    PSI_MEMORY,
+    PSI_IO,
+    PSI_RESOURCE_COUNT
+} PsiResource;
+
+/* 压力监视器 */
+typedef struct {
+    int fds[PSI_RESOURCE_COUNT];            // 文件描述符，-1表示不可用
+    bool trigger[PSI_RESOURCE_COUNT];       // 是否注册了内核触发器
+    int poll_fds[PSI_RESOURCE_COUNT];       // 供poll的触发器描述符，未注册的为-1
+    unsigned long long totals[PSI_RESOURCE_COUNT]; // 上一次读取的停顿总时间（微秒，仅退化模式）
+    uint64_t sampled_ns;                    // 上一次读取的时间（单调时钟，仅退化模式）
+    double stall_ratio;                     // 停顿比例阈值（停顿时间/窗口）
+} PsiMonitor;
+
+/**
+ * @brief 打开压力文件并尽量注册触发器
+ * @param monitor 监视器指针
+ * @param stall_us 窗口内的停顿阈值（微秒）
+ * @param window_us 窗口长度（微秒）
+ * @return 至少一种资源可用时返回0，否则返回非0
+ */
+int psi_monitor_open(PsiMonitor *monitor, uint64_t stall_us, uint64_t window_us);
+
+/**
+ * @brief 退化模式下读取未注册触发器的资源的停顿总时间
+ * @param monitor 监视器指针
+ * @param now_ns 当前时间（单调时钟，纳秒）
+ * @return 自上次读取以来停顿比例超过阈值的资源位掩码（1 << PsiResource）
+ */
+unsigned int psi_monitor_check(PsiMonitor *monitor, uint64_t now_ns);
+
+/**
+ * @brief 是否有资源处于退化模式（需要定期调用psi_monitor_check）
+ * @param monitor 监视器指针
+ * @return 有返回true
+ */
+bool psi_monitor_polling(const PsiMonitor *monitor);
+
+/**
+ * @brief 获取资源名称
+ * @param resource 资源
+ * @return 资源名称（cpu、memory、io）
+ */
+const char *psi_resource_name(PsiResource resource);
+
+/**
+ * @brief 关闭压力文件
+ * @param monitor 监视器指针
+ */
+void psi_monitor_close(PsiMonitor *monitor);
+
+#endif /* PSI_H */
@@ -0,0 +1,53 @@
+/**
+ * @file replay.h
+ * @brief 离线回放模块头文件
+ *
+ * 把记录下来的样本不加节流地送入检测器，用于回测Sigma因子和窗口大小，
+ * 以及测量检测器吞吐量。支持两种输入：
+ *   - 序列文件（见series_store.h），按文件魔数识别；
+ *   - 宽格式CSV：首行为"timestamp,<指标名>,<指标名>,..."，之后每行一个周期，
+ *     时间戳为Unix纪元秒（可带小数），空单元表示该指标本周期没有值。
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "anomaly_detection.h"
+
+/* 回放统计 */
+typedef struct {
+    unsigned long rows;             // 回放的周期数
+    unsigned long samples;          // 回放的样本数
+    unsigned long anomalies;        // 检测到的异常数
+    unsigned long skipped_columns;  // 无法识别指标名而跳过的列数
+    double elapsed_sec;             // 耗时（秒）
+    unsigned long *metric_anomalies; // 各指标的异常数，以指标下标索引
+    int metric_slots;               // metric_anomalies的长度
+} ReplayStats;
+
+/**
+ * @brief 回放文件中的全部样本，每个周期运行N-Sigma、MAD、预测和阈值检测
+ * @param path 输入文件路径（序列文件或CSV）
+ * @param detector 异常检测器指针，文件中的指标按名称注册
+ * @param out 逐条输出异常的文件流，NULL表示不输出
+ * @param stats 存储回放统计的指针
+ * @return 成功返回0，文件无法读取或格式错误返回非0
+ */
+int replay_file(const char *path, AnomalyDetector *detector, FILE *out, ReplayStats *stats);
+
+/**
+ * @brief 释放回放统计中的数组
+ * @param stats 回放统计
+ */
+void replay_stats_free(ReplayStats *stats);
+
+/**
+ * @brief 打印回放统计和各指标的异常数量
+ * @param detector 异常检测器指针
+ * @param stats 回放统计
+ */
+void print_replay_summary(const AnomalyDetector *detector, const ReplayStats *stats);
+
+#endif /* REPLAY_H */
@@ -0,0 +1,81 @@
+/**
+ * @file runtime_config.h
+ * @brief 运行时配置（配置文件与热加载）头文件
+ *
+ * 可在运行中修改的参数（N-Sigma因子、设备和接口列表、各检测器的指标列表、
+ * 多维相关检测的指标组、按指标覆盖的阈值和N-Sigma因子）组成一个配置。配置发布后只读，重新加载时
+ * 构造新配置替换整个指针，采集和检测线程在各自周期开始时取用，不加锁。
+ *
+ * 配置文件每行一个"键 = 值"，'#'之后为注释，文件中没有的键保持命令行的值：
+ *
+ *   sigma = 3.0                    # N-Sigma因子
+ *   devices = sda,nvme0n1          # 磁盘设备，auto表示自动发现
+ *   interfaces = auto              # 网络接口，auto表示自动发现
+ *   mad = net_dropped              # MAD检测的指标，none表示无
+ *   ewma = none                    # EWMA检测的指标
+ *   holt_winters = cpu_usage       # Holt-Winters检测的指标
+ *   correlation = cpu_iowait,disk_write_await # 多维相关检测的指标组，分号分隔，none表示无
+ *   threshold.cpu_usage = 80       # 种类的阈值，0表示不做阈值检测
+ *   threshold.disk_util:sda = 95   # 单个指标的阈值，优先于种类的阈值
+ *   sigma.net_dropped = 4          # 种类或单个指标的N-Sigma因子
+ */
+
+#ifndef RUNTIME_CONFIG_H
+#define RUNTIME_CONFIG_H
+
+#include "anomaly_detection.h"
+
+/* 运行时配置，发布后只读 */
+typedef struct RuntimeConfig {
+    unsigned long generation;       // 版本号，发布时分配
+    double sigma_factor;            // N-Sigma因子
+    char *disk_devices;             // 逗号分隔的磁盘设备，NULL表示自动发现
+    char *net_interfaces;           // 逗号分隔的网络接口，NULL表示自动发现
+    char *detector_metrics[DETECTOR_COUNT]; // 各检测器的指标列表，NULL表示无（N-Sigma不用）
+    char *correlation_groups;       // 多维相关检测的指标组，NULL表示无
+    MetricSetting *settings;        // 按指标覆盖的阈值和N-Sigma因子
+    int setting_count;
+    int setting_capacity;
+    struct RuntimeConfig *next_retired; // 被替换后等待释放的链表
+} RuntimeConfig;
+
+/**
+ * @brief 按命令行参数创建配置
+ * @param sigma_factor N-Sigma因子
+ * @param disk_devices 逗号分隔的磁盘设备，NULL表示自动发现
+ * @param net_interfaces 逗号分隔的网络接口，NULL表示自动发现
+ * @param detector_metrics 各检测器的指标列表，NULL表示无
+ * @param correlation_groups 多维相关检测的指标组，NULL表示无
+ * @return 成功返回配置指针，失败返回NULL
+ */
+RuntimeConfig *runtime_config_create(double sigma_factor, const char *disk_devices,
+                                     const char *net_interfaces,
+                                     const char *const detector_metrics[DETECTOR_COUNT],
+                                     const char *correlation_groups);
+
+/**
+ * @brief 复制配置（版本号不复制）
+ * @param config 配置指针
+ * @return 成功返回新配置指针，失败返回NULL
+ */
+RuntimeConfig *runtime_config_clone(const RuntimeConfig *config);
+
+/**
+ * @brief 读取配置文件并覆盖到配置上
+ *
+ * 错误以"文件:行号"的形式打印到标准错误，出错时配置可能已被部分修改，
+ * 调用者应丢弃该配置。
+ *
+ * @param config 配置指针
+ * @param path 配置文件路径
+ * @return 成功返回0，失败返回非0
+ */
+int runtime_config_load(RuntimeConfig *config, const char *path);
+
+/**
+ * @brief 释放配置
+ * @param config 配置指针，可以为NULL
+ */
+void runtime_config_free(RuntimeConfig *config);
+
+#endif /* RUNTIME_CONFIG_H */
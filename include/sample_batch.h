@@ -0,0 +1,111 @@
+/**
+ * @file sample_batch.h
+ * @brief 采样批次头文件
+ *
+ * 采集端每个周期产生一个批次：带时间戳的样本，以及序列的创建/退役事件。
+ * 序列号由采集端分配，检测端把序列号映射到注册表中的指标下标，
+ * 采集端因此不需要访问异常检测器。
+ */
+
+#ifndef SAMPLE_BATCH_H
+#define SAMPLE_BATCH_H
+
+#include "anomaly_detection.h"
+#include "proc_snapshot.h"
+#include "process_collector.h"
+
+/* 单个样本 */
+typedef struct {
+    int series;                 // 序列号
+    double value;               // 样本值
+} Sample;
+
+/* 序列事件类型 */
+typedef enum {
+    SERIES_CREATE,              // 新序列（新发现的设备、接口或CPU）
+    SERIES_RETIRE               // 序列退役（来源消失）
+} SeriesEventType;
+
+/* 序列事件 */
+typedef struct {
+    SeriesEventType event;      // 事件类型
+    int series;                 // 序列号
+    MetricType type;            // 指标种类（仅SERIES_CREATE）
+    char instance[NAME_INDEX_KEY_LEN]; // 实例名，系统级指标为空串（仅SERIES_CREATE）
+} SeriesEvent;
+
+/* 采样批次，数组在批次复用时保留，稳定运行时不再分配内存 */
+typedef struct {
+    uint64_t timestamp_ns;      // 采样时间（单调时钟）
+    Sample *samples;            // 样本
+    int sample_count;
+    int sample_capacity;
+    SeriesEvent *events;        // 序列事件，按发生顺序排列，先于样本应用
+    int event_count;
+    int event_capacity;
+    ProcessTop processes;       // 占用最高的进程，未采集时process_count为0
+} SampleBatch;
+
+/**
+ * @brief 初始化批次
+ * @param batch 批次指针
+ */
+void sample_batch_init(SampleBatch *batch);
+
+/**
+ * @brief 释放批次
+ * @param batch 批次指针
+ */
+void sample_batch_free(SampleBatch *batch);
+
+/**
+ * @brief 清空样本和事件，保留已分配的数组
+ * @param batch 批次指针
+ */
+void sample_batch_reset(SampleBatch *batch);
+
+/**
+ * @brief 追加样本
+ * @param batch 批次指针
+ * @param series 序列号
+ * @param value 样本值
+ * @return 成功返回0，失败返回非0
+ */
+int sample_batch_add(SampleBatch *batch, int series, double value);
+
+/**
+ * @brief 追加序列事件
+ * @param batch 批次指针
+ * @param event 事件类型
+ * @param series 序列号
+ * @param type 指标种类
+ * @param instance 实例名，系统级指标传NULL
+ * @return 成功返回0，失败返回非0
+ */
+int sample_batch_add_event(SampleBatch *batch, SeriesEventType event, int series,
+                           MetricType type, const char *instance);
+
+/**
+ * @brief 把src中的事件追加到dst（批次被丢弃时保留其中的事件）
+ * @param dst 目标批次
+ * @param src 源批次
+ * @return 成功返回0，失败返回非0
+ */
+int sample_batch_append_events(SampleBatch *dst, const SampleBatch *src);
+
+/**
+ * @brief 把批次应用到异常检测器：先按顺序处理序列事件，再写入样本
+ * @param detector 异常检测器指针
+ * @param batch 批次指针
+ * @return 成功返回0，有事件或样本未能应用时返回非0
+ */
+int apply_sample_batch(AnomalyDetector *detector, const SampleBatch *batch);
+
+/**
+ * @brief 退役没有任何序列映射到的指标（如从持久化数据恢复、但来源已不存在的指标）
+ * @param detector 异常检测器指针
+ * @return 退役的指标数量
+ */
+int retire_unmapped_metrics(AnomalyDetector *detector);
+
+#endif /* SAMPLE_BATCH_H */
@@ -0,0 +1,113 @@
+/**
+ * @file scheduler.h
+ * @brief 采样调度模块头文件
+ *
+ * 以CLOCK_MONOTONIC上的绝对截止时间驱动采样周期，每个周期的截止时间
+ * 都是起始时间加整数倍采样间隔，采集耗时不会累积成漂移。
+ *
+ * 突发模式：触发描述符（如PSI触发器）出现POLLPRI或调用scheduler_burst时，
+ * 立即结束当前等待，此后按突发间隔采样；持续时间内没有新的触发时，
+ * 间隔每个周期加倍，逐步回到基础间隔。
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define NSEC_PER_SEC 1000000000ULL
+#define NSEC_PER_MSEC 1000000ULL
+#define SCHEDULER_MAX_TRIGGERS 4
+
+/* 采样调度器 */
+typedef struct {
+    uint64_t interval_ns;       // 采样间隔（纳秒）
+    uint64_t deadline_ns;       // 下一个截止时间（单调时钟，纳秒）
+    bool waiting;               // 是否已确定本周期截止时间、正在等待
+    int cycle_missed;           // 本周期跳过的截止时间数
+    unsigned long missed;       // 累计错过的截止时间数
+    int wake_fd;                // 可读时提前结束等待的文件描述符（如eventfd），-1表示无
+    uint64_t base_interval_ns;  // 基础采样间隔
+    uint64_t burst_interval_ns; // 突发采样间隔，0表示不使用突发模式
+    uint64_t burst_duration_ns; // 每次触发后保持突发间隔的时长
+    uint64_t burst_until_ns;    // 突发模式的结束时间（单调时钟，纳秒）
+    unsigned long bursts;       // 进入突发模式的次数
+    unsigned int fired;         // 出现POLLPRI的触发描述符位掩码，由调用者清零
+    int trigger_fds[SCHEDULER_MAX_TRIGGERS]; // 触发描述符，-1表示无
+} Scheduler;
+
+/**
+ * @brief 读取单调时钟
+ * @return 单调时钟的纳秒值
+ */
+uint64_t monotonic_ns(void);
+
+/**
+ * @brief 把单调时钟时间换算为墙上时间（CLOCK_REALTIME）
+ * @param mono_ns 单调时钟的纳秒值
+ * @return 对应的Unix纪元纳秒值
+ */
+uint64_t monotonic_to_realtime_ns(uint64_t mono_ns);
+
+/**
+ * @brief 解析时长，支持"5"、"0.5"、"100ms"、"2s"、"10m"、"12h"、"1d"、"1w"等写法
+ * @param text 时长字符串（无单位时按秒解析）
+ * @param duration_ns 存储时长纳秒值的指针
+ * @return 成功返回0，格式错误返回非0
+ */
+int parse_duration(const char *text, uint64_t *duration_ns);
+
+/**
+ * @brief 解析采样间隔，写法同parse_duration，不超过一天
+ * @param text 间隔字符串（无单位时按秒解析）
+ * @param interval_ns 存储间隔纳秒值的指针
+ * @return 成功返回0，格式错误返回非0
+ */
+int parse_interval(const char *text, uint64_t *interval_ns);
+
+/**
+ * @brief 初始化调度器，第一个截止时间为当前时刻
+ * @param sched 调度器指针
+ * @param interval_ns 采样间隔（纳秒）
+ * @return 成功返回0，失败返回非0
+ */
+int scheduler_init(Scheduler *sched, uint64_t interval_ns);
+
+/**
+ * @brief 设置唤醒文件描述符，该描述符可读时scheduler_wait提前返回
+ * @param sched 调度器指针
+ * @param fd 文件描述符（如eventfd），-1表示不使用
+ */
+void scheduler_set_wake_fd(Scheduler *sched, int fd);
+
+/**
+ * @brief 设置突发模式
+ * @param sched 调度器指针
+ * @param interval_ns 突发采样间隔（纳秒），0或不小于基础间隔时不使用突发模式
+ * @param duration_ns 每次触发后保持突发间隔的时长（纳秒）
+ * @param fds 触发描述符数组，出现POLLPRI时进入突发模式，-1的项被忽略
+ * @param count 触发描述符数量（不超过SCHEDULER_MAX_TRIGGERS）
+ */
+void scheduler_set_burst(Scheduler *sched, uint64_t interval_ns, uint64_t duration_ns,
+                         const int *fds, int count);
+
+/**
+ * @brief 进入或延长突发模式，正在等待的截止时间提前到当前时刻
+ * @param sched 调度器指针
+ */
+void scheduler_burst(Scheduler *sched);
+
+/**
+ * @brief 休眠到下一个截止时间
+ *
+ * 如果本周期已超过一个或多个截止时间，跳到当前时刻之后的第一个截止时间，
+ * 并把跳过的数量计入missed。被信号或唤醒描述符中断时返回-1（唤醒描述符
+ * 中的计数会被读空），再次调用会继续等待同一个截止时间。
+ *
+ * @param sched 调度器指针
+ * @return 到达截止时间返回本周期错过的截止时间数（>=0），被中断返回-1
+ */
+int scheduler_wait(Scheduler *sched);
+
+#endif /* SCHEDULER_H */
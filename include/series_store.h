@@ -0,0 +1,178 @@
+/**
+ * @file series_store.h
+ * @brief 内存映射的指标时间序列文件头文件
+ *
+ * 只追加的列式文件，外部工具可以直接mmap读取。所有整数和浮点数均为
+ * 本机字节序（小端），布局如下：
+ *
+ *   [文件头，SERIES_HEADER_SIZE字节]
+ *   [块0][块1]...            每个块的长度为页大小的整数倍
+ *
+ * 块内依次为：块头、列名表（column_capacity个SERIES_NAME_LEN字节的名称）、
+ * 时间戳列（row_capacity个uint64，Unix纪元纳秒）、值列（column_capacity列，
+ * 每列row_capacity个double）。第c列第r行的值位于
+ * values_offset + (c * row_capacity + r) * 8。没有数据的单元为NaN。
+ *
+ * 块创建时为后续出现的指标预留空列，预留用完或行写满时开始新块。
+ * row_count在一行全部写完后才增加，读者只应读取前row_count行。
+ * 写入只是内存写操作，不调用fsync/msync，由内核回写。
+ */
+
+#ifndef SERIES_STORE_H
+#define SERIES_STORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "anomaly_detection.h"
+
+#define SERIES_MAGIC "ADSERIES"         // 文件魔数（8字节，不含'\0'）
+#define SERIES_BLOCK_MAGIC 0x4b4c4253u  // 块魔数"SBLK"
+#define SERIES_VERSION 1                // 文件格式版本
+#define SERIES_HEADER_SIZE 4096         // 文件头长度
+#define SERIES_NAME_LEN NAME_INDEX_KEY_LEN // 列名长度
+
+/* 文件头 */
+typedef struct {
+    char magic[8];                  // SERIES_MAGIC
+    uint32_t version;               // SERIES_VERSION
+    uint32_t header_size;           // SERIES_HEADER_SIZE
+    uint64_t interval_ns;           // 采样间隔
+    uint64_t block_count;           // 块数量
+    uint64_t data_bytes;            // 文件头加全部块的长度
+} SeriesFileHeader;
+
+/* 块头 */
+typedef struct {
+    uint32_t magic;                 // SERIES_BLOCK_MAGIC
+    uint32_t column_count;          // 已使用的列数
+    uint32_t column_capacity;       // 列容量
+    uint32_t row_capacity;          // 行容量
+    uint64_t row_count;             // 已提交的行数
+    uint64_t block_bytes;           // 块长度（含块头）
+    uint64_t names_offset;          // 列名表偏移（相对块起点）
+    uint64_t timestamps_offset;     // 时间戳列偏移
+    uint64_t values_offset;         // 值列偏移
+} SeriesBlockHeader;
+
+/* 序列文件写入器 */
+typedef struct {
+    int fd;                         // 文件描述符
+    char path[256];                 // 文件路径
+    uint64_t interval_ns;           // 采样间隔
+    uint32_t row_capacity;          // 每块行数
+    uint64_t max_bytes;             // 文件超过该大小时轮转为path.1
+    SeriesFileHeader *header;       // 映射的文件头
+    char *block;                    // 映射的当前块，NULL表示尚未创建
+    uint64_t block_offset;          // 当前块在文件中的偏移
+    int *metric_columns;            // 指标下标到当前块列号的映射，-1表示无
+    unsigned long *column_incarnations; // 映射建立时指标的注册编号
+    int metric_slots;               // 以上两个数组的长度
+} SeriesStore;
+
+/* 序列文件读取器：只读映射整个文件，逐块遍历 */
+typedef struct {
+    char *data;                     // 映射的文件内容
+    uint64_t size;                  // 映射长度
+    uint64_t offset;                // 下一个块的偏移
+    uint64_t block_index;           // 下一个块的序号
+} SeriesReader;
+
+/**
+ * @brief 块中已提交的行数
+ * @param bh 块头
+ * @return 行数
+ */
+static inline uint64_t series_block_rows(const SeriesBlockHeader *bh) {
+    uint64_t rows = __atomic_load_n(&bh->row_count, __ATOMIC_ACQUIRE);
+    return rows < bh->row_capacity ? rows : bh->row_capacity;
+}
+
+/**
+ * @brief 块的时间戳列
+ * @param bh 块头
+ * @return 时间戳数组（Unix纪元纳秒）
+ */
+static inline const uint64_t *series_block_timestamps(const SeriesBlockHeader *bh) {
+    return (const uint64_t *)((const char *)bh + bh->timestamps_offset);
+}
+
+/**
+ * @brief 块的第column列
+ * @param bh 块头
+ * @param column 列号
+ * @return 值数组，长度为row_capacity
+ */
+static inline const double *series_block_values(const SeriesBlockHeader *bh, uint32_t column) {
+    return (const double *)((const char *)bh + bh->values_offset) + (uint64_t)column * bh->row_capacity;
+}
+
+/**
+ * @brief 复制第column列的列名
+ * @param bh 块头
+ * @param column 列号
+ * @param name 存储列名的缓冲区（SERIES_NAME_LEN字节，保证以'\0'结尾）
+ */
+static inline void series_block_name(const SeriesBlockHeader *bh, uint32_t column, char *name) {
+    memcpy(name, (const char *)bh + bh->names_offset + (size_t)column * SERIES_NAME_LEN, SERIES_NAME_LEN);
+    name[SERIES_NAME_LEN - 1] = '\0';
+}
+
+/**
+ * @brief 打开（不存在时创建）序列文件用于追加
+ *
+ * 已有文件的格式或采样间隔不匹配时，将其改名为path.1后创建新文件。
+ *
+ * @param store 写入器指针
+ * @param path 文件路径
+ * @param interval_ns 采样间隔
+ * @return 成功返回0，失败返回非0
+ */
+int series_store_open(SeriesStore *store, const char *path, uint64_t interval_ns);
+
+/**
+ * @brief 把检测器中本周期有新值的指标追加为一行
+ * @param store 写入器指针
+ * @param detector 异常检测器指针
+ * @param timestamp_ns 本周期的采样时间（单调时钟），只写入时间戳等于它的指标值
+ * @return 成功返回0，失败返回非0
+ */
+int series_store_append(SeriesStore *store, const AnomalyDetector *detector, uint64_t timestamp_ns);
+
+/**
+ * @brief 关闭序列文件
+ * @param store 写入器指针
+ */
+void series_store_close(SeriesStore *store);
+
+/**
+ * @brief 只读打开序列文件
+ * @param reader 读取器指针
+ * @param path 文件路径
+ * @return 成功返回0，文件不存在或格式不符返回非0
+ */
+int series_reader_open(SeriesReader *reader, const char *path);
+
+/**
+ * @brief 读取下一个块
+ * @param reader 读取器指针
+ * @return 块头指针（指向映射内存，关闭前有效），没有更多块或块损坏时返回NULL
+ */
+const SeriesBlockHeader *series_reader_next(SeriesReader *reader);
+
+/**
+ * @brief 关闭读取器
+ * @param reader 读取器指针
+ */
+void series_reader_close(SeriesReader *reader);
+
+/**
+ * @brief 从path.1和path中恢复检测器的滑动窗口
+ * @param path 文件路径
+ * @param detector 异常检测器指针，文件中的指标按名称注册
+ * @param since_ns 只恢复不早于该时间（Unix纪元纳秒）的行
+ * @return 恢复的行数，没有可用数据时返回0
+ */
+int series_store_restore(const char *path, AnomalyDetector *detector, uint64_t since_ns);
+
+#endif /* SERIES_STORE_H */
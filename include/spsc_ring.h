@@ -0,0 +1,99 @@
+/**
+ * @file spsc_ring.h
+ * @brief 单生产者单消费者无锁环形队列头文件
+ *
+ * 槽位在初始化时一次性分配，生产者原地写入槽位后发布，消费者原地读取后释放，
+ * 队列满时生产者立即得到失败结果而不会阻塞。消费者可以通过信号量阻塞等待。
+ */
+
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+#include <semaphore.h>
+
+/* 单生产者单消费者环形队列 */
+typedef struct {
+    char *slots;                                            // 槽位内存
+    size_t slot_size;                                       // 每个槽位的字节数
+    unsigned long mask;                                     // 容量-1（容量为2的幂）
+    _Alignas(64) atomic_ulong head;                         // 生产者写入位置
+    _Alignas(64) atomic_ulong tail;                         // 消费者读取位置
+    _Alignas(64) sem_t items;                               // 已发布元素计数，供消费者阻塞等待
+} SpscRing;
+
+/**
+ * @brief 初始化队列
+ * @param ring 队列指针
+ * @param capacity 槽位数量（向上取整为2的幂）
+ * @param slot_size 每个槽位的字节数
+ * @return 成功返回0，失败返回非0
+ */
+int spsc_ring_init(SpscRing *ring, unsigned long capacity, size_t slot_size);
+
+/**
+ * @brief 释放队列
+ * @param ring 队列指针
+ */
+void spsc_ring_free(SpscRing *ring);
+
+/**
+ * @brief 获取容量
+ * @param ring 队列指针
+ * @return 槽位数量
+ */
+static inline unsigned long spsc_ring_capacity(const SpscRing *ring) {
+    return ring->mask + 1;
+}
+
+/**
+ * @brief 按下标访问槽位（用于初始化和释放槽位内的资源）
+ * @param ring 队列指针
+ * @param index 槽位下标
+ * @return 槽位指针
+ */
+static inline void *spsc_ring_slot(const SpscRing *ring, unsigned long index) {
+    return ring->slots + (index & ring->mask) * ring->slot_size;
+}
+
+/**
+ * @brief 生产者：获取下一个可写槽位
+ * @param ring 队列指针
+ * @return 可写槽位指针，队列满时返回NULL
+ */
+void *spsc_ring_reserve(SpscRing *ring);
+
+/**
+ * @brief 生产者：发布spsc_ring_reserve得到的槽位
+ * @param ring 队列指针
+ */
+void spsc_ring_publish(SpscRing *ring);
+
+/**
+ * @brief 消费者：获取最旧的已发布槽位，不阻塞
+ * @param ring 队列指针
+ * @return 槽位指针，队列空时返回NULL
+ */
+void *spsc_ring_peek(SpscRing *ring);
+
+/**
+ * @brief 消费者：阻塞等待已发布的槽位
+ * @param ring 队列指针
+ * @return 槽位指针，被spsc_ring_wake唤醒且队列为空时返回NULL
+ */
+void *spsc_ring_wait(SpscRing *ring);
+
+/**
+ * @brief 消费者：释放spsc_ring_peek/spsc_ring_wait得到的槽位
+ * @param ring 队列指针
+ */
+void spsc_ring_release(SpscRing *ring);
+
+/**
+ * @brief 唤醒阻塞在spsc_ring_wait上的消费者（用于退出）
+ * @param ring 队列指针
+ */
+void spsc_ring_wake(SpscRing *ring);
+
+#endif /* SPSC_RING_H */
@@ -0,0 +1,104 @@
+/**
+ * @file worker_pool.h
+ * @brief 小型工作线程池头文件
+ *
+ * 固定数量的工作线程从一个先进先出队列中取任务执行。任务结构由提交者
+ * 持有并跨周期复用，池不分配内存；提交者按截止时间等待一组任务，
+ * 到期仍未完成的任务继续在工作线程上运行，在完成前不能再次提交，
+ * 提交者据此跳过卡住的任务而不必等待它。
+ *
+ * 线程数为0时任务在提交者线程中同步执行，没有截止时间。
+ *
+ * 停止时卡住的任务（如读取挂起的NFS文件）不会阻塞退出：超过等待时长
+ * 仍在执行任务的工作线程被分离，池和任务的内存此后必须保持有效。
+ */
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+/* 任务，由提交者持有 */
+typedef struct WorkerTask {
+    void (*fn)(void *arg);          // 任务函数
+    void *arg;                      // 任务参数
+    bool pending;                   // 已提交尚未完成，受池的锁保护
+    struct WorkerTask *next;        // 队列链表
+} WorkerTask;
+
+struct WorkerPool;
+
+/* 一个工作线程 */
+typedef struct {
+    pthread_t thread;
+    struct WorkerPool *pool;
+    bool busy;                      // 正在执行任务，受池的锁保护
+    bool detached;                  // 停止时仍在执行任务而被分离，不再回收
+} WorkerThread;
+
+/* 工作线程池 */
+typedef struct WorkerPool {
+    pthread_mutex_t lock;
+    pthread_cond_t work_cond;       // 有新任务或请求停止
+    pthread_cond_t done_cond;       // 有任务完成
+    WorkerTask *head;               // 等待执行的任务队列
+    WorkerTask *tail;
+    WorkerThread *threads;
+    int thread_count;               // 已启动的工作线程数
+    int busy_count;                 // 正在执行任务的工作线程数
+    bool stopping;                  // 请求停止
+} WorkerPool;
+
+/**
+ * @brief 初始化线程池并启动工作线程
+ * @param pool 线程池指针
+ * @param threads 工作线程数，0表示在提交者线程中同步执行
+ * @return 成功返回0，失败返回非0
+ */
+int worker_pool_init(WorkerPool *pool, int threads);
+
+/**
+ * @brief 提交任务
+ * @param pool 线程池指针
+ * @param task 任务指针，完成前不能修改或释放
+ * @return 成功返回0，任务仍未完成时返回非0
+ */
+int worker_pool_submit(WorkerPool *pool, WorkerTask *task);
+
+/**
+ * @brief 判断任务是否已提交尚未完成
+ * @param pool 线程池指针
+ * @param task 任务指针
+ * @return 未完成返回true
+ */
+bool worker_task_pending(WorkerPool *pool, WorkerTask *task);
+
+/**
+ * @brief 等待一组任务完成，最多等到截止时间
+ *
+ * 返回后已完成任务写入的数据对调用者可见。
+ *
+ * @param pool 线程池指针
+ * @param tasks 任务指针数组，未提交的任务视为已完成
+ * @param count 任务数量
+ * @param deadline_ns 截止时间（单调时钟，纳秒），0表示一直等待
+ * @return 截止时间到达时仍未完成的任务数
+ */
+int worker_pool_wait(WorkerPool *pool, WorkerTask *const *tasks, int count, uint64_t deadline_ns);
+
+/**
+ * @brief 停止工作线程并释放资源
+ *
+ * 队列中尚未开始的任务被丢弃，正在执行的任务最多等待timeout_ns；到期仍在
+ * 执行任务的工作线程被分离而不是回收，这时池的锁和线程表不释放，调用者也
+ * 必须保留池和这些任务访问的内存（通常随进程退出回收）。
+ *
+ * @param pool 线程池指针
+ * @param timeout_ns 等待正在执行的任务的时长（纳秒），0表示一直等待
+ * @return 被分离的工作线程数，0表示全部已回收、资源已释放
+ */
+int worker_pool_free(WorkerPool *pool, uint64_t timeout_ns);
+
+#endif /* WORKER_POOL_H */
@@ -0,0 +1,321 @@
+#include "../include/alert.h"
+#include "../include/scheduler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+int alert_tracker_init(AlertTracker *tracker, uint64_t pending_ns, uint64_t resolve_ns, double hysteresis) {
+    if (!tracker || hysteresis < 0) {
+        return -1;
+    }
+
+    memset(tracker, 0, sizeof(*tracker));
+    tracker->pending_ns = pending_ns;
+    tracker->resolve_ns = resolve_ns;
+    tracker->hysteresis = hysteresis;
+    return 0;
+}
+
+void alert_tracker_clear_events(AlertTracker *tracker) {
+    tracker->event_count = 0;
+}
+
+void alert_tracker_free(AlertTracker *tracker) {
+    if (!tracker) {
+        return;
+    }
+    free(tracker->entries);
+    free(tracker->events);
+    memset(tracker, 0, sizeof(*tracker));
+}
+
+// 按指标下标扩展状态表，新槽位为未触发
+static int grow_entries(AlertTracker *t, int count) {
+    if (count <= t->capacity) {
+        return 0;
+    }
+
+    int new_capacity = t->capacity > 0 ? t->capacity : 32;
+    while (new_capacity < count) {
+        new_capacity *= 2;
+    }
+    AlertEntry *entries = (AlertEntry *)realloc(t->entries, sizeof(AlertEntry) * new_capacity);
+    if (!entries) {
+        return -1;
+    }
+    memset(entries + t->capacity, 0, sizeof(AlertEntry) * (new_capacity - t->capacity));
+    t->entries = entries;
+    t->capacity = new_capacity;
+    return 0;
+}
+
+// 样本时间对应的Unix纪元时间，与序列文件的时间戳一致（不受输出延迟影响）
+static inline time_t sample_time(const AnomalyDetector *d, uint64_t timestamp_ns) {
+    return (time_t)(((int64_t)timestamp_ns + d->clock_offset_ns) / (int64_t)NSEC_PER_SEC);
+}
+
+// 生成一个事件，内存不足时丢弃事件但状态照常转换
+static void emit(AlertTracker *t, AlertEventKind kind, int metric_id, MetricType type,
+                 const AlertEntry *e, double value, uint64_t timestamp_ns, time_t now) {
+    if (kind == ALERT_EVENT_FIRING) {
+        t->firing++;
+        t->fired++;
+    } else {
+        t->firing--;
+    }
+
+    if (t->event_count >= t->event_capacity) {
+        int new_capacity = t->event_capacity > 0 ? t->event_capacity * 2 : 16;
+        AlertEvent *events = (AlertEvent *)realloc(t->events, sizeof(AlertEvent) * new_capacity);
+        if (!events) {
+            return;
+        }
+        t->events = events;
+        t->event_capacity = new_capacity;
+    }
+
+    AlertEvent *event = &t->events[t->event_count++];
+    event->kind = kind;
+    event->metric_id = metric_id;
+    event->type = type;
+    event->sources = e->sources;
+    event->severity = e->severity;
+    event->value = value;
+    event->threshold = e->bound;
+    event->peak = e->peak;
+    event->started = e->started;
+    event->timestamp = now;
+    event->duration_ns = timestamp_ns > e->first_ns ? timestamp_ns - e->first_ns : 0;
+    event->anomalies = e->anomalies;
+    event->anomaly = e->anomaly;
+}
+
+// 取指标的状态，指标重新注册过时重置；原注册上触发中的告警以恢复事件结束
+static AlertEntry *entry_for(AlertTracker *t, const AnomalyDetector *d, int metric_id,
+                             uint64_t timestamp_ns) {
+    if (grow_entries(t, metric_id + 1) != 0) {
+        return NULL;
+    }
+
+    AlertEntry *e = &t->entries[metric_id];
+    const Metric *metric = &d->metrics[metric_id];
+    if (e->incarnation != metric->incarnation) {
+        if (e->state == ALERT_FIRING) {
+            emit(t, ALERT_EVENT_RESOLVED, metric_id, metric->type, e, e->value, timestamp_ns,
+                 sample_time(d, timestamp_ns));
+        }
+        memset(e, 0, sizeof(*e));
+        e->incarnation = metric->incarnation;
+    }
+    return e;
+}
+
+// 合并一条异常：同一轮次内的多条异常合并为一次判定
+static void merge_anomaly(AlertTracker *t, AlertEntry *e, const Anomaly *anomaly) {
+    // 马氏距离的界限与指标值量纲不同，不参与界限和方向的合并，只用于跟踪峰值
+    bool bounded = anomaly->source != ANOMALY_SOURCE_MAHALANOBIS;
+    bool high = anomaly->value > anomaly_reference(anomaly);
+    if (e->hit_round != t->round) {
+        if (e->state == ALERT_INACTIVE) {
+            e->severity = 0;
+            e->sources = 0;
+            e->anomalies = 0;
+            e->has_anomaly = false;
+            e->peak = anomaly->value;
+        }
+        e->hit_round = t->round;
+        e->anomalies++;
+        e->high = high;
+        e->bound = NAN;
+        e->threshold = 0;
+    }
+    if (bounded) {
+        if (isnan(e->bound)) {
+            e->high = high;
+            e->bound = anomaly->threshold;
+        } else if (high == e->high) {
+            // 多个检测同时越界时以最先越过的界限为准
+            e->bound = high ? fmin(e->bound, anomaly->threshold) : fmax(e->bound, anomaly->threshold);
+        }
+    }
+
+    e->value = anomaly->value;
+    e->sources |= 1u << anomaly->source;
+    if (anomaly->source == ANOMALY_SOURCE_THRESHOLD) {
+        e->threshold = anomaly->threshold;
+    }
+    if (high ? anomaly->value > e->peak : anomaly->value < e->peak) {
+        e->peak = anomaly->value;
+    }
+    if (anomaly->severity > e->severity || !e->has_anomaly) {
+        if (anomaly->severity > e->severity) {
+            e->severity = anomaly->severity;
+        }
+        e->anomaly = *anomaly;
+        e->has_anomaly = true;
+    }
+}
+
+// 按本轮次是否被标记推进一个指标的状态
+static void step(AlertTracker *t, const Metric *metric, int metric_id, AlertEntry *e,
+                 uint64_t timestamp_ns, time_t now) {
+    if (e->hit_round == t->round) {
+        e->clearing = false;
+        if (e->state == ALERT_INACTIVE) {
+            e->state = ALERT_PENDING;
+            e->first_ns = timestamp_ns;
+            e->started = now;
+        }
+        if (e->state == ALERT_PENDING &&
+            (timestamp_ns < e->first_ns || timestamp_ns - e->first_ns >= t->pending_ns)) {
+            e->state = ALERT_FIRING;
+            emit(t, ALERT_EVENT_FIRING, metric_id, metric->type, e, e->value, timestamp_ns, now);
+        }
+        return;
+    }
+
+    if (e->state == ALERT_PENDING) {
+        // 持续时间不足，不产生事件
+        e->state = ALERT_INACTIVE;
+        return;
+    }
+    if (e->state != ALERT_FIRING) {
+        return;
+    }
+
+    // 停在阈值附近视为仍在告警，重新开始恢复计时
+    if (e->threshold > 0 && metric->value > e->threshold * (1 - t->hysteresis)) {
+        e->clearing = false;
+        return;
+    }
+    if (!e->clearing) {
+        e->clearing = true;
+        e->clear_ns = timestamp_ns;
+    }
+    if (timestamp_ns < e->clear_ns || timestamp_ns - e->clear_ns >= t->resolve_ns) {
+        emit(t, ALERT_EVENT_RESOLVED, metric_id, metric->type, e, metric->value, timestamp_ns, now);
+        e->state = ALERT_INACTIVE;
+        e->clearing = false;
+    }
+}
+
+int alert_tracker_update(AlertTracker *tracker, const AnomalyDetector *detector, uint64_t timestamp_ns) {
+    if (!tracker || !detector) {
+        return -1;
+    }
+
+    AlertTracker *t = tracker;
+    int before = t->event_count;
+    time_t now = sample_time(detector, timestamp_ns);
+    t->round++;
+    if (grow_entries(t, detector->metric_count) != 0) {
+        return -1;
+    }
+
+    for (int i = 0; i < detector->anomalies.count; i++) {
+        const Anomaly *anomaly = &detector->anomalies.records[i];
+        AlertEntry *e = entry_for(t, detector, anomaly->metric_id, timestamp_ns);
+        if (e) {
+            merge_anomaly(t, e, anomaly);
+        }
+    }
+
+    for (int i = 0; i < detector->metric_count; i++) {
+        const Metric *metric = &detector->metrics[i];
+        AlertEntry *e = &t->entries[i];
+        if (!metric->active) {
+            // 来源消失，触发中的告警随之结束
+            if (e->state == ALERT_FIRING) {
+                emit(t, ALERT_EVENT_RESOLVED, i, metric->type, e, e->value, timestamp_ns, now);
+            }
+            e->state = ALERT_INACTIVE;
+            continue;
+        }
+        if (e->state == ALERT_INACTIVE && e->hit_round != t->round) {
+            continue;
+        }
+        e = entry_for(t, detector, i, timestamp_ns);
+        step(t, metric, i, e, timestamp_ns, now);
+    }
+    return t->event_count - before;
+}
+
+int alert_tracker_observe(AlertTracker *tracker, const AnomalyDetector *detector, int metric_id,
+                          int first, uint64_t timestamp_ns) {
+    if (!tracker || !detector || metric_id < 0 || metric_id >= detector->metric_count) {
+        return -1;
+    }
+
+    AlertTracker *t = tracker;
+    int before = t->event_count;
+    t->round++;
+    AlertEntry *e = entry_for(t, detector, metric_id, timestamp_ns);
+    if (!e) {
+        return -1;
+    }
+    for (int i = first; i < detector->anomalies.count; i++) {
+        merge_anomaly(t, e, &detector->anomalies.records[i]);
+    }
+    step(t, &detector->metrics[metric_id], metric_id, e, timestamp_ns,
+         sample_time(detector, timestamp_ns));
+    return t->event_count - before;
+}
+
+const char *alert_source_names(unsigned int sources, char *buf, size_t size) {
+    static const char *names[ANOMALY_SOURCE_MAHALANOBIS + 1] = {
+        "N-Sigma", "MAD", "EWMA", "Holt-Winters", "阈值", "马氏距离"
+    };
+
+    size_t used = 0;
+    buf[0] = '\0';
+    for (int i = 0; i <= ANOMALY_SOURCE_MAHALANOBIS && used < size; i++) {
+        if (sources & (1u << i)) {
+            int len = snprintf(buf + used, size - used, "%s%s", used > 0 ? "+" : "", names[i]);
+            if (len < 0) {
+                break;
+            }
+            used += (size_t)len;
+        }
+    }
+    return buf;
+}
+
+int alert_event_format(const AlertEvent *event, const char *time_str, const char *metric_name,
+                       const char *description, const char *processes, char *buf, size_t size) {
+    if (!event || !time_str || !metric_name || !description || !buf || size < 2) {
+        return -1;
+    }
+
+    char sources[64];
+    alert_source_names(event->sources, sources, sizeof(sources));
+    int len;
+    if (event->kind == ALERT_EVENT_FIRING) {
+        char message[256];
+        if (format_anomaly(&event->anomaly, description, message, sizeof(message)) < 0) {
+            message[0] = '\0';
+        }
+        // 只被多维相关检测标记时没有指标值量纲的界限
+        char bound[48] = "";
+        if (!isnan(event->threshold)) {
+            snprintf(bound, sizeof(bound), ", 阈值=%.2f", event->threshold);
+        }
+        len = snprintf(buf, size, "[%s] 状态=触发, 严重程度=%d, 指标=%s, 值=%.2f%s, 来源=%s, 消息=%s%s%s\n",
+                       time_str, event->severity, metric_name, event->value, bound,
+                       sources, message,
+                       processes && processes[0] ? ", 进程=" : "", processes ? processes : "");
+    } else {
+        len = snprintf(buf, size, "[%s] 状态=恢复, 严重程度=%d, 指标=%s, 值=%.2f, 峰值=%.2f, 持续=%.1f秒, "
+                       "异常周期=%lu, 来源=%s\n",
+                       time_str, event->severity, metric_name, event->value, event->peak,
+                       (double)event->duration_ns / 1e9, event->anomalies, sources);
+    }
+    if (len < 0) {
+        return -1;
+    }
+    if ((size_t)len >= size) {
+        len = (int)size - 1;
+        buf[len - 1] = '\n';
+    }
+    return len;
+}
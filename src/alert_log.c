@@ -0,0 +1,491 @@
+#include "../include/alert_log.h"
+#include "../include/config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define HEADER_SIZE ((uint64_t)sizeof(AlertLogFileHeader))
+#define MAX_NAME_LEN 255            // 记录中指标名的最大长度
+#define MAX_DESCRIPTION_LEN 511     // 记录中描述的最大长度
+
+// FNV-1a哈希
+static uint64_t hash_bytes(const char *data, size_t len) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+#define BLOOM_BITS (ALERT_LOG_BLOOM_WORDS * 64)
+#define BLOOM_PROBES 3
+
+// 布隆过滤器的第i个位：由哈希值的高低两半做双重哈希
+static unsigned int bloom_bit(uint64_t hash, int i) {
+    uint32_t h1 = (uint32_t)hash;
+    uint32_t h2 = (uint32_t)(hash >> 32) | 1;
+    return (h1 + (uint32_t)i * h2) % BLOOM_BITS;
+}
+
+static void bloom_add(uint64_t *words, uint64_t hash) {
+    for (int i = 0; i < BLOOM_PROBES; i++) {
+        unsigned int bit = bloom_bit(hash, i);
+        words[bit / 64] |= 1ULL << (bit % 64);
+    }
+}
+
+static bool bloom_has(const uint64_t *words, uint64_t hash) {
+    for (int i = 0; i < BLOOM_PROBES; i++) {
+        unsigned int bit = bloom_bit(hash, i);
+        if (!(words[bit / 64] & (1ULL << (bit % 64)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 种类名的长度（指标名中':'之前的部分），没有实例名时返回0
+static size_t kind_length(const char *name, size_t len) {
+    const char *colon = (const char *)memchr(name, ':', len);
+    return colon ? (size_t)(colon - name) : 0;
+}
+
+static bool header_valid(const AlertLogFileHeader *header, const char *magic) {
+    return memcmp(header->magic, magic, sizeof(header->magic)) == 0 &&
+           header->version == ALERT_LOG_VERSION &&
+           header->header_size == HEADER_SIZE;
+}
+
+// offset处是否为一条完整的记录
+static const AlertLogRecord *record_at(const char *data, uint64_t size, uint64_t offset) {
+    if (offset + sizeof(AlertLogRecord) > size) {
+        return NULL;
+    }
+    const AlertLogRecord *record = (const AlertLogRecord *)(data + offset);
+    if (record->length < sizeof(AlertLogRecord) || record->length % 8 != 0 ||
+        record->length > size - offset ||
+        sizeof(AlertLogRecord) + record->name_len + record->description_len > record->length ||
+        record->kind > ALERT_EVENT_RESOLVED) {
+        return NULL;
+    }
+    return record;
+}
+
+// 把一条记录计入块的索引项
+static void block_add(AlertIndexEntry *block, const AlertLogRecord *record) {
+    if (block->count == 0 || record->timestamp < block->first) {
+        block->first = record->timestamp;
+    }
+    if (block->count == 0 || record->timestamp > block->last) {
+        block->last = record->timestamp;
+    }
+    if (record->severity > block->max_severity) {
+        block->max_severity = record->severity;
+    }
+
+    const char *name = alert_record_name(record);
+    size_t kind_len = kind_length(name, record->name_len);
+    bloom_add(block->metrics, hash_bytes(name, record->name_len));
+    if (kind_len > 0) {
+        bloom_add(block->metrics, hash_bytes(name, kind_len));
+    }
+    block->count++;
+    block->bytes += record->length;
+}
+
+// 写入完整的数据，失败时返回非0
+static int write_all(int fd, const void *data, size_t len) {
+    const char *p = (const char *)data;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n <= 0) {
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+// 为当前块追加索引项，之后的记录从新块开始
+static int flush_block(AlertLog *log) {
+    int ret = 0;
+    if (log->block.count > 0 && write_all(log->index_fd, &log->block, sizeof(log->block)) != 0) {
+        log->write_errors++;
+        ret = -1;
+    }
+    memset(&log->block, 0, sizeof(log->block));
+    log->block.offset = log->size;
+    return ret;
+}
+
+// 打开文件，不存在、为空或格式不符时写入新的文件头，retire表示格式不符时保留为path.1
+static int open_file(const char *path, const char *magic, bool retire) {
+    int fd = open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+
+    AlertLogFileHeader header;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+    if ((uint64_t)st.st_size >= HEADER_SIZE &&
+        pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) &&
+        header_valid(&header, magic)) {
+        return fd;
+    }
+
+    if (st.st_size > 0 && retire) {
+        close(fd);
+        char old_path[300];
+        snprintf(old_path, sizeof(old_path), "%s.1", path);
+        rename(path, old_path);
+        fd = open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            return -1;
+        }
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, magic, sizeof(header.magic));
+    header.version = ALERT_LOG_VERSION;
+    header.header_size = (uint32_t)HEADER_SIZE;
+    if (ftruncate(fd, 0) != 0 || write_all(fd, &header, sizeof(header)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// 对齐索引和日志：丢弃指向日志之外的索引项，为尚未建立索引的记录补写索引项，
+// 截掉末尾不完整的记录，最后一个未写满的块作为当前块继续填充
+static int recover(AlertLog *log) {
+    struct stat log_st, index_st;
+    if (fstat(log->fd, &log_st) != 0 || fstat(log->index_fd, &index_st) != 0) {
+        return -1;
+    }
+    uint64_t size = (uint64_t)log_st.st_size;
+    uint64_t count = ((uint64_t)index_st.st_size - HEADER_SIZE) / sizeof(AlertIndexEntry);
+
+    uint64_t indexed = HEADER_SIZE;
+    while (count > 0) {
+        AlertIndexEntry entry;
+        off_t at = (off_t)(HEADER_SIZE + (count - 1) * sizeof(entry));
+        if (pread(log->index_fd, &entry, sizeof(entry), at) == (ssize_t)sizeof(entry) &&
+            entry.offset >= HEADER_SIZE && entry.offset + entry.bytes <= size) {
+            indexed = entry.offset + entry.bytes;
+            break;
+        }
+        count--;
+    }
+    if (ftruncate(log->index_fd, (off_t)(HEADER_SIZE + count * sizeof(AlertIndexEntry))) != 0) {
+        return -1;
+    }
+
+    // 逐条扫描未建立索引的记录
+    char *data = NULL;
+    if (size > indexed) {
+        data = (char *)mmap(NULL, size, PROT_READ, MAP_SHARED, log->fd, 0);
+        if (data == MAP_FAILED) {
+            return -1;
+        }
+    }
+    log->size = indexed;
+    memset(&log->block, 0, sizeof(log->block));
+    log->block.offset = indexed;
+    const AlertLogRecord *record;
+    while (data && (record = record_at(data, size, log->size)) != NULL) {
+        log->size += record->length;
+        block_add(&log->block, record);
+        if (log->block.count >= ALERT_LOG_BLOCK_RECORDS) {
+            flush_block(log);
+        }
+    }
+    if (data) {
+        munmap(data, size);
+    }
+
+    if (log->size < size && ftruncate(log->fd, (off_t)log->size) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+int alert_log_open(AlertLog *log, const char *path) {
+    if (!log || !path || strlen(path) + 4 >= sizeof(log->path)) {
+        return -1;
+    }
+
+    memset(log, 0, sizeof(*log));
+    strcpy(log->path, path);
+    log->index_fd = -1;
+    log->fd = open_file(path, ALERT_LOG_MAGIC, true);
+    if (log->fd < 0) {
+        return -1;
+    }
+
+    char index_path[sizeof(log->path)];
+    snprintf(index_path, sizeof(index_path), "%s.idx", path);
+    log->index_fd = open_file(index_path, ALERT_INDEX_MAGIC, false);
+    if (log->index_fd < 0 || recover(log) != 0) {
+        if (log->index_fd >= 0) {
+            close(log->index_fd);
+        }
+        close(log->fd);
+        log->fd = log->index_fd = -1;
+        return -1;
+    }
+
+    pthread_mutex_init(&log->lock, NULL);
+    return 0;
+}
+
+int alert_log_append(AlertLog *log, const AlertEvent *event, const char *name, const char *description) {
+    if (!log || !event || !name || !description) {
+        return -1;
+    }
+
+    size_t name_len = strnlen(name, MAX_NAME_LEN);
+    size_t description_len = strnlen(description, MAX_DESCRIPTION_LEN);
+    size_t length = (sizeof(AlertLogRecord) + name_len + description_len + 7) / 8 * 8;
+    char buf[(sizeof(AlertLogRecord) + MAX_NAME_LEN + MAX_DESCRIPTION_LEN + 7) / 8 * 8];
+    memset(buf, 0, length);
+
+    AlertLogRecord *record = (AlertLogRecord *)buf;
+    record->length = (uint32_t)length;
+    record->kind = (uint8_t)event->kind;
+    record->type = (uint8_t)event->type;
+    record->source = event->anomaly.source;
+    record->severity = (uint8_t)event->severity;
+    record->sources = event->sources;
+    record->name_len = (uint16_t)name_len;
+    record->description_len = (uint16_t)description_len;
+    record->timestamp = (int64_t)event->timestamp;
+    record->started = (int64_t)event->started;
+    record->duration_ns = event->duration_ns;
+    record->anomalies = event->anomalies;
+    record->value = event->value;
+    record->threshold = event->threshold;
+    record->peak = event->peak;
+    record->anomaly_value = event->anomaly.value;
+    record->anomaly_threshold = event->anomaly.threshold;
+    record->anomaly_center = event->anomaly.center;
+    record->anomaly_spread = event->anomaly.spread;
+    memcpy(buf + sizeof(AlertLogRecord), name, name_len);
+    memcpy(buf + sizeof(AlertLogRecord) + name_len, description, description_len);
+
+    pthread_mutex_lock(&log->lock);
+    int ret = 0;
+    if (write_all(log->fd, buf, length) != 0) {
+        // 截掉写了一半的记录，之后的记录仍然完整
+        log->write_errors++;
+        if (ftruncate(log->fd, (off_t)log->size) != 0) {
+            // 下次打开时同样会截掉
+        }
+        ret = -1;
+    } else {
+        log->size += length;
+        log->records++;
+        block_add(&log->block, record);
+        if (log->block.count >= ALERT_LOG_BLOCK_RECORDS) {
+            ret = flush_block(log);
+        }
+    }
+    pthread_mutex_unlock(&log->lock);
+    return ret;
+}
+
+void alert_log_close(AlertLog *log) {
+    if (!log || log->fd < 0) {
+        return;
+    }
+
+    flush_block(log);
+    close(log->index_fd);
+    close(log->fd);
+    log->index_fd = -1;
+    log->fd = -1;
+    pthread_mutex_destroy(&log->lock);
+}
+
+// 只读映射整个文件，文件头不符时返回NULL
+static const char *map_file(const char *path, const char *magic, uint64_t *size) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < HEADER_SIZE) {
+        close(fd);
+        return NULL;
+    }
+    *size = (uint64_t)st.st_size;
+    char *data = (char *)mmap(NULL, *size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return NULL;
+    }
+    if (!header_valid((const AlertLogFileHeader *)data, magic)) {
+        munmap(data, *size);
+        return NULL;
+    }
+    return data;
+}
+
+int alert_log_reader_open(AlertLogReader *reader, const char *path) {
+    if (!reader || !path) {
+        return -1;
+    }
+
+    memset(reader, 0, sizeof(*reader));
+    reader->data = map_file(path, ALERT_LOG_MAGIC, &reader->size);
+    if (!reader->data) {
+        return -1;
+    }
+    reader->tail = HEADER_SIZE;
+
+    char index_path[300];
+    snprintf(index_path, sizeof(index_path), "%s.idx", path);
+    reader->index = map_file(index_path, ALERT_INDEX_MAGIC, &reader->index_size);
+    if (!reader->index) {
+        return 0;
+    }
+
+    // 只使用位于日志范围内的索引项，其后的记录按未建立索引处理
+    reader->entries = (const AlertIndexEntry *)(reader->index + HEADER_SIZE);
+    uint64_t count = (reader->index_size - HEADER_SIZE) / sizeof(AlertIndexEntry);
+    uint64_t tail = HEADER_SIZE;
+    for (uint64_t i = 0; i < count; i++) {
+        const AlertIndexEntry *entry = &reader->entries[i];
+        if (entry->offset != tail || entry->bytes > reader->size - tail) {
+            break;
+        }
+        tail += entry->bytes;
+        reader->entry_count++;
+    }
+    reader->tail = tail;
+    return 0;
+}
+
+void alert_log_reader_close(AlertLogReader *reader) {
+    if (!reader) {
+        return;
+    }
+    if (reader->data) {
+        munmap((void *)reader->data, reader->size);
+    }
+    if (reader->index) {
+        munmap((void *)reader->index, reader->index_size);
+    }
+    memset(reader, 0, sizeof(*reader));
+}
+
+static bool record_matches(const AlertLogRecord *record, const AlertQuery *query, size_t metric_len) {
+    if ((query->since != 0 && record->timestamp < query->since) ||
+        (query->until != 0 && record->timestamp >= query->until) ||
+        record->severity < query->min_severity) {
+        return false;
+    }
+    if (!query->metric) {
+        return true;
+    }
+
+    // 完整指标名，或以"种类名:"开头
+    const char *name = alert_record_name(record);
+    if (record->name_len < metric_len || memcmp(name, query->metric, metric_len) != 0) {
+        return false;
+    }
+    return record->name_len == metric_len || name[metric_len] == ':';
+}
+
+static bool block_may_match(const AlertIndexEntry *entry, const AlertQuery *query, uint64_t metric_hash) {
+    if ((query->since != 0 && entry->last < query->since) ||
+        (query->until != 0 && entry->first >= query->until) ||
+        (int)entry->max_severity < query->min_severity) {
+        return false;
+    }
+    return !query->metric || bloom_has(entry->metrics, metric_hash);
+}
+
+// 扫描[offset, end)内的记录，fn要求停止时返回非0
+static int scan_range(const AlertLogReader *reader, uint64_t offset, uint64_t end,
+                      const AlertQuery *query, size_t metric_len,
+                      int (*fn)(const AlertLogRecord *record, void *arg), void *arg,
+                      AlertQueryStats *stats) {
+    const AlertLogRecord *record;
+    while (offset < end && (record = record_at(reader->data, end, offset)) != NULL) {
+        offset += record->length;
+        stats->records_scanned++;
+        if (record_matches(record, query, metric_len)) {
+            stats->matched++;
+            if (fn && fn(record, arg) != 0) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+unsigned long alert_log_query(const AlertLogReader *reader, const AlertQuery *query,
+                              int (*fn)(const AlertLogRecord *record, void *arg), void *arg,
+                              AlertQueryStats *stats) {
+    AlertQueryStats local;
+    if (!stats) {
+        stats = &local;
+    }
+    memset(stats, 0, sizeof(*stats));
+    if (!reader || !reader->data || !query) {
+        return 0;
+    }
+
+    size_t metric_len = query->metric ? strlen(query->metric) : 0;
+    uint64_t metric_hash = query->metric ? hash_bytes(query->metric, metric_len) : 0;
+    stats->blocks = (unsigned long)reader->entry_count;
+    for (uint64_t i = 0; i < reader->entry_count; i++) {
+        const AlertIndexEntry *entry = &reader->entries[i];
+        if (!block_may_match(entry, query, metric_hash)) {
+            continue;
+        }
+        stats->blocks_scanned++;
+        if (scan_range(reader, entry->offset, entry->offset + entry->bytes, query, metric_len,
+                       fn, arg, stats) != 0) {
+            return stats->matched;
+        }
+    }
+    scan_range(reader, reader->tail, reader->size, query, metric_len, fn, arg, stats);
+    return stats->matched;
+}
+
+void alert_record_to_event(const AlertLogRecord *record, AlertEvent *event) {
+    memset(event, 0, sizeof(*event));
+    event->kind = (AlertEventKind)record->kind;
+    event->metric_id = -1;
+    event->type = (MetricType)record->type;
+    event->sources = record->sources;
+    event->severity = record->severity;
+    event->value = record->value;
+    event->threshold = record->threshold;
+    event->peak = record->peak;
+    event->started = (time_t)record->started;
+    event->timestamp = (time_t)record->timestamp;
+    event->duration_ns = record->duration_ns;
+    event->anomalies = (unsigned long)record->anomalies;
+    event->anomaly.metric_id = -1;
+    event->anomaly.type = record->type;
+    event->anomaly.source = record->source;
+    event->anomaly.severity = record->severity;
+    event->anomaly.value = record->anomaly_value;
+    event->anomaly.threshold = record->anomaly_threshold;
+    event->anomaly.center = record->anomaly_center;
+    event->anomaly.spread = record->anomaly_spread;
+    event->anomaly.timestamp = event->timestamp;
+}
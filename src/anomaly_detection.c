@@ -6,132 +6,634 @@
 #include <math.h>
 #include <time.h>
 
+#define MAD_SCALE 1.4826            // 正态分布下MAD到标准差的换算系数
+#define MEAN_ABS_DEV_SCALE 1.2533   // 正态分布下平均绝对偏差到标准差的换算系数
+
+// 各指标种类的名称、描述和阈值，按MetricType顺序排列
+static const struct {
+    const char *name;
+    const char *description;
+    double threshold;
+    bool per_instance;          // 是否每个设备/接口一个实例
+} metric_kinds[METRIC_COUNT] = {
+    [METRIC_CPU_USAGE] = { "cpu_usage", "CPU使用率(%)", CPU_USAGE_THRESHOLD, false },
+    [METRIC_CPU_IOWAIT] = { "cpu_iowait", "CPU IO等待时间(%)", CPU_IOWAIT_THRESHOLD, false },
+    [METRIC_CPU_IRQ] = { "cpu_irq", "CPU中断时间(%)", CPU_IRQ_THRESHOLD, false },
+    [METRIC_MEM_USAGE] = { "mem_usage", "内存使用率(%)", MEM_USAGE_THRESHOLD, false },
+    [METRIC_MEM_ACTIVE] = { "mem_active", "活跃内存大小(KB)", 0, false }, // 使用动态阈值
+    [METRIC_DISK_READ_AWAIT] = { "disk_read_await", "磁盘读响应时间(ms)", DISK_READ_AWAIT_THRESHOLD, true },
+    [METRIC_DISK_WRITE_AWAIT] = { "disk_write_await", "磁盘写响应时间(ms)", DISK_WRITE_AWAIT_THRESHOLD, true },
+    [METRIC_DISK_UTIL] = { "disk_util", "磁盘使用率(%)", DISK_UTIL_THRESHOLD, true },
+    [METRIC_NET_DROPPED] = { "net_dropped", "网络丢包数", NET_DROPPED_THRESHOLD, true },
+};
+
+const char *metric_kind_name(MetricType type) {
+    if ((int)type < 0 || type >= METRIC_COUNT) {
+        return "unknown";
+    }
+    return metric_kinds[type].name;
+}
+
+int find_metric_kind(const char *name, size_t len) {
+    if (!name) {
+        return -1;
+    }
+    for (int i = 0; i < METRIC_COUNT; i++) {
+        if (strlen(metric_kinds[i].name) == len && strncmp(metric_kinds[i].name, name, len) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
 int init_detector(AnomalyDetector *detector, int window_size, double sigma_factor) {
     if (!detector) {
         return -1;
     }
 
     // 初始化检测器参数
+    memset(detector, 0, sizeof(*detector));
     detector->window_size = window_size;
     detector->sigma_factor = sigma_factor;
-    detector->anomaly_count = 0;
-    detector->anomaly_capacity = MAX_ANOMALIES;
-    
-    // 分配异常数组内存
-    detector->anomalies = (Anomaly *)malloc(sizeof(Anomaly) * detector->anomaly_capacity);
-    if (!detector->anomalies) {
+    detector->forecast_params = (ForecastParams){
+        .alpha = FORECAST_ALPHA,
+        .beta = FORECAST_BETA,
+        .gamma = FORECAST_GAMMA,
+        .variance_alpha = FORECAST_VARIANCE_ALPHA,
+        .season_ns = (uint64_t)FORECAST_SEASON_SEC * 1000000000ULL,
+        .season_buckets = FORECAST_SEASON_BUCKETS,
+        .warmup = FORECAST_WARMUP,
+    };
+
+    if (stats_columns_init(&detector->columns) != 0) {
+        free_detector(detector);
+        return -1;
+    }
+
+    if (name_index_init(&detector->metric_index, METRIC_COUNT * 2) != 0) {
+        free_detector(detector);
         return -1;
     }
 
-    // 初始化指标
+    // 注册系统级指标，设备和接口指标在发现时注册
     for (int i = 0; i < METRIC_COUNT; i++) {
-        Metric *metric = &detector->metrics[i];
-        metric->type = (MetricType)i;
-        metric->history_capacity = window_size;
-        metric->history_size = 0;
-        metric->history = (double *)malloc(sizeof(double) * window_size);
-        
-        if (!metric->history) {
+        if (!metric_kinds[i].per_instance &&
+            register_metric(detector, (MetricType)i, NULL) < 0) {
             free_detector(detector);
             return -1;
         }
-        
-        // 设置指标名称和描述
-        switch (i) {
-            case METRIC_CPU_USAGE:
-                strcpy(metric->name, "cpu_usage");
-                strcpy(metric->description, "CPU使用率(%)");
-                metric->threshold = CPU_USAGE_THRESHOLD;
-                break;
-            case METRIC_CPU_IOWAIT:
-                strcpy(metric->name, "cpu_iowait");
-                strcpy(metric->description, "CPU IO等待时间(%)");
-                metric->threshold = CPU_IOWAIT_THRESHOLD;
-                break;
-            case METRIC_CPU_IRQ:
-                strcpy(metric->name, "cpu_irq");
-                strcpy(metric->description, "CPU中断时间(%)");
-                metric->threshold = CPU_IRQ_THRESHOLD;
-                break;
-            case METRIC_MEM_USAGE:
-                strcpy(metric->name, "mem_usage");
-                strcpy(metric->description, "内存使用率(%)");
-                metric->threshold = MEM_USAGE_THRESHOLD;
-                break;
-            case METRIC_MEM_ACTIVE:
-                strcpy(metric->name, "mem_active");
-                strcpy(metric->description, "活跃内存大小(KB)");
-                metric->threshold = 0; // 使用动态阈值
-                break;
-            case METRIC_DISK_READ_AWAIT:
-                strcpy(metric->name, "disk_read_await");
-                strcpy(metric->description, "磁盘读响应时间(ms)");
-                metric->threshold = DISK_READ_AWAIT_THRESHOLD;
-                break;
-            case METRIC_DISK_WRITE_AWAIT:
-                strcpy(metric->name, "disk_write_await");
-                strcpy(metric->description, "磁盘写响应时间(ms)");
-                metric->threshold = DISK_WRITE_AWAIT_THRESHOLD;
-                break;
-            case METRIC_DISK_UTIL:
-                strcpy(metric->name, "disk_util");
-                strcpy(metric->description, "磁盘使用率(%)");
-                metric->threshold = DISK_UTIL_THRESHOLD;
-                break;
-            case METRIC_NET_DROPPED:
-                strcpy(metric->name, "net_dropped");
-                strcpy(metric->description, "网络丢包数");
-                metric->threshold = NET_DROPPED_THRESHOLD;
-                break;
-            default:
-                strcpy(metric->name, "unknown");
-                strcpy(metric->description, "未知指标");
-                metric->threshold = 0;
-                break;
+    }
+
+    return 0;
+}
+
+// 判断指标是否在逗号分隔的列表中：列表项可以是all、种类名或完整指标名
+static bool metric_in_list(const char *list, const Metric *metric) {
+    if (!list) {
+        return false;
+    }
+
+    const char *kind = metric_kinds[metric->type].name;
+    const char *p = list;
+    while (*p) {
+        const char *end = strchr(p, ',');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        if ((len == 3 && strncmp(p, "all", 3) == 0) ||
+            (len == strlen(kind) && strncmp(p, kind, len) == 0) ||
+            (len == strlen(metric->name) && strncmp(p, metric->name, len) == 0)) {
+            return true;
+        }
+        if (!end) {
+            break;
+        }
+        p = end + 1;
+    }
+    return false;
+}
+
+// 预测检测只保存常数大小的模型，不需要原始历史和窗口统计
+static inline bool detector_keeps_history(DetectorKind kind) {
+    return kind == DETECTOR_NSIGMA || kind == DETECTOR_MAD;
+}
+
+// 按各检测器的指标列表为指标选择检测器，靠后的种类优先
+static DetectorKind detector_for_metric(const AnomalyDetector *detector, const Metric *metric) {
+    for (int kind = DETECTOR_COUNT - 1; kind > DETECTOR_NSIGMA; kind--) {
+        if (metric_in_list(detector->detector_metrics[kind], metric)) {
+            return (DetectorKind)kind;
+        }
+    }
+    return DETECTOR_NSIGMA;
+}
+
+// 应用一个匹配的设置
+static void apply_setting(Metric *metric, const MetricSetting *setting) {
+    if (setting->threshold >= 0) {
+        metric->threshold = setting->threshold;
+    }
+    if (setting->sigma_factor > 0) {
+        metric->sigma_factor = setting->sigma_factor;
+    }
+}
+
+// 按种类名和完整指标名应用覆盖设置，完整指标名的设置后应用
+static void apply_metric_settings(const AnomalyDetector *detector, Metric *metric) {
+    const char *kind = metric_kinds[metric->type].name;
+    for (int i = 0; i < detector->setting_count; i++) {
+        if (strcmp(detector->settings[i].name, kind) == 0) {
+            apply_setting(metric, &detector->settings[i]);
+        }
+    }
+    for (int i = 0; i < detector->setting_count; i++) {
+        if (strcmp(detector->settings[i].name, metric->name) == 0 &&
+            strcmp(metric->name, kind) != 0) {
+            apply_setting(metric, &detector->settings[i]);
+        }
+    }
+}
+
+int add_metric(AnomalyDetector *detector, MetricType type, const char *name,
+               const char *description, double threshold) {
+    if (!detector || !name || !description || strlen(name) >= NAME_INDEX_KEY_LEN) {
+        return -1;
+    }
+
+    int id = name_index_find(&detector->metric_index, name);
+    if (id >= 0) {
+        return id;
+    }
+
+    if (detector->free_count > 0) {
+        // 优先复用已退役的下标
+        id = detector->free_ids[detector->free_count - 1];
+    } else {
+        // 检查容量
+        if (detector->metric_count >= detector->metric_capacity) {
+            int new_capacity = detector->metric_capacity > 0 ? detector->metric_capacity * 2
+                                                             : METRIC_COUNT * 2;
+            Metric *new_metrics = (Metric *)realloc(detector->metrics,
+                                                    sizeof(Metric) * new_capacity);
+            if (!new_metrics) {
+                return -1;
+            }
+            detector->metrics = new_metrics;
+            int *new_free = (int *)realloc(detector->free_ids, sizeof(int) * new_capacity);
+            if (!new_free) {
+                return -1;
+            }
+            detector->free_ids = new_free;
+            detector->metric_capacity = new_capacity;
+        }
+        id = detector->metric_count;
+        if (stats_columns_reserve(&detector->columns, id + 1) != 0) {
+            return -1;
+        }
+    }
+
+    Metric *metric = &detector->metrics[id];
+    memset(metric, 0, sizeof(*metric));
+    metric->type = type;
+    strcpy(metric->name, name);
+    DetectorKind kind = detector_for_metric(detector, metric);
+    if (detector_keeps_history(kind)) {
+        metric->history = (double *)malloc(sizeof(double) * detector->window_size);
+        if (!metric->history) {
+            return -1;
+        }
+    }
+    if (name_index_put(&detector->metric_index, name, id) != 0) {
+        free(metric->history);
+        metric->history = NULL;
+        return -1;
+    }
+    metric->active = true;
+    metric->history_capacity = detector->window_size;
+    strncpy(metric->description, description, sizeof(metric->description) - 1);
+    metric->threshold = threshold;
+    apply_metric_settings(detector, metric);
+    metric->incarnation = ++detector->incarnations;
+    metric->columns = &detector->columns;
+    metric->column = id;
+    stats_columns_set(metric->columns, id, 0, 0, 0, 0);
+
+    if (id == detector->metric_count) {
+        detector->metric_count++;
+    } else {
+        detector->free_count--;
+    }
+
+    // 预测模型建立失败时退回N-Sigma，由它分配历史数据
+    if (kind != DETECTOR_NSIGMA && set_metric_detector(detector, id, kind) != 0) {
+        set_metric_detector(detector, id, DETECTOR_NSIGMA);
+    }
+    return id;
+}
+
+int register_metric(AnomalyDetector *detector, MetricType type, const char *instance) {
+    if (!detector || (int)type < 0 || type >= METRIC_COUNT) {
+        return -1;
+    }
+
+    if (!instance) {
+        return add_metric(detector, type, metric_kinds[type].name,
+                          metric_kinds[type].description, metric_kinds[type].threshold);
+    }
+
+    char name[NAME_INDEX_KEY_LEN];
+    int len = snprintf(name, sizeof(name), "%s:%s", metric_kinds[type].name, instance);
+    if (len < 0 || len >= (int)sizeof(name)) {
+        return -1;
+    }
+
+    // 常见情况下指标已存在，直接返回，避免格式化描述
+    int id = name_index_find(&detector->metric_index, name);
+    if (id >= 0) {
+        return id;
+    }
+
+    char description[256];
+    snprintf(description, sizeof(description), "%s [%s]",
+             metric_kinds[type].description, instance);
+    return add_metric(detector, type, name, description, metric_kinds[type].threshold);
+}
+
+int register_metric_name(AnomalyDetector *detector, const char *name) {
+    if (!detector || !name) {
+        return -1;
+    }
+
+    int id = name_index_find(&detector->metric_index, name);
+    if (id >= 0) {
+        return id;
+    }
+
+    const char *sep = strchr(name, ':');
+    int kind = find_metric_kind(name, sep ? (size_t)(sep - name) : strlen(name));
+    if (kind < 0) {
+        return -1;
+    }
+    return register_metric(detector, (MetricType)kind, sep ? sep + 1 : NULL);
+}
+
+int find_metric(const AnomalyDetector *detector, const char *name) {
+    if (!detector || !name) {
+        return -1;
+    }
+    return name_index_find(&detector->metric_index, name);
+}
+
+// 把当前值和窗口统计写入统计列，只有使用N-Sigma、检测器因子且有历史数据的指标参与批量检测
+static void sync_metric_columns(Metric *metric) {
+    if (!metric->columns) {
+        return;
+    }
+    int n = metric->detector == DETECTOR_NSIGMA && metric->sigma_factor == 0 && metric->history
+                ? metric->history_size : 0;
+    stats_columns_set(metric->columns, metric->column, metric->value,
+                      metric->window.mean, metric->window.m2, n);
+}
+
+void retire_metric(AnomalyDetector *detector, int metric_id) {
+    if (!detector || metric_id < 0 || metric_id >= detector->metric_count) {
+        return;
+    }
+
+    Metric *metric = &detector->metrics[metric_id];
+    if (!metric->active) {
+        return;
+    }
+
+    name_index_remove(&detector->metric_index, metric->name);
+    free(metric->history);
+    metric->history = NULL;
+    metric->history_size = 0;
+    metric->active = false;
+    set_metric_detector(detector, metric_id, DETECTOR_NSIGMA);
+    detector->free_ids[detector->free_count++] = metric_id;
+}
+
+int set_metric_detector(AnomalyDetector *detector, int metric_id, DetectorKind kind) {
+    if (!detector || metric_id < 0 || metric_id >= detector->metric_count) {
+        return -1;
+    }
+
+    Metric *metric = &detector->metrics[metric_id];
+    double *history = NULL;
+    if (detector_keeps_history(kind) && !metric->history && metric->active) {
+        // 从预测检测切换回来，历史数据从空窗口重新积累
+        history = (double *)malloc(sizeof(double) * metric->history_capacity);
+        if (!history) {
+            return -1;
+        }
+        metric->history = history;
+    }
+
+    if (kind == DETECTOR_MAD && !metric->order) {
+        if (!metric->history) {
+            return -1;
+        }
+        OrderStats *order = (OrderStats *)malloc(sizeof(OrderStats));
+        if (!order || order_stats_init(order, metric->history_capacity) != 0) {
+            free(order);
+            if (history) {
+                free(history);
+                metric->history = NULL;
+            }
+            return -1;
+        }
+        for (int i = 0; i < metric->history_size; i++) {
+            order_stats_insert(order, metric_history_at(metric, i));
+        }
+        metric->order = order;
+    } else if (kind != DETECTOR_MAD && metric->order) {
+        order_stats_free(metric->order);
+        free(metric->order);
+        metric->order = NULL;
+    }
+
+    if (kind == DETECTOR_EWMA || kind == DETECTOR_HOLT_WINTERS) {
+        ForecastKind model = kind == DETECTOR_EWMA ? FORECAST_EWMA : FORECAST_HOLT_WINTERS;
+        if (!metric->forecast || metric->forecast->kind != model) {
+            Forecast *forecast = forecast_create(model, &detector->forecast_params,
+                                                 detector->clock_offset_ns);
+            if (!forecast) {
+                return -1;
+            }
+            // 历史数据没有逐点时间戳，只用来预热EWMA；季节模型由之后的样本（含恢复的数据）训练
+            if (model == FORECAST_EWMA) {
+                for (int i = 0; i < metric->history_size; i++) {
+                    forecast_update(forecast, metric_history_at(metric, i), metric->timestamp_ns);
+                }
+            }
+            free(metric->forecast);
+            metric->forecast = forecast;
+        }
+        if (metric->history) {
+            // 模型建好后释放原始历史和窗口统计
+            free(metric->history);
+            metric->history = NULL;
+            metric->history_head = 0;
+            metric->history_size = 0;
+            memset(&metric->window, 0, sizeof(metric->window));
+            memset(&metric->shadow, 0, sizeof(metric->shadow));
+            metric->mean = 0;
+            metric->stddev = 0;
+        }
+    } else if (metric->forecast) {
+        free(metric->forecast);
+        metric->forecast = NULL;
+    }
+
+    metric->detector = kind;
+    sync_metric_columns(metric);
+    return 0;
+}
+
+int set_detector_metrics(AnomalyDetector *detector, DetectorKind kind, const char *list) {
+    if (!detector || kind <= DETECTOR_NSIGMA || kind >= DETECTOR_COUNT) {
+        return -1;
+    }
+
+    char *copy = NULL;
+    if (list && list[0] != '\0') {
+        copy = strdup(list);
+        if (!copy) {
+            return -1;
+        }
+    }
+    free(detector->detector_metrics[kind]);
+    detector->detector_metrics[kind] = copy;
+
+    int ret = 0;
+    for (int i = 0; i < detector->metric_count; i++) {
+        Metric *metric = &detector->metrics[i];
+        if (!metric->active) {
+            continue;
+        }
+        if (set_metric_detector(detector, i, detector_for_metric(detector, metric)) != 0) {
+            ret = -1;
+        }
+    }
+    return ret;
+}
+
+int set_metric_settings(AnomalyDetector *detector, const MetricSetting *settings, int count) {
+    if (!detector || count < 0 || (count > 0 && !settings)) {
+        return -1;
+    }
+
+    MetricSetting *copy = NULL;
+    if (count > 0) {
+        copy = (MetricSetting *)malloc(sizeof(MetricSetting) * count);
+        if (!copy) {
+            return -1;
+        }
+        memcpy(copy, settings, sizeof(MetricSetting) * count);
+    }
+    free(detector->settings);
+    detector->settings = copy;
+    detector->setting_count = count;
+
+    // 先恢复种类默认值再应用，删除的设置随之失效
+    for (int i = 0; i < detector->metric_count; i++) {
+        Metric *metric = &detector->metrics[i];
+        if (!metric->active) {
+            continue;
+        }
+        metric->threshold = metric_kinds[metric->type].threshold;
+        metric->sigma_factor = 0;
+        apply_metric_settings(detector, metric);
+        sync_metric_columns(metric);
+    }
+    return 0;
+}
+
+// 释放一个指标组
+static void free_group(CorrelationGroup *group) {
+    free(group->spec);
+    free(group->members);
+    free(group->incarnations);
+    free(group->values);
+    free(group->contrib);
+    correlation_free(&group->model);
+    memset(group, 0, sizeof(*group));
+}
+
+int set_correlation_groups(AnomalyDetector *detector, const char *groups) {
+    if (!detector) {
+        return -1;
+    }
+
+    // 先数出组数，空的组跳过
+    int count = 0;
+    for (const char *p = groups; p && *p; ) {
+        const char *end = strchr(p, ';');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        count += len > 0;
+        p = end ? end + 1 : p + len;
+    }
+
+    CorrelationGroup *next = NULL;
+    if (count > 0) {
+        next = (CorrelationGroup *)calloc((size_t)count, sizeof(CorrelationGroup));
+        if (!next) {
+            return -1;
+        }
+    }
+
+    int n = 0;
+    for (const char *p = groups; p && *p; ) {
+        const char *end = strchr(p, ';');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        if (len > 0) {
+            // 成员列表不变的组原样移入，保留模型
+            CorrelationGroup *group = &next[n++];
+            for (int i = 0; i < detector->group_count; i++) {
+                CorrelationGroup *old = &detector->groups[i];
+                if (old->spec && strlen(old->spec) == len && strncmp(old->spec, p, len) == 0) {
+                    *group = *old;
+                    memset(old, 0, sizeof(*old));
+                    break;
+                }
+            }
+            if (!group->spec) {
+                group->spec = strndup(p, len);
+                if (!group->spec) {
+                    for (int i = 0; i < n; i++) {
+                        free_group(&next[i]);
+                    }
+                    free(next);
+                    return -1;
+                }
+            }
         }
+        p = end ? end + 1 : p + len;
     }
 
+    for (int i = 0; i < detector->group_count; i++) {
+        free_group(&detector->groups[i]);
+    }
+    free(detector->groups);
+    detector->groups = next;
+    detector->group_count = n;
     return 0;
 }
 
+void set_detector_clock(AnomalyDetector *detector, int64_t offset_ns) {
+    if (!detector) {
+        return;
+    }
+
+    detector->clock_offset_ns = offset_ns;
+    for (int i = 0; i < detector->metric_count; i++) {
+        if (detector->metrics[i].forecast) {
+            detector->metrics[i].forecast->clock_offset_ns = offset_ns;
+        }
+    }
+}
+
 void free_detector(AnomalyDetector *detector) {
     if (!detector) {
         return;
     }
 
     // 释放指标历史数据
-    for (int i = 0; i < METRIC_COUNT; i++) {
-        if (detector->metrics[i].history) {
-            free(detector->metrics[i].history);
-            detector->metrics[i].history = NULL;
-        }
+    for (int i = 0; i < detector->metric_count; i++) {
+        free(detector->metrics[i].history);
+        detector->metrics[i].history = NULL;
+        detector->metrics[i].active = false;
+        set_metric_detector(detector, i, DETECTOR_NSIGMA);
     }
+    free(detector->metrics);
+    detector->metrics = NULL;
+    detector->metric_count = 0;
+    detector->metric_capacity = 0;
+    free(detector->free_ids);
+    detector->free_ids = NULL;
+    detector->free_count = 0;
+    free(detector->series_metrics);
+    detector->series_metrics = NULL;
+    detector->series_capacity = 0;
+    name_index_free(&detector->metric_index);
+    stats_columns_free(&detector->columns);
+    for (int i = 0; i < DETECTOR_COUNT; i++) {
+        free(detector->detector_metrics[i]);
+        detector->detector_metrics[i] = NULL;
+    }
+    free(detector->settings);
+    detector->settings = NULL;
+    detector->setting_count = 0;
+    set_correlation_groups(detector, NULL);
+
+    // 释放异常记录
+    free(detector->anomalies.records);
+    memset(&detector->anomalies, 0, sizeof(detector->anomalies));
+}
+
+// Welford增量：加入一个样本
+static inline void running_stats_add(RunningStats *rs, double x) {
+    rs->count++;
+    double delta = x - rs->mean;
+    rs->mean += delta / rs->count;
+    rs->m2 += delta * (x - rs->mean);
+}
 
-    // 释放异常数组
-    if (detector->anomalies) {
-        free(detector->anomalies);
-        detector->anomalies = NULL;
+// 滑动替换：用新样本x替换最旧样本old，样本数量不变
+static inline void running_stats_replace(RunningStats *rs, double old, double x) {
+    double old_mean = rs->mean;
+    rs->mean += (x - old) / rs->count;
+    rs->m2 += (x - old) * (x - rs->mean + old - old_mean);
+    if (rs->m2 < 0) {
+        rs->m2 = 0;
     }
 }
 
-int add_metric_datapoint(Metric *metric, double value) {
-    if (!metric || !metric->history) {
+int add_metric_datapoint(Metric *metric, double value, uint64_t timestamp_ns) {
+    if (!metric || (!metric->history && !metric->forecast)) {
         return -1;
     }
 
-    // 如果历史数据已满，移动数据
-    if (metric->history_size == metric->history_capacity) {
-        for (int i = 0; i < metric->history_size - 1; i++) {
-            metric->history[i] = metric->history[i + 1];
+    if (metric->forecast) {
+        // 预测检测的指标只更新模型
+        forecast_update(metric->forecast, value, timestamp_ns);
+    } else if (metric->history_size == metric->history_capacity) {
+        // 历史数据已满，覆盖最旧的数据点并前移头指针
+        double old = metric->history[metric->history_head];
+        metric->history[metric->history_head] = value;
+        if (++metric->history_head == metric->history_capacity) {
+            metric->history_head = 0;
+        }
+        running_stats_replace(&metric->window, old, value);
+        if (metric->order) {
+            order_stats_remove(metric->order, old);
         }
-        metric->history[metric->history_size - 1] = value;
     } else {
-        // 否则直接添加
-        metric->history[metric->history_size++] = value;
+        // 否则直接追加
+        int tail = metric->history_head + metric->history_size;
+        if (tail >= metric->history_capacity) {
+            tail -= metric->history_capacity;
+        }
+        metric->history[tail] = value;
+        metric->history_size++;
+        running_stats_add(&metric->window, value);
+    }
+    if (metric->order) {
+        order_stats_insert(metric->order, value);
+    }
+
+    // 影子累加器只做加法，累计满一个窗口时恰好覆盖当前窗口的全部数据，
+    // 用它替换滑动累加器即可消除减法带来的累积误差（重新锚定）
+    if (metric->history) {
+        running_stats_add(&metric->shadow, value);
+        if (metric->shadow.count == metric->history_capacity) {
+            metric->window = metric->shadow;
+            memset(&metric->shadow, 0, sizeof(metric->shadow));
+        }
     }
 
     // 更新当前值
     metric->value = value;
+    metric->timestamp_ns = timestamp_ns;
 
     // 更新统计信息
     update_metric_stats(metric);
@@ -144,103 +646,170 @@ void update_metric_stats(Metric *metric) {
         return;
     }
 
-    // 计算均值
-    double sum = 0;
-    for (int i = 0; i < metric->history_size; i++) {
-        sum += metric->history[i];
-    }
-    metric->mean = sum / metric->history_size;
-
-    // 计算标准差
-    double variance = 0;
-    for (int i = 0; i < metric->history_size; i++) {
-        double diff = metric->history[i] - metric->mean;
-        variance += diff * diff;
-    }
-    metric->stddev = sqrt(variance / metric->history_size);
+    // 每个窗口重新锚定一次，误差只来自至多一个窗口的滑动替换。误差与数据有关：
+    // 与两遍算法相比，均值相对误差约为ε·√n，标准差相对误差约为ε·(√n + |均值|/标准差)
+    // （ε为机器精度，n为窗口大小）；均值1e9、标准差3时标准差相对误差约2e-8，
+    // 由make bench BENCH_ARGS="-f StatsError"测量
+    metric->mean = metric->window.mean;
+    metric->stddev = sqrt(metric->window.m2 / metric->window.count);
+    sync_metric_columns(metric);
 }
 
-int add_anomaly(AnomalyDetector *detector, MetricType type, double value, 
-                double threshold, const char *message, int severity) {
-    if (!detector || !detector->anomalies || !message) {
+int add_anomaly(AnomalyDetector *detector, int metric_id, int source, double value,
+                double threshold, double center, double spread, int severity) {
+    if (!detector || metric_id < 0 || metric_id >= detector->metric_count) {
         return -1;
     }
 
-    // 检查容量
-    if (detector->anomaly_count >= detector->anomaly_capacity) {
-        // 扩展容量
-        int new_capacity = detector->anomaly_capacity * 2;
-        Anomaly *new_anomalies = (Anomaly *)realloc(detector->anomalies, 
-                                                   sizeof(Anomaly) * new_capacity);
-        if (!new_anomalies) {
+    // 容量不足时倍增，之后的周期复用
+    AnomalyArena *arena = &detector->anomalies;
+    if (arena->count >= arena->capacity) {
+        int new_capacity = arena->capacity > 0 ? arena->capacity * 2 : 64;
+        Anomaly *records = (Anomaly *)realloc(arena->records, sizeof(Anomaly) * new_capacity);
+        if (!records) {
             return -1;
         }
-        detector->anomalies = new_anomalies;
-        detector->anomaly_capacity = new_capacity;
+        arena->records = records;
+        arena->capacity = new_capacity;
     }
 
     // 添加异常
-    Anomaly *anomaly = &detector->anomalies[detector->anomaly_count++];
-    anomaly->type = type;
+    Anomaly *anomaly = &arena->records[arena->count++];
+    anomaly->metric_id = metric_id;
+    anomaly->type = (uint8_t)detector->metrics[metric_id].type;
+    anomaly->source = (uint8_t)source;
+    anomaly->severity = (int16_t)severity;
     anomaly->value = value;
     anomaly->threshold = threshold;
-    strncpy(anomaly->message, message, sizeof(anomaly->message) - 1);
-    anomaly->message[sizeof(anomaly->message) - 1] = '\0';
+    anomaly->center = center;
+    anomaly->spread = spread;
     anomaly->timestamp = time(NULL);
-    anomaly->severity = severity;
 
     return 0;
 }
 
+int format_anomaly(const Anomaly *anomaly, const char *description, char *buf, size_t size) {
+    if (!anomaly || !description || !buf || size == 0) {
+        return -1;
+    }
+
+    bool high = anomaly->value > anomaly_reference(anomaly);
+    const char *direction = high ? "异常偏高" : "异常偏低";
+    const char *op = high ? ">" : "<";
+    int len;
+    switch (anomaly->source) {
+        case DETECTOR_NSIGMA:
+            len = snprintf(buf, size, "%.128s %s: %.2f %s %.2f (均值: %.2f, 标准差: %.2f)",
+                           description, direction, anomaly->value, op, anomaly->threshold,
+                           anomaly->center, anomaly->spread);
+            break;
+        case DETECTOR_MAD:
+            len = snprintf(buf, size, "%.128s %s: %.2f %s %.2f (中位数: %.2f, MAD: %.2f)",
+                           description, direction, anomaly->value, op, anomaly->threshold,
+                           anomaly->center, anomaly->spread);
+            break;
+        case DETECTOR_EWMA:
+        case DETECTOR_HOLT_WINTERS:
+            len = snprintf(buf, size, "%.128s %s: %.2f %s %.2f (%s预测: %.2f, 残差标准差: %.2f)",
+                           description, direction, anomaly->value, op, anomaly->threshold,
+                           anomaly->source == DETECTOR_EWMA ? "EWMA" : "Holt-Winters",
+                           anomaly->center, anomaly->spread);
+            break;
+        case ANOMALY_SOURCE_MAHALANOBIS:
+            len = snprintf(buf, size, "%.128s 与同组指标的组合异常: 马氏距离 %.2f > %.2f (当前: %.2f, 窗口均值: %.2f)",
+                           description, anomaly->spread, anomaly->threshold, anomaly->value,
+                           anomaly->center);
+            break;
+        default:
+            len = snprintf(buf, size, "%.128s 超过阈值: %.2f > %.2f",
+                           description, anomaly->value, anomaly->threshold);
+            break;
+    }
+    if (len < 0) {
+        return -1;
+    }
+    return (size_t)len < size ? len : (int)size - 1;
+}
+
+// 为越过N-Sigma上限（high）或下限的指标生成异常记录
+static void report_nsigma(AnomalyDetector *detector, int i, bool high, double bound) {
+    Metric *metric = &detector->metrics[i];
+
+    // 计算严重程度 (1-5)
+    int severity = high ? (int)(((metric->value - bound) / bound) * 5) + 1
+                        : (int)(((bound - metric->value) / bound) * 5) + 1;
+    if (severity > 5) severity = 5;
+
+    add_anomaly(detector, i, DETECTOR_NSIGMA, metric->value, bound, metric->mean, metric->stddev,
+                severity);
+}
+
+// 指标使用的N-Sigma因子
+static inline double metric_sigma(const AnomalyDetector *detector, const Metric *metric) {
+    return metric->sigma_factor > 0 ? metric->sigma_factor : detector->sigma_factor;
+}
+
+// 单个指标的N-Sigma检测，与批量内核的计算相同，返回检测到的异常数量
+static int check_nsigma(AnomalyDetector *detector, int i) {
+    Metric *metric = &detector->metrics[i];
+
+    // 需要足够的历史数据（已退役的指标历史为空）
+    if (metric->history_size < STATS_MIN_SAMPLES || metric->detector != DETECTOR_NSIGMA) {
+        return 0;
+    }
+
+    // 计算上下限
+    double sigma = metric_sigma(detector, metric);
+    double upper_bound = metric->mean + sigma * metric->stddev;
+    double lower_bound = metric->mean - sigma * metric->stddev;
+
+    // 检测异常
+    if (metric->value > upper_bound) {
+        report_nsigma(detector, i, true, upper_bound);
+        return 1;
+    }
+    if (metric->value < lower_bound && lower_bound > 0) {
+        report_nsigma(detector, i, false, lower_bound);
+        return 1;
+    }
+    return 0;
+}
+
 int detect_anomalies_nsigma(AnomalyDetector *detector) {
     if (!detector) {
         return -1;
     }
 
+    // 统计列中不使用N-Sigma或历史数据不足3个的指标样本数为0，不会被置位；
+    // 批量内核一次算出全部上下限和异常位图，这里只为置位的指标生成消息
+    StatsColumns *cols = &detector->columns;
     int anomalies_detected = 0;
 
-    // 遍历所有指标
-    for (int i = 0; i < METRIC_COUNT; i++) {
-        Metric *metric = &detector->metrics[i];
-        
-        // 需要足够的历史数据
-        if (metric->history_size < 3) {
-            continue;
+    // 使用自己因子的指标不在批量内核中，逐个检测
+    if (detector->setting_count > 0) {
+        for (int i = 0; i < detector->metric_count; i++) {
+            if (detector->metrics[i].sigma_factor > 0) {
+                anomalies_detected += check_nsigma(detector, i);
+            }
         }
+    }
 
-        // 计算上下限
-        double upper_bound = metric->mean + detector->sigma_factor * metric->stddev;
-        double lower_bound = metric->mean - detector->sigma_factor * metric->stddev;
-
-        // 检测异常
-        if (metric->value > upper_bound) {
-            char message[256];
-            snprintf(message, sizeof(message), 
-                    "%s 异常偏高: %.2f > %.2f (均值: %.2f, 标准差: %.2f)",
-                    metric->description, metric->value, upper_bound, 
-                    metric->mean, metric->stddev);
-            
-            // 计算严重程度 (1-5)
-            int severity = (int)(((metric->value - upper_bound) / upper_bound) * 5) + 1;
-            if (severity > 5) severity = 5;
-            
-            add_anomaly(detector, metric->type, metric->value, upper_bound, 
-                       message, severity);
-            anomalies_detected++;
-        } 
-        else if (metric->value < lower_bound && lower_bound > 0) {
-            char message[256];
-            snprintf(message, sizeof(message), 
-                    "%s 异常偏低: %.2f < %.2f (均值: %.2f, 标准差: %.2f)",
-                    metric->description, metric->value, lower_bound, 
-                    metric->mean, metric->stddev);
-            
-            // 计算严重程度 (1-5)
-            int severity = (int)(((lower_bound - metric->value) / lower_bound) * 5) + 1;
-            if (severity > 5) severity = 5;
-            
-            add_anomaly(detector, metric->type, metric->value, lower_bound, 
-                       message, severity);
+    if (stats_columns_detect(cols, detector->sigma_factor) == 0) {
+        return anomalies_detected;
+    }
+
+    int words = (cols->count + 63) / 64;
+    for (int w = 0; w < words; w++) {
+        uint64_t bits = cols->high[w] | cols->low[w];
+        while (bits) {
+            int i = w * 64 + __builtin_ctzll(bits);
+            bool high = (cols->high[w] >> (i - w * 64)) & 1;
+            bits &= bits - 1;
+            if (i >= detector->metric_count) {
+                break;
+            }
+
+            report_nsigma(detector, i, high, high ? cols->upper[i] : cols->lower[i]);
             anomalies_detected++;
         }
     }
@@ -248,6 +817,137 @@ int detect_anomalies_nsigma(AnomalyDetector *detector) {
     return anomalies_detected;
 }
 
+// 单个指标的中位数/MAD检测，返回检测到的异常数量
+static int check_mad(AnomalyDetector *detector, int i) {
+    Metric *metric = &detector->metrics[i];
+    if (metric->detector != DETECTOR_MAD || !metric->order ||
+        order_stats_count(metric->order) < 3) {
+        return 0;
+    }
+
+    metric->median = order_stats_median(metric->order);
+    metric->mad = order_stats_mad(metric->order, metric->median);
+    double scale = MAD_SCALE * metric->mad;
+    if (scale == 0) {
+        // 超过一半的点相同，MAD无法度量离散程度
+        scale = MEAN_ABS_DEV_SCALE * order_stats_mean_abs_dev(metric->order, metric->median);
+        if (scale == 0) {
+            return 0;
+        }
+    }
+
+    // 计算上下限
+    double sigma = metric_sigma(detector, metric);
+    double upper_bound = metric->median + sigma * scale;
+    double lower_bound = metric->median - sigma * scale;
+
+    // 检测异常
+    if (metric->value > upper_bound) {
+        // 计算严重程度 (1-5)
+        int severity = upper_bound > 0
+                       ? (int)(((metric->value - upper_bound) / upper_bound) * 5) + 1 : 5;
+        if (severity > 5) severity = 5;
+
+        add_anomaly(detector, i, DETECTOR_MAD, metric->value, upper_bound,
+                    metric->median, metric->mad, severity);
+        return 1;
+    }
+    if (metric->value < lower_bound && lower_bound > 0) {
+        // 计算严重程度 (1-5)
+        int severity = (int)(((lower_bound - metric->value) / lower_bound) * 5) + 1;
+        if (severity > 5) severity = 5;
+
+        add_anomaly(detector, i, DETECTOR_MAD, metric->value, lower_bound,
+                    metric->median, metric->mad, severity);
+        return 1;
+    }
+    return 0;
+}
+
+int detect_anomalies_mad(AnomalyDetector *detector) {
+    if (!detector) {
+        return -1;
+    }
+
+    int anomalies_detected = 0;
+    for (int i = 0; i < detector->metric_count; i++) {
+        anomalies_detected += check_mad(detector, i);
+    }
+    return anomalies_detected;
+}
+
+// 单个指标的预测检测，返回检测到的异常数量
+static int check_forecast(AnomalyDetector *detector, int i) {
+    Metric *metric = &detector->metrics[i];
+    const Forecast *forecast = metric->forecast;
+    // 只检查预测可用的模型
+    if (!forecast || !forecast->ready || forecast->scale <= 0) {
+        return 0;
+    }
+
+    // 计算上下限
+    double sigma = metric_sigma(detector, metric);
+    double upper_bound = forecast->predicted + sigma * forecast->scale;
+    double lower_bound = forecast->predicted - sigma * forecast->scale;
+    int source = forecast->kind == FORECAST_EWMA ? DETECTOR_EWMA : DETECTOR_HOLT_WINTERS;
+
+    // 检测异常
+    if (metric->value > upper_bound) {
+        // 计算严重程度 (1-5)
+        int severity = upper_bound > 0
+                       ? (int)(((metric->value - upper_bound) / upper_bound) * 5) + 1 : 5;
+        if (severity > 5) severity = 5;
+
+        add_anomaly(detector, i, source, metric->value, upper_bound,
+                    forecast->predicted, forecast->scale, severity);
+        return 1;
+    }
+    if (metric->value < lower_bound && lower_bound > 0) {
+        // 计算严重程度 (1-5)
+        int severity = (int)(((lower_bound - metric->value) / lower_bound) * 5) + 1;
+        if (severity > 5) severity = 5;
+
+        add_anomaly(detector, i, source, metric->value, lower_bound,
+                    forecast->predicted, forecast->scale, severity);
+        return 1;
+    }
+    return 0;
+}
+
+int detect_anomalies_forecast(AnomalyDetector *detector) {
+    if (!detector) {
+        return -1;
+    }
+
+    int anomalies_detected = 0;
+    for (int i = 0; i < detector->metric_count; i++) {
+        anomalies_detected += check_forecast(detector, i);
+    }
+    return anomalies_detected;
+}
+
+// 单个指标的阈值检测，返回检测到的异常数量
+static int check_threshold(AnomalyDetector *detector, int i) {
+    Metric *metric = &detector->metrics[i];
+
+    // 跳过已退役和没有设置阈值的指标
+    if (!metric->active || metric->threshold <= 0) {
+        return 0;
+    }
+
+    // 检测异常
+    if (metric->value > metric->threshold) {
+        // 计算严重程度 (1-5)
+        int severity = (int)(((metric->value - metric->threshold) / metric->threshold) * 5) + 1;
+        if (severity > 5) severity = 5;
+        
+        add_anomaly(detector, i, ANOMALY_SOURCE_THRESHOLD, metric->value, metric->threshold,
+                    0, 0, severity);
+        return 1;
+    }
+    return 0;
+}
+
 int detect_anomalies_threshold(AnomalyDetector *detector) {
     if (!detector) {
         return -1;
@@ -256,83 +956,169 @@ int detect_anomalies_threshold(AnomalyDetector *detector) {
     int anomalies_detected = 0;
 
     // 遍历所有指标
-    for (int i = 0; i < METRIC_COUNT; i++) {
-        Metric *metric = &detector->metrics[i];
-        
-        // 跳过没有设置阈值的指标
-        if (metric->threshold <= 0) {
-            continue;
-        }
+    for (int i = 0; i < detector->metric_count; i++) {
+        anomalies_detected += check_threshold(detector, i);
+    }
 
-        // 检测异常
-        if (metric->value > metric->threshold) {
-            char message[256];
-            snprintf(message, sizeof(message), 
-                    "%s 超过阈值: %.2f > %.2f",
-                    metric->description, metric->value, metric->threshold);
-            
-            // 计算严重程度 (1-5)
-            int severity = (int)(((metric->value - metric->threshold) / metric->threshold) * 5) + 1;
-            if (severity > 5) severity = 5;
-            
-            add_anomaly(detector, metric->type, metric->value, metric->threshold, 
-                       message, severity);
-            anomalies_detected++;
+    return anomalies_detected;
+}
+
+// 检查成员是否仍是解析时的指标，有新注册的指标或成员退役、重新注册时重新解析；
+// 成员变化时清空模型，返回0表示组可用
+static int refresh_group(AnomalyDetector *detector, CorrelationGroup *group) {
+    bool stale = group->resolved != detector->incarnations;
+    for (int i = 0; i < group->member_count && !stale; i++) {
+        const Metric *metric = &detector->metrics[group->members[i]];
+        stale = !metric->active || metric->incarnation != group->incarnations[i];
+    }
+    if (!stale) {
+        return 0;
+    }
+
+    int members[CORRELATION_MAX_MEMBERS];
+    unsigned long incarnations[CORRELATION_MAX_MEMBERS];
+    int count = 0;
+    int matched = 0;
+    for (int i = 0; i < detector->metric_count; i++) {
+        const Metric *metric = &detector->metrics[i];
+        if (metric->active && metric_in_list(group->spec, metric)) {
+            if (count < CORRELATION_MAX_MEMBERS) {
+                members[count] = i;
+                incarnations[count] = metric->incarnation;
+                count++;
+            }
+            matched++;
         }
     }
+    if (matched > count && !group->truncated) {
+        // 只提示一次，之后注册的指标同样不加入
+        fprintf(stderr, "警告: 相关检测组 %s 匹配%d个指标，超过上限%d个，只使用下标最小的%d个\n",
+                group->spec, matched, CORRELATION_MAX_MEMBERS, CORRELATION_MAX_MEMBERS);
+        group->truncated = true;
+    }
+    group->resolved = detector->incarnations;
+    if (count == group->member_count && count > 0 &&
+        memcmp(members, group->members, sizeof(int) * count) == 0 &&
+        memcmp(incarnations, group->incarnations, sizeof(unsigned long) * count) == 0) {
+        return 0;
+    }
 
-    return anomalies_detected;
+    // 成员变化，按新的维数重建模型
+    correlation_free(&group->model);
+    free(group->members);
+    free(group->incarnations);
+    free(group->values);
+    free(group->contrib);
+    group->members = NULL;
+    group->incarnations = NULL;
+    group->values = NULL;
+    group->contrib = NULL;
+    group->member_count = 0;
+    group->last_timestamp_ns = 0;
+    group->limit_sigma = 0;
+    if (count < 2) {
+        return 0;
+    }
+
+    group->members = (int *)malloc(sizeof(int) * count);
+    group->incarnations = (unsigned long *)malloc(sizeof(unsigned long) * count);
+    group->values = (double *)malloc(sizeof(double) * count);
+    group->contrib = (double *)malloc(sizeof(double) * count);
+    if (!group->members || !group->incarnations || !group->values || !group->contrib ||
+        correlation_init(&group->model, count, detector->window_size) != 0) {
+        // 下次有指标注册时重试
+        return -1;
+    }
+    memcpy(group->members, members, sizeof(int) * count);
+    memcpy(group->incarnations, incarnations, sizeof(unsigned long) * count);
+    group->member_count = count;
+    return 0;
 }
 
-void print_anomalies(AnomalyDetector *detector) {
-    if (!detector || !detector->anomalies) {
-        return;
+// 一个指标组的马氏距离检测，返回检测到的异常数量
+static int check_group(AnomalyDetector *detector, CorrelationGroup *group) {
+    if (refresh_group(detector, group) != 0 || group->member_count < 2) {
+        return 0;
     }
 
-    if (detector->anomaly_count == 0) {
-        printf("没有检测到异常\n");
-        return;
+    // 只使用全部成员在同一周期写入的新样本
+    int k = group->member_count;
+    uint64_t timestamp_ns = detector->metrics[group->members[0]].timestamp_ns;
+    if (timestamp_ns <= group->last_timestamp_ns) {
+        return 0;
     }
+    for (int i = 0; i < k; i++) {
+        const Metric *metric = &detector->metrics[group->members[i]];
+        if (metric->timestamp_ns != timestamp_ns) {
+            return 0;
+        }
+        group->values[i] = metric->value;
+    }
+    group->last_timestamp_ns = timestamp_ns;
 
-    printf("检测到 %d 个异常:\n", detector->anomaly_count);
-    printf("---------------------------------------------------\n");
-    
-    for (int i = 0; i < detector->anomaly_count; i++) {
-        Anomaly *anomaly = &detector->anomalies[i];
-        char time_str[64];
-        struct tm *tm_info = localtime(&anomaly->timestamp);
-        strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", tm_info);
-        
-        printf("异常 #%d:\n", i + 1);
-        printf("  时间: %s\n", time_str);
-        printf("  指标: %s\n", detector->metrics[anomaly->type].name);
-        printf("  消息: %s\n", anomaly->message);
-        printf("  严重程度: %d/5\n", anomaly->severity);
-        printf("---------------------------------------------------\n");
+    if (group->limit_sigma != detector->sigma_factor) {
+        group->limit = correlation_limit(k, detector->sigma_factor);
+        group->limit_sigma = detector->sigma_factor;
     }
+
+    // 先以样本到达前的窗口评分，再并入窗口
+    double d2 = correlation_score(&group->model, group->values, group->contrib);
+    double distance = d2 >= 0 ? sqrt(d2) : 0;
+    bool anomalous = d2 >= 0 && group->limit > 0 && distance > group->limit;
+    int top = 0;
+    double mean = 0;
+    if (anomalous) {
+        // 异常记在对距离贡献最大的成员上
+        for (int i = 1; i < k; i++) {
+            if (group->contrib[i] > group->contrib[top]) {
+                top = i;
+            }
+        }
+        mean = group->model.mean[top];
+    }
+    correlation_update(&group->model, group->values);
+    if (!anomalous) {
+        return 0;
+    }
+
+    // 计算严重程度 (1-5)
+    int severity = (int)(((distance - group->limit) / group->limit) * 5) + 1;
+    if (severity > 5) severity = 5;
+
+    add_anomaly(detector, group->members[top], ANOMALY_SOURCE_MAHALANOBIS, group->values[top],
+                group->limit, mean, distance, severity);
+    return 1;
 }
 
-int log_anomalies(AnomalyDetector *detector, const char *filename) {
-    if (!detector || !detector->anomalies || !filename) {
+int detect_anomalies_correlation(AnomalyDetector *detector) {
+    if (!detector) {
         return -1;
     }
 
-    FILE *file = fopen(filename, "a");
-    if (!file) {
-        return -1;
+    int anomalies_detected = 0;
+    for (int i = 0; i < detector->group_count; i++) {
+        anomalies_detected += check_group(detector, &detector->groups[i]);
     }
+    return anomalies_detected;
+}
 
-    for (int i = 0; i < detector->anomaly_count; i++) {
-        Anomaly *anomaly = &detector->anomalies[i];
-        char time_str[64];
-        struct tm *tm_info = localtime(&anomaly->timestamp);
-        strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", tm_info);
-        
-        fprintf(file, "[%s] 严重程度=%d, 指标=%s, 值=%.2f, 阈值=%.2f, 消息=%s\n",
-                time_str, anomaly->severity, detector->metrics[anomaly->type].name,
-                anomaly->value, anomaly->threshold, anomaly->message);
+int detect_metric_anomalies(AnomalyDetector *detector, int metric_id) {
+    if (!detector || metric_id < 0 || metric_id >= detector->metric_count) {
+        return -1;
     }
 
-    fclose(file);
-    return 0;
+    int anomalies_detected;
+    switch (detector->metrics[metric_id].detector) {
+    case DETECTOR_MAD:
+        anomalies_detected = check_mad(detector, metric_id);
+        break;
+    case DETECTOR_EWMA:
+    case DETECTOR_HOLT_WINTERS:
+        anomalies_detected = check_forecast(detector, metric_id);
+        break;
+    default:
+        anomalies_detected = check_nsigma(detector, metric_id);
+        break;
+    }
+    return anomalies_detected + check_threshold(detector, metric_id);
 }
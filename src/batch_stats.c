@@ -0,0 +1,247 @@
+#include "../include/batch_stats.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define STATS_X86 1
+#endif
+
+/* 内核：处理[begin, end)，begin为64的倍数，返回被置位的序列数 */
+typedef int (*StatsKernel)(StatsColumns *cols, int begin, int end, double k);
+
+static int kernel_scalar(StatsColumns *cols, int begin, int end, double k) {
+    int flagged = 0;
+    for (int base = begin; base < end; base += 64) {
+        uint64_t high = 0, low = 0;
+        int limit = end - base < 64 ? end - base : 64;
+        for (int j = 0; j < limit; j++) {
+            int i = base + j;
+            double n = cols->n[i] > 1.0 ? cols->n[i] : 1.0;
+            double sd = sqrt(cols->m2[i] / n);
+            double upper = cols->mean[i] + k * sd;
+            double lower = cols->mean[i] - k * sd;
+            cols->stddev[i] = sd;
+            cols->upper[i] = upper;
+            cols->lower[i] = lower;
+            if (cols->n[i] >= STATS_MIN_SAMPLES) {
+                if (cols->value[i] > upper) {
+                    high |= 1ULL << j;
+                } else if (cols->value[i] < lower && lower > 0) {
+                    low |= 1ULL << j;
+                }
+            }
+        }
+        cols->high[base / 64] = high;
+        cols->low[base / 64] = low;
+        flagged += __builtin_popcountll(high) + __builtin_popcountll(low);
+    }
+    return flagged;
+}
+
+#ifdef STATS_X86
+// 容量为8的倍数，尾部填充的样本数为0，向量内核可以整组处理
+__attribute__((target("sse2")))
+static int kernel_sse2(StatsColumns *cols, int begin, int end, double k) {
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d min_samples = _mm_set1_pd(STATS_MIN_SAMPLES);
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d kv = _mm_set1_pd(k);
+    int flagged = 0;
+
+    for (int base = begin; base < end; base += 64) {
+        uint64_t high = 0, low = 0;
+        int limit = end - base < 64 ? end - base : 64;
+        for (int j = 0; j < limit; j += 2) {
+            int i = base + j;
+            __m128d n = _mm_loadu_pd(cols->n + i);
+            __m128d mean = _mm_loadu_pd(cols->mean + i);
+            __m128d value = _mm_loadu_pd(cols->value + i);
+            __m128d sd = _mm_sqrt_pd(_mm_div_pd(_mm_loadu_pd(cols->m2 + i), _mm_max_pd(n, one)));
+            __m128d spread = _mm_mul_pd(kv, sd);
+            __m128d upper = _mm_add_pd(mean, spread);
+            __m128d lower = _mm_sub_pd(mean, spread);
+            _mm_storeu_pd(cols->stddev + i, sd);
+            _mm_storeu_pd(cols->upper + i, upper);
+            _mm_storeu_pd(cols->lower + i, lower);
+
+            __m128d eligible = _mm_cmpge_pd(n, min_samples);
+            __m128d hi = _mm_and_pd(eligible, _mm_cmpgt_pd(value, upper));
+            __m128d lo = _mm_and_pd(_mm_and_pd(eligible, _mm_cmplt_pd(value, lower)),
+                                    _mm_cmpgt_pd(lower, zero));
+            high |= (uint64_t)_mm_movemask_pd(hi) << j;
+            low |= (uint64_t)_mm_movemask_pd(lo) << j;
+        }
+        // 与标量实现一致：偏高优先
+        low &= ~high;
+        cols->high[base / 64] = high;
+        cols->low[base / 64] = low;
+        flagged += __builtin_popcountll(high) + __builtin_popcountll(low);
+    }
+    return flagged;
+}
+
+__attribute__((target("avx2")))
+static int kernel_avx2(StatsColumns *cols, int begin, int end, double k) {
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d min_samples = _mm256_set1_pd(STATS_MIN_SAMPLES);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d kv = _mm256_set1_pd(k);
+    int flagged = 0;
+
+    for (int base = begin; base < end; base += 64) {
+        uint64_t high = 0, low = 0;
+        int limit = end - base < 64 ? end - base : 64;
+        for (int j = 0; j < limit; j += 4) {
+            int i = base + j;
+            __m256d n = _mm256_loadu_pd(cols->n + i);
+            __m256d mean = _mm256_loadu_pd(cols->mean + i);
+            __m256d value = _mm256_loadu_pd(cols->value + i);
+            __m256d sd = _mm256_sqrt_pd(_mm256_div_pd(_mm256_loadu_pd(cols->m2 + i),
+                                                      _mm256_max_pd(n, one)));
+            // 不用FMA，与标量实现的舍入一致
+            __m256d spread = _mm256_mul_pd(kv, sd);
+            __m256d upper = _mm256_add_pd(mean, spread);
+            __m256d lower = _mm256_sub_pd(mean, spread);
+            _mm256_storeu_pd(cols->stddev + i, sd);
+            _mm256_storeu_pd(cols->upper + i, upper);
+            _mm256_storeu_pd(cols->lower + i, lower);
+
+            __m256d eligible = _mm256_cmp_pd(n, min_samples, _CMP_GE_OQ);
+            __m256d hi = _mm256_and_pd(eligible, _mm256_cmp_pd(value, upper, _CMP_GT_OQ));
+            __m256d lo = _mm256_and_pd(_mm256_and_pd(eligible, _mm256_cmp_pd(value, lower, _CMP_LT_OQ)),
+                                       _mm256_cmp_pd(lower, zero, _CMP_GT_OQ));
+            high |= (uint64_t)_mm256_movemask_pd(hi) << j;
+            low |= (uint64_t)_mm256_movemask_pd(lo) << j;
+        }
+        low &= ~high;
+        cols->high[base / 64] = high;
+        cols->low[base / 64] = low;
+        flagged += __builtin_popcountll(high) + __builtin_popcountll(low);
+    }
+    return flagged;
+}
+#endif
+
+static const struct {
+    const char *name;
+    StatsKernel kernel;
+} kernels[] = {
+#ifdef STATS_X86
+    { "avx2", kernel_avx2 },
+    { "sse2", kernel_sse2 },
+#endif
+    { "scalar", kernel_scalar },
+};
+
+static StatsKernel active_kernel = NULL;
+static const char *active_name = "scalar";
+
+static int kernel_supported(const char *name) {
+#ifdef STATS_X86
+    __builtin_cpu_init();
+    if (strcmp(name, "avx2") == 0) {
+        return __builtin_cpu_supports("avx2");
+    }
+    if (strcmp(name, "sse2") == 0) {
+        return __builtin_cpu_supports("sse2");
+    }
+#endif
+    return strcmp(name, "scalar") == 0;
+}
+
+int stats_kernel_select(const char *name) {
+    for (size_t i = 0; i < sizeof(kernels) / sizeof(kernels[0]); i++) {
+        // 自动选择时按表中顺序取第一个受支持的内核
+        if ((name ? strcmp(name, kernels[i].name) == 0 : 1) && kernel_supported(kernels[i].name)) {
+            active_kernel = kernels[i].kernel;
+            active_name = kernels[i].name;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const char *stats_kernel_name(void) {
+    if (!active_kernel) {
+        stats_kernel_select(NULL);
+    }
+    return active_name;
+}
+
+int stats_columns_init(StatsColumns *cols) {
+    if (!cols) {
+        return -1;
+    }
+    memset(cols, 0, sizeof(*cols));
+    if (!active_kernel) {
+        stats_kernel_select(NULL);
+    }
+    return 0;
+}
+
+void stats_columns_free(StatsColumns *cols) {
+    if (!cols) {
+        return;
+    }
+    // 全部字段共用一块内存，value位于起始位置
+    free(cols->value);
+    memset(cols, 0, sizeof(*cols));
+}
+
+int stats_columns_reserve(StatsColumns *cols, int count) {
+    if (count <= cols->capacity) {
+        if (count > cols->count) {
+            cols->count = count;
+        }
+        return 0;
+    }
+
+    int capacity = cols->capacity > 0 ? cols->capacity : 64;
+    while (capacity < count) {
+        capacity *= 2;
+    }
+
+    // 7个double列加2个位图，按64字节对齐分段
+    size_t column_bytes = sizeof(double) * (size_t)capacity;
+    size_t mask_bytes = sizeof(uint64_t) * (size_t)((capacity + 63) / 64);
+    char *block = (char *)aligned_alloc(64, column_bytes * 7 + ((mask_bytes * 2 + 63) & ~(size_t)63));
+    if (!block) {
+        return -1;
+    }
+    memset(block, 0, column_bytes * 7 + mask_bytes * 2);
+
+    double **fields[7] = {
+        &cols->value, &cols->mean, &cols->m2, &cols->n,
+        &cols->stddev, &cols->upper, &cols->lower
+    };
+    void *old_block = cols->value;
+    for (int f = 0; f < 7; f++) {
+        double *array = (double *)(block + column_bytes * f);
+        if (cols->count > 0) {
+            memcpy(array, *fields[f], sizeof(double) * (size_t)cols->count);
+        }
+        *fields[f] = array;
+    }
+    cols->high = (uint64_t *)(block + column_bytes * 7);
+    cols->low = cols->high + (capacity + 63) / 64;
+
+    free(old_block);
+    cols->capacity = capacity;
+    cols->count = count;
+    return 0;
+}
+
+int stats_columns_detect(StatsColumns *cols, double sigma_factor) {
+    if (!cols || cols->count == 0) {
+        return 0;
+    }
+    if (!active_kernel) {
+        stats_kernel_select(NULL);
+    }
+
+    // 向量内核按4个一组处理，尾部的填充序列样本数为0，不会被置位
+    int end = (cols->count + 3) & ~3;
+    return active_kernel(cols, 0, end, sigma_factor);
+}
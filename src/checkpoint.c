@@ -0,0 +1,105 @@
+#include "../include/checkpoint.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+int save_forecast_checkpoint(const AnomalyDetector *detector, const char *path, uint64_t saved_ns) {
+    if (!detector || !path) {
+        return -1;
+    }
+
+    char tmp_path[300];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE *file = fopen(tmp_path, "wb");
+    if (!file) {
+        return -1;
+    }
+
+    CheckpointHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    header.saved_ns = saved_ns;
+    // 记录数在写完后回填
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+
+    for (int i = 0; ok && i < detector->metric_count; i++) {
+        const Metric *metric = &detector->metrics[i];
+        if (!metric->active || !metric->forecast) {
+            continue;
+        }
+
+        CheckpointRecord record;
+        memset(&record, 0, sizeof(record));
+        strcpy(record.name, metric->name);
+        record.bytes = (uint32_t)forecast_size(metric->forecast);
+        ok = fwrite(&record, sizeof(record), 1, file) == 1 &&
+             fwrite(metric->forecast, record.bytes, 1, file) == 1;
+        header.record_count++;
+    }
+
+    ok = ok && fseek(file, 0, SEEK_SET) == 0 &&
+         fwrite(&header, sizeof(header), 1, file) == 1 &&
+         fflush(file) == 0 && fsync(fileno(file)) == 0;
+    if (fclose(file) != 0) {
+        ok = false;
+    }
+    if (!ok || rename(tmp_path, path) != 0) {
+        unlink(tmp_path);
+        return -1;
+    }
+    return (int)header.record_count;
+}
+
+int load_forecast_checkpoint(AnomalyDetector *detector, const char *path) {
+    if (!detector || !path) {
+        return 0;
+    }
+
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return 0;
+    }
+
+    CheckpointHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != CHECKPOINT_VERSION) {
+        fclose(file);
+        return 0;
+    }
+
+    Forecast *saved = NULL;
+    uint32_t saved_capacity = 0;
+    int restored = 0;
+    for (uint32_t r = 0; r < header.record_count; r++) {
+        CheckpointRecord record;
+        if (fread(&record, sizeof(record), 1, file) != 1 || record.bytes < sizeof(Forecast)) {
+            break;
+        }
+        if (record.bytes > saved_capacity) {
+            Forecast *new_saved = (Forecast *)realloc(saved, record.bytes);
+            if (!new_saved) {
+                break;
+            }
+            saved = new_saved;
+            saved_capacity = record.bytes;
+        }
+        if (fread(saved, record.bytes, 1, file) != 1 ||
+            forecast_size(saved) != record.bytes) {
+            break;
+        }
+
+        record.name[sizeof(record.name) - 1] = '\0';
+        int id = register_metric_name(detector, record.name);
+        if (id >= 0 && detector->metrics[id].forecast &&
+            forecast_restore(detector->metrics[id].forecast, saved) == 0) {
+            restored++;
+        }
+    }
+
+    free(saved);
+    fclose(file);
+    return restored;
+}
@@ -0,0 +1,270 @@
+#include "../include/correlation.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+int correlation_init(CorrelationModel *model, int dims, int capacity) {
+    if (!model || dims < 1 || capacity < 2) {
+        return -1;
+    }
+
+    memset(model, 0, sizeof(*model));
+    model->dims = dims;
+    model->capacity = capacity;
+    size_t k = (size_t)dims;
+    model->samples = (double *)malloc(sizeof(double) * (size_t)capacity * k);
+    model->mean = (double *)calloc(k, sizeof(double));
+    model->scatter = (double *)calloc(k * k, sizeof(double));
+    model->inverse = (double *)calloc(k * k, sizeof(double));
+    model->ridge = (double *)calloc(k, sizeof(double));
+    model->work = (double *)malloc(sizeof(double) * (k * k + 2 * k));
+    if (!model->samples || !model->mean || !model->scatter || !model->inverse ||
+        !model->ridge || !model->work) {
+        correlation_free(model);
+        return -1;
+    }
+    return 0;
+}
+
+void correlation_free(CorrelationModel *model) {
+    if (!model) {
+        return;
+    }
+    free(model->samples);
+    free(model->mean);
+    free(model->scatter);
+    free(model->inverse);
+    free(model->ridge);
+    free(model->work);
+    memset(model, 0, sizeof(*model));
+}
+
+void correlation_reset(CorrelationModel *model) {
+    size_t k = (size_t)model->dims;
+    model->count = 0;
+    model->head = 0;
+    model->inverse_valid = false;
+    model->updates = 0;
+    memset(model->mean, 0, sizeof(double) * k);
+    memset(model->scatter, 0, sizeof(double) * k * k);
+}
+
+// 窗口中第i个样本向量，0为最旧的样本
+static inline double *sample_at(const CorrelationModel *model, int i) {
+    int idx = model->head + i;
+    if (idx >= model->capacity) {
+        idx -= model->capacity;
+    }
+    return model->samples + (size_t)idx * model->dims;
+}
+
+// 由窗口内的样本重新计算均值、S和逆矩阵（两遍算法，Cholesky分解求逆），O(n·k² + k³)
+void correlation_rebuild(CorrelationModel *model, bool update_ridge) {
+    int k = model->dims;
+    double *mean = model->mean;
+    double *s = model->scatter;
+    double *l = model->work;            // Cholesky因子（下三角）
+    double *y = model->work + k * k;    // 解三角方程组用的向量
+
+    memset(mean, 0, sizeof(double) * k);
+    memset(s, 0, sizeof(double) * k * k);
+    for (int n = 0; n < model->count; n++) {
+        const double *x = sample_at(model, n);
+        for (int i = 0; i < k; i++) {
+            mean[i] += x[i];
+        }
+    }
+    for (int i = 0; i < k; i++) {
+        mean[i] /= model->count;
+    }
+    for (int n = 0; n < model->count; n++) {
+        const double *x = sample_at(model, n);
+        for (int i = 0; i < k; i++) {
+            double di = x[i] - mean[i];
+            for (int j = 0; j <= i; j++) {
+                s[i * k + j] += di * (x[j] - mean[j]);
+            }
+        }
+    }
+    for (int i = 0; i < k; i++) {
+        for (int j = 0; j < i; j++) {
+            s[j * k + i] = s[i * k + j];
+        }
+    }
+
+    // 正则项随窗口内的方差缩放，成员完全共线或恒定时矩阵仍然正定
+    for (int i = 0; i < k && update_ridge; i++) {
+        model->ridge[i] = CORRELATION_RIDGE * s[i * k + i] +
+                          CORRELATION_MIN_VARIANCE * (model->count - 1);
+    }
+
+    // S + R = L·Lᵀ
+    model->inverse_valid = false;
+    model->updates = 0;
+    for (int i = 0; i < k; i++) {
+        for (int j = 0; j <= i; j++) {
+            double sum = s[i * k + j] + (i == j ? model->ridge[i] : 0.0);
+            for (int p = 0; p < j; p++) {
+                sum -= l[i * k + p] * l[j * k + p];
+            }
+            if (i == j) {
+                if (!(sum > 0)) {
+                    return;
+                }
+                l[i * k + i] = sqrt(sum);
+            } else {
+                l[i * k + j] = sum / l[j * k + j];
+            }
+        }
+    }
+
+    // 逐列解L·Lᵀ·z = e_c，得到逆矩阵的第c列
+    for (int c = 0; c < k; c++) {
+        for (int i = 0; i < k; i++) {
+            double sum = i == c ? 1.0 : 0.0;
+            for (int p = 0; p < i; p++) {
+                sum -= l[i * k + p] * y[p];
+            }
+            y[i] = sum / l[i * k + i];
+        }
+        for (int i = k - 1; i >= 0; i--) {
+            double sum = y[i];
+            for (int p = i + 1; p < k; p++) {
+                sum -= l[p * k + i] * model->inverse[p * k + c];
+            }
+            model->inverse[i * k + c] = sum / l[i * k + i];
+        }
+    }
+    model->inverse_valid = true;
+}
+
+// S加上c·d·dᵀ，逆矩阵按Sherman-Morrison公式同步更新：
+// (A + c·d·dᵀ)⁻¹ = A⁻¹ - c·(A⁻¹d)(A⁻¹d)ᵀ / (1 + c·dᵀA⁻¹d)
+static void rank_one_update(CorrelationModel *model, const double *d, double c) {
+    int k = model->dims;
+    for (int i = 0; i < k; i++) {
+        for (int j = 0; j < k; j++) {
+            model->scatter[i * k + j] += c * d[i] * d[j];
+        }
+    }
+    if (!model->inverse_valid) {
+        return;
+    }
+
+    double *u = model->work + k * k + k;
+    double q = 0.0;
+    for (int i = 0; i < k; i++) {
+        double sum = 0.0;
+        for (int j = 0; j < k; j++) {
+            sum += model->inverse[i * k + j] * d[j];
+        }
+        u[i] = sum;
+        q += d[i] * sum;
+    }
+
+    // 移出样本（c < 0）使矩阵接近奇异时公式失去精度，改为重新求逆
+    double denom = 1.0 + c * q;
+    if (!(denom > CORRELATION_MIN_PIVOT)) {
+        model->inverse_valid = false;
+        return;
+    }
+    double f = c / denom;
+    for (int i = 0; i < k; i++) {
+        for (int j = 0; j < k; j++) {
+            model->inverse[i * k + j] -= f * u[i] * u[j];
+        }
+    }
+}
+
+double correlation_score(const CorrelationModel *model, const double *x, double *contrib) {
+    if (!model || !x || !correlation_ready(model)) {
+        return -1;
+    }
+
+    int k = model->dims;
+    double scale = model->count - 1;
+    double d2 = 0.0;
+    for (int i = 0; i < k; i++) {
+        double sum = 0.0;
+        for (int j = 0; j < k; j++) {
+            sum += model->inverse[i * k + j] * (x[j] - model->mean[j]);
+        }
+        double term = scale * (x[i] - model->mean[i]) * sum;
+        if (contrib) {
+            contrib[i] = term;
+        }
+        d2 += term;
+    }
+    return d2 > 0 ? d2 : 0.0;
+}
+
+void correlation_update(CorrelationModel *model, const double *x) {
+    if (!model || !x) {
+        return;
+    }
+
+    int k = model->dims;
+    for (int i = 0; i < k; i++) {
+        if (!isfinite(x[i])) {
+            return;
+        }
+    }
+    double *d = model->work + k * k;
+
+    // 窗口已满时移出最旧的样本：μ' = μ - d/(n-1)，S' = S - n/(n-1)·d·dᵀ
+    if (model->count == model->capacity) {
+        const double *old = sample_at(model, 0);
+        double n = model->count;
+        for (int i = 0; i < k; i++) {
+            d[i] = old[i] - model->mean[i];
+            model->mean[i] -= d[i] / (n - 1);
+        }
+        rank_one_update(model, d, -n / (n - 1));
+        model->head = model->head + 1 == model->capacity ? 0 : model->head + 1;
+        model->count--;
+    }
+
+    // 加入新样本：μ' = μ + d/(n+1)，S' = S + n/(n+1)·d·dᵀ
+    double n = model->count;
+    memcpy(sample_at(model, model->count), x, sizeof(double) * k);
+    for (int i = 0; i < k; i++) {
+        d[i] = x[i] - model->mean[i];
+        model->mean[i] += d[i] / (n + 1);
+    }
+    rank_one_update(model, d, n / (n + 1));
+    model->count++;
+    model->updates++;
+
+    // 首次可用、逆矩阵失效或滑过一个窗口时重新计算，消除增量更新的累积误差
+    if (model->count >= 2 * k + 1 &&
+        (!model->inverse_valid || model->updates >= model->capacity)) {
+        correlation_rebuild(model, true);
+    }
+}
+
+double correlation_limit(int dims, double sigma_factor) {
+    if (dims < 1 || sigma_factor <= 0) {
+        return 0;
+    }
+
+    // 一维sigma倍标准差以外的双侧概率，作为卡方分布的上侧概率
+    double tail = erfc(sigma_factor / M_SQRT2);
+
+    // 二分求标准正态分布上侧概率为tail的分位数z
+    double lo = -10.0, hi = 40.0;
+    for (int i = 0; i < 100; i++) {
+        double mid = 0.5 * (lo + hi);
+        if (0.5 * erfc(mid / M_SQRT2) > tail) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    double z = 0.5 * (lo + hi);
+
+    // Wilson-Hilferty：χ²ₖ的分位数 ≈ k·(1 - 2/(9k) + z·√(2/(9k)))³
+    double v = 2.0 / (9.0 * dims);
+    double t = 1.0 - v + z * sqrt(v);
+    double q = dims * t * t * t;
+    return q > 0 ? sqrt(q) : 0.0;
+}
@@ -0,0 +1,56 @@
+#include "../include/counter_rate.h"
+#include <string.h>
+
+#define COUNTER_WRAP_32 (1ULL << 32)
+
+void counter_set_reset(CounterSet *set) {
+    if (set) {
+        set->timestamp_ns = 0;
+    }
+}
+
+// 计算一个计数器的增量，计数器被重置时返回false
+static bool counter_diff(unsigned long long prev, unsigned long long cur, bool width32,
+                         unsigned long long *diff) {
+    if (cur >= prev) {
+        *diff = cur - prev;
+        return true;
+    }
+
+    // 32位计数器回绕：上一次接近2^32，当前从0附近重新计数。
+    // 宽度未知的计数器变小时无法区分回绕和重置，按重置处理
+    if (width32 && prev < COUNTER_WRAP_32) {
+        unsigned long long wrapped = COUNTER_WRAP_32 - prev + cur;
+        if (wrapped < COUNTER_WRAP_32 / 2) {
+            *diff = wrapped;
+            return true;
+        }
+    }
+    return false;
+}
+
+int counter_set_update(CounterSet *set, const unsigned long long *values, int count,
+                       unsigned int width32, uint64_t timestamp_ns, CounterDelta *delta) {
+    if (!set || !values || !delta || count <= 0 || count > COUNTER_SET_MAX || timestamp_ns == 0) {
+        return -1;
+    }
+
+    // 时间未前进（同一快照重复更新）时增量没有意义，保留原来的基准
+    if (counter_set_primed(set) && timestamp_ns <= set->timestamp_ns) {
+        return 1;
+    }
+
+    int ret = counter_set_primed(set) ? 0 : 1;
+    for (int i = 0; i < count && ret == 0; i++) {
+        if (!counter_diff(set->prev[i], values[i], (width32 >> i) & 1u, &delta->delta[i])) {
+            ret = 1;
+        }
+    }
+    if (ret == 0) {
+        delta->seconds = (double)(timestamp_ns - set->timestamp_ns) / 1e9;
+    }
+
+    memcpy(set->prev, values, sizeof(values[0]) * count);
+    set->timestamp_ns = timestamp_ns;
+    return ret;
+}
@@ -0,0 +1,588 @@
+#define _GNU_SOURCE
+#include "../include/exposition.h"
+#include "../include/config.h"
+#include "../include/latency.h"
+#include "../include/scheduler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+// 保证缓冲区还能容纳extra字节，按倍数扩容
+static int buffer_reserve(ExpositionBuffer *buf, size_t extra) {
+    if (buf->len + extra <= buf->capacity) {
+        return 0;
+    }
+    size_t new_capacity = buf->capacity > 0 ? buf->capacity : 16384;
+    while (new_capacity < buf->len + extra) {
+        new_capacity *= 2;
+    }
+    char *new_data = (char *)realloc(buf->data, new_capacity);
+    if (!new_data) {
+        return -1;
+    }
+    buf->data = new_data;
+    buf->capacity = new_capacity;
+    return 0;
+}
+
+static int buffer_printf(ExpositionBuffer *buf, const char *fmt, ...) {
+    for (;;) {
+        va_list ap;
+        va_start(ap, fmt);
+        size_t room = buf->capacity - buf->len;
+        int len = vsnprintf(buf->data ? buf->data + buf->len : NULL, room, fmt, ap);
+        va_end(ap);
+        if (len < 0) {
+            return -1;
+        }
+        if ((size_t)len < room) {
+            buf->len += (size_t)len;
+            return 0;
+        }
+        if (buffer_reserve(buf, (size_t)len + 1) != 0) {
+            return -1;
+        }
+    }
+}
+
+// 按Prometheus文本格式写浮点数
+static const char *format_value(char *out, size_t size, double value) {
+    if (isnan(value)) {
+        return "NaN";
+    }
+    if (isinf(value)) {
+        return value > 0 ? "+Inf" : "-Inf";
+    }
+    // 优先用15位有效数字，不能精确还原时才用17位
+    snprintf(out, size, "%.15g", value);
+    if (strtod(out, NULL) != value) {
+        snprintf(out, size, "%.17g", value);
+    }
+    return out;
+}
+
+// 把"种类名[:实例名]"写成标签集，转义反斜杠、双引号和换行
+static void format_labels(char *out, size_t size, const char *name) {
+    const char *sep = strchr(name, ':');
+    size_t kind_len = sep ? (size_t)(sep - name) : strlen(name);
+    int len = snprintf(out, size, "{metric=\"%.*s\"", (int)kind_len, name);
+    size_t used = len > 0 && (size_t)len < size ? (size_t)len : 0;
+
+    if (sep && used + 14 < size) {
+        memcpy(out + used, ",instance=\"", 11);
+        used += 11;
+        for (const char *p = sep + 1; *p && used + 4 < size; p++) {
+            if (*p == '\\' || *p == '"' || *p == '\n') {
+                out[used++] = '\\';
+                out[used++] = *p == '\n' ? 'n' : *p;
+            } else {
+                out[used++] = *p;
+            }
+        }
+        out[used++] = '"';
+    }
+    if (used + 2 <= size) {
+        out[used++] = '}';
+    }
+    out[used < size ? used : size - 1] = '\0';
+}
+
+/* 每个指标一行的指标族 */
+typedef enum {
+    FAMILY_VALUE,
+    FAMILY_MEAN,
+    FAMILY_STDDEV,
+    FAMILY_MEDIAN,
+    FAMILY_MAD,
+    FAMILY_THRESHOLD,
+    FAMILY_ALERTS,
+    FAMILY_FIRING,
+    FAMILY_COUNT
+} MetricFamily;
+
+static const struct {
+    const char *name;
+    const char *type;
+    const char *help;
+} families[FAMILY_COUNT] = {
+    { "anomaly_metric_value", "gauge", "指标当前值" },
+    { "anomaly_metric_mean", "gauge", "滑动窗口均值" },
+    { "anomaly_metric_stddev", "gauge", "滑动窗口标准差" },
+    { "anomaly_metric_median", "gauge", "滑动窗口中位数（中位数/MAD检测的指标）" },
+    { "anomaly_metric_mad", "gauge", "滑动窗口中位数绝对偏差（中位数/MAD检测的指标）" },
+    { "anomaly_metric_threshold", "gauge", "阈值检测的阈值" },
+    { "anomaly_metric_alerts_total", "counter", "该指标累计触发的告警数" },
+    { "anomaly_metric_alert_firing", "gauge", "该指标的告警是否触发中（1为触发中）" },
+};
+
+// 取一个指标在某个指标族中的值，不适用时返回false
+static bool family_value(const Exposition *e, const MetricReport *report,
+                         MetricFamily family, double *value) {
+    bool stats = report->has_stats && !report->robust;
+    bool robust = report->has_stats && report->robust;
+    switch (family) {
+    case FAMILY_VALUE:
+        *value = report->value;
+        return true;
+    case FAMILY_MEAN:
+        *value = report->mean;
+        return stats;
+    case FAMILY_STDDEV:
+        *value = report->stddev;
+        return stats;
+    case FAMILY_MEDIAN:
+        *value = report->median;
+        return robust;
+    case FAMILY_MAD:
+        *value = report->mad;
+        return robust;
+    case FAMILY_THRESHOLD:
+        *value = report->threshold;
+        return *value > 0;
+    case FAMILY_ALERTS:
+        *value = report->metric_id < e->alert_capacity ? (double)e->alert_totals[report->metric_id] : 0;
+        return true;
+    case FAMILY_FIRING:
+        *value = report->metric_id < e->alert_capacity && e->alert_firing[report->metric_id] ? 1 : 0;
+        return true;
+    default:
+        return false;
+    }
+}
+
+// 写一个只有一行的计数器
+static int render_counter(ExpositionBuffer *buf, const char *name, const char *help,
+                          unsigned long value) {
+    return buffer_printf(buf, "# HELP %s %s\n# TYPE %s counter\n%s %lu\n",
+                         name, help, name, name, value);
+}
+
+// 写进程占用排行，进程名中的反斜杠、双引号和换行需要转义
+static int render_processes(ExpositionBuffer *buf, const ProcessTop *top) {
+    static const struct {
+        const char *name;
+        const char *help;
+    } families[2] = {
+        { "anomaly_process_cpu_percent", "CPU占用最高的进程的CPU使用率（%，单核为100%）" },
+        { "anomaly_process_resident_bytes", "常驻内存最多的进程的常驻内存（字节）" },
+    };
+
+    int ret = 0;
+    for (int f = 0; f < 2 && ret == 0; f++) {
+        const ProcessUsage *list = f == 0 ? top->cpu : top->mem;
+        int count = f == 0 ? top->cpu_count : top->mem_count;
+        ret |= buffer_printf(buf, "# HELP %s %s\n# TYPE %s gauge\n",
+                             families[f].name, families[f].help, families[f].name);
+        for (int i = 0; i < count && ret == 0; i++) {
+            char comm[PROCESS_COMM_LEN * 2];
+            size_t len = 0;
+            for (const char *p = list[i].comm; *p; p++) {
+                if (*p == '\\' || *p == '"' || *p == '\n') {
+                    comm[len++] = '\\';
+                    comm[len++] = *p == '\n' ? 'n' : *p;
+                } else {
+                    comm[len++] = *p;
+                }
+            }
+            comm[len] = '\0';
+            if (f == 0) {
+                ret |= buffer_printf(buf, "%s{rank=\"%d\",pid=\"%d\",comm=\"%s\"} %.2f\n",
+                                     families[f].name, i + 1, list[i].pid, comm, list[i].cpu_percent);
+            } else {
+                ret |= buffer_printf(buf, "%s{rank=\"%d\",pid=\"%d\",comm=\"%s\"} %lu\n",
+                                     families[f].name, i + 1, list[i].pid, comm, list[i].rss_kb * 1024UL);
+            }
+        }
+    }
+    return ret;
+}
+
+// 写各阶段耗时的摘要（分位数为对数直方图桶的上界）
+static int render_latency(ExpositionBuffer *buf) {
+    static const char *name = "anomaly_stage_latency_seconds";
+    int ret = buffer_printf(buf, "# HELP %s 各处理阶段的耗时\n# TYPE %s summary\n", name, name);
+    for (int i = 0; i < LATENCY_STAGE_COUNT && ret == 0; i++) {
+        LatencySummary s;
+        latency_summarize((LatencyStage)i, &s);
+        if (s.count == 0) {
+            continue;
+        }
+        const char *stage = latency_stage_name((LatencyStage)i);
+        ret |= buffer_printf(buf,
+                             "%s{stage=\"%s\",quantile=\"0.5\"} %.9f\n"
+                             "%s{stage=\"%s\",quantile=\"0.9\"} %.9f\n"
+                             "%s{stage=\"%s\",quantile=\"0.99\"} %.9f\n"
+                             "%s{stage=\"%s\",quantile=\"0.999\"} %.9f\n"
+                             "%s_sum{stage=\"%s\"} %.9f\n"
+                             "%s_count{stage=\"%s\"} %lu\n",
+                             name, stage, s.p50_ns / 1e9, name, stage, s.p90_ns / 1e9,
+                             name, stage, s.p99_ns / 1e9, name, stage, s.p999_ns / 1e9,
+                             name, stage, s.sum_ns / 1e9, name, stage, s.count);
+    }
+    return ret;
+}
+
+// 按告警事件累计各指标的告警数和触发状态，指标重新注册（带新标签）时清零
+static int count_alerts(Exposition *e, const OutputBatch *batch) {
+    for (int i = 0; i < batch->label_count; i++) {
+        int id = batch->labels[i].metric_id;
+        if (id >= e->alert_capacity) {
+            int new_capacity = e->alert_capacity > 0 ? e->alert_capacity : 64;
+            while (new_capacity <= id) {
+                new_capacity *= 2;
+            }
+            unsigned long *totals = (unsigned long *)realloc(e->alert_totals,
+                                                             sizeof(unsigned long) * new_capacity);
+            if (!totals) {
+                return -1;
+            }
+            e->alert_totals = totals;
+            bool *firing = (bool *)realloc(e->alert_firing, sizeof(bool) * new_capacity);
+            if (!firing) {
+                return -1;
+            }
+            e->alert_firing = firing;
+            memset(totals + e->alert_capacity, 0,
+                   sizeof(unsigned long) * (new_capacity - e->alert_capacity));
+            memset(firing + e->alert_capacity, 0, sizeof(bool) * (new_capacity - e->alert_capacity));
+            e->alert_capacity = new_capacity;
+        }
+        e->alert_totals[id] = 0;
+        e->alert_firing[id] = false;
+    }
+
+    // 同一批次中重新注册的指标，原注册的恢复事件排在新注册的事件之前，只清除触发状态
+    for (int i = 0; i < batch->event_count; i++) {
+        const AlertEvent *event = &batch->events[i];
+        int id = event->metric_id;
+        if (id < 0 || id >= e->alert_capacity) {
+            continue;
+        }
+        if (event->kind == ALERT_EVENT_FIRING) {
+            e->alert_totals[id]++;
+            e->alert_firing[id] = true;
+            e->alerts++;
+        } else {
+            e->alert_firing[id] = false;
+        }
+    }
+    return 0;
+}
+
+int exposition_publish(Exposition *exposition, const OutputSink *sink, const OutputBatch *batch,
+                       const ExpositionCounters *counters) {
+    if (!exposition || !sink || !batch || !counters) {
+        return -1;
+    }
+
+    Exposition *e = exposition;
+    if (count_alerts(e, batch) != 0) {
+        return -1;
+    }
+
+    ExpositionBuffer *buf = &e->render;
+    buf->len = 0;
+    int ret = 0;
+    for (int f = 0; f < FAMILY_COUNT && ret == 0; f++) {
+        ret |= buffer_printf(buf, "# HELP %s %s\n# TYPE %s %s\n",
+                             families[f].name, families[f].help, families[f].name, families[f].type);
+        for (int i = 0; i < batch->report_count && ret == 0; i++) {
+            const MetricReport *report = &batch->reports[i];
+            double value;
+            if (report->metric_id >= sink->capacity ||
+                !family_value(e, report, (MetricFamily)f, &value)) {
+                continue;
+            }
+            char labels[NAME_INDEX_KEY_LEN * 2 + 32];
+            char number[32];
+            format_labels(labels, sizeof(labels), sink->labels[report->metric_id].name);
+            ret |= buffer_printf(buf, "%s%s %s\n", families[f].name, labels,
+                                 format_value(number, sizeof(number), value));
+        }
+    }
+
+    ret |= render_counter(buf, "anomaly_alerts_total", "累计触发的告警数", e->alerts);
+    ret |= buffer_printf(buf, "# HELP anomaly_alerts_firing 触发中的告警数\n"
+                         "# TYPE anomaly_alerts_firing gauge\nanomaly_alerts_firing %d\n",
+                         batch->alerts_firing);
+    ret |= render_counter(buf, "anomaly_cycles_total", "已采集的周期数", counters->cycles);
+    ret |= render_counter(buf, "anomaly_collect_errors_total", "数据源读取失败的周期数",
+                          counters->collect_errors);
+    ret |= render_counter(buf, "anomaly_missed_deadlines_total", "错过的采样截止时间数",
+                          counters->missed_deadlines);
+    ret |= render_counter(buf, "anomaly_source_timeouts_total", "超时未读完而被跳过的数据源次数",
+                          counters->source_timeouts);
+    ret |= render_counter(buf, "anomaly_dropped_sample_batches_total", "检测队列满而丢弃的采样批次数",
+                          counters->dropped_samples);
+    ret |= render_counter(buf, "anomaly_dropped_output_batches_total", "输出队列满而丢弃的输出批次数",
+                          counters->dropped_outputs);
+    ret |= render_counter(buf, "anomaly_pressure_bursts_total", "资源压力触发突发采样的次数",
+                          counters->pressure_bursts);
+    ret |= render_counter(buf, "anomaly_scrapes_total", "已响应的抓取次数",
+                          atomic_load_explicit(&e->scrapes, memory_order_relaxed));
+    ret |= render_latency(buf);
+    if (batch->processes.process_count > 0) {
+        ret |= render_processes(buf, &batch->processes);
+    }
+    if (ret != 0) {
+        return -1;
+    }
+
+    // 交换渲染好的页面和已发布的页面，旧页面的缓冲区下个周期复用
+    pthread_mutex_lock(&e->lock);
+    ExpositionBuffer published = e->published;
+    e->published = e->render;
+    e->render = published;
+    pthread_mutex_unlock(&e->lock);
+    return 0;
+}
+
+// 发送全部数据，对端关闭或超时返回非0
+// 等待连接可读/可写，直到整个请求的截止时间（单调时钟），超时或出错返回-1
+static int wait_ready(int fd, short events, uint64_t deadline_ns) {
+    for (;;) {
+        uint64_t now = monotonic_ns();
+        if (now >= deadline_ns) {
+            return -1;
+        }
+        struct pollfd pfd = { .fd = fd, .events = events };
+        int timeout_ms = (int)((deadline_ns - now + NSEC_PER_MSEC - 1) / NSEC_PER_MSEC);
+        int ready = poll(&pfd, 1, timeout_ms);
+        if (ready > 0) {
+            return 0;
+        }
+        if (ready < 0 && errno != EINTR) {
+            return -1;
+        }
+    }
+}
+
+static int send_all(int fd, const char *data, size_t len, uint64_t deadline_ns) {
+    while (len > 0) {
+        if (wait_ready(fd, POLLOUT, deadline_ns) != 0) {
+            return -1;
+        }
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) {
+                continue;
+            }
+            return -1;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static void send_status(int fd, const char *status, uint64_t deadline_ns) {
+    char header[256];
+    int len = snprintf(header, sizeof(header),
+                       "HTTP/1.1 %s\r\nContent-Type: text/plain; charset=utf-8\r\n"
+                       "Content-Length: 0\r\nConnection: close\r\n\r\n", status);
+    send_all(fd, header, (size_t)len, deadline_ns);
+}
+
+// 处理一个连接：读取请求头，GET /metrics返回最新页面
+static void serve_client(Exposition *e, int fd) {
+    // 整个请求（读请求头和写响应）共用一个截止时间，每隔一会儿发一个字节的
+    // 慢速客户端也最多占用服务线程EXPOSITION_TIMEOUT_MS，与采集无关
+    uint64_t deadline_ns = monotonic_ns() + EXPOSITION_TIMEOUT_MS * NSEC_PER_MSEC;
+
+    char request[2048];
+    size_t len = 0;
+    while (len < sizeof(request) - 1) {
+        if (wait_ready(fd, POLLIN, deadline_ns) != 0) {
+            return;
+        }
+        ssize_t n = recv(fd, request + len, sizeof(request) - 1 - len, MSG_DONTWAIT);
+        if (n < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) {
+            continue;
+        }
+        if (n <= 0) {
+            return;
+        }
+        len += (size_t)n;
+        request[len] = '\0';
+        if (strstr(request, "\r\n\r\n")) {
+            break;
+        }
+    }
+    request[len] = '\0';
+
+    if (strncmp(request, "GET ", 4) != 0) {
+        send_status(fd, "405 Method Not Allowed", deadline_ns);
+        return;
+    }
+    const char *path = request + 4;
+    size_t path_len = strcspn(path, " ?\r\n");
+    if (path_len != 8 || strncmp(path, "/metrics", 8) != 0) {
+        send_status(fd, "404 Not Found", deadline_ns);
+        return;
+    }
+
+    // 复制已发布的页面，锁只在复制期间持有
+    ExpositionBuffer *copy = &e->response;
+    pthread_mutex_lock(&e->lock);
+    copy->len = 0;
+    if (buffer_reserve(copy, e->published.len) == 0 && e->published.len > 0) {
+        memcpy(copy->data, e->published.data, e->published.len);
+        copy->len = e->published.len;
+    }
+    pthread_mutex_unlock(&e->lock);
+
+    char header[256];
+    int header_len = snprintf(header, sizeof(header),
+                              "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                              "Content-Length: %zu\r\nConnection: close\r\n\r\n", copy->len);
+    if (send_all(fd, header, (size_t)header_len, deadline_ns) == 0 && copy->len > 0) {
+        send_all(fd, copy->data, copy->len, deadline_ns);
+    }
+    atomic_fetch_add_explicit(&e->scrapes, 1, memory_order_relaxed);
+}
+
+static void *serve_main(void *arg) {
+    Exposition *e = (Exposition *)arg;
+    struct pollfd fds[2] = {
+        { .fd = e->fd, .events = POLLIN },
+        { .fd = e->wake_fd, .events = POLLIN },
+    };
+
+    while (!atomic_load(&e->stopping)) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (!(fds[0].revents & POLLIN)) {
+            continue;
+        }
+        int client = accept4(e->fd, NULL, NULL, SOCK_CLOEXEC);
+        if (client < 0) {
+            continue;
+        }
+        serve_client(e, client);
+        close(client);
+    }
+    return NULL;
+}
+
+// 解析"<端口>"或"<IPv4地址>:<端口>"
+static int parse_listen_address(const char *text, struct sockaddr_in *addr) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    const char *colon = strrchr(text, ':');
+    const char *port_text = colon ? colon + 1 : text;
+    if (colon) {
+        char host[64];
+        size_t host_len = (size_t)(colon - text);
+        if (host_len == 0 || host_len >= sizeof(host)) {
+            return -1;
+        }
+        memcpy(host, text, host_len);
+        host[host_len] = '\0';
+        if (inet_pton(AF_INET, host, &addr->sin_addr) != 1) {
+            return -1;
+        }
+    }
+
+    char *end;
+    long port = strtol(port_text, &end, 10);
+    if (end == port_text || *end != '\0' || port <= 0 || port > 65535) {
+        return -1;
+    }
+    addr->sin_port = htons((uint16_t)port);
+    return 0;
+}
+
+int exposition_start(Exposition *exposition, const char *address) {
+    if (!exposition || !address) {
+        return -1;
+    }
+
+    Exposition *e = exposition;
+    memset(e, 0, sizeof(*e));
+    e->fd = -1;
+    e->wake_fd = -1;
+
+    struct sockaddr_in addr;
+    if (parse_listen_address(address, &addr) != 0) {
+        fprintf(stderr, "错误: 无效的指标端点地址 %s\n", address);
+        return -1;
+    }
+
+    int one = 1;
+    e->fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (e->fd < 0 ||
+        setsockopt(e->fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0 ||
+        bind(e->fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(e->fd, 16) != 0) {
+        fprintf(stderr, "错误: 无法监听指标端点 %s: %s\n", address, strerror(errno));
+        exposition_stop(e);
+        return -1;
+    }
+
+    e->wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (e->wake_fd < 0) {
+        exposition_stop(e);
+        return -1;
+    }
+
+    pthread_mutex_init(&e->lock, NULL);
+    if (pthread_create(&e->thread, NULL, serve_main, e) != 0) {
+        pthread_mutex_destroy(&e->lock);
+        exposition_stop(e);
+        return -1;
+    }
+    e->running = true;
+    return 0;
+}
+
+void exposition_stop(Exposition *exposition) {
+    if (!exposition) {
+        return;
+    }
+
+    Exposition *e = exposition;
+    if (e->running) {
+        atomic_store(&e->stopping, true);
+        uint64_t one = 1;
+        if (write(e->wake_fd, &one, sizeof(one)) < 0) {
+            // eventfd计数溢出时服务线程已处于唤醒状态
+        }
+        pthread_join(e->thread, NULL);
+        pthread_mutex_destroy(&e->lock);
+        e->running = false;
+    }
+    if (e->fd >= 0) {
+        close(e->fd);
+        e->fd = -1;
+    }
+    if (e->wake_fd >= 0) {
+        close(e->wake_fd);
+        e->wake_fd = -1;
+    }
+    free(e->published.data);
+    free(e->render.data);
+    free(e->response.data);
+    free(e->alert_totals);
+    free(e->alert_firing);
+    memset(&e->published, 0, sizeof(e->published));
+    memset(&e->render, 0, sizeof(e->render));
+    memset(&e->response, 0, sizeof(e->response));
+    e->alert_totals = NULL;
+    e->alert_firing = NULL;
+    e->alert_capacity = 0;
+}
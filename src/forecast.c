@@ -0,0 +1,114 @@
+#include "../include/forecast.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+Forecast *forecast_create(ForecastKind kind, const ForecastParams *params, int64_t clock_offset_ns) {
+    if (!params) {
+        return NULL;
+    }
+
+    int buckets = kind == FORECAST_HOLT_WINTERS ? params->season_buckets : 0;
+    if (kind == FORECAST_HOLT_WINTERS && (buckets <= 0 || params->season_ns < (uint64_t)buckets)) {
+        return NULL;
+    }
+
+    Forecast *f = (Forecast *)calloc(1, sizeof(Forecast) + sizeof(float) * (size_t)buckets);
+    if (!f) {
+        return NULL;
+    }
+    f->kind = kind;
+    f->params = *params;
+    f->params.season_buckets = buckets;
+    f->clock_offset_ns = clock_offset_ns;
+    for (int i = 0; i < buckets; i++) {
+        f->seasonal[i] = NAN;
+    }
+    return f;
+}
+
+size_t forecast_size(const Forecast *forecast) {
+    return sizeof(Forecast) + sizeof(float) * (size_t)forecast->params.season_buckets;
+}
+
+// 样本所在的季节桶，按墙上时间计算，重启后相位不变
+static int season_bucket(const Forecast *f, uint64_t timestamp_ns) {
+    uint64_t wall = (uint64_t)((int64_t)timestamp_ns + f->clock_offset_ns);
+    uint64_t phase = wall % f->params.season_ns;
+    return (int)(phase / (f->params.season_ns / (uint64_t)f->params.season_buckets)) %
+           f->params.season_buckets;
+}
+
+// 更新残差方差；预测可用时把残差截断在尺度的若干倍以内，一个尖峰不会放大后续的尺度
+static void update_variance(Forecast *f, double residual, double clamp) {
+    if (f->ready && f->scale > 0 && fabs(residual) > clamp * f->scale) {
+        residual = residual > 0 ? clamp * f->scale : -clamp * f->scale;
+    }
+    f->variance += f->params.variance_alpha * (residual * residual - f->variance);
+}
+
+void forecast_update(Forecast *f, double value, uint64_t timestamp_ns) {
+    if (!f || isnan(value)) {
+        return;
+    }
+
+    const ForecastParams *p = &f->params;
+    f->count++;
+    if (f->count == 1) {
+        f->level = value;
+        f->ready = false;
+        if (f->kind == FORECAST_HOLT_WINTERS) {
+            f->seasonal[season_bucket(f, timestamp_ns)] = 0.0f;
+        }
+        return;
+    }
+
+    if (f->kind == FORECAST_EWMA) {
+        f->predicted = f->level;
+        f->scale = sqrt(f->variance);
+        f->ready = f->count > (uint64_t)p->warmup;
+
+        double residual = value - f->predicted;
+        update_variance(f, residual, 4.0);
+        f->level += p->alpha * residual;
+        return;
+    }
+
+    // 加法Holt-Winters：预测 = 水平 + 趋势 + 季节分量
+    int b = season_bucket(f, timestamp_ns);
+    bool seen = !isnan(f->seasonal[b]);
+    double season = seen ? f->seasonal[b] : 0.0;
+    f->predicted = f->level + f->trend + season;
+    f->scale = sqrt(f->variance);
+    // 第一次进入某个桶时还没有季节估计，不给出预测
+    f->ready = seen && f->count > (uint64_t)p->warmup;
+
+    double residual = value - f->predicted;
+    if (seen) {
+        update_variance(f, residual, 4.0);
+    }
+
+    double level = p->alpha * (value - season) + (1.0 - p->alpha) * (f->level + f->trend);
+    f->trend = p->beta * (level - f->level) + (1.0 - p->beta) * f->trend;
+    f->level = level;
+    f->seasonal[b] = seen ? (float)(p->gamma * (value - level) + (1.0 - p->gamma) * season)
+                          : (float)(value - level);
+}
+
+int forecast_restore(Forecast *forecast, const Forecast *saved) {
+    if (!forecast || !saved || forecast->kind != saved->kind ||
+        forecast->params.season_buckets != saved->params.season_buckets ||
+        forecast->params.season_ns != saved->params.season_ns) {
+        return -1;
+    }
+
+    forecast->count = saved->count;
+    forecast->level = saved->level;
+    forecast->trend = saved->trend;
+    forecast->variance = saved->variance;
+    forecast->predicted = saved->predicted;
+    forecast->scale = saved->scale;
+    forecast->ready = false;
+    memcpy(forecast->seasonal, saved->seasonal, sizeof(float) * (size_t)saved->params.season_buckets);
+    return 0;
+}
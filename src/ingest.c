@@ -0,0 +1,255 @@
+#include "../include/ingest.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/un.h>
+#include <netdb.h>
+
+int ingest_parse_address(const char *text, IngestAddress *address) {
+    if (!text || !address) {
+        return -1;
+    }
+    memset(address, 0, sizeof(*address));
+
+    if (strncmp(text, "unix:", 5) == 0) {
+        struct sockaddr_un *un = (struct sockaddr_un *)&address->addr;
+        const char *path = text + 5;
+        if (path[0] == '\0' || strlen(path) >= sizeof(un->sun_path)) {
+            return -1;
+        }
+        un->sun_family = AF_UNIX;
+        strcpy(un->sun_path, path);
+        address->len = (socklen_t)sizeof(*un);
+        address->family = AF_UNIX;
+        return 0;
+    }
+
+    if (strncmp(text, "udp:", 4) != 0) {
+        return -1;
+    }
+
+    // 主机和端口以最后一个冒号分隔，IPv6地址写在方括号中
+    char host[256];
+    const char *start = text + 4;
+    const char *colon = strrchr(start, ':');
+    if (!colon || colon == start || colon[1] == '\0') {
+        return -1;
+    }
+    size_t host_len = (size_t)(colon - start);
+    if (start[0] == '[' && colon[-1] == ']') {
+        start++;
+        host_len -= 2;
+    }
+    if (host_len == 0 || host_len >= sizeof(host)) {
+        return -1;
+    }
+    memcpy(host, start, host_len);
+    host[host_len] = '\0';
+
+    struct addrinfo hints, *result;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_flags = AI_NUMERICSERV;
+    if (getaddrinfo(host, colon + 1, &hints, &result) != 0) {
+        return -1;
+    }
+    memcpy(&address->addr, result->ai_addr, result->ai_addrlen);
+    address->len = result->ai_addrlen;
+    address->family = result->ai_family;
+    freeaddrinfo(result);
+    return 0;
+}
+
+uint64_t ingest_series_key(const char *host, const char *metric) {
+    // FNV-1a，主机名和指标名之间以'\0'分隔
+    uint64_t hash = 14695981039346656037ULL;
+    for (const char *p = host; *p; p++) {
+        hash = (hash ^ (unsigned char)*p) * 1099511628211ULL;
+    }
+    hash *= 1099511628211ULL;
+    for (const char *p = metric; *p; p++) {
+        hash = (hash ^ (unsigned char)*p) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+int ingest_frame_records(const void *data, size_t len) {
+    if (len < sizeof(IngestFrameHeader)) {
+        return -1;
+    }
+
+    const IngestFrameHeader *header = (const IngestFrameHeader *)data;
+    if (header->magic != INGEST_MAGIC || header->version != INGEST_VERSION) {
+        return -1;
+    }
+
+    size_t record_size;
+    if (header->kind == INGEST_FRAME_SAMPLES) {
+        record_size = sizeof(IngestSample);
+    } else if (header->kind == INGEST_FRAME_SERIES) {
+        record_size = sizeof(IngestSeries);
+    } else {
+        return -1;
+    }
+    if (header->count > INGEST_MAX_FRAME / record_size ||
+        len != sizeof(IngestFrameHeader) + record_size * header->count) {
+        return -1;
+    }
+    return (int)header->count;
+}
+
+int ingest_client_open(IngestClient *client, const char *address, const char *host) {
+    if (!client || !address) {
+        return -1;
+    }
+    memset(client, 0, sizeof(*client));
+    client->fd = -1;
+
+    if (host) {
+        if (strlen(host) >= sizeof(client->host)) {
+            return -1;
+        }
+        strcpy(client->host, host);
+    } else if (gethostname(client->host, sizeof(client->host)) != 0) {
+        return -1;
+    }
+    client->host[sizeof(client->host) - 1] = '\0';
+
+    IngestAddress addr;
+    if (ingest_parse_address(address, &addr) != 0) {
+        return -1;
+    }
+
+    client->frame = (IngestFrameHeader *)calloc(1, INGEST_MAX_FRAME);
+    if (!client->frame) {
+        return -1;
+    }
+    client->samples = (IngestSample *)(client->frame + 1);
+
+    client->fd = socket(addr.family, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (client->fd < 0 || connect(client->fd, (struct sockaddr *)&addr.addr, addr.len) != 0) {
+        ingest_client_close(client);
+        return -1;
+    }
+    return 0;
+}
+
+// 发送一帧，失败时计数
+static int client_send(IngestClient *client, const void *frame, size_t len) {
+    client->frames++;
+    while (send(client->fd, frame, len, 0) < 0) {
+        if (errno != EINTR) {
+            client->send_errors++;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// 发送序列定义，每帧最多INGEST_SERIES_PER_FRAME条
+static int client_send_series(IngestClient *client, int first, int count) {
+    char frame[INGEST_MAX_FRAME];
+    IngestFrameHeader *header = (IngestFrameHeader *)frame;
+    IngestSeries *records = (IngestSeries *)(header + 1);
+    int ret = 0;
+
+    while (count > 0) {
+        int n = count < (int)INGEST_SERIES_PER_FRAME ? count : (int)INGEST_SERIES_PER_FRAME;
+        memset(header, 0, sizeof(*header));
+        header->magic = INGEST_MAGIC;
+        header->version = INGEST_VERSION;
+        header->kind = INGEST_FRAME_SERIES;
+        header->count = (uint32_t)n;
+        memcpy(records, client->series + first, sizeof(IngestSeries) * n);
+        ret |= client_send(client, frame, sizeof(*header) + sizeof(IngestSeries) * n);
+        first += n;
+        count -= n;
+    }
+    return ret;
+}
+
+int ingest_client_define(IngestClient *client, const char *metric, uint64_t *key) {
+    if (!client || !metric || !key || strlen(metric) >= NAME_INDEX_KEY_LEN) {
+        return -1;
+    }
+
+    if (client->series_count == client->series_capacity) {
+        int new_capacity = client->series_capacity > 0 ? client->series_capacity * 2 : 16;
+        IngestSeries *new_series = (IngestSeries *)realloc(client->series,
+                                                           sizeof(IngestSeries) * new_capacity);
+        if (!new_series) {
+            return -1;
+        }
+        client->series = new_series;
+        client->series_capacity = new_capacity;
+    }
+
+    IngestSeries *series = &client->series[client->series_count++];
+    memset(series, 0, sizeof(*series));
+    series->key = ingest_series_key(client->host, metric);
+    strcpy(series->host, client->host);
+    strcpy(series->metric, metric);
+    *key = series->key;
+    return 0;
+}
+
+int ingest_client_flush(IngestClient *client) {
+    if (!client || !client->frame || client->frame->count == 0) {
+        return 0;
+    }
+
+    int ret = 0;
+    // 新定义的序列先于样本发出；数据报可能丢失，定期重发全部序列定义
+    if (++client->frames_since_define >= INGEST_DEFINE_EVERY) {
+        client->frames_since_define = 0;
+        client->series_sent = 0;
+    }
+    if (client->series_sent < client->series_count) {
+        ret |= client_send_series(client, client->series_sent, client->series_count - client->series_sent);
+        client->series_sent = client->series_count;
+    }
+
+    IngestFrameHeader *header = client->frame;
+    header->magic = INGEST_MAGIC;
+    header->version = INGEST_VERSION;
+    header->kind = INGEST_FRAME_SAMPLES;
+    ret |= client_send(client, header, sizeof(*header) + sizeof(IngestSample) * header->count);
+    header->count = 0;
+    return ret;
+}
+
+int ingest_client_sample(IngestClient *client, uint64_t key, double value, uint64_t timestamp_ns) {
+    if (!client || !client->frame) {
+        return -1;
+    }
+
+    int ret = 0;
+    IngestFrameHeader *header = client->frame;
+    if (header->count > 0 &&
+        (header->timestamp_ns != timestamp_ns || header->count == INGEST_SAMPLES_PER_FRAME)) {
+        ret = ingest_client_flush(client);
+    }
+
+    header->timestamp_ns = timestamp_ns;
+    client->samples[header->count].key = key;
+    client->samples[header->count].value = value;
+    header->count++;
+    return ret;
+}
+
+void ingest_client_close(IngestClient *client) {
+    if (!client) {
+        return;
+    }
+    if (client->fd >= 0) {
+        ingest_client_flush(client);
+        close(client->fd);
+    }
+    free(client->series);
+    free(client->frame);
+    memset(client, 0, sizeof(*client));
+    client->fd = -1;
+}
@@ -0,0 +1,514 @@
+#define _GNU_SOURCE
+#include "../include/ingest_server.h"
+#include "../include/config.h"
+#include "../include/scheduler.h"
+#include "../include/latency.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#define KEY_MIX 0x9E3779B97F4A7C15ULL
+
+// 序列所属的工作线程，由序列键决定，同一序列总是落在同一线程
+static int shard_of(const IngestServer *s, uint64_t key) {
+    return (int)((uint32_t)((key * KEY_MIX) >> 32) % (uint32_t)s->worker_count);
+}
+
+// 在映射表中查找序列键，不存在时返回键应插入的空槽位
+static IngestKeySlot *key_slot(const IngestServer *s, uint64_t key) {
+    unsigned long i = (unsigned long)((key ^ (key >> 29)) * KEY_MIX >> 17) & s->key_mask;
+    while (s->keys[i].key != 0 && s->keys[i].key != key) {
+        i = (i + 1) & s->key_mask;
+    }
+    return &s->keys[i];
+}
+
+// 映射表装载率超过一半时扩容
+static int grow_keys(IngestServer *s) {
+    if ((s->key_count + 1) * 2 <= s->key_mask + 1) {
+        return 0;
+    }
+
+    unsigned long old_capacity = s->key_mask + 1;
+    IngestKeySlot *old_keys = s->keys;
+    IngestKeySlot *new_keys = (IngestKeySlot *)calloc(old_capacity * 2, sizeof(IngestKeySlot));
+    if (!new_keys) {
+        return -1;
+    }
+    s->keys = new_keys;
+    s->key_mask = old_capacity * 2 - 1;
+    for (unsigned long i = 0; i < old_capacity; i++) {
+        if (old_keys[i].key != 0) {
+            *key_slot(s, old_keys[i].key) = old_keys[i];
+        }
+    }
+    free(old_keys);
+    return 0;
+}
+
+// 把工作线程的待发批次写入队列；队列满时丢弃样本、保留序列事件
+static void publish_worker(IngestServer *s, IngestWorker *w) {
+    if (w->pending.sample_count == 0 && w->pending.event_count == 0) {
+        return;
+    }
+
+    SampleBatch *slot = (SampleBatch *)spsc_ring_reserve(&w->ring);
+    if (!slot) {
+        atomic_fetch_add_explicit(&s->counters.dropped_samples, (unsigned long)w->pending.sample_count,
+                                  memory_order_relaxed);
+        w->pending.sample_count = 0;
+        return;
+    }
+
+    // 交换批次，两边的数组都保留复用，稳定运行时不分配内存
+    SampleBatch spare = *slot;
+    *slot = w->pending;
+    w->pending = spare;
+    sample_batch_reset(&w->pending);
+    spsc_ring_publish(&w->ring);
+}
+
+// 定义一个序列：校验后分配工作线程和序列号，创建事件随该线程的下一个批次送达
+static void define_series(IngestServer *s, const IngestSeries *record) {
+    char host[INGEST_HOST_LEN];
+    char metric[NAME_INDEX_KEY_LEN];
+    memcpy(host, record->host, sizeof(host));
+    memcpy(metric, record->metric, sizeof(metric));
+    host[sizeof(host) - 1] = '\0';
+    metric[sizeof(metric) - 1] = '\0';
+
+    // 主机名中不能有'/'和':'，否则不同主机的指标名可能相同
+    if (record->key == 0 || host[0] == '\0' || strpbrk(host, "/:") ||
+        record->key != ingest_series_key(host, metric)) {
+        atomic_fetch_add_explicit(&s->counters.rejected_series, 1, memory_order_relaxed);
+        return;
+    }
+    if (key_slot(s, record->key)->key != 0) {
+        return;     // 已定义（代理定期重发）
+    }
+
+    // 指标名改写为 种类名:主机名[/实例名]
+    const char *sep = strchr(metric, ':');
+    int kind = find_metric_kind(metric, sep ? (size_t)(sep - metric) : strlen(metric));
+    char instance[NAME_INDEX_KEY_LEN];
+    int len = sep ? snprintf(instance, sizeof(instance), "%s/%s", host, sep + 1)
+                  : snprintf(instance, sizeof(instance), "%s", host);
+    if (kind < 0 || len < 0 ||
+        strlen(metric_kind_name((MetricType)kind)) + 1 + (size_t)len >= NAME_INDEX_KEY_LEN ||
+        grow_keys(s) != 0) {
+        atomic_fetch_add_explicit(&s->counters.rejected_series, 1, memory_order_relaxed);
+        return;
+    }
+
+    IngestWorker *w = &s->workers[shard_of(s, record->key)];
+    if (sample_batch_add_event(&w->pending, SERIES_CREATE, w->series_count,
+                               (MetricType)kind, instance) != 0) {
+        atomic_fetch_add_explicit(&s->counters.rejected_series, 1, memory_order_relaxed);
+        return;
+    }
+
+    IngestKeySlot *slot = key_slot(s, record->key);
+    slot->key = record->key;
+    slot->worker = w->index;
+    slot->series = w->series_count++;
+    s->key_count++;
+    atomic_fetch_add_explicit(&s->counters.series, 1, memory_order_relaxed);
+}
+
+// 处理一个数据报
+static void handle_frame(IngestServer *s, const char *data, size_t len) {
+    int count = ingest_frame_records(data, len);
+    if (count < 0) {
+        atomic_fetch_add_explicit(&s->counters.bad_frames, 1, memory_order_relaxed);
+        return;
+    }
+    atomic_fetch_add_explicit(&s->counters.frames, 1, memory_order_relaxed);
+
+    const IngestFrameHeader *header = (const IngestFrameHeader *)data;
+    if (header->kind == INGEST_FRAME_SERIES) {
+        const IngestSeries *records = (const IngestSeries *)(header + 1);
+        for (int i = 0; i < count; i++) {
+            define_series(s, &records[i]);
+        }
+        return;
+    }
+
+    const IngestSample *records = (const IngestSample *)(header + 1);
+    unsigned long unknown = 0;
+    for (int i = 0; i < count; i++) {
+        const IngestKeySlot *slot = key_slot(s, records[i].key);
+        if (slot->key == 0) {
+            unknown++;
+            continue;
+        }
+
+        // 批次内的样本共用采样时间，时间不同时先发出已有的样本
+        IngestWorker *w = &s->workers[slot->worker];
+        if (w->pending.sample_count > 0 && w->pending.timestamp_ns != header->timestamp_ns) {
+            publish_worker(s, w);
+        }
+        w->pending.timestamp_ns = header->timestamp_ns;
+        if (sample_batch_add(&w->pending, slot->series, records[i].value) != 0) {
+            atomic_fetch_add_explicit(&s->counters.dropped_samples, 1, memory_order_relaxed);
+        }
+    }
+
+    atomic_fetch_add_explicit(&s->counters.samples, (unsigned long)count, memory_order_relaxed);
+    if (unknown > 0) {
+        atomic_fetch_add_explicit(&s->counters.unknown_samples, unknown, memory_order_relaxed);
+    }
+}
+
+static void *receiver_main(void *arg) {
+    IngestServer *s = (IngestServer *)arg;
+    struct mmsghdr msgs[INGEST_RECV_BATCH];
+    struct iovec iovs[INGEST_RECV_BATCH];
+    struct pollfd fds[2] = {
+        { .fd = s->fd, .events = POLLIN },
+        { .fd = s->wake_fd, .events = POLLIN },
+    };
+
+    memset(msgs, 0, sizeof(msgs));
+    for (int i = 0; i < INGEST_RECV_BATCH; i++) {
+        iovs[i].iov_base = s->recv_buffers + (size_t)i * INGEST_MAX_FRAME;
+        iovs[i].iov_len = INGEST_MAX_FRAME;
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    while (!atomic_load(&s->stopping)) {
+        if (poll(fds, 2, -1) < 0 && errno != EINTR) {
+            perror("poll");
+            break;
+        }
+
+        // 一次读取多个数据报，读空后把各工作线程的待发批次写入队列
+        for (;;) {
+            int n = recvmmsg(s->fd, msgs, INGEST_RECV_BATCH, MSG_DONTWAIT, NULL);
+            if (n <= 0) {
+                break;
+            }
+            for (int i = 0; i < n; i++) {
+                handle_frame(s, (const char *)iovs[i].iov_base, msgs[i].msg_len);
+            }
+            if (n < INGEST_RECV_BATCH) {
+                break;
+            }
+        }
+        for (int w = 0; w < s->worker_count; w++) {
+            publish_worker(s, &s->workers[w]);
+        }
+    }
+
+    atomic_store(&s->receiver_done, true);
+    for (int w = 0; w < s->worker_count; w++) {
+        spsc_ring_wake(&s->workers[w].ring);
+    }
+    return NULL;
+}
+
+// 把工作线程本批次的告警事件按日志格式整块追加
+static void log_worker_alerts(IngestServer *s, IngestWorker *w) {
+    AnomalyDetector *d = &w->detector;
+    char chunk[8192];
+    size_t used = 0;
+
+    for (int i = 0; i < w->alerts.event_count; i++) {
+        const AlertEvent *event = &w->alerts.events[i];
+
+        // 日志写入器的时间戳缓存不能跨线程共用，每个工作线程各自缓存
+        if (event->timestamp != w->cached_second || w->cached_time[0] == '\0') {
+            struct tm tm_info;
+            localtime_r(&event->timestamp, &tm_info);
+            strftime(w->cached_time, sizeof(w->cached_time), "%Y-%m-%d %H:%M:%S", &tm_info);
+            w->cached_second = event->timestamp;
+        }
+
+        char line[1024];
+        const Metric *metric = &d->metrics[event->metric_id];
+        if (s->alert_log_enabled) {
+            alert_log_append(&s->alert_log, event, metric->name, metric->description);
+        }
+        int len = alert_event_format(event, w->cached_time, metric->name, metric->description, NULL,
+                                     line, sizeof(line));
+        if (len < 0) {
+            continue;
+        }
+
+        if (used + (size_t)len > sizeof(chunk)) {
+            log_writer_append(&s->log, chunk, used);
+            used = 0;
+        }
+        memcpy(chunk + used, line, (size_t)len);
+        used += (size_t)len;
+    }
+
+    if (used > 0) {
+        log_writer_append(&s->log, chunk, used);
+    }
+}
+
+// 应用一个批次，只检测本批次写入样本的指标
+static void detect_batch(IngestServer *s, IngestWorker *w, const SampleBatch *batch) {
+    AnomalyDetector *d = &w->detector;
+    uint64_t start_ns = monotonic_ns();
+    apply_sample_batch(d, batch);
+    start_ns = latency_record(LATENCY_APPLY, start_ns);
+
+    for (int i = 0; i < batch->sample_count; i++) {
+        int series = batch->samples[i].series;
+        int id = series < d->series_capacity ? d->series_metrics[series] : -1;
+        if (id >= 0) {
+            // 每个样本的判定立即并入该指标的告警状态
+            int first = d->anomalies.count;
+            detect_metric_anomalies(d, id);
+            alert_tracker_observe(&w->alerts, d, id, first, d->metrics[id].timestamp_ns);
+        }
+    }
+    start_ns = latency_record(LATENCY_DETECT, start_ns);
+    atomic_fetch_add_explicit(&s->counters.detected_samples, (unsigned long)batch->sample_count,
+                              memory_order_relaxed);
+
+    if (d->anomalies.count > 0) {
+        atomic_fetch_add_explicit(&s->counters.anomalies, (unsigned long)d->anomalies.count,
+                                  memory_order_relaxed);
+        anomaly_arena_reset(&d->anomalies);
+    }
+    if (w->alerts.event_count > 0) {
+        log_worker_alerts(s, w);
+        latency_record(LATENCY_LOG, start_ns);
+        for (int i = 0; i < w->alerts.event_count; i++) {
+            if (w->alerts.events[i].kind == ALERT_EVENT_FIRING) {
+                atomic_fetch_add_explicit(&s->counters.alerts, 1, memory_order_relaxed);
+            }
+        }
+        alert_tracker_clear_events(&w->alerts);
+    }
+}
+
+static void *worker_main(void *arg) {
+    IngestWorker *w = (IngestWorker *)arg;
+    IngestServer *s = w->server;
+
+    for (;;) {
+        SampleBatch *batch = (SampleBatch *)spsc_ring_wait(&w->ring);
+        if (!batch) {
+            // 接收线程退出后排空队列再退出
+            if (atomic_load(&s->receiver_done) && !spsc_ring_peek(&w->ring)) {
+                break;
+            }
+            continue;
+        }
+        detect_batch(s, w, batch);
+        spsc_ring_release(&w->ring);
+    }
+    return NULL;
+}
+
+// 创建、绑定监听套接字
+static int open_socket(IngestServer *s) {
+    IngestAddress addr;
+    if (ingest_parse_address(s->config.address, &addr) != 0) {
+        fprintf(stderr, "错误: 无效的监听地址 %s\n", s->config.address);
+        return -1;
+    }
+
+    s->fd = socket(addr.family, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (s->fd < 0) {
+        perror("socket");
+        return -1;
+    }
+
+    if (addr.family == AF_UNIX) {
+        // 清理上次运行留下的套接字文件
+        const char *path = ((struct sockaddr_un *)&addr.addr)->sun_path;
+        struct stat st;
+        if (stat(path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+            unlink(path);
+        }
+    }
+    if (bind(s->fd, (struct sockaddr *)&addr.addr, addr.len) != 0) {
+        fprintf(stderr, "错误: 无法绑定 %s: %s\n", s->config.address, strerror(errno));
+        return -1;
+    }
+
+    // 突发流量先进入内核缓冲区；有CAP_NET_ADMIN时可以超过rmem_max
+    int size = INGEST_RECV_BUFFER;
+    if (setsockopt(s->fd, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size)) != 0) {
+        setsockopt(s->fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    }
+    return 0;
+}
+
+// 释放服务端的全部资源（线程已回收或未启动）
+static void ingest_server_free(IngestServer *s) {
+    for (int i = 0; s->workers && i < s->worker_count; i++) {
+        IngestWorker *w = &s->workers[i];
+        if (w->ring.slots) {
+            for (unsigned long j = 0; j < spsc_ring_capacity(&w->ring); j++) {
+                sample_batch_free((SampleBatch *)spsc_ring_slot(&w->ring, j));
+            }
+            spsc_ring_free(&w->ring);
+        }
+        sample_batch_free(&w->pending);
+        free_detector(&w->detector);
+        alert_tracker_free(&w->alerts);
+    }
+    free(s->workers);
+    s->workers = NULL;
+    free(s->keys);
+    s->keys = NULL;
+    free(s->recv_buffers);
+    s->recv_buffers = NULL;
+    log_writer_close(&s->log);
+    if (s->alert_log_enabled) {
+        alert_log_close(&s->alert_log);
+        s->alert_log_enabled = false;
+    }
+
+    if (s->fd >= 0) {
+        IngestAddress addr;
+        if (ingest_parse_address(s->config.address, &addr) == 0 && addr.family == AF_UNIX) {
+            unlink(((struct sockaddr_un *)&addr.addr)->sun_path);
+        }
+        close(s->fd);
+        s->fd = -1;
+    }
+    if (s->wake_fd >= 0) {
+        close(s->wake_fd);
+        s->wake_fd = -1;
+    }
+}
+
+// 初始化一个工作线程的检测器和队列
+static int init_worker(IngestServer *s, IngestWorker *w, int index) {
+    const IngestServerConfig *config = &s->config;
+    w->server = s;
+    w->index = index;
+    sample_batch_init(&w->pending);
+
+    // 队列槽位由calloc清零，即已初始化的空批次
+    if (init_detector(&w->detector, config->window_size, config->sigma_factor) != 0 ||
+        alert_tracker_init(&w->alerts, config->alert_pending_ns, config->alert_resolve_ns,
+                           ALERT_HYSTERESIS) != 0 ||
+        spsc_ring_init(&w->ring, config->queue_depth, sizeof(SampleBatch)) != 0) {
+        return -1;
+    }
+
+    // 样本时间戳已是Unix纪元时间
+    set_detector_clock(&w->detector, 0);
+    if (config->season_ns > 0) {
+        w->detector.forecast_params.season_ns = config->season_ns;
+    }
+    for (int kind = DETECTOR_NSIGMA + 1; kind < DETECTOR_COUNT; kind++) {
+        if (set_detector_metrics(&w->detector, (DetectorKind)kind, config->detector_metrics[kind]) != 0) {
+            return -1;
+        }
+    }
+    return set_metric_settings(&w->detector, config->settings, config->setting_count);
+}
+
+// 停止已启动的工作线程（接收线程未启动或已退出）
+static void stop_workers(IngestServer *s, int started) {
+    atomic_store(&s->receiver_done, true);
+    for (int i = 0; i < started; i++) {
+        spsc_ring_wake(&s->workers[i].ring);
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(s->workers[i].thread, NULL);
+    }
+}
+
+int ingest_server_start(IngestServer *server, const IngestServerConfig *config) {
+    if (!server || !config || !config->address || config->queue_depth == 0) {
+        return -1;
+    }
+
+    IngestServer *s = server;
+    memset(s, 0, sizeof(*s));
+    s->config = *config;
+    s->fd = -1;
+    s->wake_fd = -1;
+
+    s->worker_count = config->workers;
+    if (s->worker_count <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        s->worker_count = cpus > 0 ? (int)cpus : 1;
+    }
+
+    s->key_mask = 1023;
+    s->keys = (IngestKeySlot *)calloc(s->key_mask + 1, sizeof(IngestKeySlot));
+    s->recv_buffers = (char *)malloc((size_t)INGEST_RECV_BATCH * INGEST_MAX_FRAME);
+    s->workers = (IngestWorker *)calloc((size_t)s->worker_count, sizeof(IngestWorker));
+    if (!s->keys || !s->recv_buffers || !s->workers) {
+        ingest_server_free(s);
+        return -1;
+    }
+    for (int i = 0; i < s->worker_count; i++) {
+        if (init_worker(s, &s->workers[i], i) != 0) {
+            ingest_server_free(s);
+            return -1;
+        }
+    }
+
+    if (log_writer_open(&s->log, config->log_file, NULL) != 0) {
+        fprintf(stderr, "错误: 无法打开日志文件 %s\n", config->log_file);
+        ingest_server_free(s);
+        return -1;
+    }
+    if (config->alert_log_file) {
+        if (alert_log_open(&s->alert_log, config->alert_log_file) != 0) {
+            fprintf(stderr, "错误: 无法打开告警日志文件 %s\n", config->alert_log_file);
+            ingest_server_free(s);
+            return -1;
+        }
+        s->alert_log_enabled = true;
+    }
+
+    s->wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (s->wake_fd < 0 || open_socket(s) != 0) {
+        ingest_server_free(s);
+        return -1;
+    }
+
+    for (int i = 0; i < s->worker_count; i++) {
+        if (pthread_create(&s->workers[i].thread, NULL, worker_main, &s->workers[i]) != 0) {
+            stop_workers(s, i);
+            ingest_server_free(s);
+            return -1;
+        }
+    }
+    if (pthread_create(&s->receiver_thread, NULL, receiver_main, s) != 0) {
+        stop_workers(s, s->worker_count);
+        ingest_server_free(s);
+        return -1;
+    }
+    return 0;
+}
+
+void ingest_server_stop(IngestServer *server) {
+    if (!server) {
+        return;
+    }
+
+    IngestServer *s = server;
+
+    // 唤醒阻塞在poll上的接收线程，它退出时唤醒各工作线程排空队列
+    atomic_store(&s->stopping, true);
+    uint64_t one = 1;
+    if (write(s->wake_fd, &one, sizeof(one)) < 0) {
+        // eventfd计数溢出时接收线程已处于唤醒状态
+    }
+    pthread_join(s->receiver_thread, NULL);
+    for (int i = 0; i < s->worker_count; i++) {
+        pthread_join(s->workers[i].thread, NULL);
+    }
+
+    ingest_server_free(s);
+}
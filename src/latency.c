@@ -0,0 +1,145 @@
+#include "../include/latency.h"
+#include "../include/scheduler.h"
+#include <string.h>
+
+// 各阶段的直方图，记录方可以是任意线程
+static LatencyHistogram histograms[LATENCY_STAGE_COUNT];
+
+static const char *const stage_names[LATENCY_STAGE_COUNT] = {
+    [LATENCY_PROC_STAT] = "proc_stat",
+    [LATENCY_PROC_MEMINFO] = "proc_meminfo",
+    [LATENCY_PROC_DISKSTATS] = "proc_diskstats",
+    [LATENCY_PROC_NETDEV] = "proc_netdev",
+    [LATENCY_READ_CPU] = "read_cpu",
+    [LATENCY_READ_MEM] = "read_mem",
+    [LATENCY_READ_DISK] = "read_disk",
+    [LATENCY_READ_NET] = "read_net",
+    [LATENCY_READ_PROCESS] = "read_process",
+    [LATENCY_COLLECT] = "collect",
+    [LATENCY_APPLY] = "apply",
+    [LATENCY_SERIES] = "series_append",
+    [LATENCY_DETECT_NSIGMA] = "detect_nsigma",
+    [LATENCY_DETECT_MAD] = "detect_mad",
+    [LATENCY_DETECT_FORECAST] = "detect_forecast",
+    [LATENCY_DETECT_THRESHOLD] = "detect_threshold",
+    [LATENCY_DETECT_CORRELATION] = "detect_correlation",
+    [LATENCY_ALERT] = "alert",
+    [LATENCY_DETECT] = "detect",
+    [LATENCY_PRINT] = "print",
+    [LATENCY_LOG] = "log",
+    [LATENCY_EXPOSITION] = "exposition",
+    [LATENCY_END_TO_END] = "end_to_end",
+};
+
+// 耗时所在的桶：最高位决定2的幂区间，其后3位决定区间内的桶
+static inline int bucket_index(uint64_t ns) {
+    if (ns < LATENCY_SUB_BUCKETS) {
+        return (int)ns;
+    }
+    int e = 63 - __builtin_clzll(ns);
+    return (e - LATENCY_SUB_BITS + 1) * LATENCY_SUB_BUCKETS +
+           (int)((ns >> (e - LATENCY_SUB_BITS)) & (LATENCY_SUB_BUCKETS - 1));
+}
+
+// 桶中最大的值
+static uint64_t bucket_upper(int index) {
+    if (index < LATENCY_SUB_BUCKETS) {
+        return (uint64_t)index;
+    }
+    int shift = index / LATENCY_SUB_BUCKETS - 1;
+    uint64_t lower = (uint64_t)(LATENCY_SUB_BUCKETS + index % LATENCY_SUB_BUCKETS) << shift;
+    return lower + ((1ULL << shift) - 1);
+}
+
+void latency_add(LatencyStage stage, uint64_t elapsed_ns) {
+    if ((unsigned)stage >= LATENCY_STAGE_COUNT) {
+        return;
+    }
+
+    LatencyHistogram *h = &histograms[stage];
+    atomic_fetch_add_explicit(&h->buckets[bucket_index(elapsed_ns)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->sum_ns, elapsed_ns, memory_order_relaxed);
+
+    unsigned long max = atomic_load_explicit(&h->max_ns, memory_order_relaxed);
+    while (elapsed_ns > max &&
+           !atomic_compare_exchange_weak_explicit(&h->max_ns, &max, elapsed_ns,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+uint64_t latency_record(LatencyStage stage, uint64_t start_ns) {
+    uint64_t now = monotonic_ns();
+    latency_add(stage, now > start_ns ? now - start_ns : 0);
+    return now;
+}
+
+void latency_summarize(LatencyStage stage, LatencySummary *summary) {
+    memset(summary, 0, sizeof(*summary));
+    if ((unsigned)stage >= LATENCY_STAGE_COUNT) {
+        return;
+    }
+
+    // 先复制桶计数，分位数以复制时的总数为准，不受并发记录影响
+    const LatencyHistogram *h = &histograms[stage];
+    static _Thread_local unsigned long counts[LATENCY_BUCKETS];
+    unsigned long total = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        counts[i] = atomic_load_explicit(&h->buckets[i], memory_order_relaxed);
+        total += counts[i];
+    }
+    if (total == 0) {
+        return;
+    }
+
+    summary->count = total;
+    summary->sum_ns = atomic_load_explicit(&h->sum_ns, memory_order_relaxed);
+    summary->max_ns = atomic_load_explicit(&h->max_ns, memory_order_relaxed);
+    summary->mean_ns = (double)summary->sum_ns / (double)total;
+
+    static const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+    uint64_t *results[] = { &summary->p50_ns, &summary->p90_ns, &summary->p99_ns, &summary->p999_ns };
+    unsigned long seen = 0;
+    int q = 0;
+    for (int i = 0; i < LATENCY_BUCKETS && q < 4; i++) {
+        seen += counts[i];
+        while (q < 4 && (double)seen >= quantiles[q] * (double)total) {
+            uint64_t upper = bucket_upper(i);
+            *results[q++] = upper < summary->max_ns ? upper : summary->max_ns;
+        }
+    }
+}
+
+const char *latency_stage_name(LatencyStage stage) {
+    if ((unsigned)stage >= LATENCY_STAGE_COUNT) {
+        return "unknown";
+    }
+    return stage_names[stage];
+}
+
+void latency_dump(FILE *out) {
+    fprintf(out, "各阶段耗时（微秒）:\n");
+    // 中文标题按显示宽度手工对齐
+    fprintf(out, "阶段                     次数       平均        p50        p90        p99      p99.9       最大\n");
+    for (int i = 0; i < LATENCY_STAGE_COUNT; i++) {
+        LatencySummary s;
+        latency_summarize((LatencyStage)i, &s);
+        if (s.count == 0) {
+            continue;
+        }
+        fprintf(out, "%-18s %10lu %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+                stage_names[i], s.count, s.mean_ns / 1e3, s.p50_ns / 1e3, s.p90_ns / 1e3,
+                s.p99_ns / 1e3, s.p999_ns / 1e3, s.max_ns / 1e3);
+    }
+    fflush(out);
+}
+
+void latency_reset(void) {
+    for (int i = 0; i < LATENCY_STAGE_COUNT; i++) {
+        LatencyHistogram *h = &histograms[i];
+        for (int b = 0; b < LATENCY_BUCKETS; b++) {
+            atomic_store_explicit(&h->buckets[b], 0, memory_order_relaxed);
+        }
+        atomic_store_explicit(&h->sum_ns, 0, memory_order_relaxed);
+        atomic_store_explicit(&h->max_ns, 0, memory_order_relaxed);
+    }
+}
@@ -0,0 +1,269 @@
+#include "../include/log_writer.h"
+#include "../include/config.h"
+#include "../include/scheduler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+void log_writer_default_config(LogWriterConfig *config) {
+    config->buffer_size = LOG_BUFFER_SIZE;
+    config->flush_interval_ms = LOG_FLUSH_INTERVAL_MS;
+    config->rotate_bytes = LOG_ROTATE_BYTES;
+    config->rotate_age_sec = LOG_ROTATE_AGE_SEC;
+    config->rotate_keep = LOG_ROTATE_KEEP;
+}
+
+// 打开（或重新打开）日志文件，大小从已有文件继承
+static int open_log_file(LogWriter *writer) {
+    writer->fd = open(writer->path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (writer->fd < 0) {
+        return -1;
+    }
+
+    struct stat st;
+    writer->file_bytes = fstat(writer->fd, &st) == 0 ? (uint64_t)st.st_size : 0;
+    writer->file_opened = time(NULL);
+    return 0;
+}
+
+// 轮转：path.N-1 -> path.N, ..., path -> path.1，然后打开新文件
+static void rotate_log_file(LogWriter *writer) {
+    char from[300], to[300];
+
+    for (int i = writer->config.rotate_keep; i > 1; i--) {
+        snprintf(from, sizeof(from), "%s.%d", writer->path, i - 1);
+        snprintf(to, sizeof(to), "%s.%d", writer->path, i);
+        rename(from, to);
+    }
+    if (writer->config.rotate_keep > 0) {
+        snprintf(to, sizeof(to), "%s.1", writer->path);
+        rename(writer->path, to);
+    } else {
+        unlink(writer->path);
+    }
+
+    close(writer->fd);
+    if (open_log_file(writer) != 0) {
+        writer->write_errors++;
+    }
+    writer->rotations++;
+}
+
+static bool should_rotate(const LogWriter *writer, size_t pending) {
+    if (writer->file_bytes == 0) {
+        return false;
+    }
+    if (writer->config.rotate_bytes > 0 &&
+        writer->file_bytes + pending > writer->config.rotate_bytes) {
+        return true;
+    }
+    return writer->config.rotate_age_sec > 0 &&
+           time(NULL) - writer->file_opened >= (time_t)writer->config.rotate_age_sec;
+}
+
+// 写出整块数据，处理部分写入和信号中断
+static int write_all(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+// 计算条件变量等待的绝对超时（单调时钟）
+static struct timespec deadline_after_ms(unsigned int ms) {
+    uint64_t deadline = monotonic_ns() + (uint64_t)ms * NSEC_PER_MSEC;
+    struct timespec ts;
+    ts.tv_sec = (time_t)(deadline / NSEC_PER_SEC);
+    ts.tv_nsec = (long)(deadline % NSEC_PER_SEC);
+    return ts;
+}
+
+static void *flush_main(void *arg) {
+    LogWriter *writer = (LogWriter *)arg;
+    size_t threshold = writer->config.buffer_size / 2;
+
+    pthread_mutex_lock(&writer->lock);
+    for (;;) {
+        // 未达到大小阈值时最多等待一个刷新间隔
+        if (!writer->closing && !writer->flush_requested && writer->active_len < threshold) {
+            struct timespec ts = deadline_after_ms(writer->config.flush_interval_ms);
+            pthread_cond_timedwait(&writer->flush_cond, &writer->lock, &ts);
+        }
+
+        if (writer->active_len == 0) {
+            writer->flush_requested = false;
+            if (writer->closing) {
+                break;
+            }
+            continue;
+        }
+
+        // 交换缓冲区，写文件时不持有锁
+        char *block = writer->active;
+        size_t len = writer->active_len;
+        writer->active = writer->spare;
+        writer->active_len = 0;
+        writer->spare = NULL;
+        writer->flush_requested = false;
+        pthread_cond_broadcast(&writer->space_cond);
+        pthread_mutex_unlock(&writer->lock);
+
+        if (writer->fd < 0) {
+            open_log_file(writer);
+        } else if (should_rotate(writer, len)) {
+            rotate_log_file(writer);
+        }
+        bool failed = writer->fd < 0 || write_all(writer->fd, block, len) != 0;
+        if (!failed) {
+            writer->file_bytes += len;
+        }
+
+        pthread_mutex_lock(&writer->lock);
+        if (failed) {
+            writer->write_errors++;
+        }
+        writer->spare = block;
+        writer->written += len;
+        pthread_cond_broadcast(&writer->space_cond);
+    }
+    pthread_mutex_unlock(&writer->lock);
+    return NULL;
+}
+
+int log_writer_open(LogWriter *writer, const char *path, const LogWriterConfig *config) {
+    if (!writer || !path || strlen(path) >= sizeof(writer->path)) {
+        return -1;
+    }
+
+    memset(writer, 0, sizeof(*writer));
+    if (config) {
+        writer->config = *config;
+    } else {
+        log_writer_default_config(&writer->config);
+    }
+    if (writer->config.buffer_size == 0 || writer->config.flush_interval_ms == 0) {
+        return -1;
+    }
+    strcpy(writer->path, path);
+    writer->cached_second = (time_t)-1;
+
+    if (open_log_file(writer) != 0) {
+        return -1;
+    }
+
+    writer->active = (char *)malloc(writer->config.buffer_size);
+    writer->spare = (char *)malloc(writer->config.buffer_size);
+    if (!writer->active || !writer->spare) {
+        free(writer->active);
+        free(writer->spare);
+        close(writer->fd);
+        return -1;
+    }
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&writer->lock, NULL);
+    pthread_cond_init(&writer->flush_cond, &attr);
+    pthread_cond_init(&writer->space_cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    if (pthread_create(&writer->thread, NULL, flush_main, writer) != 0) {
+        pthread_cond_destroy(&writer->flush_cond);
+        pthread_cond_destroy(&writer->space_cond);
+        pthread_mutex_destroy(&writer->lock);
+        free(writer->active);
+        free(writer->spare);
+        close(writer->fd);
+        return -1;
+    }
+    writer->running = true;
+    return 0;
+}
+
+int log_writer_append(LogWriter *writer, const char *data, size_t len) {
+    if (!writer || !data || len > writer->config.buffer_size) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&writer->lock);
+
+    // 当前缓冲区放不下时请求刷新，等待后台线程交换缓冲区
+    while (writer->active_len + len > writer->config.buffer_size) {
+        writer->flush_requested = true;
+        pthread_cond_signal(&writer->flush_cond);
+        pthread_cond_wait(&writer->space_cond, &writer->lock);
+    }
+
+    memcpy(writer->active + writer->active_len, data, len);
+    writer->active_len += len;
+    writer->appended += len;
+    if (writer->active_len >= writer->config.buffer_size / 2) {
+        pthread_cond_signal(&writer->flush_cond);
+    }
+
+    pthread_mutex_unlock(&writer->lock);
+    return 0;
+}
+
+const char *log_writer_time(LogWriter *writer, time_t timestamp) {
+    if (timestamp != writer->cached_second) {
+        struct tm tm_info;
+        localtime_r(&timestamp, &tm_info);
+        strftime(writer->cached_time, sizeof(writer->cached_time), "%Y-%m-%d %H:%M:%S", &tm_info);
+        writer->cached_second = timestamp;
+    }
+    return writer->cached_time;
+}
+
+void log_writer_flush(LogWriter *writer) {
+    if (!writer) {
+        return;
+    }
+
+    pthread_mutex_lock(&writer->lock);
+    uint64_t target = writer->appended;
+    while (writer->written < target) {
+        writer->flush_requested = true;
+        pthread_cond_signal(&writer->flush_cond);
+        pthread_cond_wait(&writer->space_cond, &writer->lock);
+    }
+    pthread_mutex_unlock(&writer->lock);
+}
+
+void log_writer_close(LogWriter *writer) {
+    // active会被后台线程交换，不能用来判断是否已打开
+    if (!writer || !writer->running) {
+        return;
+    }
+
+    pthread_mutex_lock(&writer->lock);
+    writer->closing = true;
+    pthread_cond_signal(&writer->flush_cond);
+    pthread_mutex_unlock(&writer->lock);
+    pthread_join(writer->thread, NULL);
+
+    pthread_cond_destroy(&writer->flush_cond);
+    pthread_cond_destroy(&writer->space_cond);
+    pthread_mutex_destroy(&writer->lock);
+    free(writer->active);
+    free(writer->spare);
+    writer->active = writer->spare = NULL;
+    writer->running = false;
+    if (writer->fd >= 0) {
+        close(writer->fd);
+        writer->fd = -1;
+    }
+}
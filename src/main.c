@@ -1,52 +1,270 @@
 #include "../include/anomaly_detection.h"
 #include "../include/metrics_collector.h"
 #include "../include/config.h"
+#include "../include/scheduler.h"
+#include "../include/pipeline.h"
+#include "../include/replay.h"
+#include "../include/ingest_server.h"
+#include "../include/latency.h"
+#include "../include/runtime_config.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <signal.h>
 #include <stdbool.h>
-
-// 全局变量，用于信号处理
-static volatile bool running = true;
-
-// 信号处理函数
-void signal_handler(int sig) {
-    printf("接收到信号 %d，准备退出...\n", sig);
-    running = false;
-}
+#include <errno.h>
 
 void print_help() {
     printf("操作系统指标异常检测系统\n");
     printf("用法: anomaly_detection [选项]\n");
     printf("选项:\n");
     printf("  -h            显示帮助信息\n");
-    printf("  -i <秒>       设置采样间隔（默认: %d秒）\n", DEFAULT_SAMPLING_INTERVAL);
+    printf("  -i <间隔>     设置采样间隔，如5、0.5、100ms（默认: %d秒，最小: %dms）\n",
+           DEFAULT_SAMPLING_INTERVAL, MIN_SAMPLING_INTERVAL_MS);
     printf("  -w <数量>     设置滑动窗口大小（默认: %d个数据点）\n", DEFAULT_WINDOW_SIZE);
     printf("  -s <因子>     设置N-Sigma因子（默认: %.1f）\n", DEFAULT_SIGMA_FACTOR);
     printf("  -l <文件>     设置日志文件路径（默认: %s）\n", LOG_FILE_PATH);
-    printf("  -d <设备>     设置磁盘设备名（默认: %s）\n", DEFAULT_DISK_DEVICE);
-    printf("  -n <接口>     设置网络接口名（默认: %s）\n", DEFAULT_NET_INTERFACE);
+    printf("  -A <文件>     同时写入带索引的结构化告警日志，可用alert_query查询（默认: 不写入）\n");
+    printf("  -d <设备>     设置磁盘设备名，多个用逗号分隔（默认: 自动发现全部整盘设备）\n");
+    printf("  -n <接口>     设置网络接口名，多个用逗号分隔（默认: 自动发现全部接口）\n");
+    printf("  -M <列表>     使用中位数/MAD检测的指标，逗号分隔的种类名或完整指标名，all表示全部\n");
+    printf("  -E <列表>     使用EWMA预测检测的指标，格式同-M\n");
+    printf("  -H <列表>     使用Holt-Winters季节预测检测的指标，格式同-M\n");
+    printf("  -X <组>       多维相关（马氏距离）检测的指标组，组内格式同-M，多个组用分号分隔，\n");
+    printf("                如cpu_iowait,disk_write_await（最多%d个成员）\n", CORRELATION_MAX_MEMBERS);
+    printf("  -P <周期>     设置Holt-Winters季节周期，如1d、7d、12h（默认: %d秒）\n", FORECAST_SEASON_SEC);
+    printf("  -C <文件>     设置预测模型检查点文件，none表示不保存（默认: %s）\n", FORECAST_CHECKPOINT_PATH);
+    printf("  -S <文件>     设置指标时间序列文件，none表示不持久化（默认: %s）\n", SERIES_FILE_PATH);
+    printf("  -R <文件>     离线回放序列文件或CSV，全速运行检测后退出\n");
+    printf("  -q            回放时不逐条输出异常，只打印统计\n");
+    printf("  -L <地址>     以汇聚服务端运行，接收多台主机上报的样本，如udp:0.0.0.0:9125、unix:/run/ad.sock\n");
+    printf("  -W <数量>     汇聚服务端的工作线程数（默认: 在线CPU数）\n");
+    printf("  -j <数量>     并行读取数据源的工作线程数，0表示在采集线程中依次读取（默认: %d）\n",
+           COLLECT_WORKERS);
+    printf("  -T <数量>     进程占用排行的进程数，0表示不采集进程；采集时把打开文件数软限制\n"
+           "                提高到硬限制（默认: %d，最大%d）\n",
+           PROCESS_TOP_K, PROCESS_TOP_MAX);
+    printf("  -m <地址>     在本机启用Prometheus指标端点，端口号或<IPv4地址>:<端口>，如9464\n");
+    printf("  -F <时长>     告警触发前需要持续异常的时长，如30s、2m，0表示首次异常即触发（默认: %d秒）\n",
+           ALERT_PENDING_SEC);
+    printf("  -K <时长>     告警恢复前需要持续正常的时长，0表示首个正常周期即恢复（默认: %d秒）\n",
+           ALERT_RESOLVE_SEC);
+    printf("  -B <间隔>     资源压力（PSI）超过阈值时的突发采样间隔，off表示不使用（默认: %dms）\n",
+           BURST_INTERVAL_MS);
+    printf("  -c <文件>     读取运行时配置文件，覆盖-s、-d、-n、-M、-E、-H、-X并可按指标设置阈值，\n");
+    printf("                实时运行时收到SIGHUP重新加载\n");
+}
+
+// 离线回放：不采集、不启动线程，使用与实时运行相同的检测设置，不读写检查点
+static int run_replay(const char *path, const PipelineConfig *config, bool quiet) {
+    AnomalyDetector detector;
+    const RuntimeConfig *runtime = config->runtime;
+    if (init_detector(&detector, config->window_size, runtime->sigma_factor) != 0) {
+        fprintf(stderr, "错误: 无法初始化异常检测器\n");
+        return 1;
+    }
+    if (config->season_ns > 0) {
+        detector.forecast_params.season_ns = config->season_ns;
+    }
+    for (int kind = DETECTOR_NSIGMA + 1; kind < DETECTOR_COUNT; kind++) {
+        if (set_detector_metrics(&detector, (DetectorKind)kind, runtime->detector_metrics[kind]) != 0) {
+            fprintf(stderr, "错误: 无法设置检测器\n");
+            free_detector(&detector);
+            return 1;
+        }
+    }
+    if (set_metric_settings(&detector, runtime->settings, runtime->setting_count) != 0 ||
+        set_correlation_groups(&detector, runtime->correlation_groups) != 0) {
+        fprintf(stderr, "错误: 无法设置检测器\n");
+        free_detector(&detector);
+        return 1;
+    }
+
+    ReplayStats stats;
+    int ret = replay_file(path, &detector, quiet ? NULL : stdout, &stats);
+    if (ret != 0) {
+        fprintf(stderr, "错误: 无法回放文件 %s\n", path);
+    }
+    if (stats.rows > 0) {
+        print_replay_summary(&detector, &stats);
+    }
+
+    replay_stats_free(&stats);
+    free_detector(&detector);
+    return ret != 0 ? 1 : 0;
+}
+
+// 打印汇聚服务端一个统计间隔内的吞吐
+static void report_ingest(IngestServer *server, unsigned long *last_samples,
+                          unsigned long *last_detected, double elapsed) {
+    IngestCounters *c = &server->counters;
+    unsigned long samples = atomic_load(&c->samples);
+    unsigned long detected = atomic_load(&c->detected_samples);
+    printf("序列: %lu, 接收: %.0f 样本/秒, 检测: %.0f 样本/秒, 未知样本: %lu, 丢弃样本: %lu, "
+           "错误帧: %lu, 异常: %lu, 告警: %lu\n",
+           atomic_load(&c->series), (samples - *last_samples) / elapsed,
+           (detected - *last_detected) / elapsed, atomic_load(&c->unknown_samples),
+           atomic_load(&c->dropped_samples), atomic_load(&c->bad_frames), atomic_load(&c->anomalies),
+           atomic_load(&c->alerts));
+    fflush(stdout);
+    *last_samples = samples;
+    *last_detected = detected;
+}
+
+// 汇聚服务端：接收多台主机上报的样本，按序列分片到各工作线程检测，直到收到退出信号
+static int run_server(const char *address, int workers, const PipelineConfig *config,
+                      const sigset_t *signals) {
+    const RuntimeConfig *runtime = config->runtime;
+    IngestServerConfig server_config = {
+        .address = address,
+        .workers = workers,
+        .window_size = config->window_size,
+        .sigma_factor = runtime->sigma_factor,
+        .log_file = config->log_file,
+        .alert_log_file = config->alert_log_file,
+        .settings = runtime->settings,
+        .setting_count = runtime->setting_count,
+        .season_ns = config->season_ns,
+        .alert_pending_ns = config->alert_pending_ns,
+        .alert_resolve_ns = config->alert_resolve_ns,
+        .queue_depth = INGEST_QUEUE_DEPTH,
+    };
+    for (int kind = 0; kind < DETECTOR_COUNT; kind++) {
+        server_config.detector_metrics[kind] = runtime->detector_metrics[kind];
+    }
+
+    static IngestServer server;
+    if (ingest_server_start(&server, &server_config) != 0) {
+        fprintf(stderr, "错误: 无法启动汇聚服务端\n");
+        return 1;
+    }
+
+    printf("汇聚服务端启动\n");
+    printf("监听地址: %s\n", address);
+    printf("工作线程: %d\n", server.worker_count);
+    printf("滑动窗口大小: %d个数据点\n", config->window_size);
+    printf("N-Sigma因子: %.1f\n", runtime->sigma_factor);
+    printf("日志文件: %s\n", config->log_file);
+    printf("告警日志: %s\n", config->alert_log_file ? config->alert_log_file : "不写入");
+    if (runtime->correlation_groups) {
+        // 各序列的样本逐个到达、分片到不同的工作线程，没有同一周期的样本向量
+        fprintf(stderr, "警告: 汇聚服务端不支持多维相关检测，忽略指标组 %s\n", runtime->correlation_groups);
+    }
+    printf("按Ctrl+C退出\n\n");
+    fflush(stdout);
+
+    // 等待退出信号，每隔INGEST_REPORT_SEC秒打印吞吐
+    unsigned long last_samples = 0;
+    unsigned long last_detected = 0;
+    uint64_t started = monotonic_ns();
+    uint64_t last = started;
+    int sig;
+    for (;;) {
+        struct timespec timeout = { .tv_sec = INGEST_REPORT_SEC, .tv_nsec = 0 };
+        sig = sigtimedwait(signals, NULL, &timeout);
+        if (sig == SIGUSR1) {
+            latency_dump(stderr);
+            continue;
+        }
+        if (sig == SIGHUP) {
+            fprintf(stderr, "警告: 汇聚服务端不支持重新加载配置，忽略SIGHUP\n");
+            continue;
+        }
+        if (sig > 0) {
+            break;
+        }
+        if (sig < 0 && errno == EAGAIN) {
+            uint64_t now = monotonic_ns();
+            report_ingest(&server, &last_samples, &last_detected, (double)(now - last) / NSEC_PER_SEC);
+            last = now;
+        }
+    }
+    printf("接收到信号 %d，准备退出...\n", sig);
+
+    ingest_server_stop(&server);
+    printf("共接收 %lu 帧、%lu 个样本，检测 %lu 个样本，耗时 %.1f秒\n",
+           atomic_load(&server.counters.frames), atomic_load(&server.counters.samples),
+           atomic_load(&server.counters.detected_samples),
+           (double)(monotonic_ns() - started) / NSEC_PER_SEC);
+    return 0;
+}
+
+// 在命令行参数上覆盖配置文件（path为NULL时只复制），错误已打印到标准错误
+static RuntimeConfig *load_runtime_config(const RuntimeConfig *base, const char *path) {
+    RuntimeConfig *runtime = runtime_config_clone(base);
+    if (!runtime) {
+        fprintf(stderr, "错误: 内存不足\n");
+        return NULL;
+    }
+    if (path && runtime_config_load(runtime, path) != 0) {
+        runtime_config_free(runtime);
+        return NULL;
+    }
+    if (check_collector_filters(runtime->disk_devices, runtime->net_interfaces) != 0) {
+        fprintf(stderr, "错误: 磁盘设备或网络接口列表过长\n");
+        runtime_config_free(runtime);
+        return NULL;
+    }
+    return runtime;
+}
+
+// 重新读取配置文件并发布，出错时继续使用当前配置
+static void reload_config(Pipeline *pipeline, const RuntimeConfig *base, const char *path) {
+    if (!path) {
+        fprintf(stderr, "警告: 未指定配置文件（-c），忽略SIGHUP\n");
+        return;
+    }
+
+    RuntimeConfig *runtime = load_runtime_config(base, path);
+    if (!runtime) {
+        fprintf(stderr, "警告: 重新加载配置文件 %s 失败，继续使用当前配置\n", path);
+        return;
+    }
+    unsigned long generation = pipeline_reload(pipeline, runtime);
+    printf("已重新加载配置文件 %s（版本 %lu）\n", path, generation);
+    fflush(stdout);
 }
 
 int main(int argc, char *argv[]) {
     // 默认参数
-    int sampling_interval = DEFAULT_SAMPLING_INTERVAL;
+    uint64_t sampling_interval_ns = (uint64_t)DEFAULT_SAMPLING_INTERVAL * NSEC_PER_SEC;
     int window_size = DEFAULT_WINDOW_SIZE;
     double sigma_factor = DEFAULT_SIGMA_FACTOR;
     char log_file[256] = LOG_FILE_PATH;
+    const char *alert_log_file = NULL;
+    const char *disk_devices = NULL;
+    const char *net_interfaces = NULL;
+    const char *series_file = SERIES_FILE_PATH;
+    const char *detector_metrics[DETECTOR_COUNT] = { NULL };
+    const char *correlation_groups = NULL;
+    const char *config_file = NULL;
+    uint64_t season_ns = 0;
+    const char *checkpoint_file = FORECAST_CHECKPOINT_PATH;
+    const char *replay_path = NULL;
+    bool quiet = false;
+    const char *listen_address = NULL;
+    int ingest_workers = 0;
+    const char *metrics_address = NULL;
+    int process_top_k = PROCESS_TOP_K;
+    int collect_workers = COLLECT_WORKERS;
+    uint64_t burst_interval_ns = (uint64_t)BURST_INTERVAL_MS * NSEC_PER_MSEC;
+    uint64_t alert_pending_ns = (uint64_t)ALERT_PENDING_SEC * NSEC_PER_SEC;
+    uint64_t alert_resolve_ns = (uint64_t)ALERT_RESOLVE_SEC * NSEC_PER_SEC;
     
     // 解析命令行参数
     int opt;
-    while ((opt = getopt(argc, argv, "hi:w:s:l:d:n:")) != -1) {
+    while ((opt = getopt(argc, argv, "hi:w:s:l:A:d:n:M:E:H:X:P:C:S:R:qL:W:m:T:B:F:K:c:j:")) != -1) {
         switch (opt) {
             case 'h':
                 print_help();
                 return 0;
             case 'i':
-                sampling_interval = atoi(optarg);
-                if (sampling_interval <= 0) {
-                    fprintf(stderr, "错误: 采样间隔必须大于0\n");
+                if (parse_interval(optarg, &sampling_interval_ns) != 0) {
+                    fprintf(stderr, "错误: 无效的采样间隔 %s\n", optarg);
+                    return 1;
+                }
+                if (sampling_interval_ns < MIN_SAMPLING_INTERVAL_MS * NSEC_PER_MSEC) {
+                    fprintf(stderr, "错误: 采样间隔不能小于%dms\n", MIN_SAMPLING_INTERVAL_MS);
                     return 1;
                 }
                 break;
@@ -68,13 +286,99 @@ int main(int argc, char *argv[]) {
                 strncpy(log_file, optarg, sizeof(log_file) - 1);
                 log_file[sizeof(log_file) - 1] = '\0';
                 break;
+            case 'A':
+                alert_log_file = optarg;
+                break;
             case 'd':
-                // 这里可以设置磁盘设备，但需要修改config.h
-                fprintf(stderr, "警告: 磁盘设备设置需要修改config.h\n");
+                disk_devices = optarg;
                 break;
             case 'n':
-                // 这里可以设置网络接口，但需要修改config.h
-                fprintf(stderr, "警告: 网络接口设置需要修改config.h\n");
+                net_interfaces = optarg;
+                break;
+            case 'M':
+                detector_metrics[DETECTOR_MAD] = optarg;
+                break;
+            case 'E':
+                detector_metrics[DETECTOR_EWMA] = optarg;
+                break;
+            case 'H':
+                detector_metrics[DETECTOR_HOLT_WINTERS] = optarg;
+                break;
+            case 'X':
+                correlation_groups = optarg;
+                break;
+            case 'P':
+                if (parse_duration(optarg, &season_ns) != 0) {
+                    fprintf(stderr, "错误: 无效的季节周期 %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'C':
+                checkpoint_file = strcmp(optarg, "none") == 0 ? NULL : optarg;
+                break;
+            case 'S':
+                series_file = strcmp(optarg, "none") == 0 ? NULL : optarg;
+                break;
+            case 'R':
+                replay_path = optarg;
+                break;
+            case 'q':
+                quiet = true;
+                break;
+            case 'L':
+                listen_address = optarg;
+                break;
+            case 'm':
+                metrics_address = optarg;
+                break;
+            case 'T':
+                process_top_k = atoi(optarg);
+                if (process_top_k < 0 || process_top_k > PROCESS_TOP_MAX) {
+                    fprintf(stderr, "错误: 进程排行数必须在0到%d之间\n", PROCESS_TOP_MAX);
+                    return 1;
+                }
+                break;
+            case 'F':
+            case 'K': {
+                uint64_t *duration = opt == 'F' ? &alert_pending_ns : &alert_resolve_ns;
+                if (strcmp(optarg, "0") == 0) {
+                    *duration = 0;
+                } else if (parse_duration(optarg, duration) != 0) {
+                    fprintf(stderr, "错误: 无效的告警时长 %s\n", optarg);
+                    return 1;
+                }
+                break;
+            }
+            case 'B':
+                if (strcmp(optarg, "off") == 0) {
+                    burst_interval_ns = 0;
+                    break;
+                }
+                if (parse_interval(optarg, &burst_interval_ns) != 0) {
+                    fprintf(stderr, "错误: 无效的突发采样间隔 %s\n", optarg);
+                    return 1;
+                }
+                if (burst_interval_ns < MIN_SAMPLING_INTERVAL_MS * NSEC_PER_MSEC) {
+                    fprintf(stderr, "错误: 突发采样间隔不能小于%dms\n", MIN_SAMPLING_INTERVAL_MS);
+                    return 1;
+                }
+                break;
+            case 'c':
+                config_file = optarg;
+                break;
+            case 'W':
+                ingest_workers = atoi(optarg);
+                if (ingest_workers <= 0) {
+                    fprintf(stderr, "错误: 工作线程数必须大于0\n");
+                    return 1;
+                }
+                break;
+            case 'j':
+                collect_workers = atoi(optarg);
+                if (collect_workers < 0) {
+                    fprintf(stderr, "错误: 工作线程数不能小于0\n");
+                    return 1;
+                }
                 break;
             default:
                 fprintf(stderr, "使用 -h 选项获取帮助\n");
@@ -82,92 +386,169 @@ int main(int argc, char *argv[]) {
         }
     }
     
-    // 设置信号处理
-    signal(SIGINT, signal_handler);
-    signal(SIGTERM, signal_handler);
+    // 命令行参数作为运行时配置的初始值，配置文件中的键覆盖之，重新加载时同样以此为基础
+    RuntimeConfig *base = runtime_config_create(sigma_factor, disk_devices, net_interfaces,
+                                                detector_metrics, correlation_groups);
+    RuntimeConfig *runtime = base ? load_runtime_config(base, config_file) : NULL;
+    if (!runtime) {
+        if (!base) {
+            fprintf(stderr, "错误: 内存不足\n");
+        }
+        runtime_config_free(base);
+        return 1;
+    }
+
+    PipelineConfig config = {
+        .interval_ns = sampling_interval_ns,
+        .window_size = window_size,
+        .runtime = runtime,
+        .log_file = log_file,
+        .alert_log_file = alert_log_file,
+        .series_file = series_file,
+        .season_ns = season_ns,
+        .checkpoint_file = checkpoint_file,
+        .metrics_address = metrics_address,
+        .burst_interval_ns = burst_interval_ns,
+        .alert_pending_ns = alert_pending_ns,
+        .alert_resolve_ns = alert_resolve_ns,
+        .queue_depth = PIPELINE_QUEUE_DEPTH,
+    };
+    
+    if (replay_path) {
+        int ret = run_replay(replay_path, &config, quiet);
+        runtime_config_free(runtime);
+        runtime_config_free(base);
+        return ret;
+    }
+    
+    // 屏蔽退出信号、SIGUSR1（打印各阶段耗时）和SIGHUP（重新加载配置），
+    // 工作线程继承屏蔽字，由主线程同步等待
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGUSR1);
+    sigaddset(&signals, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+    
+    if (listen_address) {
+        int ret = run_server(listen_address, ingest_workers, &config, &signals);
+        runtime_config_free(runtime);
+        runtime_config_free(base);
+        return ret;
+    }
+    
+    // 单个数据源最多等待半个采样间隔，卡住的数据源不会拖过下一次采样
+    CollectorConfig collector_config;
+    metrics_collector_default_config(&collector_config);
+    collector_config.process_top_k = process_top_k;
+    collector_config.workers = collect_workers;
+    if (collector_config.source_timeout_ns > sampling_interval_ns / 2) {
+        collector_config.source_timeout_ns = sampling_interval_ns / 2;
+    }
     
     printf("操作系统指标异常检测系统启动\n");
-    printf("采样间隔: %d秒\n", sampling_interval);
+    printf("采样间隔: %.3f秒\n", (double)sampling_interval_ns / NSEC_PER_SEC);
     printf("滑动窗口大小: %d个数据点\n", window_size);
-    printf("N-Sigma因子: %.1f\n", sigma_factor);
+    printf("N-Sigma因子: %.1f\n", runtime->sigma_factor);
     printf("日志文件: %s\n", log_file);
-    printf("磁盘设备: %s\n", DEFAULT_DISK_DEVICE);
-    printf("网络接口: %s\n", DEFAULT_NET_INTERFACE);
+    printf("告警日志: %s\n", alert_log_file ? alert_log_file : "不写入");
+    printf("配置文件: %s\n", config_file ? config_file : "无");
+    printf("磁盘设备: %s\n", runtime->disk_devices ? runtime->disk_devices : "自动发现");
+    printf("网络接口: %s\n", runtime->net_interfaces ? runtime->net_interfaces : "自动发现");
+    printf("MAD检测指标: %s\n",
+           runtime->detector_metrics[DETECTOR_MAD] ? runtime->detector_metrics[DETECTOR_MAD] : "无");
+    printf("EWMA检测指标: %s\n",
+           runtime->detector_metrics[DETECTOR_EWMA] ? runtime->detector_metrics[DETECTOR_EWMA] : "无");
+    printf("Holt-Winters检测指标: %s\n",
+           runtime->detector_metrics[DETECTOR_HOLT_WINTERS] ? runtime->detector_metrics[DETECTOR_HOLT_WINTERS] : "无");
+    printf("多维相关检测组: %s\n", runtime->correlation_groups ? runtime->correlation_groups : "无");
+    if (runtime->setting_count > 0) {
+        printf("按指标设置: %d项\n", runtime->setting_count);
+    }
+    printf("序列文件: %s\n", series_file ? series_file : "不持久化");
+    printf("指标端点: %s\n", metrics_address ? metrics_address : "未启用");
+    if (process_top_k > 0) {
+        printf("进程排行: 前%d个\n", process_top_k);
+    } else {
+        printf("进程排行: 不采集\n");
+    }
+    if (collect_workers > 0) {
+        printf("数据源读取: %d个工作线程，单个数据源最多等待%.3f秒\n", collect_workers,
+               (double)collector_config.source_timeout_ns / NSEC_PER_SEC);
+    } else {
+        printf("数据源读取: 在采集线程中依次读取\n");
+    }
+    printf("告警: 持续异常%.1f秒后触发，持续正常%.1f秒后恢复\n",
+           (double)alert_pending_ns / NSEC_PER_SEC, (double)alert_resolve_ns / NSEC_PER_SEC);
+    if (burst_interval_ns > 0 && burst_interval_ns < sampling_interval_ns) {
+        printf("突发采样: 资源压力超过阈值时%.3f秒，持续%d秒\n",
+               (double)burst_interval_ns / NSEC_PER_SEC, BURST_DURATION_SEC);
+    } else {
+        printf("突发采样: 不使用\n");
+    }
     printf("按Ctrl+C退出\n\n");
+    fflush(stdout);
     
-    // 初始化指标收集器
-    if (init_metrics_collector() != 0) {
+    // 创建指标收集器
+    MetricsCollector *collector = metrics_collector_create(&collector_config);
+    if (!collector) {
         fprintf(stderr, "错误: 无法初始化指标收集器\n");
+        runtime_config_free(runtime);
+        runtime_config_free(base);
         return 1;
     }
+    config.collector = collector;
     
-    // 初始化异常检测器
-    AnomalyDetector detector;
-    if (init_detector(&detector, window_size, sigma_factor) != 0) {
-        fprintf(stderr, "错误: 无法初始化异常检测器\n");
-        cleanup_metrics_collector();
+    // 启动采集、检测和输出线程，运行时配置从此归流水线所有
+    static Pipeline pipeline;
+    if (pipeline_start(&pipeline, &config) != 0) {
+        fprintf(stderr, "错误: 无法启动采集和检测线程\n");
+        metrics_collector_free(collector);
+        runtime_config_free(base);
         return 1;
     }
     
-    // 主循环
-    int cycle = 0;
-    while (running) {
-        printf("\n--- 周期 %d ---\n", ++cycle);
-        
-        // 收集指标
-        if (collect_metrics(&detector) != 0) {
-            fprintf(stderr, "警告: 收集指标时出错\n");
-        }
-        
-        // 打印当前指标值
-        printf("当前指标值:\n");
-        for (int i = 0; i < METRIC_COUNT; i++) {
-            Metric *metric = &detector.metrics[i];
-            printf("  %s: %.2f", metric->name, metric->value);
-            
-            // 如果有足够的历史数据，显示统计信息
-            if (metric->history_size >= 3) {
-                printf(" (均值: %.2f, 标准差: %.2f)", metric->mean, metric->stddev);
-            }
-            printf("\n");
+    if (pipeline.restored > 0) {
+        printf("从序列文件恢复了 %d 个周期的历史数据\n", pipeline.restored);
+        fflush(stdout);
+    }
+    if (pipeline.forecasts_restored > 0) {
+        printf("从检查点恢复了 %d 个预测模型\n", pipeline.forecasts_restored);
+        fflush(stdout);
+    }
+    
+    // 等待退出信号，SIGUSR1打印各阶段耗时、SIGHUP重新加载配置后继续运行
+    int sig;
+    for (;;) {
+        if (sigwait(&signals, &sig) != 0) {
+            continue;
         }
-        
-        // 需要足够的历史数据才能进行异常检测
-        if (cycle >= 3) {
-            // 重置异常计数
-            detector.anomaly_count = 0;
-            
-            // 使用N-Sigma算法检测异常
-            int nsigma_anomalies = detect_anomalies_nsigma(&detector);
-            
-            // 使用阈值检测异常
-            int threshold_anomalies = detect_anomalies_threshold(&detector);
-            
-            // 打印异常
-            print_anomalies(&detector);
-            
-            // 记录异常到日志
-            if (detector.anomaly_count > 0) {
-                if (log_anomalies(&detector, log_file) != 0) {
-                    fprintf(stderr, "警告: 无法写入日志文件 %s\n", log_file);
-                }
-            }
-        } else {
-            printf("收集更多数据点以进行异常检测...\n");
+        if (sig == SIGUSR1) {
+            latency_dump(stderr);
+            continue;
         }
-        
-        // 等待下一个采样周期
-        printf("等待 %d 秒...\n", sampling_interval);
-        for (int i = 0; i < sampling_interval && running; i++) {
-            sleep(1);
+        if (sig == SIGHUP) {
+            reload_config(&pipeline, base, config_file);
+            continue;
         }
+        break;
     }
+    printf("接收到信号 %d，准备退出...\n", sig);
     
     printf("清理资源并退出...\n");
     
     // 清理资源
-    free_detector(&detector);
-    cleanup_metrics_collector();
+    pipeline_stop(&pipeline);
+    metrics_collector_free(collector);
+    runtime_config_free(base);
+    
+    unsigned long dropped_samples = atomic_load(&pipeline.counters.dropped_samples);
+    unsigned long dropped_outputs = atomic_load(&pipeline.counters.dropped_outputs);
+    if (dropped_samples > 0 || dropped_outputs > 0) {
+        printf("共采集 %lu 个周期，丢弃采样批次 %lu 个，丢弃输出批次 %lu 个\n",
+               atomic_load(&pipeline.counters.cycles), dropped_samples, dropped_outputs);
+    }
     
     return 0;
 }
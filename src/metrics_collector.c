@@ -1,524 +1,1030 @@
 #include "../include/metrics_collector.h"
+#include "../include/name_index.h"
 #include "../include/config.h"
+#include "../include/scheduler.h"
+#include "../include/latency.h"
+#include "../include/sample_batch.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <dirent.h>
+
+#define NUMA_NODE_PATH "/sys/devices/system/node"
+#define SYS_BLOCK_PATH "/sys/block"
+#define MAX_FILTERS 64              // -d/-n最多指定的设备/接口数量
+#define SOURCE_METRICS 3            // 每个设备/接口最多的序列数量
+#define COLLECT_TASK_PROCESSES PROC_SRC_COUNT // 进程扫描任务的下标，之前为各procfs数据源
+#define COLLECT_TASKS (PROC_SRC_COUNT + 1)    // 每个周期的读取任务数
+
+/* 自动发现的块设备或网络接口 */
+typedef struct {
+    char name[PROC_NAME_LEN];           // 设备名/接口名
+    bool tracked;                       // 是否跟踪（被过滤或为分区时为false）
+    unsigned long generation;           // 最近一次出现在快照中的周期
+    int series[SOURCE_METRICS];         // 该设备/接口的序列号，-1表示无
+    CounterSet counters;                // 该设备/接口的累计计数器
+} SourceEntry;
+
+/* 设备/接口表：按名称哈希索引，来源消失时整条删除 */
+typedef struct {
+    SourceEntry *entries;
+    int count;
+    int capacity;
+    NameIndex index;
+} SourceTable;
+
+/* 序列号分配：退役的序列号留待复用，检测端据此维护序列号到指标下标的映射 */
+typedef struct {
+    int next;
+    int *free;
+    int free_count;
+    int free_capacity;
+} SeriesAllocator;
+
+/* CPU来源：聚合CPU计数器、每CPU状态和按NUMA节点的汇总 */
+typedef struct {
+    CounterSet counters;                // 聚合CPU时间计数器
+
+    // 每CPU状态，结构数组布局，以CPU编号为下标
+    CounterSet *percpu;                 // 每CPU时间计数器（没有基准表示尚未见过）
+    unsigned long *generation;          // 最近一次在线的周期
+    int *series;                        // 每CPU序列号，-1表示尚未创建
+    int *node;                          // CPU所属NUMA节点，-1表示未知
+    int slots;                          // 以上数组的长度
+
+    // 每NUMA节点状态，以节点编号为下标
+    unsigned long long *node_busy;      // 本周期忙碌时间差值之和
+    unsigned long long *node_total;     // 本周期总时间差值之和
+    int *node_series;                   // 每节点序列号，-1表示尚未创建
+    int node_slots;                     // 以上数组的长度（最大节点编号+1）
+} CpuSource;
+
+/* -d/-n指定的设备或接口，为空时自动发现全部 */
+typedef struct {
+    char names[MAX_FILTERS][PROC_NAME_LEN];
+    int count;
+} FilterList;
+
+/* 一个数据源的读取任务，只写入该数据源自己的字段 */
+typedef struct {
+    WorkerTask task;
+    MetricsCollector *collector;
+    int source;                         // procfs数据源类型或COLLECT_TASK_PROCESSES
+    uint64_t timestamp_ns;              // 提交时的周期采样时间
+    int status;                         // 读取结果，0表示成功
+} CollectTask;
+
+struct MetricsCollector {
+    CollectorConfig config;
+    ProcSnapshot snapshot;              // 每个周期共享的/proc快照，文件描述符在周期之间保持打开
+    unsigned long generation;           // 采集周期计数，用于识别已消失的设备、接口和CPU
+    SeriesAllocator series;
+    int system_series[METRIC_COUNT];    // 系统级指标的序列号，-1表示尚未创建
+    CpuSource cpu;
+    SourceTable disks;                  // 已发现的块设备
+    SourceTable nets;                   // 已发现的网络接口
+    FilterList disk_filters;
+    FilterList net_filters;
+    bool filters_changed;               // 过滤列表改变后，下个周期重新判断已发现的来源
+    bool processes_enabled;             // 排行进程数为0或无法打开/proc目录时不采集
+    ProcessCollector processes;
+    ProcessTop process_top;             // 进程扫描任务写入的排行，完成后复制到批次
+    SampleBatch direct_batch;           // collect_metrics直接写入检测器时使用的批次
+    WorkerPool pool;
+    bool pool_started;
+    CollectTask tasks[COLLECT_TASKS];
+};
+
+// 解析逗号分隔的名称列表
+static int parse_filter_list(const char *list, FilterList *filters) {
+    filters->count = 0;
+    if (!list) {
+        return 0;
+    }
 
-// 存储上一次CPU统计信息，用于计算使用率
-static unsigned long long prev_total_user = 0;
-static unsigned long long prev_total_user_low = 0;
-static unsigned long long prev_total_sys = 0;
-static unsigned long long prev_total_idle = 0;
-static unsigned long long prev_total_iowait = 0;
-static unsigned long long prev_total_irq = 0;
-static unsigned long long prev_total_softirq = 0;
-static unsigned long long prev_total_steal = 0;
-
-// 存储上一次网络统计信息，用于计算丢包率
-static unsigned long long prev_rx_dropped = 0;
-static unsigned long long prev_tx_dropped = 0;
-static time_t prev_net_time = 0;
-
-int init_metrics_collector() {
-    // 初始化CPU统计信息
-    FILE *file = fopen("/proc/stat", "r");
-    if (!file) {
-        return -1;
+    const char *p = list;
+    while (*p) {
+        const char *end = strchr(p, ',');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        if (len > 0) {
+            if (filters->count >= MAX_FILTERS || len >= PROC_NAME_LEN) {
+                return -1;
+            }
+            memcpy(filters->names[filters->count], p, len);
+            filters->names[filters->count][len] = '\0';
+            filters->count++;
+        }
+        if (!end) {
+            break;
+        }
+        p = end + 1;
     }
+    return 0;
+}
 
-    char buffer[256];
-    if (fgets(buffer, sizeof(buffer), file)) {
-        // 解析CPU行
-        sscanf(buffer, "cpu %llu %llu %llu %llu %llu %llu %llu %llu",
-               &prev_total_user, &prev_total_user_low, &prev_total_sys, 
-               &prev_total_idle, &prev_total_iowait, &prev_total_irq,
-               &prev_total_softirq, &prev_total_steal);
+static bool filter_contains(const FilterList *filters, const char *name) {
+    for (int i = 0; i < filters->count; i++) {
+        if (strcmp(filters->names[i], name) == 0) {
+            return true;
+        }
     }
-    fclose(file);
+    return false;
+}
 
-    // 初始化网络统计信息
-    file = fopen("/proc/net/dev", "r");
-    if (!file) {
+int check_collector_filters(const char *disks, const char *interfaces) {
+    FilterList filters;
+    if (parse_filter_list(disks, &filters) != 0) {
         return -1;
     }
+    return parse_filter_list(interfaces, &filters);
+}
 
-    // 跳过前两行
-    fgets(buffer, sizeof(buffer), file);
-    fgets(buffer, sizeof(buffer), file);
+int set_collector_filters(MetricsCollector *collector, const char *disks, const char *interfaces) {
+    // 先检查再替换，失败时保留原来的过滤列表
+    if (!collector || check_collector_filters(disks, interfaces) != 0) {
+        return -1;
+    }
+    parse_filter_list(disks, &collector->disk_filters);
+    parse_filter_list(interfaces, &collector->net_filters);
+    collector->filters_changed = true;
+    return 0;
+}
 
-    char interface[32];
-    unsigned long long rx_bytes, rx_packets, rx_errs, rx_drop;
-    unsigned long long tx_bytes, tx_packets, tx_errs, tx_drop;
+// 分配序列号并在批次中记录创建事件
+static int series_create(SeriesAllocator *alloc, SampleBatch *batch, MetricType type,
+                         const char *instance) {
+    int series = alloc->free_count > 0 ? alloc->free[alloc->free_count - 1] : alloc->next;
+    if (sample_batch_add_event(batch, SERIES_CREATE, series, type, instance) != 0) {
+        return -1;
+    }
+    if (alloc->free_count > 0) {
+        alloc->free_count--;
+    } else {
+        alloc->next++;
+    }
+    return series;
+}
 
-    while (fgets(buffer, sizeof(buffer), file)) {
-        sscanf(buffer, "%[^:]: %llu %llu %llu %llu %*u %*u %*u %*u %llu %llu %llu %llu",
-               interface, &rx_bytes, &rx_packets, &rx_errs, &rx_drop,
-               &tx_bytes, &tx_packets, &tx_errs, &tx_drop);
-        
-        if (strcmp(interface, DEFAULT_NET_INTERFACE) == 0) {
-            prev_rx_dropped = rx_drop;
-            prev_tx_dropped = tx_drop;
-            prev_net_time = time(NULL);
-            break;
+// 在批次中记录退役事件，序列号留待复用
+static void series_retire(SeriesAllocator *alloc, SampleBatch *batch, int series) {
+    if (series < 0 || sample_batch_add_event(batch, SERIES_RETIRE, series, METRIC_COUNT, NULL) != 0) {
+        return;
+    }
+    if (alloc->free_count == alloc->free_capacity) {
+        int new_capacity = alloc->free_capacity > 0 ? alloc->free_capacity * 2 : 64;
+        int *new_free = (int *)realloc(alloc->free, sizeof(int) * new_capacity);
+        if (!new_free) {
+            return;
         }
+        alloc->free = new_free;
+        alloc->free_capacity = new_capacity;
     }
-    fclose(file);
+    alloc->free[alloc->free_count++] = series;
+}
 
-    return 0;
+static int source_table_init(SourceTable *table) {
+    memset(table, 0, sizeof(*table));
+    return name_index_init(&table->index, 64);
 }
 
-void cleanup_metrics_collector() {
-    // 目前没有需要清理的资源
+static void source_table_free(SourceTable *table) {
+    free(table->entries);
+    name_index_free(&table->index);
+    memset(table, 0, sizeof(*table));
 }
 
-int read_cpu_usage(double *usage) {
-    if (!usage) {
-        return -1;
+// 查找设备/接口，不存在时新建（created置为true）
+static SourceEntry *source_table_get(SourceTable *table, const char *name, bool *created) {
+    int pos = name_index_find(&table->index, name);
+    if (pos >= 0) {
+        *created = false;
+        return &table->entries[pos];
     }
 
-    FILE *file = fopen("/proc/stat", "r");
-    if (!file) {
-        return -1;
+    if (table->count == table->capacity) {
+        int new_capacity = table->capacity > 0 ? table->capacity * 2 : 16;
+        SourceEntry *new_entries = (SourceEntry *)realloc(table->entries,
+                                                          sizeof(SourceEntry) * new_capacity);
+        if (!new_entries) {
+            return NULL;
+        }
+        table->entries = new_entries;
+        table->capacity = new_capacity;
+    }
+    if (name_index_put(&table->index, name, table->count) != 0) {
+        return NULL;
     }
 
-    unsigned long long total_user, total_user_low, total_sys, total_idle;
-    unsigned long long total_iowait, total_irq, total_softirq, total_steal;
+    SourceEntry *entry = &table->entries[table->count++];
+    memset(entry, 0, sizeof(*entry));
+    strncpy(entry->name, name, sizeof(entry->name) - 1);
+    for (int i = 0; i < SOURCE_METRICS; i++) {
+        entry->series[i] = -1;
+    }
+    *created = true;
+    return entry;
+}
 
-    char buffer[256];
-    if (fgets(buffer, sizeof(buffer), file)) {
-        // 解析CPU行
-        sscanf(buffer, "cpu %llu %llu %llu %llu %llu %llu %llu %llu",
-               &total_user, &total_user_low, &total_sys, &total_idle,
-               &total_iowait, &total_irq, &total_softirq, &total_steal);
-    } else {
-        fclose(file);
-        return -1;
+// 删除本周期未出现的设备/接口并退役其序列，开销与表中条目数量成正比
+static void source_table_sweep(MetricsCollector *c, SourceTable *table, SampleBatch *batch) {
+    int i = 0;
+    while (i < table->count) {
+        SourceEntry *entry = &table->entries[i];
+        if (entry->generation == c->generation) {
+            i++;
+            continue;
+        }
+
+        for (int m = 0; m < SOURCE_METRICS; m++) {
+            series_retire(&c->series, batch, entry->series[m]);
+        }
+        name_index_remove(&table->index, entry->name);
+
+        // 用最后一个条目填补空位
+        int last = table->count - 1;
+        if (i != last) {
+            table->entries[i] = table->entries[last];
+            name_index_put(&table->index, table->entries[i].name, i);
+        }
+        table->count--;
     }
-    fclose(file);
-
-    // 计算差值
-    unsigned long long diff_user = total_user - prev_total_user;
-    unsigned long long diff_user_low = total_user_low - prev_total_user_low;
-    unsigned long long diff_sys = total_sys - prev_total_sys;
-    unsigned long long diff_idle = total_idle - prev_total_idle;
-    unsigned long long diff_iowait = total_iowait - prev_total_iowait;
-    unsigned long long diff_irq = total_irq - prev_total_irq;
-    unsigned long long diff_softirq = total_softirq - prev_total_softirq;
-    unsigned long long diff_steal = total_steal - prev_total_steal;
-
-    // 计算总差值
-    unsigned long long diff_total = diff_user + diff_user_low + diff_sys + diff_idle +
-                                   diff_iowait + diff_irq + diff_softirq + diff_steal;
-
-    // 计算CPU使用率
-    if (diff_total > 0) {
-        *usage = 100.0 * (diff_total - diff_idle - diff_iowait) / diff_total;
-    } else {
-        *usage = 0.0;
+}
+
+// 按过滤结果改变来源的跟踪状态：开始跟踪时创建序列并重新取计数器基准，不再跟踪时退役序列
+static void source_set_tracked(SeriesAllocator *alloc, SampleBatch *batch, SourceEntry *entry,
+                               bool tracked, const MetricType *types, int count) {
+    if (tracked && !entry->tracked) {
+        for (int m = 0; m < count; m++) {
+            entry->series[m] = series_create(alloc, batch, types[m], entry->name);
+        }
+        counter_set_reset(&entry->counters);
+    } else if (!tracked && entry->tracked) {
+        for (int m = 0; m < count; m++) {
+            series_retire(alloc, batch, entry->series[m]);
+            entry->series[m] = -1;
+        }
     }
+    entry->tracked = tracked;
+}
 
-    // 更新上一次的值
-    prev_total_user = total_user;
-    prev_total_user_low = total_user_low;
-    prev_total_sys = total_sys;
-    prev_total_idle = total_idle;
-    prev_total_iowait = total_iowait;
-    prev_total_irq = total_irq;
-    prev_total_softirq = total_softirq;
-    prev_total_steal = total_steal;
+// 判断块设备是否需要跟踪：指定了-d时只跟踪列出的设备，
+// 否则跟踪/sys/block下的整盘设备，跳过分区和loop/ram设备
+static bool disk_is_tracked(const FilterList *filters, const char *name) {
+    if (filters->count > 0) {
+        return filter_contains(filters, name);
+    }
+    if (strncmp(name, "loop", 4) == 0 || strncmp(name, "ram", 3) == 0) {
+        return false;
+    }
 
-    return 0;
+    // sysfs中设备名里的'/'替换为'!'（如cciss/c0d0）
+    char path[256];
+    int len = snprintf(path, sizeof(path), SYS_BLOCK_PATH "/%s", name);
+    for (int i = (int)sizeof(SYS_BLOCK_PATH); i < len; i++) {
+        if (path[i] == '/') {
+            path[i] = '!';
+        }
+    }
+    return access(path, F_OK) == 0;
 }
 
-int read_cpu_iowait(double *iowait) {
-    if (!iowait) {
-        return -1;
+static bool net_is_tracked(const FilterList *filters, const char *name) {
+    if (filters->count > 0) {
+        return filter_contains(filters, name);
     }
+    return true;
+}
 
-    FILE *file = fopen("/proc/stat", "r");
-    if (!file) {
-        return -1;
-    }
+// 取第k个CPU的时间计数器
+static void percpu_times(const PerCpuTimes *pc, int k, CpuTimes *times) {
+    times->user = pc->user[k];
+    times->nice = pc->nice[k];
+    times->system = pc->system[k];
+    times->idle = pc->idle[k];
+    times->iowait = pc->iowait[k];
+    times->irq = pc->irq[k];
+    times->softirq = pc->softirq[k];
+    times->steal = pc->steal[k];
+}
 
-    unsigned long long total_user, total_user_low, total_sys, total_idle;
-    unsigned long long total_iowait, total_irq, total_softirq, total_steal;
+// 扩展每CPU数组，使其至少能容纳slots个CPU
+static int grow_cpu_slots(CpuSource *cpu, int slots) {
+    if (slots <= cpu->slots) {
+        return 0;
+    }
 
-    char buffer[256];
-    if (fgets(buffer, sizeof(buffer), file)) {
-        // 解析CPU行
-        sscanf(buffer, "cpu %llu %llu %llu %llu %llu %llu %llu %llu",
-               &total_user, &total_user_low, &total_sys, &total_idle,
-               &total_iowait, &total_irq, &total_softirq, &total_steal);
-    } else {
-        fclose(file);
+    CounterSet *counters = (CounterSet *)realloc(cpu->percpu, sizeof(*counters) * slots);
+    if (!counters) {
         return -1;
     }
-    fclose(file);
-
-    // 计算差值
-    unsigned long long diff_iowait = total_iowait - prev_total_iowait;
-    
-    // 计算总差值
-    unsigned long long diff_total = (total_user - prev_total_user) + 
-                                   (total_user_low - prev_total_user_low) + 
-                                   (total_sys - prev_total_sys) + 
-                                   (total_idle - prev_total_idle) +
-                                   diff_iowait + 
-                                   (total_irq - prev_total_irq) + 
-                                   (total_softirq - prev_total_softirq) + 
-                                   (total_steal - prev_total_steal);
-
-    // 计算IO等待率
-    if (diff_total > 0) {
-        *iowait = 100.0 * diff_iowait / diff_total;
-    } else {
-        *iowait = 0.0;
+    cpu->percpu = counters;
+    unsigned long *gens = (unsigned long *)realloc(cpu->generation, sizeof(*gens) * slots);
+    if (!gens) {
+        return -1;
+    }
+    cpu->generation = gens;
+    int *ids = (int *)realloc(cpu->series, sizeof(*ids) * slots);
+    if (!ids) {
+        return -1;
+    }
+    cpu->series = ids;
+    int *nodes = (int *)realloc(cpu->node, sizeof(*nodes) * slots);
+    if (!nodes) {
+        return -1;
     }
+    cpu->node = nodes;
 
+    for (int i = cpu->slots; i < slots; i++) {
+        counter_set_reset(&cpu->percpu[i]);
+        cpu->generation[i] = 0;
+        cpu->series[i] = -1;
+        cpu->node[i] = -1;
+    }
+    cpu->slots = slots;
     return 0;
 }
 
-int read_cpu_irq(double *irq) {
-    if (!irq) {
-        return -1;
+// 解析节点的cpulist（如"0-3,8-11"），记录每个CPU所属节点
+static void parse_node_cpulist(CpuSource *cpu, int node, const char *list) {
+    const char *p = list;
+    while (*p >= '0' && *p <= '9') {
+        int first = (int)strtol(p, (char **)&p, 10);
+        int last = first;
+        if (*p == '-') {
+            last = (int)strtol(p + 1, (char **)&p, 10);
+        }
+        if (last >= first && grow_cpu_slots(cpu, last + 1) == 0) {
+            for (int id = first; id <= last; id++) {
+                cpu->node[id] = node;
+            }
+        }
+        if (*p == ',') {
+            p++;
+        }
     }
+}
 
-    FILE *file = fopen("/proc/stat", "r");
-    if (!file) {
-        return -1;
+// 从sysfs读取NUMA拓扑，无NUMA信息时所有CPU保持未知节点
+static void load_numa_topology(CpuSource *cpu) {
+    DIR *dir = opendir(NUMA_NODE_PATH);
+    if (!dir) {
+        return;
     }
 
-    unsigned long long total_user, total_user_low, total_sys, total_idle;
-    unsigned long long total_iowait, total_irq, total_softirq, total_steal;
+    int max_node = -1;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        int node;
+        char tail;
+        if (sscanf(entry->d_name, "node%d%c", &node, &tail) != 1) {
+            continue;
+        }
 
-    char buffer[256];
-    if (fgets(buffer, sizeof(buffer), file)) {
-        // 解析CPU行
-        sscanf(buffer, "cpu %llu %llu %llu %llu %llu %llu %llu %llu",
-               &total_user, &total_user_low, &total_sys, &total_idle,
-               &total_iowait, &total_irq, &total_softirq, &total_steal);
-    } else {
+        char path[512];
+        snprintf(path, sizeof(path), NUMA_NODE_PATH "/%s/cpulist", entry->d_name);
+        FILE *file = fopen(path, "r");
+        if (!file) {
+            continue;
+        }
+        char list[4096];
+        if (fgets(list, sizeof(list), file)) {
+            parse_node_cpulist(cpu, node, list);
+            if (node > max_node) {
+                max_node = node;
+            }
+        }
         fclose(file);
-        return -1;
     }
-    fclose(file);
-
-    // 计算差值
-    unsigned long long diff_irq = (total_irq - prev_total_irq) + 
-                                 (total_softirq - prev_total_softirq);
-    
-    // 计算总差值
-    unsigned long long diff_total = (total_user - prev_total_user) + 
-                                   (total_user_low - prev_total_user_low) + 
-                                   (total_sys - prev_total_sys) + 
-                                   (total_idle - prev_total_idle) +
-                                   (total_iowait - prev_total_iowait) + 
-                                   diff_irq + 
-                                   (total_steal - prev_total_steal);
-
-    // 计算中断率
-    if (diff_total > 0) {
-        *irq = 100.0 * diff_irq / diff_total;
+    closedir(dir);
+
+    if (max_node < 0) {
+        return;
+    }
+    cpu->node_slots = max_node + 1;
+    cpu->node_busy = (unsigned long long *)calloc(cpu->node_slots, sizeof(*cpu->node_busy));
+    cpu->node_total = (unsigned long long *)calloc(cpu->node_slots, sizeof(*cpu->node_total));
+    cpu->node_series = (int *)malloc(sizeof(*cpu->node_series) * cpu->node_slots);
+    if (!cpu->node_busy || !cpu->node_total || !cpu->node_series) {
+        free(cpu->node_busy);
+        free(cpu->node_total);
+        free(cpu->node_series);
+        cpu->node_busy = cpu->node_total = NULL;
+        cpu->node_series = NULL;
+        cpu->node_slots = 0;
+        return;
+    }
+    for (int i = 0; i < cpu->node_slots; i++) {
+        cpu->node_series[i] = -1;
+    }
+}
+
+static void cpu_source_free(CpuSource *cpu) {
+    free(cpu->percpu);
+    free(cpu->generation);
+    free(cpu->series);
+    free(cpu->node);
+    free(cpu->node_busy);
+    free(cpu->node_total);
+    free(cpu->node_series);
+    memset(cpu, 0, sizeof(*cpu));
+}
+
+// 读取任务：procfs数据源只写入快照中该数据源的字段，进程扫描只写入进程采集器和排行
+static void run_collect_task(void *arg) {
+    CollectTask *t = (CollectTask *)arg;
+    MetricsCollector *c = t->collector;
+
+    if (t->source == COLLECT_TASK_PROCESSES) {
+        uint64_t start_ns = monotonic_ns();
+        t->status = process_collector_refresh(&c->processes, t->timestamp_ns, &c->process_top);
+        latency_record(LATENCY_READ_PROCESS, start_ns);
     } else {
-        *irq = 0.0;
+        t->status = proc_snapshot_read(&c->snapshot, (ProcSourceType)t->source);
     }
+}
 
-    return 0;
+void metrics_collector_default_config(CollectorConfig *config) {
+    if (!config) {
+        return;
+    }
+    config->proc_root = NULL;
+    config->process_top_k = PROCESS_TOP_K;
+    config->workers = COLLECT_WORKERS;
+    config->source_timeout_ns = (uint64_t)COLLECT_SOURCE_TIMEOUT_MS * NSEC_PER_MSEC;
 }
 
-int read_mem_usage(double *usage) {
-    if (!usage) {
-        return -1;
+MetricsCollector *metrics_collector_create(const CollectorConfig *config) {
+    if (!config || config->process_top_k < 0 || config->process_top_k > PROCESS_TOP_MAX ||
+        config->workers < 0) {
+        return NULL;
     }
 
-    FILE *file = fopen("/proc/meminfo", "r");
-    if (!file) {
-        return -1;
+    MetricsCollector *c = (MetricsCollector *)calloc(1, sizeof(MetricsCollector));
+    if (!c) {
+        return NULL;
+    }
+    c->config = *config;
+    sample_batch_init(&c->direct_batch);
+    if (proc_snapshot_init(&c->snapshot, config->proc_root) != 0) {
+        metrics_collector_free(c);
+        return NULL;
     }
 
-    unsigned long total_mem = 0;
-    unsigned long free_mem = 0;
-    unsigned long buffers = 0;
-    unsigned long cached = 0;
+    for (int i = 0; i < METRIC_COUNT; i++) {
+        c->system_series[i] = -1;
+    }
 
-    char buffer[256];
-    while (fgets(buffer, sizeof(buffer), file)) {
-        if (strncmp(buffer, "MemTotal:", 9) == 0) {
-            sscanf(buffer, "MemTotal: %lu", &total_mem);
-        } else if (strncmp(buffer, "MemFree:", 8) == 0) {
-            sscanf(buffer, "MemFree: %lu", &free_mem);
-        } else if (strncmp(buffer, "Buffers:", 8) == 0) {
-            sscanf(buffer, "Buffers: %lu", &buffers);
-        } else if (strncmp(buffer, "Cached:", 7) == 0) {
-            sscanf(buffer, "Cached: %lu", &cached);
+    long configured = sysconf(_SC_NPROCESSORS_CONF);
+    if (grow_cpu_slots(&c->cpu, configured > 0 ? (int)configured : 1) != 0 ||
+        source_table_init(&c->disks) != 0 || source_table_init(&c->nets) != 0) {
+        metrics_collector_free(c);
+        return NULL;
+    }
+    load_numa_topology(&c->cpu);
+
+    // 进程采集失败不影响系统级指标
+    if (config->process_top_k > 0) {
+        c->processes_enabled = process_collector_init(&c->processes, config->proc_root,
+                                                      config->process_top_k) == 0;
+        if (!c->processes_enabled) {
+            fprintf(stderr, "警告: 无法打开/proc目录，不采集进程资源占用\n");
         }
     }
-    fclose(file);
 
-    if (total_mem > 0) {
-        // 计算已使用内存（不包括缓存和缓冲区）
-        unsigned long used_mem = total_mem - free_mem - buffers - cached;
-        *usage = 100.0 * used_mem / total_mem;
-    } else {
-        *usage = 0.0;
+    proc_snapshot_refresh(&c->snapshot);
+
+    // 初始化CPU统计信息
+    if (!proc_snapshot_has(&c->snapshot, PROC_SRC_STAT)) {
+        metrics_collector_free(c);
+        return NULL;
+    }
+    CounterDelta delta;
+    cpu_counters_update(&c->cpu.counters, &c->snapshot.cpu, c->snapshot.timestamp_ns, &delta);
+
+    // 初始化每CPU统计信息
+    const PerCpuTimes *pc = &c->snapshot.percpu;
+    for (int k = 0; k < pc->count; k++) {
+        int id = pc->cpu[k];
+        if (grow_cpu_slots(&c->cpu, id + 1) != 0) {
+            continue;
+        }
+        CpuTimes times;
+        percpu_times(pc, k, &times);
+        cpu_counters_update(&c->cpu.percpu[id], &times, c->snapshot.timestamp_ns, &delta);
     }
 
-    return 0;
+    // 工作线程数不超过任务数，多出的线程不会有事可做
+    int workers = config->workers < COLLECT_TASKS ? config->workers : COLLECT_TASKS;
+    if (worker_pool_init(&c->pool, workers) != 0) {
+        metrics_collector_free(c);
+        return NULL;
+    }
+    c->pool_started = true;
+    for (int i = 0; i < COLLECT_TASKS; i++) {
+        c->tasks[i].task.fn = run_collect_task;
+        c->tasks[i].task.arg = &c->tasks[i];
+        c->tasks[i].collector = c;
+        c->tasks[i].source = i;
+    }
+
+    return c;
 }
 
-int read_mem_active(double *active) {
-    if (!active) {
-        return -1;
+void metrics_collector_free(MetricsCollector *collector) {
+    if (!collector) {
+        return;
     }
 
-    FILE *file = fopen("/proc/meminfo", "r");
-    if (!file) {
+    // 先回收工作线程，之后不再有任务访问快照和进程采集器；卡住的读取最多再等一个
+    // 数据源超时，仍未完成时工作线程被分离，采集器的内存留给它直到进程退出
+    if (collector->pool_started &&
+        worker_pool_free(&collector->pool, collector->config.source_timeout_ns) > 0) {
+        fprintf(stderr, "警告: 有数据源读取仍未完成，不等待其结束\n");
+        return;
+    }
+    proc_snapshot_free(&collector->snapshot);
+    if (collector->processes_enabled) {
+        process_collector_free(&collector->processes);
+    }
+    sample_batch_free(&collector->direct_batch);
+    free(collector->series.free);
+    source_table_free(&collector->disks);
+    source_table_free(&collector->nets);
+    cpu_source_free(&collector->cpu);
+    free(collector);
+}
+
+int cpu_counters_update(CounterSet *set, const CpuTimes *cpu, uint64_t timestamp_ns,
+                        CounterDelta *delta) {
+    if (!cpu) {
         return -1;
     }
 
-    unsigned long active_mem = 0;
+    unsigned long long values[CPU_COUNTERS] = {
+        [CPU_COUNTER_USER] = cpu->user,
+        [CPU_COUNTER_NICE] = cpu->nice,
+        [CPU_COUNTER_SYSTEM] = cpu->system,
+        [CPU_COUNTER_IDLE] = cpu->idle,
+        [CPU_COUNTER_IOWAIT] = cpu->iowait,
+        [CPU_COUNTER_IRQ] = cpu->irq,
+        [CPU_COUNTER_SOFTIRQ] = cpu->softirq,
+        [CPU_COUNTER_STEAL] = cpu->steal,
+    };
+    return counter_set_update(set, values, CPU_COUNTERS, 0, timestamp_ns, delta);
+}
 
-    char buffer[256];
-    while (fgets(buffer, sizeof(buffer), file)) {
-        if (strncmp(buffer, "Active:", 7) == 0) {
-            sscanf(buffer, "Active: %lu", &active_mem);
-            break;
-        }
+// 区间内的CPU总时间
+static unsigned long long cpu_delta_total(const CounterDelta *delta) {
+    unsigned long long total = 0;
+    for (int i = 0; i < CPU_COUNTERS; i++) {
+        total += delta->delta[i];
     }
-    fclose(file);
+    return total;
+}
 
-    *active = (double)active_mem;
-    return 0;
+// 区间内的CPU忙碌时间（不含空闲和IO等待）
+static unsigned long long cpu_delta_busy(const CounterDelta *delta) {
+    return cpu_delta_total(delta) - delta->delta[CPU_COUNTER_IDLE] - delta->delta[CPU_COUNTER_IOWAIT];
 }
 
-int read_disk_stats(const char *device, unsigned long *reads_completed, 
-                   unsigned long *reads_merged, unsigned long long *sectors_read,
-                   unsigned long *read_time_ms, unsigned long *writes_completed,
-                   unsigned long *writes_merged, unsigned long long *sectors_written,
-                   unsigned long *write_time_ms, unsigned long *io_in_progress,
-                   unsigned long *io_time_ms, unsigned long *weighted_io_time_ms) {
-    
-    FILE *file = fopen("/proc/diskstats", "r");
-    if (!file) {
+int read_cpu_usage(const CounterDelta *delta, double *usage) {
+    if (!delta || !usage) {
         return -1;
     }
 
-    char buffer[256];
-    char dev_name[32];
-    int found = 0;
-
-    while (fgets(buffer, sizeof(buffer), file)) {
-        int major, minor;
-        int matched = sscanf(buffer, "%d %d %s %lu %lu %llu %lu %lu %lu %llu %lu %lu %lu %lu",
-                            &major, &minor, dev_name,
-                            reads_completed, reads_merged, sectors_read, read_time_ms,
-                            writes_completed, writes_merged, sectors_written, write_time_ms,
-                            io_in_progress, io_time_ms, weighted_io_time_ms);
-        
-        if (matched == 14 && strcmp(dev_name, device) == 0) {
-            found = 1;
-            break;
-        }
+    unsigned long long total = cpu_delta_total(delta);
+    *usage = total > 0 ? 100.0 * cpu_delta_busy(delta) / total : 0.0;
+    return 0;
+}
+
+int read_cpu_iowait(const CounterDelta *delta, double *iowait) {
+    if (!delta || !iowait) {
+        return -1;
     }
-    fclose(file);
 
-    return found ? 0 : -1;
+    unsigned long long total = cpu_delta_total(delta);
+    *iowait = total > 0 ? 100.0 * delta->delta[CPU_COUNTER_IOWAIT] / total : 0.0;
+    return 0;
 }
 
-int read_disk_read_await(double *read_await, const char *device) {
-    if (!read_await || !device) {
+int read_cpu_irq(const CounterDelta *delta, double *irq) {
+    if (!delta || !irq) {
         return -1;
     }
 
-    unsigned long reads_completed, reads_merged, read_time_ms;
-    unsigned long writes_completed, writes_merged, write_time_ms;
-    unsigned long io_in_progress, io_time_ms, weighted_io_time_ms;
-    unsigned long long sectors_read, sectors_written;
+    unsigned long long total = cpu_delta_total(delta);
+    *irq = total > 0
+           ? 100.0 * (delta->delta[CPU_COUNTER_IRQ] + delta->delta[CPU_COUNTER_SOFTIRQ]) / total : 0.0;
+    return 0;
+}
 
-    int ret = read_disk_stats(device, &reads_completed, &reads_merged, &sectors_read,
-                             &read_time_ms, &writes_completed, &writes_merged,
-                             &sectors_written, &write_time_ms, &io_in_progress,
-                             &io_time_ms, &weighted_io_time_ms);
-    
-    if (ret != 0) {
+int read_mem_usage(const ProcSnapshot *snap, double *usage) {
+    if (!snap || !usage || !proc_snapshot_has(snap, PROC_SRC_MEMINFO)) {
         return -1;
     }
 
-    if (reads_completed > 0) {
-        *read_await = (double)read_time_ms / reads_completed;
+    const MemInfo *mem = &snap->mem;
+    if (mem->total > 0) {
+        // 计算已使用内存（不包括缓存和缓冲区）
+        unsigned long used_mem = mem->total - mem->free - mem->buffers - mem->cached;
+        *usage = 100.0 * used_mem / mem->total;
     } else {
-        *read_await = 0.0;
+        *usage = 0.0;
     }
 
     return 0;
 }
 
-int read_disk_write_await(double *write_await, const char *device) {
-    if (!write_await || !device) {
+int read_mem_active(const ProcSnapshot *snap, double *active) {
+    if (!snap || !active || !proc_snapshot_has(snap, PROC_SRC_MEMINFO)) {
         return -1;
     }
 
-    unsigned long reads_completed, reads_merged, read_time_ms;
-    unsigned long writes_completed, writes_merged, write_time_ms;
-    unsigned long io_in_progress, io_time_ms, weighted_io_time_ms;
-    unsigned long long sectors_read, sectors_written;
+    *active = (double)snap->mem.active;
+    return 0;
+}
 
-    int ret = read_disk_stats(device, &reads_completed, &reads_merged, &sectors_read,
-                             &read_time_ms, &writes_completed, &writes_merged,
-                             &sectors_written, &write_time_ms, &io_in_progress,
-                             &io_time_ms, &weighted_io_time_ms);
-    
-    if (ret != 0) {
+int disk_counters_update(CounterSet *set, const DiskStats *disk, uint64_t timestamp_ns,
+                         CounterDelta *delta) {
+    if (!disk) {
         return -1;
     }
 
-    if (writes_completed > 0) {
-        *write_await = (double)write_time_ms / writes_completed;
-    } else {
-        *write_await = 0.0;
+    unsigned long long values[DISK_COUNTERS] = {
+        [DISK_COUNTER_READS] = disk->reads_completed,
+        [DISK_COUNTER_READ_TIME] = disk->read_time_ms,
+        [DISK_COUNTER_WRITES] = disk->writes_completed,
+        [DISK_COUNTER_WRITE_TIME] = disk->write_time_ms,
+        [DISK_COUNTER_IO_TIME] = disk->io_time_ms,
+    };
+    // 内核以32位（%u）输出毫秒耗时字段，约49.7天回绕一次；请求数是unsigned long
+    const unsigned int width32 = (1u << DISK_COUNTER_READ_TIME) | (1u << DISK_COUNTER_WRITE_TIME) |
+                                 (1u << DISK_COUNTER_IO_TIME);
+    return counter_set_update(set, values, DISK_COUNTERS, width32, timestamp_ns, delta);
+}
+
+int read_disk_read_await(const CounterDelta *delta, double *read_await) {
+    if (!delta || !read_await) {
+        return -1;
     }
 
+    *read_await = counter_delta_ratio(delta, DISK_COUNTER_READ_TIME, DISK_COUNTER_READS);
     return 0;
 }
 
-int read_disk_util(double *util, const char *device) {
-    if (!util || !device) {
+int read_disk_write_await(const CounterDelta *delta, double *write_await) {
+    if (!delta || !write_await) {
         return -1;
     }
 
-    unsigned long reads_completed, reads_merged, read_time_ms;
-    unsigned long writes_completed, writes_merged, write_time_ms;
-    unsigned long io_in_progress, io_time_ms, weighted_io_time_ms;
-    unsigned long long sectors_read, sectors_written;
+    *write_await = counter_delta_ratio(delta, DISK_COUNTER_WRITE_TIME, DISK_COUNTER_WRITES);
+    return 0;
+}
 
-    int ret = read_disk_stats(device, &reads_completed, &reads_merged, &sectors_read,
-                             &read_time_ms, &writes_completed, &writes_merged,
-                             &sectors_written, &write_time_ms, &io_in_progress,
-                             &io_time_ms, &weighted_io_time_ms);
-    
-    if (ret != 0) {
+int read_disk_util(const CounterDelta *delta, double *util) {
+    if (!delta || !util) {
         return -1;
     }
 
-    // 假设采样间隔为1秒，计算磁盘利用率
-    // io_time_ms是自系统启动以来磁盘处于活动状态的毫秒数
-    // 这里简单地将其除以1000，得到磁盘利用率的近似值
-    *util = (double)io_time_ms / 1000.0;
+    // 忙碌毫秒数每秒的增量除以1000即为忙碌时间占比；合并计数的误差可能略超过100%
+    *util = counter_delta_rate(delta, DISK_COUNTER_IO_TIME) / 10.0;
     if (*util > 100.0) {
         *util = 100.0;
     }
-
     return 0;
 }
 
-int read_net_dropped(double *dropped, const char *interface) {
-    if (!dropped || !interface) {
+int net_counters_update(CounterSet *set, const NetDevStats *net, uint64_t timestamp_ns,
+                        CounterDelta *delta) {
+    if (!net) {
         return -1;
     }
 
-    FILE *file = fopen("/proc/net/dev", "r");
-    if (!file) {
+    unsigned long long values[NET_COUNTERS] = {
+        [NET_COUNTER_RX_DROP] = net->rx_drop,
+        [NET_COUNTER_TX_DROP] = net->tx_drop,
+    };
+    return counter_set_update(set, values, NET_COUNTERS, 0, timestamp_ns, delta);
+}
+
+int read_net_dropped(const CounterDelta *delta, double *dropped) {
+    if (!delta || !dropped) {
         return -1;
     }
 
-    char buffer[256];
-    // 跳过前两行
-    fgets(buffer, sizeof(buffer), file);
-    fgets(buffer, sizeof(buffer), file);
+    *dropped = counter_delta_rate(delta, NET_COUNTER_RX_DROP) + counter_delta_rate(delta, NET_COUNTER_TX_DROP);
+    return 0;
+}
 
-    char if_name[32];
-    unsigned long long rx_bytes, rx_packets, rx_errs, rx_drop;
-    unsigned long long tx_bytes, tx_packets, tx_errs, tx_drop;
-    int found = 0;
+// 收集每CPU使用率并按NUMA节点汇总，开销与CPU数量成线性关系
+static void collect_percpu(MetricsCollector *c, SampleBatch *batch) {
+    const ProcSnapshot *snap = &c->snapshot;
+    const PerCpuTimes *pc = &snap->percpu;
+    CpuSource *cpu = &c->cpu;
 
-    while (fgets(buffer, sizeof(buffer), file)) {
-        sscanf(buffer, "%[^:]: %llu %llu %llu %llu %*u %*u %*u %*u %llu %llu %llu %llu",
-               if_name, &rx_bytes, &rx_packets, &rx_errs, &rx_drop,
-               &tx_bytes, &tx_packets, &tx_errs, &tx_drop);
-        
-        if (strcmp(if_name, interface) == 0) {
-            found = 1;
-            break;
+    // 单CPU主机的每CPU指标与聚合指标相同，不重复跟踪
+    if (!proc_snapshot_has(snap, PROC_SRC_STAT) || pc->count <= 1) {
+        return;
+    }
+
+    for (int n = 0; n < cpu->node_slots; n++) {
+        cpu->node_busy[n] = 0;
+        cpu->node_total[n] = 0;
+    }
+
+    for (int k = 0; k < pc->count; k++) {
+        int id = pc->cpu[k];
+        if (grow_cpu_slots(cpu, id + 1) != 0) {
+            continue;
+        }
+        cpu->generation[id] = c->generation;
+
+        // 第一次见到的CPU（如刚上线）只记录基准值
+        CpuTimes times;
+        CounterDelta delta;
+        percpu_times(pc, k, &times);
+        if (cpu_counters_update(&cpu->percpu[id], &times, snap->timestamp_ns, &delta) != 0) {
+            continue;
+        }
+
+        if (cpu->series[id] < 0) {
+            char instance[32];
+            snprintf(instance, sizeof(instance), "cpu%d", id);
+            cpu->series[id] = series_create(&c->series, batch, METRIC_CPU_USAGE, instance);
+        }
+        double usage;
+        if (cpu->series[id] >= 0 && read_cpu_usage(&delta, &usage) == 0) {
+            sample_batch_add(batch, cpu->series[id], usage);
+        }
+
+        int node = cpu->node[id];
+        if (node >= 0 && node < cpu->node_slots) {
+            cpu->node_busy[node] += cpu_delta_busy(&delta);
+            cpu->node_total[node] += cpu_delta_total(&delta);
         }
     }
-    fclose(file);
 
-    if (!found) {
-        return -1;
+    // 离线的CPU退役其序列，重新上线时从基准值开始
+    for (int id = 0; id < cpu->slots; id++) {
+        if (cpu->generation[id] != c->generation && counter_set_primed(&cpu->percpu[id])) {
+            if (cpu->series[id] >= 0) {
+                series_retire(&c->series, batch, cpu->series[id]);
+                cpu->series[id] = -1;
+            }
+            counter_set_reset(&cpu->percpu[id]);
+        }
     }
 
-    // 计算丢包率（每秒丢包数）
-    time_t current_time = time(NULL);
-    double time_diff = difftime(current_time, prev_net_time);
-    
-    if (time_diff > 0) {
-        unsigned long long total_drop = rx_drop + tx_drop;
-        unsigned long long diff_drop = total_drop - (prev_rx_dropped + prev_tx_dropped);
-        *dropped = (double)diff_drop / time_diff;
-    } else {
-        *dropped = 0.0;
+    // 只有一个节点时节点指标与聚合指标相同
+    if (cpu->node_slots <= 1) {
+        return;
     }
+    for (int n = 0; n < cpu->node_slots; n++) {
+        if (cpu->node_total[n] == 0) {
+            continue;
+        }
+        if (cpu->node_series[n] < 0) {
+            char instance[32];
+            snprintf(instance, sizeof(instance), "node%d", n);
+            cpu->node_series[n] = series_create(&c->series, batch, METRIC_CPU_USAGE, instance);
+        }
+        if (cpu->node_series[n] >= 0) {
+            sample_batch_add(batch, cpu->node_series[n], 100.0 * cpu->node_busy[n] / cpu->node_total[n]);
+        }
+    }
+}
 
-    // 更新上一次的值
-    prev_rx_dropped = rx_drop;
-    prev_tx_dropped = tx_drop;
-    prev_net_time = current_time;
+// 收集所有块设备的指标，新设备在发现时创建序列，消失的设备退役
+static void collect_disks(MetricsCollector *c, SampleBatch *batch) {
+    const ProcSnapshot *snap = &c->snapshot;
+    if (!proc_snapshot_has(snap, PROC_SRC_DISKSTATS)) {
+        return;
+    }
 
-    return 0;
+    for (int i = 0; i < snap->disk_count; i++) {
+        const DiskStats *disk = &snap->disks[i];
+        bool created;
+        SourceEntry *entry = source_table_get(&c->disks, disk->name, &created);
+        if (!entry) {
+            continue;
+        }
+        entry->generation = c->generation;
+        if (created || c->filters_changed) {
+            static const MetricType types[] = {
+                METRIC_DISK_READ_AWAIT, METRIC_DISK_WRITE_AWAIT, METRIC_DISK_UTIL
+            };
+            source_set_tracked(&c->series, batch, entry, disk_is_tracked(&c->disk_filters, disk->name),
+                               types, 3);
+        }
+        if (!entry->tracked) {
+            continue;
+        }
+
+        // 新设备只记录基准值，下个周期开始计算区间内的响应时间和使用率
+        CounterDelta delta;
+        if (disk_counters_update(&entry->counters, disk, snap->timestamp_ns, &delta) != 0) {
+            continue;
+        }
+
+        double value;
+
+        // 收集磁盘读响应时间
+        if (entry->series[0] >= 0 && read_disk_read_await(&delta, &value) == 0) {
+            sample_batch_add(batch, entry->series[0], value);
+        }
+
+        // 收集磁盘写响应时间
+        if (entry->series[1] >= 0 && read_disk_write_await(&delta, &value) == 0) {
+            sample_batch_add(batch, entry->series[1], value);
+        }
+
+        // 收集磁盘使用率
+        if (entry->series[2] >= 0 && read_disk_util(&delta, &value) == 0) {
+            sample_batch_add(batch, entry->series[2], value);
+        }
+    }
+
+    source_table_sweep(c, &c->disks, batch);
 }
 
-int collect_metrics(AnomalyDetector *detector) {
-    if (!detector) {
-        return -1;
+// 收集所有网络接口的指标，新接口在发现时创建序列，消失的接口退役
+static void collect_nets(MetricsCollector *c, SampleBatch *batch) {
+    const ProcSnapshot *snap = &c->snapshot;
+    if (!proc_snapshot_has(snap, PROC_SRC_NETDEV)) {
+        return;
     }
 
-    double value;
+    for (int i = 0; i < snap->net_count; i++) {
+        const NetDevStats *net = &snap->nets[i];
+        bool created;
+        SourceEntry *entry = source_table_get(&c->nets, net->name, &created);
+        if (!entry) {
+            continue;
+        }
+        entry->generation = c->generation;
+        if (created || c->filters_changed) {
+            static const MetricType types[] = { METRIC_NET_DROPPED };
+            source_set_tracked(&c->series, batch, entry, net_is_tracked(&c->net_filters, net->name),
+                               types, 1);
+        }
+        if (!entry->tracked) {
+            continue;
+        }
 
-    // 收集CPU使用率
-    if (read_cpu_usage(&value) == 0) {
-        add_metric_datapoint(&detector->metrics[METRIC_CPU_USAGE], value);
+        // 新接口只记录基准值，下个周期开始计算丢包率
+        CounterDelta delta;
+        if (net_counters_update(&entry->counters, net, snap->timestamp_ns, &delta) != 0) {
+            continue;
+        }
+
+        // 收集网络丢包
+        double value;
+        if (entry->series[0] >= 0 && read_net_dropped(&delta, &value) == 0) {
+            sample_batch_add(batch, entry->series[0], value);
+        }
     }
 
-    // 收集CPU IO等待
-    if (read_cpu_iowait(&value) == 0) {
-        add_metric_datapoint(&detector->metrics[METRIC_CPU_IOWAIT], value);
+    source_table_sweep(c, &c->nets, batch);
+}
+
+// 收集系统级指标
+static void collect_system_metric(MetricsCollector *c, SampleBatch *batch, MetricType type,
+                                  double value) {
+    if (c->system_series[type] < 0) {
+        c->system_series[type] = series_create(&c->series, batch, type, NULL);
+    }
+    if (c->system_series[type] >= 0) {
+        sample_batch_add(batch, c->system_series[type], value);
     }
+}
+
+// 提交本周期的读取任务并等待到超时，返回超时或仍被上次读取占用的数据源数量；
+// 按时完成的procfs数据源置入快照的有效位掩码，进程扫描按时完成时设置*processes_done
+static int run_collect_tasks(MetricsCollector *c, bool *processes_done) {
+    WorkerTask *submitted[COLLECT_TASKS];
+    int count = 0;
+    int late = 0;
 
-    // 收集CPU中断
-    if (read_cpu_irq(&value) == 0) {
-        add_metric_datapoint(&detector->metrics[METRIC_CPU_IRQ], value);
+    for (int i = 0; i < COLLECT_TASKS; i++) {
+        if (i == COLLECT_TASK_PROCESSES && !c->processes_enabled) {
+            continue;
+        }
+        CollectTask *t = &c->tasks[i];
+        if (worker_task_pending(&c->pool, &t->task)) {
+            late++;
+            continue;
+        }
+        t->timestamp_ns = c->snapshot.timestamp_ns;
+        if (worker_pool_submit(&c->pool, &t->task) == 0) {
+            submitted[count++] = &t->task;
+        }
     }
 
-    // 收集内存使用率
-    if (read_mem_usage(&value) == 0) {
-        add_metric_datapoint(&detector->metrics[METRIC_MEM_USAGE], value);
+    uint64_t deadline_ns = c->config.source_timeout_ns > 0
+                           ? c->snapshot.timestamp_ns + c->config.source_timeout_ns : 0;
+    worker_pool_wait(&c->pool, submitted, count, deadline_ns);
+
+    // 未按时完成的任务继续运行，它写入的字段在完成前不能读取
+    for (int i = 0; i < count; i++) {
+        CollectTask *t = (CollectTask *)submitted[i]->arg;
+        if (worker_task_pending(&c->pool, &t->task)) {
+            late++;
+        } else if (t->status == 0) {
+            if (t->source == COLLECT_TASK_PROCESSES) {
+                *processes_done = true;
+            } else {
+                c->snapshot.valid |= 1u << t->source;
+            }
+        }
     }
+    return late;
+}
 
-    // 收集活跃内存
-    if (read_mem_active(&value) == 0) {
-        add_metric_datapoint(&detector->metrics[METRIC_MEM_ACTIVE], value);
+int collect_samples(MetricsCollector *c, SampleBatch *batch, int *timeouts) {
+    if (!c || !batch) {
+        return -1;
+    }
+
+    // 各数据源并行读取，所有指标从同一份快照推导
+    c->snapshot.valid = 0;
+    c->snapshot.timestamp_ns = monotonic_ns();
+    bool processes_done = false;
+    int late = run_collect_tasks(c, &processes_done);
+    if (timeouts) {
+        *timeouts = late;
+    }
+    int ret = c->snapshot.valid == (1u << PROC_SRC_COUNT) - 1 ? 0 : -1;
+    c->generation++;
+    batch->timestamp_ns = c->snapshot.timestamp_ns;
+
+    double value;
+    uint64_t start_ns = monotonic_ns();
+
+    // 三个CPU指标基于同一区间的增量计算
+    CounterDelta cpu_delta;
+    if (proc_snapshot_has(&c->snapshot, PROC_SRC_STAT) &&
+        cpu_counters_update(&c->cpu.counters, &c->snapshot.cpu, c->snapshot.timestamp_ns,
+                            &cpu_delta) == 0) {
+        // 收集CPU使用率
+        if (read_cpu_usage(&cpu_delta, &value) == 0) {
+            collect_system_metric(c, batch, METRIC_CPU_USAGE, value);
+        }
+
+        // 收集CPU IO等待
+        if (read_cpu_iowait(&cpu_delta, &value) == 0) {
+            collect_system_metric(c, batch, METRIC_CPU_IOWAIT, value);
+        }
+
+        // 收集CPU中断
+        if (read_cpu_irq(&cpu_delta, &value) == 0) {
+            collect_system_metric(c, batch, METRIC_CPU_IRQ, value);
+        }
     }
 
-    // 收集磁盘读响应时间
-    if (read_disk_read_await(&value, DEFAULT_DISK_DEVICE) == 0) {
-        add_metric_datapoint(&detector->metrics[METRIC_DISK_READ_AWAIT], value);
+    // 收集每CPU和每NUMA节点使用率
+    collect_percpu(c, batch);
+    start_ns = latency_record(LATENCY_READ_CPU, start_ns);
+
+    // 收集内存使用率
+    if (read_mem_usage(&c->snapshot, &value) == 0) {
+        collect_system_metric(c, batch, METRIC_MEM_USAGE, value);
     }
 
-    // 收集磁盘写响应时间
-    if (read_disk_write_await(&value, DEFAULT_DISK_DEVICE) == 0) {
-        add_metric_datapoint(&detector->metrics[METRIC_DISK_WRITE_AWAIT], value);
+    // 收集活跃内存
+    if (read_mem_active(&c->snapshot, &value) == 0) {
+        collect_system_metric(c, batch, METRIC_MEM_ACTIVE, value);
     }
+    start_ns = latency_record(LATENCY_READ_MEM, start_ns);
+
+    // 收集磁盘和网络指标；过滤列表的变化要等对应数据源读取成功后才能应用
+    collect_disks(c, batch);
+    start_ns = latency_record(LATENCY_READ_DISK, start_ns);
+    collect_nets(c, batch);
+    if (proc_snapshot_has(&c->snapshot, PROC_SRC_DISKSTATS) &&
+        proc_snapshot_has(&c->snapshot, PROC_SRC_NETDEV)) {
+        c->filters_changed = false;
+    }
+    start_ns = latency_record(LATENCY_READ_NET, start_ns);
 
-    // 收集磁盘使用率
-    if (read_disk_util(&value, DEFAULT_DISK_DEVICE) == 0) {
-        add_metric_datapoint(&detector->metrics[METRIC_DISK_UTIL], value);
+    // 进程资源占用排行由扫描任务生成，按时完成才随批次发送
+    if (processes_done) {
+        batch->processes = c->process_top;
     }
 
-    // 收集网络丢包
-    if (read_net_dropped(&value, DEFAULT_NET_INTERFACE) == 0) {
-        add_metric_datapoint(&detector->metrics[METRIC_NET_DROPPED], value);
+    latency_add(LATENCY_COLLECT, start_ns - c->snapshot.timestamp_ns);
+    return ret == 0 && late == 0 ? 0 : -1;
+}
+
+int collect_metrics(MetricsCollector *collector, AnomalyDetector *detector) {
+    if (!collector || !detector) {
+        return -1;
     }
 
-    return 0;
+    sample_batch_reset(&collector->direct_batch);
+    int ret = collect_samples(collector, &collector->direct_batch, NULL);
+    if (apply_sample_batch(detector, &collector->direct_batch) != 0) {
+        ret = -1;
+    }
+    return ret;
 }
@@ -0,0 +1,147 @@
+#include "../include/name_index.h"
+#include <stdlib.h>
+#include <string.h>
+
+// FNV-1a哈希
+static uint32_t hash_name(const char *key) {
+    uint32_t h = 2166136261u;
+    while (*key) {
+        h ^= (unsigned char)*key++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static int alloc_slots(NameIndex *index, int capacity) {
+    NameIndexSlot *slots = (NameIndexSlot *)malloc(sizeof(NameIndexSlot) * capacity);
+    if (!slots) {
+        return -1;
+    }
+    for (int i = 0; i < capacity; i++) {
+        slots[i].value = -1;
+    }
+    index->slots = slots;
+    index->capacity = capacity;
+    index->count = 0;
+    return 0;
+}
+
+// 查找名称所在槽位，不存在时返回应插入的空槽位
+static int probe(const NameIndex *index, const char *key, uint32_t hash) {
+    int mask = index->capacity - 1;
+    int i = (int)(hash & (uint32_t)mask);
+    while (index->slots[i].value >= 0) {
+        if (index->slots[i].hash == hash && strcmp(index->slots[i].key, key) == 0) {
+            return i;
+        }
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+// 负载因子超过0.7时容量翻倍并重新散列
+static int grow(NameIndex *index) {
+    NameIndexSlot *old = index->slots;
+    int old_capacity = index->capacity;
+
+    if (alloc_slots(index, old_capacity * 2) != 0) {
+        index->slots = old;
+        index->capacity = old_capacity;
+        return -1;
+    }
+
+    int count = 0;
+    for (int i = 0; i < old_capacity; i++) {
+        if (old[i].value >= 0) {
+            int j = probe(index, old[i].key, old[i].hash);
+            index->slots[j] = old[i];
+            count++;
+        }
+    }
+    index->count = count;
+    free(old);
+    return 0;
+}
+
+int name_index_init(NameIndex *index, int capacity) {
+    if (!index) {
+        return -1;
+    }
+
+    int size = 16;
+    while (size < capacity) {
+        size *= 2;
+    }
+    return alloc_slots(index, size);
+}
+
+void name_index_free(NameIndex *index) {
+    if (!index) {
+        return;
+    }
+    free(index->slots);
+    index->slots = NULL;
+    index->capacity = 0;
+    index->count = 0;
+}
+
+int name_index_find(const NameIndex *index, const char *key) {
+    if (!index || !index->slots || !key) {
+        return -1;
+    }
+    int i = probe(index, key, hash_name(key));
+    return index->slots[i].value;
+}
+
+int name_index_put(NameIndex *index, const char *key, int value) {
+    if (!index || !index->slots || !key || value < 0 ||
+        strlen(key) >= NAME_INDEX_KEY_LEN) {
+        return -1;
+    }
+
+    if ((index->count + 1) * 10 > index->capacity * 7 && grow(index) != 0) {
+        return -1;
+    }
+
+    uint32_t hash = hash_name(key);
+    int i = probe(index, key, hash);
+    NameIndexSlot *slot = &index->slots[i];
+    if (slot->value < 0) {
+        slot->hash = hash;
+        strcpy(slot->key, key);
+        index->count++;
+    }
+    slot->value = value;
+    return 0;
+}
+
+void name_index_remove(NameIndex *index, const char *key) {
+    if (!index || !index->slots || !key) {
+        return;
+    }
+
+    int mask = index->capacity - 1;
+    int i = probe(index, key, hash_name(key));
+    if (index->slots[i].value < 0) {
+        return;
+    }
+
+    // 后移法删除：把探测链上后续元素移到空位，保证查找不中断
+    index->slots[i].value = -1;
+    index->count--;
+    int j = i;
+    for (;;) {
+        j = (j + 1) & mask;
+        if (index->slots[j].value < 0) {
+            break;
+        }
+        int home = (int)(index->slots[j].hash & (uint32_t)mask);
+        // 若home不在(i, j]循环区间内，则元素j可以移到空位i
+        int movable = (i <= j) ? (home <= i || home > j) : (home <= i && home > j);
+        if (movable) {
+            index->slots[i] = index->slots[j];
+            index->slots[j].value = -1;
+            i = j;
+        }
+    }
+}
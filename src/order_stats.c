@@ -0,0 +1,249 @@
+#include "../include/order_stats.h"
+#include <stdlib.h>
+#include <math.h>
+
+// xorshift32，用于生成treap优先级
+static inline uint32_t next_priority(OrderStats *os) {
+    uint32_t x = os->seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    os->seed = x;
+    return x;
+}
+
+static inline int node_size(const OrderStats *os, int t) {
+    return t >= 0 ? os->nodes[t].size : 0;
+}
+
+static inline double node_sum(const OrderStats *os, int t) {
+    return t >= 0 ? os->nodes[t].sum : 0.0;
+}
+
+// 由子节点重新计算子树大小和子树和（不做增量加减，避免浮点误差累积）
+static inline void pull(OrderStats *os, int t) {
+    OrderStatsNode *n = &os->nodes[t];
+    n->size = 1 + node_size(os, n->left) + node_size(os, n->right);
+    n->sum = n->value + node_sum(os, n->left) + node_sum(os, n->right);
+}
+
+// 按值拆分：*lo中的值都小于value，*hi中的值都不小于value
+static void split(OrderStats *os, int t, double value, int *lo, int *hi) {
+    if (t < 0) {
+        *lo = *hi = -1;
+        return;
+    }
+    if (os->nodes[t].value < value) {
+        split(os, os->nodes[t].right, value, &os->nodes[t].right, hi);
+        *lo = t;
+    } else {
+        split(os, os->nodes[t].left, value, lo, &os->nodes[t].left);
+        *hi = t;
+    }
+    pull(os, t);
+}
+
+// 合并两棵树，a中的值都不大于b中的值
+static int merge(OrderStats *os, int a, int b) {
+    if (a < 0) {
+        return b;
+    }
+    if (b < 0) {
+        return a;
+    }
+    if (os->nodes[a].priority > os->nodes[b].priority) {
+        os->nodes[a].right = merge(os, os->nodes[a].right, b);
+        pull(os, a);
+        return a;
+    }
+    os->nodes[b].left = merge(os, a, os->nodes[b].left);
+    pull(os, b);
+    return b;
+}
+
+// 删除子树t中一个等于value的节点，返回新的子树根
+static int erase(OrderStats *os, int t, double value, int *removed) {
+    if (t < 0) {
+        return -1;
+    }
+    OrderStatsNode *n = &os->nodes[t];
+    if (value == n->value) {
+        int rest = merge(os, n->left, n->right);
+        n->left = os->free_list;
+        os->free_list = t;
+        *removed = 1;
+        return rest;
+    }
+    if (value < n->value) {
+        n->left = erase(os, n->left, value, removed);
+    } else {
+        n->right = erase(os, n->right, value, removed);
+    }
+    pull(os, t);
+    return t;
+}
+
+int order_stats_init(OrderStats *os, int capacity) {
+    if (!os || capacity <= 0) {
+        return -1;
+    }
+
+    os->nodes = (OrderStatsNode *)malloc(sizeof(OrderStatsNode) * capacity);
+    if (!os->nodes) {
+        return -1;
+    }
+    os->capacity = capacity;
+    os->seed = 0x9e3779b9u;
+    order_stats_clear(os);
+    return 0;
+}
+
+void order_stats_free(OrderStats *os) {
+    if (!os) {
+        return;
+    }
+    free(os->nodes);
+    os->nodes = NULL;
+    os->capacity = 0;
+    os->root = -1;
+    os->free_list = -1;
+}
+
+void order_stats_clear(OrderStats *os) {
+    for (int i = 0; i < os->capacity; i++) {
+        os->nodes[i].left = i + 1 < os->capacity ? i + 1 : -1;
+    }
+    os->free_list = os->capacity > 0 ? 0 : -1;
+    os->root = -1;
+}
+
+int order_stats_insert(OrderStats *os, double value) {
+    if (os->free_list < 0 || isnan(value)) {
+        return -1;
+    }
+
+    int t = os->free_list;
+    OrderStatsNode *n = &os->nodes[t];
+    os->free_list = n->left;
+    n->value = value;
+    n->left = n->right = -1;
+    n->priority = next_priority(os);
+    pull(os, t);
+
+    int lo, hi;
+    split(os, os->root, value, &lo, &hi);
+    os->root = merge(os, merge(os, lo, t), hi);
+    return 0;
+}
+
+int order_stats_remove(OrderStats *os, double value) {
+    int removed = 0;
+    os->root = erase(os, os->root, value, &removed);
+    return removed ? 0 : -1;
+}
+
+double order_stats_select(const OrderStats *os, int k) {
+    int t = os->root;
+    while (t >= 0) {
+        const OrderStatsNode *n = &os->nodes[t];
+        int left = node_size(os, n->left);
+        if (k < left) {
+            t = n->left;
+        } else if (k == left) {
+            return n->value;
+        } else {
+            k -= left + 1;
+            t = n->right;
+        }
+    }
+    return NAN;
+}
+
+double order_stats_median(const OrderStats *os) {
+    int n = order_stats_count(os);
+    if (n % 2 == 1) {
+        return order_stats_select(os, n / 2);
+    }
+    return (order_stats_select(os, n / 2 - 1) + order_stats_select(os, n / 2)) / 2.0;
+}
+
+// 统计小于value的样本个数及其和
+static int count_below(const OrderStats *os, double value, double *sum) {
+    int count = 0;
+    *sum = 0.0;
+    int t = os->root;
+    while (t >= 0) {
+        const OrderStatsNode *n = &os->nodes[t];
+        if (n->value < value) {
+            count += node_size(os, n->left) + 1;
+            *sum += node_sum(os, n->left) + n->value;
+            t = n->right;
+        } else {
+            t = n->left;
+        }
+    }
+    return count;
+}
+
+/*
+ * 偏差序列：设有s个样本小于中位数m，有序样本为a[0..n-1]，则
+ *   L[i] = m - a[s-1-i]  (0 <= i < s)
+ *   U[j] = a[s+j] - m    (0 <= j < n-s)
+ * 都是非递减序列，|x - m|的第k小即两条序列归并后的第k小。
+ */
+static inline double lower_dev(const OrderStats *os, int s, double m, int i) {
+    return m - order_stats_select(os, s - 1 - i);
+}
+
+static inline double upper_dev(const OrderStats *os, int s, double m, int j) {
+    return order_stats_select(os, s + j) - m;
+}
+
+// 两条偏差序列归并后的第k小（k从0开始），二分L中取多少个
+static double kth_deviation(const OrderStats *os, int n, int s, double m, int k) {
+    int take = k + 1;
+    int lo = take - (n - s) > 0 ? take - (n - s) : 0;
+    int hi = take < s ? take : s;
+    while (lo < hi) {
+        int i = lo + (hi - lo) / 2;
+        if (lower_dev(os, s, m, i) < upper_dev(os, s, m, take - i - 1)) {
+            lo = i + 1;
+        } else {
+            hi = i;
+        }
+    }
+
+    int j = take - lo;
+    double result = -INFINITY;
+    if (lo > 0) {
+        result = lower_dev(os, s, m, lo - 1);
+    }
+    if (j > 0) {
+        double u = upper_dev(os, s, m, j - 1);
+        if (u > result) {
+            result = u;
+        }
+    }
+    return result;
+}
+
+double order_stats_mad(const OrderStats *os, double median) {
+    int n = order_stats_count(os);
+    double sum_below;
+    int s = count_below(os, median, &sum_below);
+    if (n % 2 == 1) {
+        return kth_deviation(os, n, s, median, n / 2);
+    }
+    return (kth_deviation(os, n, s, median, n / 2 - 1) +
+            kth_deviation(os, n, s, median, n / 2)) / 2.0;
+}
+
+double order_stats_mean_abs_dev(const OrderStats *os, double median) {
+    int n = order_stats_count(os);
+    double sum_below;
+    int below = count_below(os, median, &sum_below);
+    // 大于等于m的部分贡献(S - S_lt) - m(n - c_lt)，小于m的部分贡献m*c_lt - S_lt
+    double total = node_sum(os, os->root);
+    double dev = total - 2.0 * sum_below - median * (n - 2.0 * below);
+    return dev > 0 ? dev / n : 0.0;
+}
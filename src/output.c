@@ -0,0 +1,304 @@
+#include "../include/output.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// 保证数组至少还能容纳一个元素，容量按倍数增长
+static int reserve_one(void **array, int count, int *capacity, size_t elem_size) {
+    if (count < *capacity) {
+        return 0;
+    }
+
+    int new_capacity = *capacity > 0 ? *capacity * 2 : 32;
+    void *new_array = realloc(*array, elem_size * new_capacity);
+    if (!new_array) {
+        return -1;
+    }
+    *array = new_array;
+    *capacity = new_capacity;
+    return 0;
+}
+
+void output_batch_init(OutputBatch *batch) {
+    memset(batch, 0, sizeof(*batch));
+}
+
+void output_batch_free(OutputBatch *batch) {
+    if (!batch) {
+        return;
+    }
+    free(batch->labels);
+    free(batch->reports);
+    free(batch->events);
+    memset(batch, 0, sizeof(*batch));
+}
+
+void output_batch_reset(OutputBatch *batch) {
+    batch->cycle = 0;
+    batch->timestamp_ns = 0;
+    batch->detected = false;
+    batch->label_count = 0;
+    batch->report_count = 0;
+    batch->event_count = 0;
+    batch->alerts_firing = 0;
+    batch->processes.process_count = 0;
+    batch->processes.cpu_count = 0;
+    batch->processes.mem_count = 0;
+}
+
+int output_batch_add_label(OutputBatch *batch, const Metric *metric, int metric_id) {
+    if (reserve_one((void **)&batch->labels, batch->label_count,
+                    &batch->label_capacity, sizeof(MetricLabel)) != 0) {
+        return -1;
+    }
+
+    MetricLabel *label = &batch->labels[batch->label_count++];
+    label->metric_id = metric_id;
+    memcpy(label->name, metric->name, sizeof(label->name));
+    memcpy(label->description, metric->description, sizeof(label->description));
+    return 0;
+}
+
+int output_batch_add_report(OutputBatch *batch, const Metric *metric, int metric_id) {
+    if (reserve_one((void **)&batch->reports, batch->report_count,
+                    &batch->report_capacity, sizeof(MetricReport)) != 0) {
+        return -1;
+    }
+
+    MetricReport *report = &batch->reports[batch->report_count++];
+    report->metric_id = metric_id;
+    report->value = metric->value;
+    report->threshold = metric->threshold;
+    report->mean = metric->mean;
+    report->stddev = metric->stddev;
+    report->robust = metric->detector == DETECTOR_MAD;
+    report->median = metric->median;
+    report->mad = metric->mad;
+    report->has_stats = metric->history_size >= 3;
+    return 0;
+}
+
+int output_batch_copy_events(OutputBatch *batch, const AlertTracker *tracker) {
+    if (tracker->event_count > batch->event_capacity) {
+        AlertEvent *new_events = (AlertEvent *)realloc(batch->events,
+                                                       sizeof(AlertEvent) * tracker->event_count);
+        if (!new_events) {
+            return -1;
+        }
+        batch->events = new_events;
+        batch->event_capacity = tracker->event_count;
+    }
+
+    if (tracker->event_count > 0) {
+        memcpy(batch->events, tracker->events, sizeof(AlertEvent) * tracker->event_count);
+    }
+    batch->event_count = tracker->event_count;
+    batch->alerts_firing = tracker->firing;
+    return 0;
+}
+
+void output_sink_init(OutputSink *sink) {
+    memset(sink, 0, sizeof(*sink));
+}
+
+void output_sink_free(OutputSink *sink) {
+    if (!sink) {
+        return;
+    }
+    free(sink->labels);
+    memset(sink, 0, sizeof(*sink));
+}
+
+int output_sink_apply_labels(OutputSink *sink, const OutputBatch *batch) {
+    for (int i = 0; i < batch->label_count; i++) {
+        const MetricLabel *label = &batch->labels[i];
+        if (label->metric_id >= sink->capacity) {
+            int new_capacity = sink->capacity > 0 ? sink->capacity : 32;
+            while (new_capacity <= label->metric_id) {
+                new_capacity *= 2;
+            }
+            MetricLabel *new_labels = (MetricLabel *)realloc(sink->labels,
+                                                             sizeof(MetricLabel) * new_capacity);
+            if (!new_labels) {
+                return -1;
+            }
+            memset(new_labels + sink->capacity, 0,
+                   sizeof(MetricLabel) * (new_capacity - sink->capacity));
+            sink->labels = new_labels;
+            sink->capacity = new_capacity;
+        }
+        sink->labels[label->metric_id] = *label;
+    }
+    return 0;
+}
+
+// 按指标下标查找名称
+static const char *sink_metric_name(const OutputSink *sink, int metric_id) {
+    if (metric_id < 0 || metric_id >= sink->capacity || sink->labels[metric_id].name[0] == '\0') {
+        return "unknown";
+    }
+    return sink->labels[metric_id].name;
+}
+
+// 按指标下标查找描述，用于格式化异常信息
+static const char *sink_metric_description(const OutputSink *sink, int metric_id) {
+    if (metric_id < 0 || metric_id >= sink->capacity || sink->labels[metric_id].name[0] == '\0') {
+        return "unknown";
+    }
+    return sink->labels[metric_id].description;
+}
+
+void print_output_batch(const OutputSink *sink, const OutputBatch *batch) {
+    printf("\n--- 周期 %lu ---\n", batch->cycle);
+
+    // 打印当前指标值
+    printf("当前指标值:\n");
+    for (int i = 0; i < batch->report_count; i++) {
+        const MetricReport *report = &batch->reports[i];
+        printf("  %s: %.2f", sink_metric_name(sink, report->metric_id), report->value);
+
+        // 如果有足够的历史数据，显示统计信息
+        if (report->has_stats && report->robust) {
+            printf(" (中位数: %.2f, MAD: %.2f)", report->median, report->mad);
+        } else if (report->has_stats) {
+            printf(" (均值: %.2f, 标准差: %.2f)", report->mean, report->stddev);
+        }
+        printf("\n");
+    }
+
+    if (batch->detected) {
+        print_alerts(sink, batch);
+    } else {
+        printf("收集更多数据点以进行异常检测...\n");
+    }
+}
+
+int format_process_top(const OutputBatch *batch, MetricType type, char *buf, size_t size) {
+    const ProcessTop *top = &batch->processes;
+    bool cpu = type == METRIC_CPU_USAGE;
+    bool mem = type == METRIC_MEM_USAGE || type == METRIC_MEM_ACTIVE;
+    int count = cpu ? top->cpu_count : mem ? top->mem_count : 0;
+    if (count == 0 || size == 0) {
+        return 0;
+    }
+
+    const ProcessUsage *list = cpu ? top->cpu : top->mem;
+    size_t used = 0;
+    buf[0] = '\0';
+    for (int i = 0; i < count && used < size; i++) {
+        int len = cpu ? snprintf(buf + used, size - used, "%s%s(%d):%.1f%%", i > 0 ? "," : "",
+                                 list[i].comm, list[i].pid, list[i].cpu_percent)
+                      : snprintf(buf + used, size - used, "%s%s(%d):%luKB", i > 0 ? "," : "",
+                                 list[i].comm, list[i].pid, list[i].rss_kb);
+        if (len < 0) {
+            break;
+        }
+        used += (size_t)len;
+    }
+    return (int)(used < size ? used : size - 1);
+}
+
+void print_alerts(const OutputSink *sink, const OutputBatch *batch) {
+    if (!sink || !batch) {
+        return;
+    }
+
+    if (batch->event_count == 0) {
+        if (batch->alerts_firing > 0) {
+            printf("%d 个告警持续中\n", batch->alerts_firing);
+        } else {
+            printf("没有检测到异常\n");
+        }
+        return;
+    }
+
+    printf("告警事件 %d 个（持续中 %d 个）:\n", batch->event_count, batch->alerts_firing);
+    printf("---------------------------------------------------\n");
+
+    for (int i = 0; i < batch->event_count; i++) {
+        const AlertEvent *event = &batch->events[i];
+        char time_str[64];
+        char sources[64];
+        struct tm *tm_info = localtime(&event->timestamp);
+        strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", tm_info);
+        alert_source_names(event->sources, sources, sizeof(sources));
+
+        if (event->kind == ALERT_EVENT_FIRING) {
+            printf("告警触发 #%d:\n", i + 1);
+            printf("  时间: %s\n", time_str);
+            printf("  指标: %s\n", sink_metric_name(sink, event->metric_id));
+            char message[256];
+            format_anomaly(&event->anomaly, sink_metric_description(sink, event->metric_id),
+                           message, sizeof(message));
+            printf("  消息: %s\n", message);
+            printf("  检测: %s\n", sources);
+            printf("  严重程度: %d/5\n", event->severity);
+            char processes[512];
+            if (format_process_top(batch, event->type, processes, sizeof(processes)) > 0) {
+                printf("  占用最高的进程: %s\n", processes);
+            }
+        } else {
+            printf("告警恢复 #%d:\n", i + 1);
+            printf("  时间: %s\n", time_str);
+            printf("  指标: %s\n", sink_metric_name(sink, event->metric_id));
+            printf("  当前值: %.2f（峰值: %.2f）\n", event->value, event->peak);
+            printf("  持续: %.1f秒，异常周期 %lu 个\n", (double)event->duration_ns / 1e9, event->anomalies);
+            printf("  最高严重程度: %d/5\n", event->severity);
+        }
+        printf("---------------------------------------------------\n");
+    }
+}
+
+int log_alerts(const OutputSink *sink, const OutputBatch *batch, LogWriter *writer) {
+    if (!sink || !batch || !writer) {
+        return -1;
+    }
+
+    // 多条记录先拼接到本地缓冲区，按块追加，减少加锁次数
+    char chunk[8192];
+    size_t used = 0;
+    int ret = 0;
+
+    for (int i = 0; i < batch->event_count; i++) {
+        const AlertEvent *event = &batch->events[i];
+        char line[1024];
+        char processes[512] = "";
+        if (event->kind == ALERT_EVENT_FIRING) {
+            format_process_top(batch, event->type, processes, sizeof(processes));
+        }
+        int len = alert_event_format(event, log_writer_time(writer, event->timestamp),
+                                     sink_metric_name(sink, event->metric_id),
+                                     sink_metric_description(sink, event->metric_id), processes,
+                                     line, sizeof(line));
+        if (len < 0) {
+            continue;
+        }
+
+        if (used + (size_t)len > sizeof(chunk)) {
+            ret |= log_writer_append(writer, chunk, used);
+            used = 0;
+        }
+        memcpy(chunk + used, line, (size_t)len);
+        used += (size_t)len;
+    }
+
+    if (used > 0) {
+        ret |= log_writer_append(writer, chunk, used);
+    }
+    return ret;
+}
+
+int record_alerts(const OutputSink *sink, const OutputBatch *batch, AlertLog *log) {
+    if (!sink || !batch || !log) {
+        return -1;
+    }
+
+    int ret = 0;
+    for (int i = 0; i < batch->event_count; i++) {
+        const AlertEvent *event = &batch->events[i];
+        ret |= alert_log_append(log, event, sink_metric_name(sink, event->metric_id),
+                                sink_metric_description(sink, event->metric_id));
+    }
+    return ret;
+}
@@ -0,0 +1,595 @@
+#include "../include/pipeline.h"
+#include "../include/metrics_collector.h"
+#include "../include/checkpoint.h"
+#include "../include/config.h"
+#include "../include/latency.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+// 取用新发布的配置：设备和接口列表已由重新加载的一方检查过，被排除的来源在本周期退役
+static void collector_reload(Pipeline *p) {
+    RuntimeConfig *cfg = atomic_load_explicit(&p->runtime, memory_order_acquire);
+    if (cfg->generation == atomic_load_explicit(&p->collector_generation, memory_order_relaxed)) {
+        return;
+    }
+    if (set_collector_filters(p->config.collector, cfg->disk_devices, cfg->net_interfaces) != 0) {
+        fprintf(stderr, "警告: 磁盘设备或网络接口列表过长，保留原来的设置\n");
+    }
+    atomic_store_explicit(&p->collector_generation, cfg->generation, memory_order_release);
+}
+
+// 采集一个周期：写入队列中的空闲槽位，队列满时写入临时批次并丢弃样本，
+// 但保留其中的序列事件，随下一个成功发送的批次送达
+static void collect_cycle(Pipeline *p) {
+    SampleBatch *slot = (SampleBatch *)spsc_ring_reserve(&p->sample_ring);
+    SampleBatch *batch = slot ? slot : &p->overflow;
+
+    sample_batch_reset(batch);
+    sample_batch_append_events(batch, &p->carry);
+    sample_batch_reset(&p->carry);
+
+    int timeouts = 0;
+    if (collect_samples(p->config.collector, batch, &timeouts) != 0) {
+        atomic_fetch_add_explicit(&p->counters.collect_errors, 1, memory_order_relaxed);
+    }
+    if (timeouts > 0) {
+        atomic_fetch_add_explicit(&p->counters.source_timeouts, (unsigned long)timeouts,
+                                  memory_order_relaxed);
+    }
+    atomic_fetch_add_explicit(&p->counters.cycles, 1, memory_order_relaxed);
+
+    if (slot) {
+        spsc_ring_publish(&p->sample_ring);
+    } else {
+        sample_batch_append_events(&p->carry, batch);
+        atomic_fetch_add_explicit(&p->counters.dropped_samples, 1, memory_order_relaxed);
+    }
+}
+
+// 记录触发器报告的压力；不支持触发器的资源按两次采集之间的停顿比例判断
+static void check_pressure(Pipeline *p) {
+    Scheduler *sched = &p->scheduler;
+    unsigned int fired = sched->fired;
+    sched->fired = 0;
+
+    if (p->psi_polling) {
+        unsigned int mask = psi_monitor_check(&p->psi, monotonic_ns());
+        if (mask) {
+            scheduler_burst(sched);
+            fired |= mask;
+        }
+    }
+
+    if (fired) {
+        atomic_fetch_or_explicit(&p->pressure_resources, fired, memory_order_relaxed);
+    }
+    if (sched->bursts != p->seen_bursts) {
+        atomic_fetch_add_explicit(&p->counters.pressure_bursts, sched->bursts - p->seen_bursts,
+                                  memory_order_relaxed);
+        p->seen_bursts = sched->bursts;
+    }
+}
+
+static void *collector_main(void *arg) {
+    Pipeline *p = (Pipeline *)arg;
+
+    while (!atomic_load(&p->stopping)) {
+        collector_reload(p);
+        collect_cycle(p);
+        if (p->psi_enabled) {
+            check_pressure(p);
+        }
+
+        // 等待下一个采样周期，被中断时继续等待同一个截止时间
+        int missed;
+        while ((missed = scheduler_wait(&p->scheduler)) < 0 && !atomic_load(&p->stopping)) {
+        }
+        if (missed > 0) {
+            atomic_fetch_add_explicit(&p->counters.missed_deadlines, (unsigned long)missed,
+                                      memory_order_relaxed);
+        }
+    }
+    return NULL;
+}
+
+// 扩展已发送标签表，新槽位置为0（注册编号从1开始）
+static int grow_published(Pipeline *p, int count) {
+    if (count <= p->published_capacity) {
+        return 0;
+    }
+
+    int new_capacity = p->published_capacity > 0 ? p->published_capacity : 32;
+    while (new_capacity < count) {
+        new_capacity *= 2;
+    }
+    unsigned long *new_published = (unsigned long *)realloc(p->published,
+                                                            sizeof(unsigned long) * new_capacity);
+    if (!new_published) {
+        return -1;
+    }
+    memset(new_published + p->published_capacity, 0,
+           sizeof(unsigned long) * (new_capacity - p->published_capacity));
+    p->published = new_published;
+    p->published_capacity = new_capacity;
+    return 0;
+}
+
+// 生成输出批次：新注册指标的标签、在用指标的当前值和尚未发送的告警事件
+static void fill_output_batch(Pipeline *p, OutputBatch *out, bool detected) {
+    AnomalyDetector *detector = &p->detector;
+
+    output_batch_reset(out);
+    out->cycle = p->cycle;
+    if (grow_published(p, detector->metric_count) != 0) {
+        return;
+    }
+
+    for (int i = 0; i < detector->metric_count; i++) {
+        const Metric *metric = &detector->metrics[i];
+        if (!metric->active) {
+            continue;
+        }
+        if (p->published[i] != metric->incarnation) {
+            output_batch_add_label(out, metric, i);
+        }
+        output_batch_add_report(out, metric, i);
+    }
+
+    out->detected = detected;
+    if (output_batch_copy_events(out, &p->alerts) == 0) {
+        alert_tracker_clear_events(&p->alerts);
+    }
+}
+
+static void save_checkpoint(Pipeline *p) {
+    if (save_forecast_checkpoint(&p->detector, p->config.checkpoint_file,
+                                 monotonic_to_realtime_ns(monotonic_ns())) < 0) {
+        fprintf(stderr, "警告: 无法保存预测模型检查点 %s\n", p->config.checkpoint_file);
+    }
+}
+
+// 应用检测相关的配置，只改变参数，窗口、统计量和预测模型都保留
+static int apply_detector_config(AnomalyDetector *detector, const RuntimeConfig *cfg) {
+    int ret = 0;
+    detector->sigma_factor = cfg->sigma_factor;
+    for (int kind = DETECTOR_NSIGMA + 1; kind < DETECTOR_COUNT; kind++) {
+        if (set_detector_metrics(detector, (DetectorKind)kind, cfg->detector_metrics[kind]) != 0) {
+            ret = -1;
+        }
+    }
+    if (set_metric_settings(detector, cfg->settings, cfg->setting_count) != 0) {
+        ret = -1;
+    }
+    if (set_correlation_groups(detector, cfg->correlation_groups) != 0) {
+        ret = -1;
+    }
+    return ret;
+}
+
+// 取用新发布的配置
+static void detector_reload(Pipeline *p) {
+    RuntimeConfig *cfg = atomic_load_explicit(&p->runtime, memory_order_acquire);
+    if (cfg->generation == atomic_load_explicit(&p->detector_generation, memory_order_relaxed)) {
+        return;
+    }
+    if (apply_detector_config(&p->detector, cfg) != 0) {
+        fprintf(stderr, "警告: 应用配置版本 %lu 时内存不足，部分检测设置未生效\n", cfg->generation);
+    }
+    atomic_store_explicit(&p->detector_generation, cfg->generation, memory_order_release);
+}
+
+static void detect_cycle(Pipeline *p, const SampleBatch *batch) {
+    AnomalyDetector *detector = &p->detector;
+    uint64_t cycle_start_ns = monotonic_ns();
+
+    detector_reload(p);
+
+    apply_sample_batch(detector, batch);
+    uint64_t start_ns = latency_record(LATENCY_APPLY, cycle_start_ns);
+    p->cycle++;
+
+    // 恢复的指标在前两个周期内仍没有对应序列的，说明来源已不存在
+    if ((p->restored > 0 || p->forecasts_restored > 0) && p->cycle == 2) {
+        retire_unmapped_metrics(detector);
+    }
+
+    // 持久化本周期的值，只是内存写操作
+    if (p->series_enabled) {
+        series_store_append(&p->series, detector, batch->timestamp_ns);
+        start_ns = latency_record(LATENCY_SERIES, start_ns);
+    }
+
+    // 需要足够的历史数据才能进行异常检测，恢复的窗口计入在内
+    bool detected = p->cycle + (unsigned long)p->restored >= 3;
+    anomaly_arena_reset(&detector->anomalies);
+    if (detected) {
+        detect_anomalies_nsigma(detector);
+        start_ns = latency_record(LATENCY_DETECT_NSIGMA, start_ns);
+        detect_anomalies_mad(detector);
+        start_ns = latency_record(LATENCY_DETECT_MAD, start_ns);
+        detect_anomalies_forecast(detector);
+        start_ns = latency_record(LATENCY_DETECT_FORECAST, start_ns);
+        detect_anomalies_threshold(detector);
+        start_ns = latency_record(LATENCY_DETECT_THRESHOLD, start_ns);
+        detect_anomalies_correlation(detector);
+        start_ns = latency_record(LATENCY_DETECT_CORRELATION, start_ns);
+
+        // 合并各检测器的判定，持续的异常只在触发和恢复时产生事件
+        alert_tracker_update(&p->alerts, detector, batch->timestamp_ns);
+        latency_record(LATENCY_ALERT, start_ns);
+    }
+
+    // 定期保存预测模型，检查点很小（每个序列几百字节）
+    if (p->config.checkpoint_file && batch->timestamp_ns >= p->next_checkpoint_ns) {
+        if (p->next_checkpoint_ns > 0) {
+            save_checkpoint(p);
+        }
+        p->next_checkpoint_ns = batch->timestamp_ns + (uint64_t)FORECAST_CHECKPOINT_SEC * NSEC_PER_SEC;
+    }
+
+    OutputBatch *out = (OutputBatch *)spsc_ring_reserve(&p->output_ring);
+    if (!out) {
+        // 标签和告警事件未发送，下一个成功发送的批次会重新携带
+        atomic_fetch_add_explicit(&p->counters.dropped_outputs, 1, memory_order_relaxed);
+        latency_record(LATENCY_DETECT, cycle_start_ns);
+        return;
+    }
+
+    fill_output_batch(p, out, detected);
+    out->timestamp_ns = batch->timestamp_ns;
+    out->processes = batch->processes;
+    for (int i = 0; i < out->label_count; i++) {
+        int id = out->labels[i].metric_id;
+        p->published[id] = detector->metrics[id].incarnation;
+    }
+    latency_record(LATENCY_DETECT, cycle_start_ns);
+    spsc_ring_publish(&p->output_ring);
+}
+
+static void *detector_main(void *arg) {
+    Pipeline *p = (Pipeline *)arg;
+
+    for (;;) {
+        SampleBatch *batch = (SampleBatch *)spsc_ring_wait(&p->sample_ring);
+        if (!batch) {
+            // 采集线程退出后排空队列再退出
+            if (atomic_load(&p->collector_done) && !spsc_ring_peek(&p->sample_ring)) {
+                break;
+            }
+            continue;
+        }
+        detect_cycle(p, batch);
+        spsc_ring_release(&p->sample_ring);
+    }
+
+    // 退出前保存一次，重启后从最新状态继续
+    if (p->config.checkpoint_file) {
+        save_checkpoint(p);
+    }
+    return NULL;
+}
+
+// 计数器增长时报告
+static void report_counter(atomic_ulong *counter, unsigned long *seen, const char *what) {
+    unsigned long value = atomic_load_explicit(counter, memory_order_relaxed);
+    if (value != *seen) {
+        fprintf(stderr, "警告: %s %lu 个（累计 %lu 个）\n", what, value - *seen, value);
+        *seen = value;
+    }
+}
+
+// 报告资源压力触发的突发采样
+static void report_pressure(Pipeline *p, unsigned long *seen) {
+    unsigned long bursts = atomic_load_explicit(&p->counters.pressure_bursts, memory_order_relaxed);
+    if (bursts == *seen) {
+        return;
+    }
+    *seen = bursts;
+
+    unsigned int mask = atomic_exchange_explicit(&p->pressure_resources, 0, memory_order_relaxed);
+    char resources[64] = "";
+    size_t used = 0;
+    for (int i = 0; i < PSI_RESOURCE_COUNT; i++) {
+        if (mask & (1u << i)) {
+            used += (size_t)snprintf(resources + used, sizeof(resources) - used, "%s%s",
+                                     used > 0 ? "、" : "", psi_resource_name((PsiResource)i));
+        }
+    }
+    printf("资源压力（%s）超过阈值，切换到%.0f毫秒突发采样（累计 %lu 次）\n",
+           used > 0 ? resources : "未知", (double)p->config.burst_interval_ns / NSEC_PER_MSEC, bursts);
+}
+
+static void *output_main(void *arg) {
+    Pipeline *p = (Pipeline *)arg;
+    unsigned long seen_bursts = 0;
+    unsigned long seen_errors = 0;
+    unsigned long seen_missed = 0;
+    unsigned long seen_timeouts = 0;
+    unsigned long seen_dropped_samples = 0;
+    unsigned long seen_dropped_outputs = 0;
+
+    for (;;) {
+        OutputBatch *out = (OutputBatch *)spsc_ring_wait(&p->output_ring);
+        if (!out) {
+            if (atomic_load(&p->detector_done) && !spsc_ring_peek(&p->output_ring)) {
+                break;
+            }
+            continue;
+        }
+
+        uint64_t start_ns = monotonic_ns();
+        output_sink_apply_labels(&p->sink, out);
+        print_output_batch(&p->sink, out);
+        start_ns = latency_record(LATENCY_PRINT, start_ns);
+
+        // 记录告警事件到日志
+        if (out->event_count > 0) {
+            if (log_alerts(&p->sink, out, &p->log) != 0) {
+                fprintf(stderr, "警告: 无法写入日志文件 %s\n", p->config.log_file);
+            }
+            if (p->alert_log_enabled &&
+                record_alerts(&p->sink, out, &p->alert_log) != 0) {
+                fprintf(stderr, "警告: 无法写入告警日志文件 %s\n", p->config.alert_log_file);
+            }
+            start_ns = latency_record(LATENCY_LOG, start_ns);
+        }
+
+        // 渲染并发布指标页面，抓取只读取已发布的页面
+        if (p->exposition_enabled) {
+            ExpositionCounters counters = {
+                .cycles = atomic_load_explicit(&p->counters.cycles, memory_order_relaxed),
+                .collect_errors = atomic_load_explicit(&p->counters.collect_errors, memory_order_relaxed),
+                .missed_deadlines = atomic_load_explicit(&p->counters.missed_deadlines, memory_order_relaxed),
+                .source_timeouts = atomic_load_explicit(&p->counters.source_timeouts, memory_order_relaxed),
+                .dropped_samples = atomic_load_explicit(&p->counters.dropped_samples, memory_order_relaxed),
+                .dropped_outputs = atomic_load_explicit(&p->counters.dropped_outputs, memory_order_relaxed),
+                .pressure_bursts = atomic_load_explicit(&p->counters.pressure_bursts, memory_order_relaxed),
+            };
+            exposition_publish(&p->exposition, &p->sink, out, &counters);
+            start_ns = latency_record(LATENCY_EXPOSITION, start_ns);
+        }
+        if (out->timestamp_ns > 0 && start_ns > out->timestamp_ns) {
+            latency_add(LATENCY_END_TO_END, start_ns - out->timestamp_ns);
+        }
+
+        report_pressure(p, &seen_bursts);
+        report_counter(&p->counters.collect_errors, &seen_errors, "收集指标出错的周期");
+        report_counter(&p->counters.missed_deadlines, &seen_missed, "错过采样截止时间");
+        report_counter(&p->counters.source_timeouts, &seen_timeouts, "数据源读取超时");
+        report_counter(&p->counters.dropped_samples, &seen_dropped_samples, "检测队列已满，丢弃采样批次");
+        report_counter(&p->counters.dropped_outputs, &seen_dropped_outputs, "输出队列已满，丢弃输出批次");
+
+        spsc_ring_release(&p->output_ring);
+    }
+    return NULL;
+}
+
+// 释放流水线的全部资源（线程已回收或未启动）
+static void pipeline_free(Pipeline *p) {
+    if (p->sample_ring.slots) {
+        for (unsigned long i = 0; i < spsc_ring_capacity(&p->sample_ring); i++) {
+            sample_batch_free((SampleBatch *)spsc_ring_slot(&p->sample_ring, i));
+        }
+        spsc_ring_free(&p->sample_ring);
+    }
+    if (p->output_ring.slots) {
+        for (unsigned long i = 0; i < spsc_ring_capacity(&p->output_ring); i++) {
+            output_batch_free((OutputBatch *)spsc_ring_slot(&p->output_ring, i));
+        }
+        spsc_ring_free(&p->output_ring);
+    }
+    sample_batch_free(&p->carry);
+    sample_batch_free(&p->overflow);
+    free(p->published);
+    p->published = NULL;
+    p->published_capacity = 0;
+    free_detector(&p->detector);
+    alert_tracker_free(&p->alerts);
+    if (p->series_enabled) {
+        series_store_close(&p->series);
+        p->series_enabled = false;
+    }
+    output_sink_free(&p->sink);
+    log_writer_close(&p->log);
+    if (p->alert_log_enabled) {
+        alert_log_close(&p->alert_log);
+        p->alert_log_enabled = false;
+    }
+    if (p->exposition_enabled) {
+        exposition_stop(&p->exposition);
+        p->exposition_enabled = false;
+    }
+    if (p->wake_fd >= 0) {
+        close(p->wake_fd);
+        p->wake_fd = -1;
+    }
+    if (p->psi_enabled) {
+        psi_monitor_close(&p->psi);
+        p->psi_enabled = false;
+    }
+    runtime_config_free(atomic_load(&p->runtime));
+    atomic_store(&p->runtime, NULL);
+    while (p->retired) {
+        RuntimeConfig *next = p->retired->next_retired;
+        runtime_config_free(p->retired);
+        p->retired = next;
+    }
+}
+
+int pipeline_start(Pipeline *pipeline, const PipelineConfig *config) {
+    if (!pipeline || !config || !config->runtime || !config->collector || config->queue_depth == 0) {
+        return -1;
+    }
+
+    Pipeline *p = pipeline;
+    memset(p, 0, sizeof(*p));
+    p->config = *config;
+    p->wake_fd = -1;
+    config->runtime->generation = 1;
+    atomic_store(&p->runtime, config->runtime);
+    p->config.runtime = NULL;
+    atomic_store(&p->collector_generation, 1);
+    atomic_store(&p->detector_generation, 1);
+    sample_batch_init(&p->carry);
+    sample_batch_init(&p->overflow);
+    output_sink_init(&p->sink);
+
+    // 队列槽位由calloc清零，即已初始化的空批次
+    if (init_detector(&p->detector, config->window_size, config->runtime->sigma_factor) != 0 ||
+        alert_tracker_init(&p->alerts, config->alert_pending_ns, config->alert_resolve_ns,
+                           ALERT_HYSTERESIS) != 0 ||
+        spsc_ring_init(&p->sample_ring, config->queue_depth, sizeof(SampleBatch)) != 0 ||
+        spsc_ring_init(&p->output_ring, config->queue_depth, sizeof(OutputBatch)) != 0) {
+        pipeline_free(p);
+        return -1;
+    }
+
+    // 先选好各指标的检测器，恢复的数据同时训练预测模型
+    set_detector_clock(&p->detector, (int64_t)monotonic_to_realtime_ns(0));
+    if (config->season_ns > 0) {
+        p->detector.forecast_params.season_ns = config->season_ns;
+    }
+    if (apply_detector_config(&p->detector, config->runtime) != 0 ||
+        set_collector_filters(config->collector, config->runtime->disk_devices,
+                              config->runtime->net_interfaces) != 0) {
+        pipeline_free(p);
+        return -1;
+    }
+
+    // 从序列文件恢复最近一个窗口的数据，然后继续追加
+    if (config->series_file) {
+        uint64_t window_ns = (uint64_t)config->window_size * config->interval_ns;
+        uint64_t now = monotonic_to_realtime_ns(monotonic_ns());
+        p->restored = series_store_restore(config->series_file, &p->detector,
+                                           now > window_ns ? now - window_ns : 0);
+        if (p->restored > config->window_size) {
+            p->restored = config->window_size;
+        }
+        if (series_store_open(&p->series, config->series_file, config->interval_ns) == 0) {
+            p->series_enabled = true;
+        } else {
+            fprintf(stderr, "警告: 无法打开序列文件 %s，不持久化指标历史\n", config->series_file);
+        }
+    }
+
+    // 检查点比恢复的窗口新，覆盖由窗口训练出的模型状态
+    if (config->checkpoint_file) {
+        p->forecasts_restored = load_forecast_checkpoint(&p->detector, config->checkpoint_file);
+    }
+
+    if (log_writer_open(&p->log, config->log_file, NULL) != 0) {
+        fprintf(stderr, "错误: 无法打开日志文件 %s\n", config->log_file);
+        pipeline_free(p);
+        return -1;
+    }
+    if (config->alert_log_file) {
+        if (alert_log_open(&p->alert_log, config->alert_log_file) != 0) {
+            fprintf(stderr, "错误: 无法打开告警日志文件 %s\n", config->alert_log_file);
+            pipeline_free(p);
+            return -1;
+        }
+        p->alert_log_enabled = true;
+    }
+
+    if (config->metrics_address) {
+        if (exposition_start(&p->exposition, config->metrics_address) != 0) {
+            pipeline_free(p);
+            return -1;
+        }
+        p->exposition_enabled = true;
+    }
+
+    p->wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (p->wake_fd < 0 || scheduler_init(&p->scheduler, config->interval_ns) != 0) {
+        pipeline_free(p);
+        return -1;
+    }
+    scheduler_set_wake_fd(&p->scheduler, p->wake_fd);
+
+    // 资源压力触发突发采样，不支持PSI的内核上只按固定间隔采样
+    if (config->burst_interval_ns > 0 && config->burst_interval_ns < config->interval_ns &&
+        psi_monitor_open(&p->psi, PSI_STALL_US, PSI_WINDOW_US) == 0) {
+        p->psi_enabled = true;
+        p->psi_polling = psi_monitor_polling(&p->psi);
+        scheduler_set_burst(&p->scheduler, config->burst_interval_ns,
+                            (uint64_t)BURST_DURATION_SEC * NSEC_PER_SEC, p->psi.poll_fds, PSI_RESOURCE_COUNT);
+    }
+
+    if (pthread_create(&p->output_thread, NULL, output_main, p) != 0) {
+        pipeline_free(p);
+        return -1;
+    }
+    if (pthread_create(&p->detector_thread, NULL, detector_main, p) != 0) {
+        atomic_store(&p->detector_done, true);
+        spsc_ring_wake(&p->output_ring);
+        pthread_join(p->output_thread, NULL);
+        pipeline_free(p);
+        return -1;
+    }
+    if (pthread_create(&p->collector_thread, NULL, collector_main, p) != 0) {
+        atomic_store(&p->collector_done, true);
+        spsc_ring_wake(&p->sample_ring);
+        pthread_join(p->detector_thread, NULL);
+        atomic_store(&p->detector_done, true);
+        spsc_ring_wake(&p->output_ring);
+        pthread_join(p->output_thread, NULL);
+        pipeline_free(p);
+        return -1;
+    }
+    return 0;
+}
+
+void pipeline_stop(Pipeline *pipeline) {
+    if (!pipeline) {
+        return;
+    }
+
+    Pipeline *p = pipeline;
+
+    // 唤醒正在等待截止时间的采集线程
+    atomic_store(&p->stopping, true);
+    uint64_t one = 1;
+    if (write(p->wake_fd, &one, sizeof(one)) < 0) {
+        // eventfd计数溢出时采集线程已处于唤醒状态
+    }
+    pthread_join(p->collector_thread, NULL);
+
+    // 按流水线顺序逐级排空
+    atomic_store(&p->collector_done, true);
+    spsc_ring_wake(&p->sample_ring);
+    pthread_join(p->detector_thread, NULL);
+
+    atomic_store(&p->detector_done, true);
+    spsc_ring_wake(&p->output_ring);
+    pthread_join(p->output_thread, NULL);
+
+    pipeline_free(p);
+}
+
+unsigned long pipeline_reload(Pipeline *pipeline, RuntimeConfig *config) {
+    Pipeline *p = pipeline;
+    RuntimeConfig *old = atomic_load_explicit(&p->runtime, memory_order_relaxed);
+    config->generation = old->generation + 1;
+    atomic_store_explicit(&p->runtime, config, memory_order_release);
+    old->next_retired = p->retired;
+    p->retired = old;
+
+    // 两个线程都已应用更新的版本后，不会再有线程访问更早的配置
+    unsigned long collector = atomic_load_explicit(&p->collector_generation, memory_order_acquire);
+    unsigned long detector = atomic_load_explicit(&p->detector_generation, memory_order_acquire);
+    unsigned long applied = collector < detector ? collector : detector;
+    RuntimeConfig **link = &p->retired;
+    while (*link) {
+        RuntimeConfig *retired = *link;
+        if (retired->generation < applied) {
+            *link = retired->next_retired;
+            runtime_config_free(retired);
+        } else {
+            link = &retired->next_retired;
+        }
+    }
+    return config->generation;
+}
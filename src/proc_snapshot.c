@@ -0,0 +1,477 @@
+#include "../include/proc_snapshot.h"
+#include "../include/scheduler.h"
+#include "../include/latency.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define PROC_INITIAL_BUFFER 4096    // 读缓冲区初始大小
+#define PROC_INITIAL_ENTRIES 16     // 设备/接口数组初始容量
+
+// 各数据源相对procfs根目录的路径
+static const char *const source_paths[PROC_SRC_COUNT] = {
+    [PROC_SRC_STAT] = "stat",
+    [PROC_SRC_MEMINFO] = "meminfo",
+    [PROC_SRC_DISKSTATS] = "diskstats",
+    [PROC_SRC_NETDEV] = "net/dev",
+};
+
+/* 扫描器：在缓冲区上顺序解析，不分配内存 */
+typedef struct {
+    const char *p;
+    const char *end;
+} Scanner;
+
+static inline void scan_skip_spaces(Scanner *s) {
+    while (s->p < s->end && (*s->p == ' ' || *s->p == '\t')) {
+        s->p++;
+    }
+}
+
+static inline void scan_skip_line(Scanner *s) {
+    while (s->p < s->end && *s->p != '\n') {
+        s->p++;
+    }
+    if (s->p < s->end) {
+        s->p++;
+    }
+}
+
+static inline int scan_at_end(const Scanner *s) {
+    return s->p >= s->end;
+}
+
+// 解析一个无符号十进制整数，行尾或非数字时返回-1且不移动位置
+static inline int scan_ull(Scanner *s, unsigned long long *out) {
+    scan_skip_spaces(s);
+    if (s->p >= s->end || *s->p < '0' || *s->p > '9') {
+        return -1;
+    }
+    unsigned long long v = 0;
+    while (s->p < s->end && *s->p >= '0' && *s->p <= '9') {
+        v = v * 10 + (unsigned long long)(*s->p - '0');
+        s->p++;
+    }
+    *out = v;
+    return 0;
+}
+
+static inline int scan_ul(Scanner *s, unsigned long *out) {
+    unsigned long long v;
+    if (scan_ull(s, &v) != 0) {
+        return -1;
+    }
+    *out = (unsigned long)v;
+    return 0;
+}
+
+// 读取一个名字，遇到空白、换行或stop字符结束，超长部分截断
+static inline int scan_name(Scanner *s, char *out, size_t size, char stop) {
+    scan_skip_spaces(s);
+    size_t n = 0;
+    while (s->p < s->end && *s->p != ' ' && *s->p != '\t' &&
+           *s->p != '\n' && *s->p != stop) {
+        if (n + 1 < size) {
+            out[n++] = *s->p;
+        }
+        s->p++;
+    }
+    out[n] = '\0';
+    return n > 0 ? 0 : -1;
+}
+
+// 读取整个数据源，直到pread返回0：procfs的seq_file每次read最多返回约一页，
+// 短读不表示文件结束。缓冲区不够时扩容后从偏移0重新读取，避免
+// single_open文件（如/proc/stat）在两次read之间变化而拼出撕裂的行
+static int read_source(ProcSource *src) {
+    if (src->fd < 0) {
+        return -1;
+    }
+
+    size_t length = 0;
+    for (;;) {
+        if (length == src->capacity) {
+            size_t new_capacity = src->capacity * 2;
+            char *new_buf = (char *)realloc(src->buf, new_capacity);
+            if (!new_buf) {
+                return -1;
+            }
+            src->buf = new_buf;
+            src->capacity = new_capacity;
+            length = 0;
+        }
+
+        ssize_t n = pread(src->fd, src->buf + length, src->capacity - length, (off_t)length);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (n == 0) {
+            break;
+        }
+        length += (size_t)n;
+    }
+
+    src->length = length;
+    return 0;
+}
+
+// 调整每CPU数组容量，所有字段共用一块内存
+static int percpu_reserve(PerCpuTimes *pc, int capacity) {
+    if (capacity <= pc->capacity) {
+        return 0;
+    }
+
+    size_t counters = sizeof(unsigned long long) * (size_t)capacity;
+    char *block = (char *)malloc(counters * 8 + sizeof(int) * (size_t)capacity);
+    if (!block) {
+        return -1;
+    }
+
+    // user数组位于内存块起始位置，释放它即释放整个旧块
+    void *old_block = pc->user;
+    unsigned long long **fields[8] = {
+        &pc->user, &pc->nice, &pc->system, &pc->idle,
+        &pc->iowait, &pc->irq, &pc->softirq, &pc->steal
+    };
+    for (int f = 0; f < 8; f++) {
+        unsigned long long *array = (unsigned long long *)(block + counters * f);
+        if (pc->count > 0) {
+            memcpy(array, *fields[f], sizeof(unsigned long long) * pc->count);
+        }
+        *fields[f] = array;
+    }
+    int *cpu = (int *)(block + counters * 8);
+    if (pc->count > 0) {
+        memcpy(cpu, pc->cpu, sizeof(int) * pc->count);
+    }
+
+    free(old_block);
+    pc->cpu = cpu;
+    pc->capacity = capacity;
+    return 0;
+}
+
+// 解析一行CPU计数器（不含行首名字），至少需要user/nice/system/idle四个字段
+static int scan_cpu_fields(Scanner *s, unsigned long long fields[8]) {
+    int count = 0;
+    while (count < 8 && scan_ull(s, &fields[count]) == 0) {
+        count++;
+    }
+    for (int i = count; i < 8; i++) {
+        fields[i] = 0;
+    }
+    return count >= 4 ? 0 : -1;
+}
+
+static int parse_stat(ProcSnapshot *snap, Scanner *s) {
+    // 聚合CPU行位于文件首行: "cpu  user nice system idle iowait irq softirq steal ..."
+    if (s->end - s->p < 4 || memcmp(s->p, "cpu ", 4) != 0) {
+        return -1;
+    }
+    s->p += 4;
+
+    unsigned long long fields[8];
+    if (scan_cpu_fields(s, fields) != 0) {
+        return -1;
+    }
+
+    snap->cpu.user = fields[0];
+    snap->cpu.nice = fields[1];
+    snap->cpu.system = fields[2];
+    snap->cpu.idle = fields[3];
+    snap->cpu.iowait = fields[4];
+    snap->cpu.irq = fields[5];
+    snap->cpu.softirq = fields[6];
+    snap->cpu.steal = fields[7];
+    scan_skip_line(s);
+
+    // 紧随其后的是每个在线CPU的"cpuN ..."行
+    PerCpuTimes *pc = &snap->percpu;
+    pc->count = 0;
+    while (s->end - s->p > 3 && memcmp(s->p, "cpu", 3) == 0) {
+        s->p += 3;
+        unsigned long long id;
+        if (scan_ull(s, &id) != 0 || scan_cpu_fields(s, fields) != 0) {
+            scan_skip_line(s);
+            continue;
+        }
+        if (pc->count == pc->capacity &&
+            percpu_reserve(pc, pc->capacity > 0 ? pc->capacity * 2 : 64) != 0) {
+            return -1;
+        }
+
+        int k = pc->count++;
+        pc->cpu[k] = (int)id;
+        pc->user[k] = fields[0];
+        pc->nice[k] = fields[1];
+        pc->system[k] = fields[2];
+        pc->idle[k] = fields[3];
+        pc->iowait[k] = fields[4];
+        pc->irq[k] = fields[5];
+        pc->softirq[k] = fields[6];
+        pc->steal[k] = fields[7];
+        scan_skip_line(s);
+    }
+
+    return 0;
+}
+
+static int parse_meminfo(ProcSnapshot *snap, Scanner *s) {
+    memset(&snap->mem, 0, sizeof(snap->mem));
+
+    while (!scan_at_end(s)) {
+        const char *key = s->p;
+        while (s->p < s->end && *s->p != ':' && *s->p != '\n') {
+            s->p++;
+        }
+        size_t key_len = (size_t)(s->p - key);
+        if (s->p < s->end && *s->p == ':') {
+            s->p++;
+            unsigned long *target = NULL;
+            if (key_len == 8 && memcmp(key, "MemTotal", 8) == 0) {
+                target = &snap->mem.total;
+            } else if (key_len == 7 && memcmp(key, "MemFree", 7) == 0) {
+                target = &snap->mem.free;
+            } else if (key_len == 7 && memcmp(key, "Buffers", 7) == 0) {
+                target = &snap->mem.buffers;
+            } else if (key_len == 6 && memcmp(key, "Cached", 6) == 0) {
+                target = &snap->mem.cached;
+            } else if (key_len == 6 && memcmp(key, "Active", 6) == 0) {
+                target = &snap->mem.active;
+            }
+            if (target) {
+                scan_ul(s, target);
+            }
+        }
+        scan_skip_line(s);
+    }
+
+    return snap->mem.total > 0 ? 0 : -1;
+}
+
+static int parse_diskstats(ProcSnapshot *snap, Scanner *s) {
+    snap->disk_count = 0;
+
+    while (!scan_at_end(s)) {
+        if (snap->disk_count == snap->disk_capacity) {
+            int new_capacity = snap->disk_capacity * 2;
+            DiskStats *new_disks = (DiskStats *)realloc(snap->disks,
+                                                        sizeof(DiskStats) * new_capacity);
+            if (!new_disks) {
+                return -1;
+            }
+            snap->disks = new_disks;
+            snap->disk_capacity = new_capacity;
+        }
+
+        DiskStats *d = &snap->disks[snap->disk_count];
+        unsigned long long major, minor;
+        if (scan_ull(s, &major) == 0 && scan_ull(s, &minor) == 0 &&
+            scan_name(s, d->name, sizeof(d->name), '\0') == 0 &&
+            scan_ul(s, &d->reads_completed) == 0 &&
+            scan_ul(s, &d->reads_merged) == 0 &&
+            scan_ull(s, &d->sectors_read) == 0 &&
+            scan_ul(s, &d->read_time_ms) == 0 &&
+            scan_ul(s, &d->writes_completed) == 0 &&
+            scan_ul(s, &d->writes_merged) == 0 &&
+            scan_ull(s, &d->sectors_written) == 0 &&
+            scan_ul(s, &d->write_time_ms) == 0 &&
+            scan_ul(s, &d->io_in_progress) == 0 &&
+            scan_ul(s, &d->io_time_ms) == 0 &&
+            scan_ul(s, &d->weighted_io_time_ms) == 0) {
+            snap->disk_count++;
+        }
+        scan_skip_line(s);
+    }
+
+    return 0;
+}
+
+static int parse_netdev(ProcSnapshot *snap, Scanner *s) {
+    snap->net_count = 0;
+
+    // 跳过前两行表头
+    scan_skip_line(s);
+    scan_skip_line(s);
+
+    while (!scan_at_end(s)) {
+        if (snap->net_count == snap->net_capacity) {
+            int new_capacity = snap->net_capacity * 2;
+            NetDevStats *new_nets = (NetDevStats *)realloc(snap->nets,
+                                                           sizeof(NetDevStats) * new_capacity);
+            if (!new_nets) {
+                return -1;
+            }
+            snap->nets = new_nets;
+            snap->net_capacity = new_capacity;
+        }
+
+        NetDevStats *n = &snap->nets[snap->net_count];
+        unsigned long long skip;
+        if (scan_name(s, n->name, sizeof(n->name), ':') == 0 &&
+            s->p < s->end && *s->p == ':') {
+            s->p++;
+            if (scan_ull(s, &n->rx_bytes) == 0 &&
+                scan_ull(s, &n->rx_packets) == 0 &&
+                scan_ull(s, &n->rx_errs) == 0 &&
+                scan_ull(s, &n->rx_drop) == 0 &&
+                scan_ull(s, &skip) == 0 &&      // fifo
+                scan_ull(s, &skip) == 0 &&      // frame
+                scan_ull(s, &skip) == 0 &&      // compressed
+                scan_ull(s, &skip) == 0 &&      // multicast
+                scan_ull(s, &n->tx_bytes) == 0 &&
+                scan_ull(s, &n->tx_packets) == 0 &&
+                scan_ull(s, &n->tx_errs) == 0 &&
+                scan_ull(s, &n->tx_drop) == 0) {
+                snap->net_count++;
+            }
+        }
+        scan_skip_line(s);
+    }
+
+    return 0;
+}
+
+int proc_snapshot_init(ProcSnapshot *snap, const char *proc_root) {
+    if (!snap) {
+        return -1;
+    }
+
+    memset(snap, 0, sizeof(*snap));
+    if (!proc_root) {
+        proc_root = "/proc";
+    }
+
+    int opened = 0;
+    for (int i = 0; i < PROC_SRC_COUNT; i++) {
+        ProcSource *src = &snap->sources[i];
+        src->fd = -1;
+        src->capacity = PROC_INITIAL_BUFFER;
+        src->buf = (char *)malloc(src->capacity);
+        if (!src->buf) {
+            proc_snapshot_free(snap);
+            return -1;
+        }
+
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s", proc_root, source_paths[i]);
+        src->fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (src->fd >= 0) {
+            opened++;
+        }
+    }
+
+    // 每CPU数组按在线CPU数预分配，CPU热插拔时按需扩展
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    if (percpu_reserve(&snap->percpu, online > 0 ? (int)online : 1) != 0) {
+        proc_snapshot_free(snap);
+        return -1;
+    }
+
+    snap->disk_capacity = PROC_INITIAL_ENTRIES;
+    snap->disks = (DiskStats *)malloc(sizeof(DiskStats) * snap->disk_capacity);
+    snap->net_capacity = PROC_INITIAL_ENTRIES;
+    snap->nets = (NetDevStats *)malloc(sizeof(NetDevStats) * snap->net_capacity);
+    if (!snap->disks || !snap->nets || opened == 0) {
+        proc_snapshot_free(snap);
+        return -1;
+    }
+
+    return 0;
+}
+
+void proc_snapshot_free(ProcSnapshot *snap) {
+    if (!snap) {
+        return;
+    }
+
+    for (int i = 0; i < PROC_SRC_COUNT; i++) {
+        ProcSource *src = &snap->sources[i];
+        if (src->fd >= 0) {
+            close(src->fd);
+            src->fd = -1;
+        }
+        free(src->buf);
+        src->buf = NULL;
+    }
+
+    free(snap->percpu.user);
+    memset(&snap->percpu, 0, sizeof(snap->percpu));
+    free(snap->disks);
+    snap->disks = NULL;
+    snap->disk_count = snap->disk_capacity = 0;
+    free(snap->nets);
+    snap->nets = NULL;
+    snap->net_count = snap->net_capacity = 0;
+    snap->valid = 0;
+}
+
+int proc_snapshot_read(ProcSnapshot *snap, ProcSourceType source) {
+    if (!snap || source < 0 || source >= PROC_SRC_COUNT) {
+        return -1;
+    }
+
+    static int (*const parsers[PROC_SRC_COUNT])(ProcSnapshot *, Scanner *) = {
+        [PROC_SRC_STAT] = parse_stat,
+        [PROC_SRC_MEMINFO] = parse_meminfo,
+        [PROC_SRC_DISKSTATS] = parse_diskstats,
+        [PROC_SRC_NETDEV] = parse_netdev,
+    };
+
+    // 每个数据源的读取和解析分别计时，便于定位变慢的数据源
+    uint64_t start_ns = monotonic_ns();
+    ProcSource *src = &snap->sources[source];
+    int ret = -1;
+    if (read_source(src) == 0) {
+        Scanner s = { src->buf, src->buf + src->length };
+        ret = parsers[source](snap, &s);
+    }
+    latency_record((LatencyStage)(LATENCY_PROC_STAT + source), start_ns);
+    return ret;
+}
+
+int proc_snapshot_refresh(ProcSnapshot *snap) {
+    if (!snap) {
+        return -1;
+    }
+
+    snap->valid = 0;
+    snap->timestamp_ns = monotonic_ns();
+    for (int i = 0; i < PROC_SRC_COUNT; i++) {
+        if (proc_snapshot_read(snap, (ProcSourceType)i) == 0) {
+            snap->valid |= 1u << i;
+        }
+    }
+
+    return snap->valid == (1u << PROC_SRC_COUNT) - 1 ? 0 : -1;
+}
+
+const DiskStats *proc_snapshot_find_disk(const ProcSnapshot *snap, const char *name) {
+    if (!snap || !name || !proc_snapshot_has(snap, PROC_SRC_DISKSTATS)) {
+        return NULL;
+    }
+    for (int i = 0; i < snap->disk_count; i++) {
+        if (strcmp(snap->disks[i].name, name) == 0) {
+            return &snap->disks[i];
+        }
+    }
+    return NULL;
+}
+
+const NetDevStats *proc_snapshot_find_net(const ProcSnapshot *snap, const char *name) {
+    if (!snap || !name || !proc_snapshot_has(snap, PROC_SRC_NETDEV)) {
+        return NULL;
+    }
+    for (int i = 0; i < snap->net_count; i++) {
+        if (strcmp(snap->nets[i].name, name) == 0) {
+            return &snap->nets[i];
+        }
+    }
+    return NULL;
+}
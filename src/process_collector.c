@@ -0,0 +1,415 @@
+#include "../include/process_collector.h"
+#include "../include/config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#define PROCESS_INITIAL_SLOTS 1024  // 哈希表初始容量（2的幂）
+
+/* 排行榜最小堆的元素 */
+typedef struct {
+    double key;
+    const ProcessEntry *entry;
+} HeapItem;
+
+static inline unsigned long pid_hash(int pid) {
+    return (unsigned long)((uint32_t)pid * 2654435761u);
+}
+
+// 查找pid所在的槽位，不存在时返回应插入的空槽位
+static unsigned long find_slot(const ProcessEntry *entries, unsigned long mask, int pid) {
+    unsigned long i = pid_hash(pid) & mask;
+    while (entries[i].pid != 0 && entries[i].pid != pid) {
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+// 扩容并重新散列，表项（含缓存的文件描述符）原样搬移
+static int grow_table(ProcessCollector *pc) {
+    unsigned long capacity = pc->entries ? (pc->mask + 1) * 2 : PROCESS_INITIAL_SLOTS;
+    ProcessEntry *entries = (ProcessEntry *)calloc(capacity, sizeof(ProcessEntry));
+    if (!entries) {
+        return -1;
+    }
+    if (pc->entries) {
+        for (unsigned long i = 0; i <= pc->mask; i++) {
+            if (pc->entries[i].pid != 0) {
+                entries[find_slot(entries, capacity - 1, pc->entries[i].pid)] = pc->entries[i];
+            }
+        }
+        free(pc->entries);
+    }
+    pc->entries = entries;
+    pc->mask = capacity - 1;
+    return 0;
+}
+
+static void close_entry(ProcessCollector *pc, ProcessEntry *e) {
+    if (e->stat_fd >= 0) {
+        close(e->stat_fd);
+        pc->cached_fds--;
+    }
+    if (e->statm_fd >= 0) {
+        close(e->statm_fd);
+        pc->cached_fds--;
+    }
+    e->stat_fd = e->statm_fd = -1;
+}
+
+// 删除槽位i上的进程，把后续同一探测链上的表项前移填补空位
+static void remove_slot(ProcessCollector *pc, unsigned long i) {
+    ProcessEntry *entries = pc->entries;
+    close_entry(pc, &entries[i]);
+    pc->count--;
+
+    for (;;) {
+        entries[i].pid = 0;
+        unsigned long j = i;
+        for (;;) {
+            j = (j + 1) & pc->mask;
+            if (entries[j].pid == 0) {
+                return;
+            }
+            // 表项的理想位置不在(i, j]之间时才能移到i
+            unsigned long home = pid_hash(entries[j].pid) & pc->mask;
+            if (i <= j ? (home <= i || home > j) : (home <= i && home > j)) {
+                break;
+            }
+        }
+        entries[i] = entries[j];
+        i = j;
+    }
+}
+
+// 登记扫描到的进程，新进程在本周期读取
+static int track_pid(ProcessCollector *pc, int pid) {
+    if ((unsigned long)(pc->count + 1) * 2 > pc->mask + 1 && grow_table(pc) != 0) {
+        return -1;
+    }
+
+    ProcessEntry *e = &pc->entries[find_slot(pc->entries, pc->mask, pid)];
+    if (e->pid == 0) {
+        memset(e, 0, sizeof(*e));
+        e->pid = pid;
+        e->stat_fd = e->statm_fd = -1;
+        e->next_cycle = pc->cycle;
+        e->memory_stale = 1;
+        pc->count++;
+    }
+    e->seen = pc->cycle;
+    return 0;
+}
+
+// 读取进程的一个文件；文件描述符预算允许时缓存，否则读完即关闭
+static ssize_t read_process_file(ProcessCollector *pc, int pid, int *fd, const char *name,
+                                 char *buf, size_t size) {
+    int file = *fd;
+    if (file < 0) {
+        char path[32];
+        snprintf(path, sizeof(path), "%d/%s", pid, name);
+        file = openat(dirfd(pc->proc_dir), path, O_RDONLY | O_CLOEXEC);
+        if (file < 0) {
+            return -1;
+        }
+        if (pc->cached_fds < pc->fd_budget) {
+            *fd = file;
+            pc->cached_fds++;
+        }
+    }
+
+    ssize_t n;
+    do {
+        n = pread(file, buf, size - 1, 0);
+    } while (n < 0 && errno == EINTR);
+    if (file != *fd) {
+        close(file);
+    }
+    if (n < 0) {
+        return -1;
+    }
+    buf[n] = '\0';
+    return n;
+}
+
+// 跳过count个以空格分隔的字段
+static const char *skip_fields(const char *p, int count) {
+    while (count-- > 0 && *p) {
+        while (*p && *p != ' ') {
+            p++;
+        }
+        while (*p == ' ') {
+            p++;
+        }
+    }
+    return p;
+}
+
+// 解析stat：进程名在第一个'('和最后一个')'之间（可能含空格和括号），
+// 其后依次为第3个字段state，第14、15个字段utime、stime，第22个字段starttime
+static int parse_stat(const char *buf, char *comm, unsigned long long *ticks,
+                      unsigned long long *start_time) {
+    const char *open = strchr(buf, '(');
+    const char *close = strrchr(buf, ')');
+    if (!open || !close || close < open || close[1] != ' ') {
+        return -1;
+    }
+    size_t len = (size_t)(close - open - 1);
+    if (len >= PROCESS_COMM_LEN) {
+        len = PROCESS_COMM_LEN - 1;
+    }
+    memcpy(comm, open + 1, len);
+    comm[len] = '\0';
+
+    char *end;
+    const char *p = skip_fields(close + 2, 11);
+    unsigned long long utime = strtoull(p, &end, 10);
+    if (end == p) {
+        return -1;
+    }
+    p = skip_fields(p, 1);
+    unsigned long long stime = strtoull(p, &end, 10);
+    if (end == p) {
+        return -1;
+    }
+    p = skip_fields(p, 7);
+    *start_time = strtoull(p, &end, 10);
+    if (end == p) {
+        return -1;
+    }
+    *ticks = utime + stime;
+    return 0;
+}
+
+// 读取一个进程，返回-1表示进程已退出
+static int read_process(ProcessCollector *pc, ProcessEntry *e, uint64_t timestamp_ns) {
+    char buf[1024];
+    if (read_process_file(pc, e->pid, &e->stat_fd, "stat", buf, sizeof(buf)) < 0) {
+        return -1;
+    }
+
+    unsigned long long ticks, start_time;
+    if (parse_stat(buf, e->comm, &ticks, &start_time) != 0) {
+        return -1;
+    }
+
+    // pid被复用（未缓存文件描述符时才可能发生）或首次读取时只记录基准值
+    unsigned long long delta = 0;
+    if (e->sampled_ns > 0 && start_time == e->start_time && ticks >= e->cpu_ticks &&
+        timestamp_ns > e->sampled_ns) {
+        delta = ticks - e->cpu_ticks;
+        double elapsed = (double)(timestamp_ns - e->sampled_ns) / 1e9;
+        e->cpu_percent = 100.0 * (double)delta / (double)pc->ticks_per_sec / elapsed;
+    } else {
+        e->cpu_percent = 0.0;
+        e->idle_reads = 0;
+        e->memory_stale = 1;
+        delta = e->sampled_ns == 0 ? 1 : 0;
+    }
+    e->cpu_ticks = ticks;
+    e->start_time = start_time;
+    e->sampled_ns = timestamp_ns;
+
+    // 没有运行的进程逐步降低读取频率（间隔2、4、……，不超过PROCESS_IDLE_MAX_SKIP个周期），
+    // 空闲进程开始运行后最迟PROCESS_IDLE_MAX_SKIP个周期被看到；增量按实际间隔折算，
+    // 跳过期间的突发会被平均到整个间隔上
+    if (delta > 0) {
+        e->idle_reads = 0;
+        e->memory_stale = 1;
+        e->next_cycle = pc->cycle + 1;
+    } else {
+        unsigned long skip = 2UL << e->idle_reads;
+        if (skip < PROCESS_IDLE_MAX_SKIP) {
+            e->idle_reads++;
+        } else {
+            skip = PROCESS_IDLE_MAX_SKIP;
+        }
+        e->next_cycle = pc->cycle + skip;
+    }
+
+    // 常驻内存只在进程运行过之后重新读取
+    if (e->memory_stale) {
+        unsigned long size, resident;
+        if (read_process_file(pc, e->pid, &e->statm_fd, "statm", buf, sizeof(buf)) < 0) {
+            return -1;
+        }
+        if (sscanf(buf, "%lu %lu", &size, &resident) == 2) {
+            e->rss_kb = resident * (unsigned long)pc->page_kb;
+        }
+        e->memory_stale = 0;
+    }
+    return 0;
+}
+
+// 向大小为k的最小堆提供一个候选，堆顶是当前第k名
+static void heap_offer(HeapItem *heap, int *count, int k, double key, const ProcessEntry *entry) {
+    int i;
+    if (*count < k) {
+        i = (*count)++;
+        while (i > 0 && heap[(i - 1) / 2].key > key) {
+            heap[i] = heap[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+    } else if (key > heap[0].key) {
+        i = 0;
+        for (;;) {
+            int child = 2 * i + 1;
+            if (child >= k) {
+                break;
+            }
+            if (child + 1 < k && heap[child + 1].key < heap[child].key) {
+                child++;
+            }
+            if (heap[child].key >= key) {
+                break;
+            }
+            heap[i] = heap[child];
+            i = child;
+        }
+    } else {
+        return;
+    }
+    heap[i].key = key;
+    heap[i].entry = entry;
+}
+
+// 把堆按占用从高到低输出
+static int heap_export(HeapItem *heap, int count, ProcessUsage *out) {
+    for (int i = 1; i < count; i++) {
+        HeapItem item = heap[i];
+        int j = i;
+        while (j > 0 && heap[j - 1].key < item.key) {
+            heap[j] = heap[j - 1];
+            j--;
+        }
+        heap[j] = item;
+    }
+    for (int i = 0; i < count; i++) {
+        const ProcessEntry *e = heap[i].entry;
+        out[i].pid = e->pid;
+        memcpy(out[i].comm, e->comm, sizeof(out[i].comm));
+        out[i].cpu_percent = e->cpu_percent;
+        out[i].rss_kb = e->rss_kb;
+    }
+    return count;
+}
+
+int process_collector_init(ProcessCollector *pc, const char *proc_root, int top_k) {
+    if (!pc || top_k <= 0 || top_k > PROCESS_TOP_MAX) {
+        return -1;
+    }
+
+    memset(pc, 0, sizeof(*pc));
+    pc->top_k = top_k;
+    pc->proc_dir = opendir(proc_root ? proc_root : "/proc");
+    if (!pc->proc_dir || grow_table(pc) != 0) {
+        process_collector_free(pc);
+        return -1;
+    }
+
+    pc->ticks_per_sec = sysconf(_SC_CLK_TCK);
+    if (pc->ticks_per_sec <= 0) {
+        pc->ticks_per_sec = 100;
+    }
+    long page = sysconf(_SC_PAGESIZE);
+    pc->page_kb = page >= 1024 ? page / 1024 : 4;
+
+    // 每个进程缓存两个文件描述符，软限制提高到硬限制，预留一部分给其他用途。
+    // 修改对整个进程（包括子进程）生效，因此打印出来而不是静默进行
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        if (limit.rlim_cur < limit.rlim_max) {
+            rlim_t previous = limit.rlim_cur;
+            limit.rlim_cur = limit.rlim_max;
+            if (setrlimit(RLIMIT_NOFILE, &limit) == 0) {
+                printf("进程采集: RLIMIT_NOFILE软限制由%llu提高到%llu（-T 0不采集进程，不修改限制）\n",
+                       (unsigned long long)previous, (unsigned long long)limit.rlim_cur);
+            } else {
+                getrlimit(RLIMIT_NOFILE, &limit);
+            }
+        }
+        rlim_t budget = limit.rlim_cur > PROCESS_FD_RESERVE ? limit.rlim_cur - PROCESS_FD_RESERVE : 0;
+        pc->fd_budget = budget > (rlim_t)(1 << 30) ? (1 << 30) : (int)budget;
+    }
+    return 0;
+}
+
+int process_collector_refresh(ProcessCollector *pc, uint64_t timestamp_ns, ProcessTop *top) {
+    if (!pc || !pc->proc_dir || !top) {
+        return -1;
+    }
+
+    pc->cycle++;
+    top->cpu_count = top->mem_count = top->process_count = 0;
+
+    // 扫描/proc目录：登记新进程，标记仍然存在的进程
+    rewinddir(pc->proc_dir);
+    struct dirent *de;
+    while ((de = readdir(pc->proc_dir)) != NULL) {
+        const char *p = de->d_name;
+        if (*p < '1' || *p > '9') {
+            continue;
+        }
+        int pid = 0;
+        while (*p >= '0' && *p <= '9') {
+            pid = pid * 10 + (*p++ - '0');
+        }
+        if (*p == '\0') {
+            track_pid(pc, pid);
+        }
+    }
+
+    // 读取到期的进程并维护排行，已退出的进程留待下面移除
+    HeapItem cpu_heap[PROCESS_TOP_MAX];
+    HeapItem mem_heap[PROCESS_TOP_MAX];
+    int cpu_count = 0, mem_count = 0;
+    for (unsigned long i = 0; i <= pc->mask; i++) {
+        ProcessEntry *e = &pc->entries[i];
+        if (e->pid == 0 || e->seen != pc->cycle) {
+            continue;
+        }
+        if (pc->cycle >= e->next_cycle && read_process(pc, e, timestamp_ns) != 0) {
+            e->seen = 0;
+            continue;
+        }
+        if (e->cpu_percent > 0) {
+            heap_offer(cpu_heap, &cpu_count, pc->top_k, e->cpu_percent, e);
+        }
+        if (e->rss_kb > 0) {
+            heap_offer(mem_heap, &mem_count, pc->top_k, (double)e->rss_kb, e);
+        }
+    }
+    top->cpu_count = heap_export(cpu_heap, cpu_count, top->cpu);
+    top->mem_count = heap_export(mem_heap, mem_count, top->mem);
+
+    // 移除已退出的进程；前移的表项可能来自尚未检查的槽位，因此重新检查当前槽位
+    for (unsigned long i = 0; i <= pc->mask; i++) {
+        while (pc->entries[i].pid != 0 && pc->entries[i].seen != pc->cycle) {
+            remove_slot(pc, i);
+        }
+    }
+    top->process_count = pc->count;
+    return 0;
+}
+
+void process_collector_free(ProcessCollector *pc) {
+    if (!pc) {
+        return;
+    }
+    if (pc->entries) {
+        for (unsigned long i = 0; i <= pc->mask; i++) {
+            if (pc->entries[i].pid != 0) {
+                close_entry(pc, &pc->entries[i]);
+            }
+        }
+        free(pc->entries);
+    }
+    if (pc->proc_dir) {
+        closedir(pc->proc_dir);
+    }
+    memset(pc, 0, sizeof(*pc));
+}
@@ -0,0 +1,130 @@
+#include "../include/psi.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+static const char *const resource_names[PSI_RESOURCE_COUNT] = {
+    [PSI_CPU] = "cpu",
+    [PSI_MEMORY] = "memory",
+    [PSI_IO] = "io",
+};
+
+// 读取"some avg10=... total=<微秒>"行中的total
+static int read_some_total(int fd, unsigned long long *total) {
+    char buf[256];
+    ssize_t n = pread(fd, buf, sizeof(buf) - 1, 0);
+    if (n <= 0) {
+        return -1;
+    }
+    buf[n] = '\0';
+    if (strncmp(buf, "some ", 5) != 0) {
+        return -1;
+    }
+    const char *p = strstr(buf, "total=");
+    const char *line_end = strchr(buf, '\n');
+    if (!p || (line_end && p > line_end)) {
+        return -1;
+    }
+    char *end;
+    *total = strtoull(p + 6, &end, 10);
+    return end == p + 6 ? -1 : 0;
+}
+
+int psi_monitor_open(PsiMonitor *monitor, uint64_t stall_us, uint64_t window_us) {
+    if (!monitor || stall_us == 0 || window_us == 0) {
+        return -1;
+    }
+
+    memset(monitor, 0, sizeof(*monitor));
+    monitor->stall_ratio = (double)stall_us / (double)window_us;
+
+    char trigger[64];
+    int len = snprintf(trigger, sizeof(trigger), "some %llu %llu",
+                       (unsigned long long)stall_us, (unsigned long long)window_us);
+
+    int available = 0;
+    for (int i = 0; i < PSI_RESOURCE_COUNT; i++) {
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/pressure/%s", resource_names[i]);
+        monitor->fds[i] = -1;
+        monitor->poll_fds[i] = -1;
+
+        // 注册触发器需要写权限，写入内容包含结尾的'\0'
+        int fd = open(path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (fd >= 0 && write(fd, trigger, (size_t)len + 1) == len + 1) {
+            monitor->fds[i] = monitor->poll_fds[i] = fd;
+            monitor->trigger[i] = true;
+            available++;
+            continue;
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+
+        // 退化为读取停顿总时间
+        fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd >= 0 && read_some_total(fd, &monitor->totals[i]) == 0) {
+            monitor->fds[i] = fd;
+            available++;
+        } else if (fd >= 0) {
+            close(fd);
+        }
+    }
+    return available > 0 ? 0 : -1;
+}
+
+unsigned int psi_monitor_check(PsiMonitor *monitor, uint64_t now_ns) {
+    if (!monitor || now_ns <= monitor->sampled_ns) {
+        return 0;
+    }
+
+    // 第一次读取只记录基准值
+    bool first = monitor->sampled_ns == 0;
+    double elapsed_us = (double)(now_ns - monitor->sampled_ns) / 1e3;
+    monitor->sampled_ns = now_ns;
+
+    unsigned int mask = 0;
+    for (int i = 0; i < PSI_RESOURCE_COUNT; i++) {
+        unsigned long long total;
+        if (monitor->fds[i] < 0 || monitor->trigger[i] || read_some_total(monitor->fds[i], &total) != 0) {
+            continue;
+        }
+        if (!first && total >= monitor->totals[i] &&
+            (double)(total - monitor->totals[i]) >= monitor->stall_ratio * elapsed_us) {
+            mask |= 1u << i;
+        }
+        monitor->totals[i] = total;
+    }
+    return mask;
+}
+
+bool psi_monitor_polling(const PsiMonitor *monitor) {
+    for (int i = 0; i < PSI_RESOURCE_COUNT; i++) {
+        if (monitor->fds[i] >= 0 && !monitor->trigger[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *psi_resource_name(PsiResource resource) {
+    if ((unsigned)resource >= PSI_RESOURCE_COUNT) {
+        return "unknown";
+    }
+    return resource_names[resource];
+}
+
+void psi_monitor_close(PsiMonitor *monitor) {
+    if (!monitor) {
+        return;
+    }
+    for (int i = 0; i < PSI_RESOURCE_COUNT; i++) {
+        if (monitor->fds[i] >= 0) {
+            close(monitor->fds[i]);
+        }
+        monitor->fds[i] = monitor->poll_fds[i] = -1;
+        monitor->trigger[i] = false;
+    }
+}
@@ -0,0 +1,253 @@
+#include "../include/replay.h"
+#include "../include/series_store.h"
+#include "../include/scheduler.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// 记录异常所属指标的计数
+static void count_anomaly(ReplayStats *stats, int metric_id) {
+    if (metric_id >= stats->metric_slots) {
+        int new_slots = stats->metric_slots > 0 ? stats->metric_slots : 64;
+        while (new_slots <= metric_id) {
+            new_slots *= 2;
+        }
+        unsigned long *counts = (unsigned long *)realloc(stats->metric_anomalies,
+                                                         sizeof(unsigned long) * new_slots);
+        if (!counts) {
+            return;
+        }
+        memset(counts + stats->metric_slots, 0, sizeof(unsigned long) * (new_slots - stats->metric_slots));
+        stats->metric_anomalies = counts;
+        stats->metric_slots = new_slots;
+    }
+    stats->metric_anomalies[metric_id]++;
+}
+
+// 一个周期的样本写入完毕后运行检测，与实时模式一样从第3个周期开始
+static void replay_detect(AnomalyDetector *detector, uint64_t timestamp_ns,
+                          FILE *out, ReplayStats *stats) {
+    stats->rows++;
+    if (stats->rows < 3) {
+        return;
+    }
+
+    anomaly_arena_reset(&detector->anomalies);
+    detect_anomalies_nsigma(detector);
+    detect_anomalies_mad(detector);
+    detect_anomalies_forecast(detector);
+    detect_anomalies_threshold(detector);
+    detect_anomalies_correlation(detector);
+
+    char time_str[64] = "";
+    if (out && detector->anomalies.count > 0) {
+        time_t seconds = (time_t)(timestamp_ns / NSEC_PER_SEC);
+        struct tm tm_info;
+        localtime_r(&seconds, &tm_info);
+        strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", &tm_info);
+    }
+
+    for (int i = 0; i < detector->anomalies.count; i++) {
+        Anomaly *anomaly = &detector->anomalies.records[i];
+        anomaly->timestamp = (time_t)(timestamp_ns / NSEC_PER_SEC);
+        count_anomaly(stats, anomaly->metric_id);
+        if (out) {
+            const Metric *metric = &detector->metrics[anomaly->metric_id];
+            char message[256];
+            format_anomaly(anomaly, metric->description, message, sizeof(message));
+            // 马氏距离的界限与指标值量纲不同，只在消息中给出
+            char bound[48] = "";
+            if (anomaly->source != ANOMALY_SOURCE_MAHALANOBIS) {
+                snprintf(bound, sizeof(bound), ", 阈值=%.2f", anomaly->threshold);
+            }
+            fprintf(out, "[%s] 严重程度=%d, 指标=%s, 值=%.2f%s, 消息=%s\n",
+                    time_str, anomaly->severity, metric->name, anomaly->value, bound, message);
+        }
+    }
+    stats->anomalies += (unsigned long)detector->anomalies.count;
+}
+
+// 回放序列文件：逐块按行读取映射内存中的列
+static int replay_series(const char *path, AnomalyDetector *detector, FILE *out, ReplayStats *stats) {
+    SeriesReader reader;
+    if (series_reader_open(&reader, path) != 0) {
+        return -1;
+    }
+
+    int *ids = NULL;
+    uint32_t id_capacity = 0;
+    int ret = 0;
+    const SeriesBlockHeader *bh;
+    while ((bh = series_reader_next(&reader)) != NULL) {
+        if (bh->column_count > id_capacity) {
+            int *new_ids = (int *)realloc(ids, sizeof(int) * bh->column_count);
+            if (!new_ids) {
+                ret = -1;
+                break;
+            }
+            ids = new_ids;
+            id_capacity = bh->column_count;
+        }
+        for (uint32_t c = 0; c < bh->column_count; c++) {
+            char name[SERIES_NAME_LEN];
+            series_block_name(bh, c, name);
+            ids[c] = name[0] != '\0' ? register_metric_name(detector, name) : -1;
+            if (ids[c] < 0) {
+                stats->skipped_columns++;
+            }
+        }
+
+        uint64_t rows = series_block_rows(bh);
+        const uint64_t *timestamps = series_block_timestamps(bh);
+        for (uint64_t r = 0; r < rows; r++) {
+            for (uint32_t c = 0; c < bh->column_count; c++) {
+                double value = series_block_values(bh, c)[r];
+                if (ids[c] >= 0 && !isnan(value)) {
+                    add_metric_datapoint(&detector->metrics[ids[c]], value, timestamps[r]);
+                    stats->samples++;
+                }
+            }
+            replay_detect(detector, timestamps[r], out, stats);
+        }
+    }
+
+    free(ids);
+    series_reader_close(&reader);
+    return ret;
+}
+
+// 去掉行尾的换行符
+static void chomp(char *line) {
+    size_t len = strlen(line);
+    while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+        line[--len] = '\0';
+    }
+}
+
+// 回放宽格式CSV
+static int replay_csv(FILE *file, AnomalyDetector *detector, FILE *out, ReplayStats *stats) {
+    char *line = NULL;
+    size_t line_capacity = 0;
+    int *ids = NULL;
+    int columns = 0;
+    int ret = 0;
+
+    // 解析表头，第一列为时间戳
+    if (getline(&line, &line_capacity, file) < 0) {
+        free(line);
+        return -1;
+    }
+    chomp(line);
+    char *save = NULL;
+    char *field = strtok_r(line, ",", &save);
+    if (!field || strcmp(field, "timestamp") != 0) {
+        free(line);
+        return -1;
+    }
+    while ((field = strtok_r(NULL, ",", &save)) != NULL) {
+        int *new_ids = (int *)realloc(ids, sizeof(int) * (columns + 1));
+        if (!new_ids) {
+            free(ids);
+            free(line);
+            return -1;
+        }
+        ids = new_ids;
+        ids[columns] = register_metric_name(detector, field);
+        if (ids[columns] < 0) {
+            stats->skipped_columns++;
+        }
+        columns++;
+    }
+
+    // 空单元表示没有值，所以逐个字段扫描而不用strtok
+    while (getline(&line, &line_capacity, file) >= 0) {
+        chomp(line);
+        if (line[0] == '\0') {
+            continue;
+        }
+
+        char *end;
+        double seconds = strtod(line, &end);
+        if (end == line || (*end != ',' && *end != '\0')) {
+            ret = -1;
+            break;
+        }
+        uint64_t timestamp_ns = seconds > 0 ? (uint64_t)(seconds * NSEC_PER_SEC) : 0;
+
+        char *p = end;
+        for (int c = 0; c < columns && *p == ','; c++) {
+            p++;
+            double value = strtod(p, &end);
+            if (end != p && ids[c] >= 0) {
+                add_metric_datapoint(&detector->metrics[ids[c]], value, timestamp_ns);
+                stats->samples++;
+            }
+            p = end;
+            while (*p != ',' && *p != '\0') {
+                p++;
+            }
+        }
+        replay_detect(detector, timestamp_ns, out, stats);
+    }
+
+    free(ids);
+    free(line);
+    return ret;
+}
+
+int replay_file(const char *path, AnomalyDetector *detector, FILE *out, ReplayStats *stats) {
+    if (!path || !detector || !stats) {
+        return -1;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        return -1;
+    }
+
+    char magic[sizeof(SERIES_MAGIC) - 1];
+    bool is_series = fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+                     memcmp(magic, SERIES_MAGIC, sizeof(magic)) == 0;
+    rewind(file);
+
+    uint64_t start = monotonic_ns();
+    int ret;
+    if (is_series) {
+        fclose(file);
+        ret = replay_series(path, detector, out, stats);
+    } else {
+        ret = replay_csv(file, detector, out, stats);
+        fclose(file);
+    }
+    stats->elapsed_sec = (double)(monotonic_ns() - start) / NSEC_PER_SEC;
+    return ret;
+}
+
+void replay_stats_free(ReplayStats *stats) {
+    if (!stats) {
+        return;
+    }
+    free(stats->metric_anomalies);
+    stats->metric_anomalies = NULL;
+    stats->metric_slots = 0;
+}
+
+void print_replay_summary(const AnomalyDetector *detector, const ReplayStats *stats) {
+    double rate = stats->elapsed_sec > 0 ? stats->samples / stats->elapsed_sec : 0.0;
+
+    printf("回放周期数: %lu\n", stats->rows);
+    printf("回放样本数: %lu\n", stats->samples);
+    printf("耗时: %.3f秒\n", stats->elapsed_sec);
+    printf("吞吐量: %.0f 样本/秒\n", rate);
+    printf("检测到异常: %lu 个\n", stats->anomalies);
+    if (stats->skipped_columns > 0) {
+        printf("跳过无法识别的列: %lu 个\n", stats->skipped_columns);
+    }
+
+    for (int i = 0; i < detector->metric_count && i < stats->metric_slots; i++) {
+        if (stats->metric_anomalies[i] > 0) {
+            printf("  %s: %lu\n", detector->metrics[i].name, stats->metric_anomalies[i]);
+        }
+    }
+}
@@ -0,0 +1,280 @@
+#include "../include/runtime_config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+
+// 检测器列表的配置键，N-Sigma为默认检测器，没有列表
+static const char *const detector_keys[DETECTOR_COUNT] = {
+    [DETECTOR_NSIGMA] = NULL,
+    [DETECTOR_MAD] = "mad",
+    [DETECTOR_EWMA] = "ewma",
+    [DETECTOR_HOLT_WINTERS] = "holt_winters",
+};
+
+// 复制可选字符串，NULL和空串都复制为NULL
+static int dup_optional(char **dst, const char *src) {
+    char *copy = NULL;
+    if (src && src[0] != '\0') {
+        copy = strdup(src);
+        if (!copy) {
+            return -1;
+        }
+    }
+    free(*dst);
+    *dst = copy;
+    return 0;
+}
+
+RuntimeConfig *runtime_config_create(double sigma_factor, const char *disk_devices,
+                                     const char *net_interfaces,
+                                     const char *const detector_metrics[DETECTOR_COUNT],
+                                     const char *correlation_groups) {
+    RuntimeConfig *config = (RuntimeConfig *)calloc(1, sizeof(RuntimeConfig));
+    if (!config) {
+        return NULL;
+    }
+
+    config->sigma_factor = sigma_factor;
+    if (dup_optional(&config->disk_devices, disk_devices) != 0 ||
+        dup_optional(&config->net_interfaces, net_interfaces) != 0 ||
+        dup_optional(&config->correlation_groups, correlation_groups) != 0) {
+        runtime_config_free(config);
+        return NULL;
+    }
+    for (int kind = DETECTOR_NSIGMA + 1; kind < DETECTOR_COUNT; kind++) {
+        if (dup_optional(&config->detector_metrics[kind], detector_metrics[kind]) != 0) {
+            runtime_config_free(config);
+            return NULL;
+        }
+    }
+    return config;
+}
+
+RuntimeConfig *runtime_config_clone(const RuntimeConfig *config) {
+    if (!config) {
+        return NULL;
+    }
+
+    RuntimeConfig *copy = runtime_config_create(config->sigma_factor, config->disk_devices,
+                                                config->net_interfaces,
+                                                (const char *const *)config->detector_metrics,
+                                                config->correlation_groups);
+    if (!copy) {
+        return NULL;
+    }
+    if (config->setting_count > 0) {
+        copy->settings = (MetricSetting *)malloc(sizeof(MetricSetting) * config->setting_count);
+        if (!copy->settings) {
+            runtime_config_free(copy);
+            return NULL;
+        }
+        memcpy(copy->settings, config->settings, sizeof(MetricSetting) * config->setting_count);
+        copy->setting_count = config->setting_count;
+        copy->setting_capacity = config->setting_count;
+    }
+    return copy;
+}
+
+void runtime_config_free(RuntimeConfig *config) {
+    if (!config) {
+        return;
+    }
+    free(config->disk_devices);
+    free(config->net_interfaces);
+    free(config->correlation_groups);
+    for (int i = 0; i < DETECTOR_COUNT; i++) {
+        free(config->detector_metrics[i]);
+    }
+    free(config->settings);
+    free(config);
+}
+
+// 取指标的设置，不存在时追加一个不覆盖任何参数的设置
+static MetricSetting *setting_for(RuntimeConfig *config, const char *name) {
+    for (int i = 0; i < config->setting_count; i++) {
+        if (strcmp(config->settings[i].name, name) == 0) {
+            return &config->settings[i];
+        }
+    }
+
+    if (config->setting_count >= config->setting_capacity) {
+        int new_capacity = config->setting_capacity > 0 ? config->setting_capacity * 2 : 16;
+        MetricSetting *settings = (MetricSetting *)realloc(config->settings,
+                                                           sizeof(MetricSetting) * new_capacity);
+        if (!settings) {
+            return NULL;
+        }
+        config->settings = settings;
+        config->setting_capacity = new_capacity;
+    }
+
+    MetricSetting *setting = &config->settings[config->setting_count++];
+    memset(setting, 0, sizeof(*setting));
+    strcpy(setting->name, name);
+    setting->threshold = -1;
+    return setting;
+}
+
+// 解析浮点数，整个值都必须是数字
+static int parse_number(const char *value, double *out) {
+    char *end;
+    errno = 0;
+    *out = strtod(value, &end);
+    return end == value || *end != '\0' || errno != 0 ? -1 : 0;
+}
+
+// 检查指标名：种类名或"种类名:实例"
+static int check_metric_name(const char *name) {
+    if (strlen(name) >= NAME_INDEX_KEY_LEN) {
+        return -1;
+    }
+    const char *sep = strchr(name, ':');
+    if (sep && sep[1] == '\0') {
+        return -1;
+    }
+    return find_metric_kind(name, sep ? (size_t)(sep - name) : strlen(name)) < 0 ? -1 : 0;
+}
+
+// 去掉首尾空白，返回新的起始位置
+static char *trim(char *s) {
+    while (isspace((unsigned char)*s)) {
+        s++;
+    }
+    char *end = s + strlen(s);
+    while (end > s && isspace((unsigned char)end[-1])) {
+        end--;
+    }
+    *end = '\0';
+    return s;
+}
+
+// 应用一个配置项，错误信息写入err
+static int apply_entry(RuntimeConfig *config, const char *key, const char *value,
+                       char *err, size_t err_size) {
+    double number;
+
+    if (strcmp(key, "sigma") == 0) {
+        if (parse_number(value, &number) != 0 || number <= 0) {
+            snprintf(err, err_size, "Sigma因子必须大于0");
+            return -1;
+        }
+        config->sigma_factor = number;
+        return 0;
+    }
+    if (strcmp(key, "devices") == 0 || strcmp(key, "interfaces") == 0) {
+        char **list = key[0] == 'd' ? &config->disk_devices : &config->net_interfaces;
+        if (dup_optional(list, strcmp(value, "auto") == 0 ? NULL : value) != 0) {
+            snprintf(err, err_size, "内存不足");
+            return -1;
+        }
+        return 0;
+    }
+    if (strcmp(key, "correlation") == 0) {
+        if (dup_optional(&config->correlation_groups, strcmp(value, "none") == 0 ? NULL : value) != 0) {
+            snprintf(err, err_size, "内存不足");
+            return -1;
+        }
+        return 0;
+    }
+    for (int kind = DETECTOR_NSIGMA + 1; kind < DETECTOR_COUNT; kind++) {
+        if (strcmp(key, detector_keys[kind]) == 0) {
+            if (dup_optional(&config->detector_metrics[kind],
+                             strcmp(value, "none") == 0 ? NULL : value) != 0) {
+                snprintf(err, err_size, "内存不足");
+                return -1;
+            }
+            return 0;
+        }
+    }
+
+    bool threshold = strncmp(key, "threshold.", 10) == 0;
+    if (threshold || strncmp(key, "sigma.", 6) == 0) {
+        const char *name = key + (threshold ? 10 : 6);
+        if (check_metric_name(name) != 0) {
+            snprintf(err, err_size, "未知的指标 %s", name);
+            return -1;
+        }
+        if (parse_number(value, &number) != 0 || (threshold ? number < 0 : number <= 0)) {
+            snprintf(err, err_size, threshold ? "阈值不能小于0" : "Sigma因子必须大于0");
+            return -1;
+        }
+        MetricSetting *setting = setting_for(config, name);
+        if (!setting) {
+            snprintf(err, err_size, "内存不足");
+            return -1;
+        }
+        if (threshold) {
+            setting->threshold = number;
+        } else {
+            setting->sigma_factor = number;
+        }
+        return 0;
+    }
+
+    snprintf(err, err_size, "未知的配置项 %s", key);
+    return -1;
+}
+
+int runtime_config_load(RuntimeConfig *config, const char *path) {
+    if (!config || !path) {
+        return -1;
+    }
+
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "错误: 无法打开配置文件 %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    char line[1024];
+    int line_no = 0;
+    int ret = 0;
+    while (fgets(line, sizeof(line), file)) {
+        line_no++;
+        size_t len = strlen(line);
+        if (len == sizeof(line) - 1 && line[len - 1] != '\n' && !feof(file)) {
+            fprintf(stderr, "错误: %s:%d: 行过长\n", path, line_no);
+            ret = -1;
+            break;
+        }
+
+        char *comment = strchr(line, '#');
+        if (comment) {
+            *comment = '\0';
+        }
+        char *key = trim(line);
+        if (key[0] == '\0') {
+            continue;
+        }
+
+        char *eq = strchr(key, '=');
+        if (!eq) {
+            fprintf(stderr, "错误: %s:%d: 缺少'='\n", path, line_no);
+            ret = -1;
+            break;
+        }
+        *eq = '\0';
+        char *value = trim(eq + 1);
+        key = trim(key);
+        if (key[0] == '\0' || value[0] == '\0') {
+            fprintf(stderr, "错误: %s:%d: 键和值都不能为空\n", path, line_no);
+            ret = -1;
+            break;
+        }
+
+        char err[128];
+        if (apply_entry(config, key, value, err, sizeof(err)) != 0) {
+            fprintf(stderr, "错误: %s:%d: %s\n", path, line_no, err);
+            ret = -1;
+            break;
+        }
+    }
+    if (ret == 0 && ferror(file)) {
+        fprintf(stderr, "错误: 读取配置文件 %s 失败\n", path);
+        ret = -1;
+    }
+    fclose(file);
+    return ret;
+}
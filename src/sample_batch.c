@@ -0,0 +1,179 @@
+#include "../include/sample_batch.h"
+#include <stdlib.h>
+#include <string.h>
+
+void sample_batch_init(SampleBatch *batch) {
+    memset(batch, 0, sizeof(*batch));
+}
+
+void sample_batch_free(SampleBatch *batch) {
+    if (!batch) {
+        return;
+    }
+    free(batch->samples);
+    free(batch->events);
+    memset(batch, 0, sizeof(*batch));
+}
+
+void sample_batch_reset(SampleBatch *batch) {
+    batch->timestamp_ns = 0;
+    batch->sample_count = 0;
+    batch->event_count = 0;
+    batch->processes.process_count = 0;
+    batch->processes.cpu_count = 0;
+    batch->processes.mem_count = 0;
+}
+
+int sample_batch_add(SampleBatch *batch, int series, double value) {
+    if (batch->sample_count == batch->sample_capacity) {
+        int new_capacity = batch->sample_capacity > 0 ? batch->sample_capacity * 2 : 64;
+        Sample *new_samples = (Sample *)realloc(batch->samples, sizeof(Sample) * new_capacity);
+        if (!new_samples) {
+            return -1;
+        }
+        batch->samples = new_samples;
+        batch->sample_capacity = new_capacity;
+    }
+
+    Sample *sample = &batch->samples[batch->sample_count++];
+    sample->series = series;
+    sample->value = value;
+    return 0;
+}
+
+static SeriesEvent *sample_batch_next_event(SampleBatch *batch) {
+    if (batch->event_count == batch->event_capacity) {
+        int new_capacity = batch->event_capacity > 0 ? batch->event_capacity * 2 : 16;
+        SeriesEvent *new_events = (SeriesEvent *)realloc(batch->events,
+                                                         sizeof(SeriesEvent) * new_capacity);
+        if (!new_events) {
+            return NULL;
+        }
+        batch->events = new_events;
+        batch->event_capacity = new_capacity;
+    }
+    return &batch->events[batch->event_count++];
+}
+
+int sample_batch_add_event(SampleBatch *batch, SeriesEventType event, int series,
+                           MetricType type, const char *instance) {
+    SeriesEvent *ev = sample_batch_next_event(batch);
+    if (!ev) {
+        return -1;
+    }
+
+    ev->event = event;
+    ev->series = series;
+    ev->type = type;
+    ev->instance[0] = '\0';
+    if (instance) {
+        strncpy(ev->instance, instance, sizeof(ev->instance) - 1);
+        ev->instance[sizeof(ev->instance) - 1] = '\0';
+    }
+    return 0;
+}
+
+int sample_batch_append_events(SampleBatch *dst, const SampleBatch *src) {
+    for (int i = 0; i < src->event_count; i++) {
+        SeriesEvent *ev = sample_batch_next_event(dst);
+        if (!ev) {
+            return -1;
+        }
+        *ev = src->events[i];
+    }
+    return 0;
+}
+
+// 扩展序列号到指标下标的映射表，新槽位置为-1
+static int grow_series_map(AnomalyDetector *detector, int series) {
+    if (series < detector->series_capacity) {
+        return 0;
+    }
+
+    int new_capacity = detector->series_capacity > 0 ? detector->series_capacity : 64;
+    while (new_capacity <= series) {
+        new_capacity *= 2;
+    }
+    int *new_map = (int *)realloc(detector->series_metrics, sizeof(int) * new_capacity);
+    if (!new_map) {
+        return -1;
+    }
+    for (int i = detector->series_capacity; i < new_capacity; i++) {
+        new_map[i] = -1;
+    }
+    detector->series_metrics = new_map;
+    detector->series_capacity = new_capacity;
+    return 0;
+}
+
+int apply_sample_batch(AnomalyDetector *detector, const SampleBatch *batch) {
+    if (!detector || !batch) {
+        return -1;
+    }
+
+    int ret = 0;
+
+    for (int i = 0; i < batch->event_count; i++) {
+        const SeriesEvent *ev = &batch->events[i];
+        if (ev->series < 0 || grow_series_map(detector, ev->series) != 0) {
+            ret = -1;
+            continue;
+        }
+
+        if (ev->event == SERIES_CREATE) {
+            int id = register_metric(detector, ev->type,
+                                     ev->instance[0] != '\0' ? ev->instance : NULL);
+            detector->series_metrics[ev->series] = id;
+            if (id < 0) {
+                ret = -1;
+            }
+        } else {
+            int id = detector->series_metrics[ev->series];
+            if (id >= 0) {
+                retire_metric(detector, id);
+            }
+            detector->series_metrics[ev->series] = -1;
+        }
+    }
+
+    for (int i = 0; i < batch->sample_count; i++) {
+        const Sample *sample = &batch->samples[i];
+        int id = sample->series >= 0 && sample->series < detector->series_capacity
+                 ? detector->series_metrics[sample->series] : -1;
+        if (id < 0) {
+            ret = -1;
+            continue;
+        }
+        add_metric_datapoint(&detector->metrics[id], sample->value, batch->timestamp_ns);
+    }
+
+    return ret;
+}
+
+int retire_unmapped_metrics(AnomalyDetector *detector) {
+    if (!detector || detector->metric_count == 0) {
+        return 0;
+    }
+
+    bool *mapped = (bool *)calloc(detector->metric_count, sizeof(bool));
+    if (!mapped) {
+        return 0;
+    }
+    for (int s = 0; s < detector->series_capacity; s++) {
+        int id = detector->series_metrics[s];
+        if (id >= 0 && id < detector->metric_count) {
+            mapped[id] = true;
+        }
+    }
+
+    int retired = 0;
+    for (int i = 0; i < detector->metric_count; i++) {
+        if (detector->metrics[i].active && !mapped[i]) {
+            retire_metric(detector, i);
+            retired++;
+        }
+    }
+
+    free(mapped);
+    return retired;
+}
@@ -0,0 +1,219 @@
+#define _GNU_SOURCE
+#include "../include/scheduler.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+
+uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * NSEC_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+uint64_t monotonic_to_realtime_ns(uint64_t mono_ns) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t real_now = (uint64_t)ts.tv_sec * NSEC_PER_SEC + (uint64_t)ts.tv_nsec;
+    uint64_t mono_now = monotonic_ns();
+    return real_now - (mono_now - mono_ns);
+}
+
+int parse_duration(const char *text, uint64_t *duration_ns) {
+    if (!text || !duration_ns) {
+        return -1;
+    }
+
+    char *end;
+    double value = strtod(text, &end);
+    if (end == text || value <= 0) {
+        return -1;
+    }
+
+    static const struct {
+        const char *suffix;
+        double scale;
+    } units[] = {
+        { "", (double)NSEC_PER_SEC },
+        { "s", (double)NSEC_PER_SEC },
+        { "ms", (double)NSEC_PER_MSEC },
+        { "m", 60.0 * NSEC_PER_SEC },
+        { "h", 3600.0 * NSEC_PER_SEC },
+        { "d", 86400.0 * NSEC_PER_SEC },
+        { "w", 7 * 86400.0 * NSEC_PER_SEC },
+    };
+    for (size_t i = 0; i < sizeof(units) / sizeof(units[0]); i++) {
+        if (strcmp(end, units[i].suffix) == 0) {
+            double ns = value * units[i].scale;
+            if (ns < 1 || ns > 1e18) {
+                return -1;
+            }
+            *duration_ns = (uint64_t)(ns + 0.5);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int parse_interval(const char *text, uint64_t *interval_ns) {
+    uint64_t ns;
+    if (parse_duration(text, &ns) != 0 || ns > 86400ULL * NSEC_PER_SEC) {
+        return -1;
+    }
+    *interval_ns = ns;
+    return 0;
+}
+
+int scheduler_init(Scheduler *sched, uint64_t interval_ns) {
+    if (!sched || interval_ns == 0) {
+        return -1;
+    }
+
+    memset(sched, 0, sizeof(*sched));
+    sched->interval_ns = interval_ns;
+    sched->base_interval_ns = interval_ns;
+    sched->deadline_ns = monotonic_ns();
+    sched->wake_fd = -1;
+    for (int i = 0; i < SCHEDULER_MAX_TRIGGERS; i++) {
+        sched->trigger_fds[i] = -1;
+    }
+    return 0;
+}
+
+void scheduler_set_burst(Scheduler *sched, uint64_t interval_ns, uint64_t duration_ns,
+                         const int *fds, int count) {
+    if (!sched) {
+        return;
+    }
+    sched->burst_interval_ns = interval_ns < sched->base_interval_ns ? interval_ns : 0;
+    sched->burst_duration_ns = duration_ns;
+    for (int i = 0; i < SCHEDULER_MAX_TRIGGERS; i++) {
+        sched->trigger_fds[i] = sched->burst_interval_ns > 0 && fds && i < count ? fds[i] : -1;
+    }
+}
+
+void scheduler_burst(Scheduler *sched) {
+    if (!sched || sched->burst_interval_ns == 0) {
+        return;
+    }
+
+    uint64_t now = monotonic_ns();
+    if (now >= sched->burst_until_ns) {
+        sched->bursts++;
+    }
+    sched->burst_until_ns = now + sched->burst_duration_ns;
+    sched->interval_ns = sched->burst_interval_ns;
+    if (sched->waiting && sched->deadline_ns > now) {
+        sched->deadline_ns = now;
+    }
+}
+
+void scheduler_set_wake_fd(Scheduler *sched, int fd) {
+    if (sched) {
+        sched->wake_fd = fd;
+    }
+}
+
+// 在唤醒描述符和触发描述符上等待到截止时间，ppoll的超时为相对值，每次重新按截止时间计算
+static int wait_with_fds(Scheduler *sched) {
+    struct pollfd pfds[1 + SCHEDULER_MAX_TRIGGERS];
+    pfds[0].fd = sched->wake_fd;
+    pfds[0].events = POLLIN;
+    for (int i = 0; i < SCHEDULER_MAX_TRIGGERS; i++) {
+        pfds[1 + i].fd = sched->trigger_fds[i];
+        pfds[1 + i].events = POLLPRI;
+    }
+
+    for (;;) {
+        uint64_t now = monotonic_ns();
+        if (now >= sched->deadline_ns) {
+            return 0;
+        }
+
+        uint64_t remaining = sched->deadline_ns - now;
+        struct timespec ts;
+        ts.tv_sec = (time_t)(remaining / NSEC_PER_SEC);
+        ts.tv_nsec = (long)(remaining % NSEC_PER_SEC);
+
+        int ret = ppoll(pfds, 1 + SCHEDULER_MAX_TRIGGERS, &ts, NULL);
+        if (ret > 0) {
+            // 触发器报告压力时进入突发模式，截止时间提前到当前时刻
+            for (int i = 0; i < SCHEDULER_MAX_TRIGGERS; i++) {
+                if (pfds[1 + i].revents & POLLPRI) {
+                    sched->fired |= 1u << i;
+                    scheduler_burst(sched);
+                } else if (pfds[1 + i].revents & (POLLERR | POLLNVAL)) {
+                    // 触发器失效（如所属cgroup被删除），不再等待
+                    pfds[1 + i].fd = -1;
+                    sched->trigger_fds[i] = -1;
+                }
+            }
+            if (pfds[0].revents & POLLIN) {
+                uint64_t count;
+                if (read(sched->wake_fd, &count, sizeof(count)) < 0) {
+                    // 非eventfd或已被读空，忽略
+                }
+                return -1;
+            }
+            continue;
+        }
+        if (ret < 0 && errno == EINTR) {
+            return -1;
+        }
+    }
+}
+
+int scheduler_wait(Scheduler *sched) {
+    if (!sched) {
+        return -1;
+    }
+
+    if (!sched->waiting) {
+        uint64_t now = monotonic_ns();
+
+        // 突发模式结束后间隔每个周期加倍，逐步回到基础间隔
+        if (sched->interval_ns < sched->base_interval_ns && now >= sched->burst_until_ns) {
+            sched->interval_ns *= 2;
+            if (sched->interval_ns > sched->base_interval_ns) {
+                sched->interval_ns = sched->base_interval_ns;
+            }
+        }
+
+        // 截止时间按固定步长前进，与本周期的采集耗时无关
+        sched->deadline_ns += sched->interval_ns;
+        sched->cycle_missed = 0;
+
+        if (now >= sched->deadline_ns) {
+            // 已经超过截止时间，跳过错过的周期，保持原有相位
+            uint64_t behind = (now - sched->deadline_ns) / sched->interval_ns + 1;
+            sched->deadline_ns += behind * sched->interval_ns;
+            sched->cycle_missed = (int)behind;
+            sched->missed += behind;
+        }
+        sched->waiting = true;
+    }
+
+    bool triggers = false;
+    for (int i = 0; i < SCHEDULER_MAX_TRIGGERS; i++) {
+        triggers |= sched->trigger_fds[i] >= 0;
+    }
+
+    if (sched->wake_fd >= 0 || triggers) {
+        if (wait_with_fds(sched) != 0) {
+            return -1;
+        }
+    } else {
+        struct timespec ts;
+        ts.tv_sec = (time_t)(sched->deadline_ns / NSEC_PER_SEC);
+        ts.tv_nsec = (long)(sched->deadline_ns % NSEC_PER_SEC);
+
+        if (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+            return -1;
+        }
+    }
+
+    sched->waiting = false;
+    return sched->cycle_missed;
+}
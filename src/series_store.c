@@ -0,0 +1,449 @@
+#include "../include/series_store.h"
+#include "../include/config.h"
+#include "../include/scheduler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// 按页大小向上取整
+static uint64_t page_align(uint64_t size) {
+    uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+    return (size + page - 1) / page * page;
+}
+
+static SeriesBlockHeader *block_header(const SeriesStore *store) {
+    return (SeriesBlockHeader *)store->block;
+}
+
+static void unmap_block(SeriesStore *store) {
+    if (store->block) {
+        munmap(store->block, block_header(store)->block_bytes);
+        store->block = NULL;
+    }
+}
+
+// 创建只有文件头的新文件
+static int create_file(SeriesStore *store) {
+    store->fd = open(store->path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (store->fd < 0) {
+        return -1;
+    }
+    if (ftruncate(store->fd, SERIES_HEADER_SIZE) != 0) {
+        close(store->fd);
+        store->fd = -1;
+        return -1;
+    }
+
+    store->header = (SeriesFileHeader *)mmap(NULL, SERIES_HEADER_SIZE, PROT_READ | PROT_WRITE,
+                                             MAP_SHARED, store->fd, 0);
+    if (store->header == MAP_FAILED) {
+        store->header = NULL;
+        close(store->fd);
+        store->fd = -1;
+        return -1;
+    }
+
+    memcpy(store->header->magic, SERIES_MAGIC, sizeof(store->header->magic));
+    store->header->version = SERIES_VERSION;
+    store->header->header_size = SERIES_HEADER_SIZE;
+    store->header->interval_ns = store->interval_ns;
+    store->header->block_count = 0;
+    store->header->data_bytes = SERIES_HEADER_SIZE;
+    return 0;
+}
+
+// 关闭当前文件并改名为path.1，保留给下次启动恢复使用
+static void retire_file(SeriesStore *store) {
+    unmap_block(store);
+    if (store->header) {
+        munmap(store->header, SERIES_HEADER_SIZE);
+        store->header = NULL;
+    }
+    if (store->fd >= 0) {
+        close(store->fd);
+        store->fd = -1;
+    }
+
+    char old_path[300];
+    snprintf(old_path, sizeof(old_path), "%s.1", store->path);
+    rename(store->path, old_path);
+}
+
+static bool header_valid(const SeriesFileHeader *header, uint64_t file_size) {
+    return memcmp(header->magic, SERIES_MAGIC, sizeof(header->magic)) == 0 &&
+           header->version == SERIES_VERSION &&
+           header->header_size == SERIES_HEADER_SIZE &&
+           header->data_bytes >= SERIES_HEADER_SIZE &&
+           header->data_bytes <= file_size;
+}
+
+int series_store_open(SeriesStore *store, const char *path, uint64_t interval_ns) {
+    if (!store || !path || strlen(path) >= sizeof(store->path) || interval_ns == 0) {
+        return -1;
+    }
+
+    memset(store, 0, sizeof(*store));
+    strcpy(store->path, path);
+    store->interval_ns = interval_ns;
+    store->row_capacity = SERIES_BLOCK_ROWS;
+    store->max_bytes = SERIES_MAX_BYTES;
+
+    store->fd = open(path, O_RDWR | O_CLOEXEC);
+    if (store->fd < 0) {
+        return create_file(store);
+    }
+
+    struct stat st;
+    if (fstat(store->fd, &st) != 0 || (uint64_t)st.st_size < SERIES_HEADER_SIZE) {
+        retire_file(store);
+        return create_file(store);
+    }
+
+    store->header = (SeriesFileHeader *)mmap(NULL, SERIES_HEADER_SIZE, PROT_READ | PROT_WRITE,
+                                             MAP_SHARED, store->fd, 0);
+    if (store->header == MAP_FAILED) {
+        store->header = NULL;
+        close(store->fd);
+        store->fd = -1;
+        return -1;
+    }
+    if (!header_valid(store->header, (uint64_t)st.st_size) ||
+        store->header->interval_ns != interval_ns) {
+        retire_file(store);
+        return create_file(store);
+    }
+
+    // 丢弃上次退出时已扩展但尚未登记的尾部，新数据从新块开始
+    if ((uint64_t)st.st_size > store->header->data_bytes &&
+        ftruncate(store->fd, (off_t)store->header->data_bytes) != 0) {
+        series_store_close(store);
+        return -1;
+    }
+    return 0;
+}
+
+// 扩展指标到列号的映射表
+static int grow_metric_slots(SeriesStore *store, int count) {
+    if (count <= store->metric_slots) {
+        return 0;
+    }
+
+    int new_slots = store->metric_slots > 0 ? store->metric_slots : 32;
+    while (new_slots < count) {
+        new_slots *= 2;
+    }
+    int *columns = (int *)realloc(store->metric_columns, sizeof(int) * new_slots);
+    if (!columns) {
+        return -1;
+    }
+    store->metric_columns = columns;
+    unsigned long *incarnations = (unsigned long *)realloc(store->column_incarnations,
+                                                           sizeof(unsigned long) * new_slots);
+    if (!incarnations) {
+        return -1;
+    }
+    store->column_incarnations = incarnations;
+    for (int i = store->metric_slots; i < new_slots; i++) {
+        store->metric_columns[i] = -1;
+        store->column_incarnations[i] = 0;
+    }
+    store->metric_slots = new_slots;
+    return 0;
+}
+
+// 为指标分配当前块中的一列并写入列名，列已用完时返回-1
+static int assign_column(SeriesStore *store, const Metric *metric, int metric_id) {
+    SeriesBlockHeader *bh = block_header(store);
+    if (bh->column_count >= bh->column_capacity) {
+        return -1;
+    }
+
+    int column = (int)bh->column_count++;
+    char *name = store->block + bh->names_offset + (size_t)column * SERIES_NAME_LEN;
+    memcpy(name, metric->name, SERIES_NAME_LEN);
+    store->metric_columns[metric_id] = column;
+    store->column_incarnations[metric_id] = metric->incarnation;
+    return column;
+}
+
+// 开始新块：列容量为当前在用指标数加上预留，值列全部填充为NaN
+static int start_block(SeriesStore *store, const AnomalyDetector *detector) {
+    unmap_block(store);
+
+    uint32_t active = 0;
+    for (int i = 0; i < detector->metric_count; i++) {
+        if (detector->metrics[i].active) {
+            active++;
+        }
+    }
+    uint32_t spare = active / 4 > SERIES_SPARE_COLUMNS ? active / 4 : SERIES_SPARE_COLUMNS;
+    uint32_t columns = active + spare;
+    uint32_t rows = store->row_capacity;
+
+    uint64_t names_offset = (sizeof(SeriesBlockHeader) + 63) / 64 * 64;
+    uint64_t timestamps_offset = names_offset + (uint64_t)columns * SERIES_NAME_LEN;
+    uint64_t values_offset = timestamps_offset + (uint64_t)rows * sizeof(uint64_t);
+    uint64_t block_bytes = page_align(values_offset + (uint64_t)columns * rows * sizeof(double));
+
+    // 文件过大时轮转，旧文件保留为path.1
+    if (store->header->block_count > 0 &&
+        store->header->data_bytes + block_bytes > store->max_bytes) {
+        retire_file(store);
+        if (create_file(store) != 0) {
+            return -1;
+        }
+    }
+
+    uint64_t offset = store->header->data_bytes;
+    if (ftruncate(store->fd, (off_t)(offset + block_bytes)) != 0) {
+        return -1;
+    }
+    char *block = (char *)mmap(NULL, block_bytes, PROT_READ | PROT_WRITE, MAP_SHARED,
+                               store->fd, (off_t)offset);
+    if (block == MAP_FAILED) {
+        return -1;
+    }
+
+    store->block = block;
+    store->block_offset = offset;
+    SeriesBlockHeader *bh = block_header(store);
+    bh->magic = SERIES_BLOCK_MAGIC;
+    bh->column_count = 0;
+    bh->column_capacity = columns;
+    bh->row_capacity = rows;
+    bh->row_count = 0;
+    bh->block_bytes = block_bytes;
+    bh->names_offset = names_offset;
+    bh->timestamps_offset = timestamps_offset;
+    bh->values_offset = values_offset;
+
+    double *values = (double *)(block + values_offset);
+    for (uint64_t i = 0; i < (uint64_t)columns * rows; i++) {
+        values[i] = NAN;
+    }
+
+    for (int i = 0; i < store->metric_slots; i++) {
+        store->metric_columns[i] = -1;
+    }
+    for (int i = 0; i < detector->metric_count; i++) {
+        if (detector->metrics[i].active) {
+            assign_column(store, &detector->metrics[i], i);
+        }
+    }
+
+    // 块初始化完成后再登记，读者不会看到未初始化的块
+    store->header->block_count++;
+    store->header->data_bytes = offset + block_bytes;
+    return 0;
+}
+
+int series_store_append(SeriesStore *store, const AnomalyDetector *detector, uint64_t timestamp_ns) {
+    if (!store || !store->header || !detector) {
+        return -1;
+    }
+    if (grow_metric_slots(store, detector->metric_count) != 0) {
+        return -1;
+    }
+    if (!store->block || block_header(store)->row_count >= block_header(store)->row_capacity) {
+        if (start_block(store, detector) != 0) {
+            return -1;
+        }
+    }
+
+    // 确认本行所有指标都有列，新出现的指标占用预留列，预留用完时开始新块
+    for (int i = 0; i < detector->metric_count; i++) {
+        const Metric *metric = &detector->metrics[i];
+        if (!metric->active || metric->timestamp_ns != timestamp_ns) {
+            continue;
+        }
+        if (store->metric_columns[i] >= 0 && store->column_incarnations[i] == metric->incarnation) {
+            continue;
+        }
+        if (assign_column(store, metric, i) < 0) {
+            if (start_block(store, detector) != 0) {
+                return -1;
+            }
+            break;
+        }
+    }
+
+    SeriesBlockHeader *bh = block_header(store);
+    uint64_t row = bh->row_count;
+    uint64_t *timestamps = (uint64_t *)(store->block + bh->timestamps_offset);
+    double *values = (double *)(store->block + bh->values_offset);
+
+    timestamps[row] = monotonic_to_realtime_ns(timestamp_ns);
+    for (int i = 0; i < detector->metric_count; i++) {
+        const Metric *metric = &detector->metrics[i];
+        if (!metric->active || metric->timestamp_ns != timestamp_ns) {
+            continue;
+        }
+        int column = store->metric_columns[i];
+        if (column >= 0) {
+            values[(uint64_t)column * bh->row_capacity + row] = metric->value;
+        }
+    }
+
+    // 整行写完后再提交，并发读取的外部工具不会看到半行
+    __atomic_store_n(&bh->row_count, row + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+void series_store_close(SeriesStore *store) {
+    if (!store) {
+        return;
+    }
+
+    unmap_block(store);
+    if (store->header) {
+        munmap(store->header, SERIES_HEADER_SIZE);
+        store->header = NULL;
+    }
+    if (store->fd >= 0) {
+        close(store->fd);
+        store->fd = -1;
+    }
+    free(store->metric_columns);
+    free(store->column_incarnations);
+    store->metric_columns = NULL;
+    store->column_incarnations = NULL;
+    store->metric_slots = 0;
+}
+
+int series_reader_open(SeriesReader *reader, const char *path) {
+    if (!reader || !path) {
+        return -1;
+    }
+
+    memset(reader, 0, sizeof(*reader));
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < SERIES_HEADER_SIZE) {
+        close(fd);
+        return -1;
+    }
+    uint64_t size = (uint64_t)st.st_size;
+    char *data = (char *)mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return -1;
+    }
+
+    if (!header_valid((const SeriesFileHeader *)data, size)) {
+        munmap(data, size);
+        return -1;
+    }
+
+    reader->data = data;
+    reader->size = size;
+    reader->offset = SERIES_HEADER_SIZE;
+    return 0;
+}
+
+const SeriesBlockHeader *series_reader_next(SeriesReader *reader) {
+    if (!reader || !reader->data) {
+        return NULL;
+    }
+
+    const SeriesFileHeader *header = (const SeriesFileHeader *)reader->data;
+    if (reader->block_index >= header->block_count ||
+        reader->offset + sizeof(SeriesBlockHeader) > header->data_bytes) {
+        return NULL;
+    }
+
+    const SeriesBlockHeader *bh = (const SeriesBlockHeader *)(reader->data + reader->offset);
+    if (bh->magic != SERIES_BLOCK_MAGIC || bh->block_bytes == 0 ||
+        bh->column_count > bh->column_capacity ||
+        bh->names_offset + (uint64_t)bh->column_capacity * SERIES_NAME_LEN > bh->timestamps_offset ||
+        bh->timestamps_offset + (uint64_t)bh->row_capacity * sizeof(uint64_t) > bh->values_offset ||
+        reader->offset + bh->block_bytes > header->data_bytes ||
+        bh->values_offset + (uint64_t)bh->column_capacity * bh->row_capacity * sizeof(double) >
+            bh->block_bytes) {
+        return NULL;
+    }
+
+    reader->offset += bh->block_bytes;
+    reader->block_index++;
+    return bh;
+}
+
+void series_reader_close(SeriesReader *reader) {
+    if (reader && reader->data) {
+        munmap(reader->data, reader->size);
+        reader->data = NULL;
+    }
+}
+
+// 恢复一个块中不早于since_ns的行，返回恢复的行数
+static int restore_block(const SeriesBlockHeader *bh, AnomalyDetector *detector, uint64_t since_ns) {
+    uint64_t rows = series_block_rows(bh);
+    const uint64_t *timestamps = series_block_timestamps(bh);
+    if (rows == 0 || timestamps[rows - 1] < since_ns) {
+        return 0;
+    }
+
+    int *ids = (int *)malloc(sizeof(int) * (bh->column_count > 0 ? bh->column_count : 1));
+    if (!ids) {
+        return 0;
+    }
+    for (uint32_t c = 0; c < bh->column_count; c++) {
+        char name[SERIES_NAME_LEN];
+        series_block_name(bh, c, name);
+        ids[c] = name[0] != '\0' ? register_metric_name(detector, name) : -1;
+    }
+
+    int restored = 0;
+    for (uint64_t r = 0; r < rows; r++) {
+        if (timestamps[r] < since_ns) {
+            continue;
+        }
+        for (uint32_t c = 0; c < bh->column_count; c++) {
+            double value = series_block_values(bh, c)[r];
+            if (ids[c] >= 0 && !isnan(value)) {
+                // 纪元时间换回检测器的时钟，季节模型据此得到正确的相位
+                add_metric_datapoint(&detector->metrics[ids[c]], value,
+                                     (uint64_t)((int64_t)timestamps[r] - detector->clock_offset_ns));
+            }
+        }
+        restored++;
+    }
+
+    free(ids);
+    return restored;
+}
+
+// 只读映射整个文件并逐块恢复
+static int restore_file(const char *path, AnomalyDetector *detector, uint64_t since_ns) {
+    SeriesReader reader;
+    if (series_reader_open(&reader, path) != 0) {
+        return 0;
+    }
+
+    int restored = 0;
+    const SeriesBlockHeader *bh;
+    while ((bh = series_reader_next(&reader)) != NULL) {
+        restored += restore_block(bh, detector, since_ns);
+    }
+
+    series_reader_close(&reader);
+    return restored;
+}
+
+int series_store_restore(const char *path, AnomalyDetector *detector, uint64_t since_ns) {
+    if (!path || !detector) {
+        return 0;
+    }
+
+    char old_path[300];
+    snprintf(old_path, sizeof(old_path), "%s.1", path);
+    return restore_file(old_path, detector, since_ns) + restore_file(path, detector, since_ns);
+}
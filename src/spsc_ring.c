@@ -0,0 +1,81 @@
+#include "../include/spsc_ring.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+int spsc_ring_init(SpscRing *ring, unsigned long capacity, size_t slot_size) {
+    if (!ring || capacity == 0 || slot_size == 0) {
+        return -1;
+    }
+
+    unsigned long size = 1;
+    while (size < capacity) {
+        size *= 2;
+    }
+
+    memset(ring, 0, sizeof(*ring));
+    ring->slots = (char *)calloc(size, slot_size);
+    if (!ring->slots) {
+        return -1;
+    }
+    ring->slot_size = slot_size;
+    ring->mask = size - 1;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    if (sem_init(&ring->items, 0, 0) != 0) {
+        free(ring->slots);
+        ring->slots = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+void spsc_ring_free(SpscRing *ring) {
+    if (!ring || !ring->slots) {
+        return;
+    }
+    sem_destroy(&ring->items);
+    free(ring->slots);
+    ring->slots = NULL;
+}
+
+void *spsc_ring_reserve(SpscRing *ring) {
+    unsigned long head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    unsigned long tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail > ring->mask) {
+        return NULL;
+    }
+    return spsc_ring_slot(ring, head);
+}
+
+void spsc_ring_publish(SpscRing *ring) {
+    unsigned long head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    // 无等待者时sem_post只是一次原子操作，不进入内核
+    sem_post(&ring->items);
+}
+
+void *spsc_ring_peek(SpscRing *ring) {
+    unsigned long tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    unsigned long head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (tail == head) {
+        return NULL;
+    }
+    return spsc_ring_slot(ring, tail);
+}
+
+void *spsc_ring_wait(SpscRing *ring) {
+    // 每次发布对应一次sem_post，每个取出的元素对应一次sem_wait
+    while (sem_wait(&ring->items) != 0 && errno == EINTR) {
+    }
+    return spsc_ring_peek(ring);
+}
+
+void spsc_ring_release(SpscRing *ring) {
+    unsigned long tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+}
+
+void spsc_ring_wake(SpscRing *ring) {
+    sem_post(&ring->items);
+}
@@ -0,0 +1,200 @@
+#include "../include/worker_pool.h"
+#include "../include/scheduler.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static void *worker_main(void *arg) {
+    WorkerThread *self = (WorkerThread *)arg;
+    WorkerPool *pool = self->pool;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->head && !pool->stopping) {
+            pthread_cond_wait(&pool->work_cond, &pool->lock);
+        }
+        if (pool->stopping) {
+            break;
+        }
+
+        WorkerTask *task = pool->head;
+        pool->head = task->next;
+        if (!pool->head) {
+            pool->tail = NULL;
+        }
+
+        // 执行任务时不持有锁，完成标记在锁内清除，等待者随后可见任务写入的数据
+        self->busy = true;
+        pool->busy_count++;
+        pthread_mutex_unlock(&pool->lock);
+        task->fn(task->arg);
+        pthread_mutex_lock(&pool->lock);
+        task->pending = false;
+        self->busy = false;
+        pool->busy_count--;
+        pthread_cond_broadcast(&pool->done_cond);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+int worker_pool_init(WorkerPool *pool, int threads) {
+    if (!pool || threads < 0) {
+        return -1;
+    }
+
+    memset(pool, 0, sizeof(*pool));
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_cond, NULL);
+    pthread_cond_init(&pool->done_cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    if (threads == 0) {
+        return 0;
+    }
+    pool->threads = (WorkerThread *)calloc((size_t)threads, sizeof(WorkerThread));
+    if (!pool->threads) {
+        worker_pool_free(pool, 0);
+        return -1;
+    }
+    for (int i = 0; i < threads; i++) {
+        pool->threads[i].pool = pool;
+        if (pthread_create(&pool->threads[i].thread, NULL, worker_main, &pool->threads[i]) != 0) {
+            worker_pool_free(pool, 0);
+            return -1;
+        }
+        pool->thread_count++;
+    }
+    return 0;
+}
+
+int worker_pool_submit(WorkerPool *pool, WorkerTask *task) {
+    if (!pool || !task || !task->fn) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    if (task->pending) {
+        pthread_mutex_unlock(&pool->lock);
+        return -1;
+    }
+    if (pool->thread_count == 0) {
+        pthread_mutex_unlock(&pool->lock);
+        task->fn(task->arg);
+        return 0;
+    }
+
+    task->pending = true;
+    task->next = NULL;
+    if (pool->tail) {
+        pool->tail->next = task;
+    } else {
+        pool->head = task;
+    }
+    pool->tail = task;
+    pthread_cond_signal(&pool->work_cond);
+    pthread_mutex_unlock(&pool->lock);
+    return 0;
+}
+
+bool worker_task_pending(WorkerPool *pool, WorkerTask *task) {
+    pthread_mutex_lock(&pool->lock);
+    bool pending = task->pending;
+    pthread_mutex_unlock(&pool->lock);
+    return pending;
+}
+
+// 统计仍未完成的任务数，调用时持有锁
+static int count_pending(WorkerTask *const *tasks, int count) {
+    int pending = 0;
+    for (int i = 0; i < count; i++) {
+        if (tasks[i]->pending) {
+            pending++;
+        }
+    }
+    return pending;
+}
+
+// 把单调时钟的截止时间转换为done_cond使用的timespec
+static struct timespec deadline_timespec(uint64_t deadline_ns) {
+    struct timespec ts;
+    ts.tv_sec = (time_t)(deadline_ns / NSEC_PER_SEC);
+    ts.tv_nsec = (long)(deadline_ns % NSEC_PER_SEC);
+    return ts;
+}
+
+int worker_pool_wait(WorkerPool *pool, WorkerTask *const *tasks, int count, uint64_t deadline_ns) {
+    if (!pool || !tasks) {
+        return 0;
+    }
+
+    struct timespec ts = deadline_timespec(deadline_ns);
+
+    pthread_mutex_lock(&pool->lock);
+    int pending = count_pending(tasks, count);
+    while (pending > 0) {
+        int rc = deadline_ns == 0 ? pthread_cond_wait(&pool->done_cond, &pool->lock)
+                                  : pthread_cond_timedwait(&pool->done_cond, &pool->lock, &ts);
+        pending = count_pending(tasks, count);
+        if (rc != 0) {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return pending;
+}
+
+int worker_pool_free(WorkerPool *pool, uint64_t timeout_ns) {
+    if (!pool) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = true;
+    for (WorkerTask *task = pool->head; task; task = task->next) {
+        task->pending = false;
+    }
+    pool->head = pool->tail = NULL;
+    pthread_cond_broadcast(&pool->work_cond);
+
+    // 等待正在执行的任务到期限，仍未完成的工作线程分离，不让卡住的数据源阻塞退出
+    struct timespec ts = deadline_timespec(monotonic_ns() + timeout_ns);
+    while (pool->busy_count > 0) {
+        int rc = timeout_ns == 0 ? pthread_cond_wait(&pool->done_cond, &pool->lock)
+                                 : pthread_cond_timedwait(&pool->done_cond, &pool->lock, &ts);
+        if (rc != 0) {
+            break;
+        }
+    }
+    int detached = 0;
+    for (int i = 0; i < pool->thread_count; i++) {
+        if (pool->threads[i].busy) {
+            pool->threads[i].detached = true;
+            pthread_detach(pool->threads[i].thread);
+            detached++;
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    // 空闲的工作线程看到停止请求后立即退出
+    for (int i = 0; i < pool->thread_count; i++) {
+        if (!pool->threads[i].detached) {
+            pthread_join(pool->threads[i].thread, NULL);
+        }
+    }
+    if (detached > 0) {
+        // 分离的线程完成任务后仍会访问锁和自己的线程表项
+        return detached;
+    }
+    free(pool->threads);
+    pool->threads = NULL;
+    pool->thread_count = 0;
+
+    pthread_cond_destroy(&pool->work_cond);
+    pthread_cond_destroy(&pool->done_cond);
+    pthread_mutex_destroy(&pool->lock);
+    return 0;
+}
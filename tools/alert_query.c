@@ -0,0 +1,181 @@
+/**
+ * @file alert_query.c
+ * @brief 结构化告警日志查询工具
+ *
+ * 只读映射-A写入的告警日志和索引，按时间范围、指标和严重程度筛选告警事件，
+ * 按文本日志的格式输出。索引表明不含符合条件记录的块不会被读取，
+ * 查询耗时取决于符合条件的块数，而不是日志的总长度。
+ */
+
+#define _GNU_SOURCE
+#include "../include/alert_log.h"
+#include "../include/scheduler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+/* 输出参数 */
+typedef struct {
+    bool count_only;                // 只统计数量
+    unsigned long limit;            // 最多输出的记录数，0表示不限
+    unsigned long printed;          // 已输出的记录数
+} QueryOutput;
+
+static void print_usage(const char *program) {
+    printf("结构化告警日志查询工具\n");
+    printf("用法: %s [选项] <告警日志文件>\n", program);
+    printf("选项:\n");
+    printf("  -h            显示帮助信息\n");
+    printf("  -f <时间>     只输出不早于该时间的事件\n");
+    printf("  -t <时间>     只输出早于该时间的事件\n");
+    printf("                时间为本地时间YYYY-MM-DD[ HH:MM[:SS]]、Unix秒数@N，\n");
+    printf("                或相对现在的-N[smhd]，如-2h、-7d\n");
+    printf("  -m <指标>     完整指标名（如disk_write_await:sda）或种类名（如disk_write_await）\n");
+    printf("  -s <级别>     最低严重程度（1-5）\n");
+    printf("  -n <数量>     最多输出的事件数\n");
+    printf("  -c            只输出符合条件的事件数\n");
+    printf("  -v            在标准错误输出中打印扫描的块数、记录数和耗时\n");
+}
+
+// 解析时间参数，失败返回-1
+static int64_t parse_time(const char *text) {
+    char *end;
+    if (text[0] == '@') {
+        long long seconds = strtoll(text + 1, &end, 10);
+        return end != text + 1 && *end == '\0' && seconds >= 0 ? (int64_t)seconds : -1;
+    }
+    if (text[0] == '-') {
+        double amount = strtod(text + 1, &end);
+        int64_t unit = 1;
+        switch (*end) {
+            case 'd': unit *= 24; /* fall through */
+            case 'h': unit *= 60; /* fall through */
+            case 'm': unit *= 60; /* fall through */
+            case 's': end++; break;
+            case '\0': break;
+            default: return -1;
+        }
+        if (end == text + 1 || *end != '\0' || amount < 0) {
+            return -1;
+        }
+        return (int64_t)time(NULL) - (int64_t)(amount * (double)unit);
+    }
+
+    static const char *const formats[] = { "%Y-%m-%d %H:%M:%S", "%Y-%m-%d %H:%M", "%Y-%m-%d" };
+    for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+        struct tm tm_info;
+        memset(&tm_info, 0, sizeof(tm_info));
+        end = strptime(text, formats[i], &tm_info);
+        if (end && *end == '\0') {
+            tm_info.tm_isdst = -1;
+            return (int64_t)mktime(&tm_info);
+        }
+    }
+    return -1;
+}
+
+// 按文本日志的格式输出一条记录
+static int print_record(const AlertLogRecord *record, void *arg) {
+    QueryOutput *out = (QueryOutput *)arg;
+    if (out->count_only) {
+        return 0;
+    }
+
+    char name[256];
+    char description[512];
+    memcpy(name, alert_record_name(record), record->name_len);
+    name[record->name_len] = '\0';
+    memcpy(description, alert_record_description(record), record->description_len);
+    description[record->description_len] = '\0';
+
+    AlertEvent event;
+    alert_record_to_event(record, &event);
+    char time_str[64];
+    struct tm tm_info;
+    localtime_r(&event.timestamp, &tm_info);
+    strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", &tm_info);
+
+    char line[1024];
+    int len = alert_event_format(&event, time_str, name, description, NULL, line, sizeof(line));
+    if (len > 0) {
+        fwrite(line, 1, (size_t)len, stdout);
+    }
+    out->printed++;
+    return out->limit > 0 && out->printed >= out->limit;
+}
+
+int main(int argc, char *argv[]) {
+    AlertQuery query = { 0 };
+    QueryOutput out = { 0 };
+    bool verbose = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "hf:t:m:s:n:cv")) != -1) {
+        switch (opt) {
+            case 'h':
+                print_usage(argv[0]);
+                return 0;
+            case 'f':
+            case 't': {
+                int64_t value = parse_time(optarg);
+                if (value < 0) {
+                    fprintf(stderr, "错误: 无效的时间 %s\n", optarg);
+                    return 1;
+                }
+                if (opt == 'f') {
+                    query.since = value;
+                } else {
+                    query.until = value;
+                }
+                break;
+            }
+            case 'm':
+                query.metric = optarg;
+                break;
+            case 's':
+                query.min_severity = atoi(optarg);
+                break;
+            case 'n':
+                out.limit = strtoul(optarg, NULL, 10);
+                break;
+            case 'c':
+                out.count_only = true;
+                break;
+            case 'v':
+                verbose = true;
+                break;
+            default:
+                fprintf(stderr, "使用 -h 选项获取帮助\n");
+                return 1;
+        }
+    }
+    if (optind != argc - 1) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    uint64_t start_ns = monotonic_ns();
+    AlertLogReader reader;
+    if (alert_log_reader_open(&reader, argv[optind]) != 0) {
+        fprintf(stderr, "错误: 无法打开告警日志 %s\n", argv[optind]);
+        return 1;
+    }
+
+    AlertQueryStats stats;
+    unsigned long matched = alert_log_query(&reader, &query, print_record, &out, &stats);
+    if (out.count_only) {
+        printf("%lu\n", matched);
+    }
+    fflush(stdout);
+    if (verbose) {
+        fprintf(stderr, "索引块: %lu，扫描块: %lu，扫描记录: %lu，符合条件: %lu，耗时: %.3f毫秒%s\n",
+                stats.blocks, stats.blocks_scanned, stats.records_scanned, stats.matched,
+                (double)(monotonic_ns() - start_ns) / NSEC_PER_MSEC,
+                reader.index ? "" : "（没有可用的索引）");
+    }
+
+    alert_log_reader_close(&reader);
+    return 0;
+}
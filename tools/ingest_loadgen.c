@@ -0,0 +1,257 @@
+/**
+ * @file ingest_loadgen.c
+ * @brief 汇聚服务端负载生成器
+ *
+ * 模拟多台主机按固定速率上报样本，用于测量汇聚服务端的吞吐：
+ * 每一轮为全部主机的全部序列各发送一个样本（同一主机的样本在一帧中），
+ * 轮次按绝对截止时间推进，速率达不到时如实报告实际速率。
+ * 约万分之一的样本为离群点，服务端应把它们检测为异常。
+ */
+
+#define _GNU_SOURCE
+#include "../include/ingest.h"
+#include "../include/config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/resource.h>
+
+/* 负载参数 */
+typedef struct {
+    const char *address;            // 服务端地址
+    int hosts;                      // 模拟的主机数
+    int series;                     // 每台主机的序列数
+    double rate;                    // 目标速率（样本/秒）
+    double duration;                // 持续时间（秒）
+    double outlier;                 // 离群点比例
+    int threads;                    // 发送线程数
+} LoadConfig;
+
+/* 发送线程 */
+typedef struct {
+    const LoadConfig *config;
+    int first_host;                 // 负责的主机范围[first_host, last_host)
+    int last_host;
+    uint64_t start_ns;              // 第0轮的截止时间（单调时钟）
+    uint64_t round_ns;              // 每轮的间隔
+    unsigned long rounds;           // 总轮数
+    unsigned long samples;          // 已发送的样本数
+    unsigned long outliers;         // 已发送的离群点数
+    unsigned long frames;           // 已发送的帧数
+    unsigned long send_errors;      // 发送失败的帧数
+    int failed;                     // 无法连接服务端
+} LoadThread;
+
+static const char *const kinds[] = { "cpu_usage", "disk_util", "disk_read_await", "net_dropped" };
+
+static uint64_t clock_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// xorshift64*，每个线程独立的随机数序列
+static double next_random(uint64_t *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return (double)((*state * 2685821657736338717ULL) >> 11) / 9007199254740992.0;
+}
+
+static void *load_main(void *arg) {
+    LoadThread *t = (LoadThread *)arg;
+    const LoadConfig *config = t->config;
+    int hosts = t->last_host - t->first_host;
+    int series = config->series;
+    uint64_t state = 0x9E3779B97F4A7C15ULL ^ (uint64_t)(t->first_host + 1);
+
+    IngestClient *clients = (IngestClient *)calloc((size_t)hosts, sizeof(IngestClient));
+    uint64_t *keys = (uint64_t *)malloc(sizeof(uint64_t) * (size_t)hosts * series);
+    double *bases = (double *)malloc(sizeof(double) * (size_t)hosts * series);
+    if (!clients || !keys || !bases) {
+        t->failed = 1;
+        free(clients);
+        free(keys);
+        free(bases);
+        return NULL;
+    }
+
+    int opened = 0;
+    for (; opened < hosts; opened++) {
+        char host[INGEST_HOST_LEN];
+        snprintf(host, sizeof(host), "host%05d", t->first_host + opened);
+        if (ingest_client_open(&clients[opened], config->address, host) != 0) {
+            t->failed = 1;
+            break;
+        }
+        for (int j = 0; j < series; j++) {
+            char metric[NAME_INDEX_KEY_LEN];
+            snprintf(metric, sizeof(metric), "%s:dev%d", kinds[j % 4], j / 4);
+            ingest_client_define(&clients[opened], metric, &keys[(size_t)opened * series + j]);
+            bases[(size_t)opened * series + j] = 20.0 + 40.0 * next_random(&state);
+        }
+    }
+
+    for (unsigned long round = 0; !t->failed && round < t->rounds; round++) {
+        uint64_t deadline = t->start_ns + round * t->round_ns;
+        struct timespec ts = { .tv_sec = (time_t)(deadline / 1000000000ULL),
+                               .tv_nsec = (long)(deadline % 1000000000ULL) };
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0) {
+        }
+
+        uint64_t now = clock_ns(CLOCK_REALTIME);
+        for (int h = 0; h < hosts; h++) {
+            for (int j = 0; j < series; j++) {
+                size_t idx = (size_t)h * series + j;
+                double value = bases[idx] + 5.0 * next_random(&state);
+                if (next_random(&state) < config->outlier) {
+                    value = bases[idx] + 60.0;
+                    t->outliers++;
+                }
+                ingest_client_sample(&clients[h], keys[idx], value, now);
+            }
+            ingest_client_flush(&clients[h]);
+        }
+        t->samples += (unsigned long)hosts * series;
+    }
+
+    for (int h = 0; h < opened; h++) {
+        t->frames += clients[h].frames;
+        t->send_errors += clients[h].send_errors;
+        ingest_client_close(&clients[h]);
+    }
+    free(clients);
+    free(keys);
+    free(bases);
+    return NULL;
+}
+
+static void print_help(void) {
+    printf("汇聚服务端负载生成器\n");
+    printf("用法: ingest_loadgen [选项]\n");
+    printf("选项:\n");
+    printf("  -h            显示帮助信息\n");
+    printf("  -a <地址>     服务端地址（默认: %s）\n", INGEST_ADDRESS);
+    printf("  -H <数量>     模拟的主机数（默认: 1000）\n");
+    printf("  -s <数量>     每台主机的序列数（默认: 100）\n");
+    printf("  -r <速率>     目标速率，样本/秒（默认: 1000000）\n");
+    printf("  -t <秒>       持续时间（默认: 10）\n");
+    printf("  -o <比例>     离群点比例（默认: 0.0001）\n");
+    printf("  -j <数量>     发送线程数（默认: 1）\n");
+}
+
+int main(int argc, char *argv[]) {
+    LoadConfig config = {
+        .address = INGEST_ADDRESS,
+        .hosts = 1000,
+        .series = 100,
+        .rate = 1000000,
+        .duration = 10,
+        .outlier = 0.0001,
+        .threads = 1,
+    };
+
+    int opt;
+    while ((opt = getopt(argc, argv, "ha:H:s:r:t:o:j:")) != -1) {
+        switch (opt) {
+            case 'h':
+                print_help();
+                return 0;
+            case 'a':
+                config.address = optarg;
+                break;
+            case 'H':
+                config.hosts = atoi(optarg);
+                break;
+            case 's':
+                config.series = atoi(optarg);
+                break;
+            case 'r':
+                config.rate = atof(optarg);
+                break;
+            case 't':
+                config.duration = atof(optarg);
+                break;
+            case 'o':
+                config.outlier = atof(optarg);
+                break;
+            case 'j':
+                config.threads = atoi(optarg);
+                break;
+            default:
+                fprintf(stderr, "使用 -h 选项获取帮助\n");
+                return 1;
+        }
+    }
+    if (config.hosts <= 0 || config.series <= 0 || config.rate <= 0 || config.duration <= 0 ||
+        config.threads <= 0 || config.threads > config.hosts) {
+        fprintf(stderr, "错误: 参数无效\n");
+        return 1;
+    }
+
+    // 每台模拟主机一个套接字
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    double per_round = (double)config.hosts * config.series;
+    uint64_t round_ns = (uint64_t)(per_round / config.rate * 1e9);
+    unsigned long rounds = (unsigned long)(config.duration * config.rate / per_round);
+    if (rounds == 0) {
+        rounds = 1;
+    }
+
+    printf("服务端: %s, 主机: %d, 序列: %d, 目标速率: %.0f 样本/秒, 轮次: %lu（间隔 %.3f秒）\n",
+           config.address, config.hosts, config.hosts * config.series, config.rate, rounds,
+           round_ns / 1e9);
+    fflush(stdout);
+
+    LoadThread *threads = (LoadThread *)calloc((size_t)config.threads, sizeof(LoadThread));
+    pthread_t *ids = (pthread_t *)calloc((size_t)config.threads, sizeof(pthread_t));
+    if (!threads || !ids) {
+        return 1;
+    }
+
+    // 留出建立连接的时间，所有线程从同一截止时间开始
+    uint64_t start = clock_ns(CLOCK_MONOTONIC) + 500000000ULL;
+    int started = 0;
+    for (int i = 0; i < config.threads; i++) {
+        threads[i].config = &config;
+        threads[i].first_host = (int)((long)config.hosts * i / config.threads);
+        threads[i].last_host = (int)((long)config.hosts * (i + 1) / config.threads);
+        threads[i].start_ns = start;
+        threads[i].round_ns = round_ns;
+        threads[i].rounds = rounds;
+        if (pthread_create(&ids[i], NULL, load_main, &threads[i]) != 0) {
+            break;
+        }
+        started++;
+    }
+
+    unsigned long samples = 0, outliers = 0, frames = 0, errors = 0;
+    int failed = started < config.threads;
+    for (int i = 0; i < started; i++) {
+        pthread_join(ids[i], NULL);
+        samples += threads[i].samples;
+        outliers += threads[i].outliers;
+        frames += threads[i].frames;
+        errors += threads[i].send_errors;
+        failed |= threads[i].failed;
+    }
+    double elapsed = (double)(clock_ns(CLOCK_MONOTONIC) - start) / 1e9;
+
+    if (failed) {
+        fprintf(stderr, "错误: 无法连接服务端 %s\n", config.address);
+    }
+    printf("发送: %lu 个样本（离群点 %lu 个），%lu 帧，发送失败 %lu 帧，耗时 %.2f秒，%.0f 样本/秒\n",
+           samples, outliers, frames, errors, elapsed, elapsed > 0 ? samples / elapsed : 0);
+
+    free(threads);
+    free(ids);
+    return failed ? 1 : 0;
+}